@@ -109,6 +109,11 @@ inline unsigned numIters()
 	return getMainWindow()->m_num_iters;
 }
 
+inline PlaybackEngine* getPlaybackEngine()
+{
+	return getMainWindow()->m_playback;
+}
+
 
 /// returns the path in which the application resides
 QDir AppDir();
@@ -0,0 +1,570 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+//	Headless benchmark of the I/O, topology and animation kernels of EmVis.
+//	No Qt and no OpenGL are involved. All datasets below the given roots
+//	(examples/ and debug_examples/ of the source tree by default) are
+//	processed and the timings are written as JSON, so that builds can be
+//	compared on the same meshes:
+//
+//	  emvis_benchmark [-repeat n] [-frames n] [-out file.json] [root ...]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include "lib_grid/lib_grid.h"
+#include "oscillation/displacements.h"
+#include "scene/lg_include.h"
+#include "scene/plane_sphere.h"
+#include "tools/UG_LogParser.h"
+#include "vtustuff/ugx_object_reader.hpp"
+#include "vtustuff/vtu_object_reader.hpp"
+#include "vtustuff/vtu_ugx_converter.hpp"
+
+using namespace std;
+using namespace ug;
+namespace fs = boost::filesystem;
+
+#ifndef EMVIS_SOURCE_DIR
+	#define EMVIS_SOURCE_DIR "."
+#endif
+
+namespace{
+
+typedef chrono::steady_clock	BenchmarkClock;
+
+///	keeps the compiler from removing kernels whose results are not used
+volatile double g_sink = 0;
+
+double ElapsedMs(const BenchmarkClock::time_point& start)
+{
+	return chrono::duration<double, milli>(BenchmarkClock::now() - start).count();
+}
+
+///	timings of a single kernel on a single input
+struct BenchmarkResult
+{
+	BenchmarkResult() : numVertices(0), numElements(0), ok(true)	{}
+
+	string			kernel;
+	string			input;
+	size_t			numVertices;
+	size_t			numElements;
+	vector<double>	samplesMs;
+	bool			ok;
+};
+
+///	collects the results and writes them as JSON
+class BenchmarkSuite
+{
+	public:
+		BenchmarkSuite(int repeat, int frames) :
+			m_repeat(max(repeat, 1)), m_frames(max(frames, 1))	{}
+
+		int repeat() const	{return m_repeat;}
+		int frames() const	{return m_frames;}
+
+		void add(const BenchmarkResult& r)
+		{
+			m_results.push_back(r);
+			cerr << "  " << r.kernel << " " << r.input;
+			if(r.ok && !r.samplesMs.empty()){
+				vector<double> s = r.samplesMs;
+				sort(s.begin(), s.end());
+				cerr << ": " << s[s.size() / 2] << " ms (median)";
+			}
+			else
+				cerr << ": failed";
+			cerr << endl;
+		}
+
+		void write_json(ostream& out) const;
+
+	private:
+		int	m_repeat;
+		int	m_frames;
+		vector<BenchmarkResult>	m_results;
+};
+
+void WriteJSONString(ostream& out, const string& str)
+{
+	out << '"';
+	for(size_t i = 0; i < str.size(); ++i){
+		const char c = str[i];
+		if(c == '"' || c == '\\')
+			out << '\\' << c;
+		else if(c == '\n')
+			out << "\\n";
+		else if((unsigned char)c < 0x20){
+			char tmp[8];
+			snprintf(tmp, sizeof(tmp), "\\u%04x", (unsigned)c);
+			out << tmp;
+		}
+		else
+			out << c;
+	}
+	out << '"';
+}
+
+void BenchmarkSuite::
+write_json(ostream& out) const
+{
+	out.precision(6);
+	out << "{\n  \"repeat\": " << m_repeat << ",\n  \"frames\": " << m_frames
+		<< ",\n  \"results\": [";
+
+	for(size_t i = 0; i < m_results.size(); ++i){
+		const BenchmarkResult& r = m_results[i];
+		out << (i == 0 ? "\n" : ",\n") << "    {\"kernel\": ";
+		WriteJSONString(out, r.kernel);
+		out << ", \"input\": ";
+		WriteJSONString(out, r.input);
+		out << ", \"vertices\": " << r.numVertices
+			<< ", \"elements\": " << r.numElements
+			<< ", \"ok\": " << (r.ok ? "true" : "false");
+
+		vector<double> s = r.samplesMs;
+		if(r.ok && !s.empty()){
+			sort(s.begin(), s.end());
+			double sum = 0;
+			for(size_t j = 0; j < s.size(); ++j)
+				sum += s[j];
+			const double mean = sum / (double)s.size();
+			double var = 0;
+			for(size_t j = 0; j < s.size(); ++j)
+				var += (s[j] - mean) * (s[j] - mean);
+			const double median = (s.size() % 2 == 1) ?
+					s[s.size() / 2] : 0.5 * (s[s.size() / 2 - 1] + s[s.size() / 2]);
+
+			out << ", \"samples\": " << s.size()
+				<< ", \"ms\": {\"min\": " << s.front()
+				<< ", \"median\": " << median
+				<< ", \"mean\": " << mean
+				<< ", \"max\": " << s.back()
+				<< ", \"stddev\": " << sqrt(var / (double)s.size()) << "}";
+		}
+		out << "}";
+	}
+	out << "\n  ]\n}\n";
+}
+
+
+bool HasSuffix(const string& str, const string& suffix)
+{
+	return str.size() >= suffix.size()
+		&& str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+size_t NumElements(Grid& grid)
+{
+	return grid.num_edges() + grid.num_faces() + grid.num_volumes();
+}
+
+///	loads a ugx file like LoadLGObjectFromFile
+bool LoadUGX(Grid& grid, SubsetHandler& sh, const string& file)
+{
+	UGXObjectReader reader;
+	if(!reader.parse_file(file.c_str()) || reader.num_grids() < 1
+	   || !reader.grid_parallel(grid, 0, aPosition))
+	{
+		return false;
+	}
+	if(reader.num_subset_handlers(0) > 0)
+		reader.subset_handler(sh, 0, 0);
+	return true;
+}
+
+bool LoadUGX(Grid& grid, const string& file)
+{
+	grid.clear_geometry();
+	SubsetHandler sh(grid);
+	return LoadUGX(grid, sh, file);
+}
+
+///	loads a vtu file like LoadVTUObjectFromFile, without its data arrays
+bool LoadVTU(Grid& grid, const string& file)
+{
+	vector<double> points;
+	vector<unsigned> conn, offsets, types;
+	vector<VTUDataArray> pointData, cellData;
+
+	VTUObjectReader reader;
+	if(!reader.parse_file(file.c_str()) || reader.num_grids() < 1
+	   || !reader.read_pieces(points, conn, offsets, types, pointData, cellData))
+	{
+		return false;
+	}
+
+	BulkGridBuilder builder(grid);
+	TopologyBuilder topology;
+	BuildVTUGrid(builder, topology, points, conn, offsets, types);
+	builder.finish();
+	return true;
+}
+
+///	loads the file repeatedly through the readers of EmVis
+void BenchmarkGridReader(BenchmarkSuite& suite, const string& file, bool vtu)
+{
+	BenchmarkResult r;
+	r.kernel = vtu ? "VTUObjectReader" : "UGXObjectReader";
+	r.input = file;
+
+	for(int i = 0; i < suite.repeat() && r.ok; ++i){
+		Grid grid(GRIDOPT_STANDARD_INTERCONNECTION);
+		SubsetHandler sh(grid);
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+		try{
+			if(vtu)
+				r.ok = LoadVTU(grid, file);
+			else
+				r.ok = LoadUGX(grid, sh, file);
+		}
+		catch(UGError&){
+			r.ok = false;
+		}
+		catch(std::exception&){
+			r.ok = false;
+		}
+		r.samplesMs.push_back(ElapsedMs(start));
+		r.numVertices = grid.num_vertices();
+		r.numElements = NumElements(grid);
+	}
+	suite.add(r);
+}
+
+///	parses a vtu file with the parser of vtu_ugx_converter
+void BenchmarkPARSE(BenchmarkSuite& suite, const string& file)
+{
+	BenchmarkResult r;
+	r.kernel = "PARSE";
+	r.input = file;
+
+//	PARSE reports the arrays it found on cout, which may hold the JSON output
+	stringstream parserLog;
+	streambuf* coutBuf = cout.rdbuf(parserLog.rdbuf());
+
+	for(int i = 0; i < suite.repeat() && r.ok; ++i){
+		try{
+			BenchmarkClock::time_point start = BenchmarkClock::now();
+			PARSE P(file);
+			pair<unsigned, unsigned> num_data = P.parse_header();
+
+			vector<VTUDataArray> point_data, cell_data;
+			P.parse_point_data(point_data, cell_data, num_data.first, num_data.second);
+			CombineVTUComponentArrays(point_data);
+
+			vector<vector<double> > points(num_data.first);
+			P.parse_points(points, num_data.first);
+
+			vector<unsigned> conn, offsets, types;
+			P.parse_connectivity(conn);
+			P.parse_offsets(offsets, num_data.second);
+			P.parse_types(types);
+			P.end_file();
+			r.samplesMs.push_back(ElapsedMs(start));
+
+			r.numVertices = num_data.first;
+			r.numElements = num_data.second;
+		}
+		catch(...){
+			r.ok = false;
+		}
+		parserLog.str("");
+	}
+
+	cout.rdbuf(coutBuf);
+	suite.add(r);
+}
+
+///	parses the log of a PINVIT run
+void BenchmarkLogParser(BenchmarkSuite& suite, const string& file)
+{
+	BenchmarkResult r;
+	r.kernel = "UG_LogParser";
+	r.input = file;
+
+	for(int i = 0; i < suite.repeat() && r.ok; ++i){
+		try{
+			string filename = file;
+			BenchmarkClock::time_point start = BenchmarkClock::now();
+			UG_LogParser parser(filename);
+		//	logs of aborted runs are parsed up to their end
+			parser.do_it();
+			r.samplesMs.push_back(ElapsedMs(start));
+			r.numElements = parser.num_iterations();
+		}
+		catch(...){
+			r.ok = false;
+		}
+	}
+	suite.add(r);
+}
+
+///	times the animation kernels on a reference grid and its modes
+/**	This mirrors an oscillation in EmVis: the displacements of all modes are
+ * computed once, then each frame superposes them onto the rest positions and
+ * recomputes the normals and bounding shapes of every mode.*/
+void BenchmarkModeSet(BenchmarkSuite& suite, const string& refFile,
+					  const vector<string>& modeFiles)
+{
+	Grid refGrid(GRIDOPT_STANDARD_INTERCONNECTION);
+	if(!LoadUGX(refGrid, refFile))
+		return;
+
+	vector<Grid*> modeGrids;
+	for(size_t i = 0; i < modeFiles.size(); ++i){
+		Grid* g = new Grid(GRIDOPT_STANDARD_INTERCONNECTION);
+		if(LoadUGX(*g, modeFiles[i]) && g->num_vertices() == refGrid.num_vertices())
+			modeGrids.push_back(g);
+		else
+			delete g;
+	}
+
+	if(modeGrids.empty())
+		return;
+
+	const string input = fs::path(refFile).parent_path().string();
+	const size_t numVrts = refGrid.num_vertices();
+	const size_t numElems = NumElements(refGrid);
+
+//	displacement computation
+	vector<vector<vector3> > displacements(modeGrids.size());
+	{
+		BenchmarkResult r;
+		r.kernel = "displacements";
+		r.input = input;
+		r.numVertices = numVrts;
+		r.numElements = numElems;
+		for(int i = 0; i < suite.repeat(); ++i){
+			BenchmarkClock::time_point start = BenchmarkClock::now();
+			for(size_t j = 0; j < modeGrids.size(); ++j){
+				displacements[j].clear();
+				ComputeDisplacements(displacements[j], *modeGrids[j], refGrid);
+			}
+			r.samplesMs.push_back(ElapsedMs(start));
+		}
+		suite.add(r);
+	}
+
+//	rest positions of the modes are the positions of the reference grid
+	vector<vector3> rest;
+	rest.reserve(numVrts);
+	Grid::VertexAttachmentAccessor<APosition> aaPosRef(refGrid, aPosition);
+	for(VertexIterator iter = refGrid.begin<Vertex>(); iter != refGrid.end<Vertex>(); ++iter)
+		rest.push_back(aaPosRef[*iter]);
+
+	BenchmarkResult superposition, normals, vrtNormals, bounds;
+	superposition.kernel = "superposition";
+	normals.kernel = "normals";
+	vrtNormals.kernel = "vertex_normals";
+	bounds.kernel = "bounding_shapes";
+	BenchmarkResult* results[] = {&superposition, &normals, &vrtNormals, &bounds};
+	for(int i = 0; i < 4; ++i){
+		results[i]->input = input;
+		results[i]->numVertices = numVrts;
+		results[i]->numElements = numElems;
+	}
+
+//	the adjacency of smooth shading is built once per topology, see LGObject
+	vector<VertexFaceAdjacency> adjacencies(modeGrids.size());
+	for(size_t j = 0; j < modeGrids.size(); ++j){
+		if(!modeGrids[j]->has_face_attachment(aNormal))
+			modeGrids[j]->attach_to_faces(aNormal);
+		if(!modeGrids[j]->has_vertex_attachment(aNormal))
+			modeGrids[j]->attach_to_vertices(aNormal);
+		BuildVertexFaceAdjacency(adjacencies[j], *modeGrids[j]);
+	}
+
+	for(int frame = 0; frame < suite.frames(); ++frame){
+		const number scale = sin(0.2 * frame);
+
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+		for(size_t j = 0; j < modeGrids.size(); ++j){
+			Grid::VertexAttachmentAccessor<APosition> aaPos(*modeGrids[j], aPosition);
+			SuperposeDisplacements(*modeGrids[j], aaPos, rest, displacements[j], scale);
+		}
+		superposition.samplesMs.push_back(ElapsedMs(start));
+
+	//	normals and bounding shapes are computed as by LGObject::geometry_changed
+		start = BenchmarkClock::now();
+		for(size_t j = 0; j < modeGrids.size(); ++j){
+			Grid& g = *modeGrids[j];
+			Grid::VertexAttachmentAccessor<APosition> aaPos(g, aPosition);
+			Grid::FaceAttachmentAccessor<ANormal> aaNorm(g, aNormal);
+			vector<Face*> faces;
+			CollectElements(faces, g.faces_begin(), g.faces_end(), g.num_faces());
+			CalculateFaceNormalsParallel(faces, aaPos, aaNorm);
+		}
+		normals.samplesMs.push_back(ElapsedMs(start));
+
+		start = BenchmarkClock::now();
+		for(size_t j = 0; j < modeGrids.size(); ++j){
+			Grid& g = *modeGrids[j];
+			Grid::VertexAttachmentAccessor<APosition> aaPos(g, aPosition);
+			Grid::VertexAttachmentAccessor<ANormal> aaVrtNorm(g, aNormal);
+			CalculateVertexNormalsParallel(adjacencies[j], aaPos, aaVrtNorm);
+		}
+		vrtNormals.samplesMs.push_back(ElapsedMs(start));
+
+		start = BenchmarkClock::now();
+		for(size_t j = 0; j < modeGrids.size(); ++j){
+			Grid& g = *modeGrids[j];
+			Grid::VertexAttachmentAccessor<APosition> aaPos(g, aPosition);
+			vector3 boxMin, boxMax, center;
+			vector<Vertex*> vrts;
+			CollectElements(vrts, g.vertices_begin(), g.vertices_end(), g.num_vertices());
+			CalculateBoundingBoxParallel(boxMin, boxMax, vrts, aaPos);
+			Sphere3 sphere;
+			sphere.set_radius(VecDistance(boxMin, boxMax) / 2.f);
+			VecAdd(center, boxMin, boxMax);
+			VecScale(center, center, 0.5f);
+			sphere.set_center(center);
+			g_sink = g_sink + sphere.get_radius();
+		}
+		bounds.samplesMs.push_back(ElapsedMs(start));
+	}
+
+	for(int i = 0; i < 4; ++i)
+		suite.add(*results[i]);
+
+	for(size_t j = 0; j < modeGrids.size(); ++j)
+		delete modeGrids[j];
+}
+
+///	a directory with a reference grid (A.ugx or ev_1_ascii.ugx) and *.ugxc modes
+void BenchmarkDirectory(BenchmarkSuite& suite, const fs::path& dir)
+{
+	string refFile;
+	vector<string> modeFiles;
+	for(fs::directory_iterator i(dir); i != fs::directory_iterator(); ++i){
+		const string name = i->path().filename().string();
+		if(name == "A.ugx" || (name == "ev_1_ascii.ugx" && refFile.empty()))
+			refFile = i->path().string();
+		else if(HasSuffix(name, ".ugxc"))
+			modeFiles.push_back(i->path().string());
+	}
+	sort(modeFiles.begin(), modeFiles.end());
+
+	if(!refFile.empty() && !modeFiles.empty())
+		BenchmarkModeSet(suite, refFile, modeFiles);
+}
+
+void BenchmarkRoot(BenchmarkSuite& suite, const fs::path& root)
+{
+	if(!fs::is_directory(root)){
+		cerr << "skipping " << root.string() << ": not a directory" << endl;
+		return;
+	}
+
+	vector<fs::path> files, dirs;
+	dirs.push_back(root);
+	for(fs::recursive_directory_iterator i(root); i != fs::recursive_directory_iterator(); ++i){
+		if(fs::is_directory(i->path()))
+			dirs.push_back(i->path());
+		else
+			files.push_back(i->path());
+	}
+	sort(files.begin(), files.end());
+	sort(dirs.begin(), dirs.end());
+
+	for(size_t i = 0; i < files.size(); ++i){
+		const string file = files[i].string();
+		const string name = files[i].filename().string();
+		if(HasSuffix(name, ".ugx") || HasSuffix(name, ".ugxc"))
+			BenchmarkGridReader(suite, file, false);
+		else if(HasSuffix(name, ".vtu")){
+			BenchmarkGridReader(suite, file, true);
+			BenchmarkPARSE(suite, file);
+		}
+		else if(name == "log.txt" || HasSuffix(name, ".log"))
+			BenchmarkLogParser(suite, file);
+	}
+
+	for(size_t i = 0; i < dirs.size(); ++i)
+		BenchmarkDirectory(suite, dirs[i]);
+}
+
+}// end of anonymous namespace
+
+
+int main(int argc, char** argv)
+{
+	int repeat = 5;
+	int frames = 100;
+	string outFile;
+	vector<string> roots;
+
+	for(int i = 1; i < argc; ++i){
+		const string arg = argv[i];
+		if(arg == "-repeat" && i + 1 < argc)
+			repeat = atoi(argv[++i]);
+		else if(arg == "-frames" && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else if(arg == "-out" && i + 1 < argc)
+			outFile = argv[++i];
+		else if(arg == "-help"){
+			cout << "usage: emvis_benchmark [-repeat n] [-frames n] [-out file.json] [root ...]\n"
+					"  -repeat  number of runs of each i/o kernel (default 5)\n"
+					"  -frames  number of animation frames per mode set (default 100)\n"
+					"  -out     write the JSON results to this file instead of stdout\n"
+					"  root     directories which are searched for datasets\n"
+					"           (default: examples and debug_examples of the source tree)\n";
+			return 0;
+		}
+		else
+			roots.push_back(arg);
+	}
+
+	if(roots.empty()){
+		roots.push_back(string(EMVIS_SOURCE_DIR) + "/examples");
+		roots.push_back(string(EMVIS_SOURCE_DIR) + "/debug_examples");
+	}
+
+	BenchmarkSuite suite(repeat, frames);
+	for(size_t i = 0; i < roots.size(); ++i){
+		cerr << "benchmarking " << roots[i] << endl;
+		BenchmarkRoot(suite, roots[i]);
+	}
+
+	if(outFile.empty())
+		suite.write_json(cout);
+	else{
+		ofstream out(outFile.c_str());
+		if(!out){
+			cerr << "could not open " << outFile << endl;
+			return 1;
+		}
+		suite.write_json(out);
+	}
+	return 0;
+}
@@ -0,0 +1,1339 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+
+//	Generator of synthetic datasets for scaling tests. Structured boxes are
+//	meshed with tetrahedrons, hexahedrons, triangles or quadrilaterals (the
+//	latter two only cover the surface of the box), so that the number of
+//	elements can be chosen freely between 10^4 and 10^8. For each mesh a set of
+//	analytic mode shapes is written in one of the layouts which EmVis loads:
+//
+//	  eigenmodes:  A.ugx, ev_i.ugxc, metadata.txt (see examples/eigenmodes)
+//	  dataset:     log.txt with a synthetic PINVIT run, solutions/ev_i_ascii.ugx(c)
+//	               and debug/pinvit_it_n_{ev,defect,corr}_i_ascii.ugxc
+//	               (see debug_examples, opened through File > Open Dataset)
+//
+//	All files are streamed, the meshes are never held in memory. The output
+//	only depends on the options, so scaling curves can be reproduced anywhere:
+//
+//	  emvis_dataset_generator -type tet -elements 1e4,1e5,1e6 -out scaling
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <boost/filesystem.hpp>
+#include "vtustuff/topology_builder.hpp"
+#include "vtustuff/ugx_stream_writer.hpp"
+
+using namespace std;
+namespace fs = boost::filesystem;
+
+namespace{
+
+enum MeshType
+{
+	MT_TET,
+	MT_HEX,
+	MT_TRI,
+	MT_QUAD
+};
+
+const char* MeshTypeName(MeshType type)
+{
+	switch(type){
+		case MT_TET:	return "tet";
+		case MT_HEX:	return "hex";
+		case MT_TRI:	return "tri";
+		case MT_QUAD:	return "quad";
+	}
+	return "";
+}
+
+///	density of the material which is written to the log (Iron, as in debug_examples)
+const double DENSITY = 0.0079;
+
+////////////////////////////////////////////////////////////////////////////////
+///	a box of nx x ny x nz cells, either as volume mesh or as surface mesh
+/**	Tetrahedral meshes split each cell into 6 tetrahedrons which share the
+ * diagonal of the cell (Kuhn subdivision), triangular surfaces split each
+ * boundary quadrilateral along the same diagonal. Edges and faces are written
+ * explicitly, as the vtu to ugx converter does, so that no sides have to be
+ * created while a file is loaded.
+ *
+ * Vertices of volume meshes are numbered lexicographically. Surface meshes only
+ * hold the vertices of the boundary: the bottom layer, the rings of the inner
+ * layers and the top layer.*/
+class StructuredBox
+{
+	public:
+	///	chooses the number of cells per axis so that about numElements elements are created
+		StructuredBox(MeshType type, size_t numElements, const double extent[3]);
+
+		MeshType type() const		{return m_type;}
+		bool surface() const		{return m_type == MT_TRI || m_type == MT_QUAD;}
+		bool simplicial() const		{return m_type == MT_TET || m_type == MT_TRI;}
+		size_t num_cells(int axis) const	{return m_n[axis];}
+		double extent(int axis) const		{return m_extent[axis];}
+
+		size_t num_vertices() const;
+		size_t num_edges() const;
+		size_t num_faces() const;
+		size_t num_volumes() const;
+
+	///	volumes of volume meshes and faces of surface meshes
+		size_t num_elements() const	{return surface() ? num_faces() : num_volumes();}
+
+		void position(double* pOut, size_t i, size_t j, size_t k) const
+		{
+			pOut[0] = m_extent[0] * double(i) / double(m_n[0]);
+			pOut[1] = m_extent[1] * double(j) / double(m_n[1]);
+			pOut[2] = m_extent[2] * double(k) / double(m_n[2]);
+		}
+
+	///	calls f(i, j, k) for all vertices, in the order of their indices
+		template <class TFunc> void for_each_vertex(TFunc& f) const;
+
+	///	calls f(indices, numIndices) for each element of the given dimension
+	/**	faces are oriented outwards on the boundary of the box and volumes
+	 * are positively oriented.*/
+		template <class TFunc> void for_each_edge(TFunc& f) const;
+		template <class TFunc> void for_each_face(TFunc& f) const;
+		template <class TFunc> void for_each_volume(TFunc& f) const;
+
+	private:
+		uint32_t vertex_index(const size_t* p) const;
+		uint32_t vertex_index(size_t i, size_t j, size_t k) const
+		{
+			const size_t p[3] = {i, j, k};
+			return vertex_index(p);
+		}
+
+	///	position of a boundary vertex (i, j) on the ring of an inner layer of a surface mesh
+		size_t ring_index(size_t i, size_t j) const;
+		void ring_position(size_t& iOut, size_t& jOut, size_t r) const;
+		size_t ring_size() const	{return 2 * (m_n[0] + m_n[1]);}
+		size_t plane_size() const	{return (m_n[0] + 1) * (m_n[1] + 1);}
+
+	///	calls f(q) for each quadrilateral q[4] of the grid, diagonal q[0]-q[2]
+		template <class TFunc> void for_each_quad(TFunc& f) const;
+		size_t num_quads() const;
+
+		MeshType	m_type;
+		size_t		m_n[3];
+		double		m_extent[3];
+};
+
+StructuredBox::
+StructuredBox(MeshType type, size_t numElements, const double extent[3]) :
+	m_type(type)
+{
+	for(int i = 0; i < 3; ++i)
+		m_extent[i] = extent[i];
+
+//	the number of cells per axis is proportional to the extent of the box
+	double s;
+	if(surface()){
+		const double numQuads = double(numElements) / (type == MT_TRI ? 2. : 1.);
+		const double area = extent[0] * extent[1] + extent[1] * extent[2]
+						  + extent[0] * extent[2];
+		s = sqrt(numQuads / (2. * area));
+	}
+	else{
+		const double numCells = double(numElements) / (type == MT_TET ? 6. : 1.);
+		s = cbrt(numCells / (extent[0] * extent[1] * extent[2]));
+	}
+
+	for(int i = 0; i < 3; ++i)
+		m_n[i] = max<size_t>(1, (size_t)llround(extent[i] * s));
+}
+
+size_t StructuredBox::
+num_vertices() const
+{
+	const size_t nx = m_n[0], ny = m_n[1], nz = m_n[2];
+	if(surface())
+		return 2 * plane_size() + (nz - 1) * ring_size();
+	return (nx + 1) * (ny + 1) * (nz + 1);
+}
+
+size_t StructuredBox::
+num_edges() const
+{
+	size_t numAxisEdges = 0;
+	for(int a = 0; a < 3; ++a){
+		const size_t nb = m_n[(a + 1) % 3], nc = m_n[(a + 2) % 3];
+		size_t numLines = (nb + 1) * (nc + 1);
+		if(surface())
+			numLines -= (nb - 1) * (nc - 1);
+		numAxisEdges += m_n[a] * numLines;
+	}
+
+	size_t numEdges = numAxisEdges;
+	if(simplicial())
+		numEdges += num_quads();
+	if(m_type == MT_TET)
+		numEdges += m_n[0] * m_n[1] * m_n[2];
+	return numEdges;
+}
+
+size_t StructuredBox::
+num_quads() const
+{
+	size_t numQuads = 0;
+	for(int a = 0; a < 3; ++a){
+		const size_t nb = m_n[(a + 1) % 3], nc = m_n[(a + 2) % 3];
+		numQuads += (surface() ? 2 : m_n[a] + 1) * nb * nc;
+	}
+	return numQuads;
+}
+
+size_t StructuredBox::
+num_faces() const
+{
+	const size_t numQuads = num_quads();
+	switch(m_type){
+		case MT_TET:	return 2 * numQuads + 6 * m_n[0] * m_n[1] * m_n[2];
+		case MT_TRI:	return 2 * numQuads;
+		default:		return numQuads;
+	}
+}
+
+size_t StructuredBox::
+num_volumes() const
+{
+	const size_t numCells = m_n[0] * m_n[1] * m_n[2];
+	switch(m_type){
+		case MT_TET:	return 6 * numCells;
+		case MT_HEX:	return numCells;
+		default:		return 0;
+	}
+}
+
+uint32_t StructuredBox::
+vertex_index(const size_t* p) const
+{
+	const size_t nx = m_n[0], ny = m_n[1], nz = m_n[2];
+	if(!surface())
+		return uint32_t((p[2] * (ny + 1) + p[1]) * (nx + 1) + p[0]);
+
+	if(p[2] == 0)
+		return uint32_t(p[1] * (nx + 1) + p[0]);
+	if(p[2] == nz)
+		return uint32_t(plane_size() + (nz - 1) * ring_size() + p[1] * (nx + 1) + p[0]);
+	return uint32_t(plane_size() + (p[2] - 1) * ring_size() + ring_index(p[0], p[1]));
+}
+
+size_t StructuredBox::
+ring_index(size_t i, size_t j) const
+{
+//	counterclockwise, starting at (0, 0)
+	const size_t nx = m_n[0], ny = m_n[1];
+	if(j == 0)
+		return i;
+	if(i == nx)
+		return nx + j;
+	if(j == ny)
+		return nx + ny + (nx - i);
+	return 2 * nx + ny + (ny - j);
+}
+
+void StructuredBox::
+ring_position(size_t& iOut, size_t& jOut, size_t r) const
+{
+	const size_t nx = m_n[0], ny = m_n[1];
+	if(r <= nx){
+		iOut = r; jOut = 0;
+	}
+	else if(r <= nx + ny){
+		iOut = nx; jOut = r - nx;
+	}
+	else if(r <= 2 * nx + ny){
+		iOut = 2 * nx + ny - r; jOut = ny;
+	}
+	else{
+		iOut = 0; jOut = 2 * nx + 2 * ny - r;
+	}
+}
+
+template <class TFunc>
+void StructuredBox::
+for_each_vertex(TFunc& f) const
+{
+	const size_t nx = m_n[0], ny = m_n[1], nz = m_n[2];
+	for(size_t k = 0; k <= nz; ++k){
+		if(surface() && k > 0 && k < nz){
+			for(size_t r = 0; r < ring_size(); ++r){
+				size_t i, j;
+				ring_position(i, j, r);
+				f(i, j, k);
+			}
+			continue;
+		}
+		for(size_t j = 0; j <= ny; ++j){
+			for(size_t i = 0; i <= nx; ++i)
+				f(i, j, k);
+		}
+	}
+}
+
+template <class TFunc>
+void StructuredBox::
+for_each_quad(TFunc& f) const
+{
+//	quadrilaterals normal to axis a span the axes b and c, so that the
+//	order p, p+e_b, p+e_b+e_c, p+e_c is oriented in direction of e_a
+	for(int a = 0; a < 3; ++a){
+		const int b = (a + 1) % 3, c = (a + 2) % 3;
+		for(size_t l = 0; l <= m_n[a]; ++l){
+			if(surface() && l > 0 && l < m_n[a])
+				continue;
+			for(size_t pc = 0; pc < m_n[c]; ++pc){
+				for(size_t pb = 0; pb < m_n[b]; ++pb){
+					size_t p[3];
+					p[a] = l; p[b] = pb; p[c] = pc;
+					uint32_t q[4];
+					q[0] = vertex_index(p);
+					++p[b];	q[1] = vertex_index(p);
+					++p[c];	q[2] = vertex_index(p);
+					--p[b];	q[3] = vertex_index(p);
+					if(l == 0)
+						swap(q[1], q[3]);
+					f(q);
+				}
+			}
+		}
+	}
+}
+
+///	forwards the diagonals of quadrilaterals as edges
+template <class TFunc>
+struct QuadDiagonals
+{
+	QuadDiagonals(TFunc& f) : func(f)	{}
+	void operator()(const uint32_t* q)
+	{
+		const uint32_t e[2] = {q[0], q[2]};
+		func(e, 2);
+	}
+	TFunc& func;
+};
+
+///	forwards quadrilaterals or the two triangles of each quadrilateral as faces
+template <class TFunc>
+struct QuadFaces
+{
+	QuadFaces(TFunc& f, bool triangulate) : func(f), tris(triangulate)	{}
+	void operator()(const uint32_t* q)
+	{
+		if(!tris){
+			func(q, 4);
+			return;
+		}
+		const uint32_t t0[3] = {q[0], q[1], q[2]};
+		const uint32_t t1[3] = {q[0], q[2], q[3]};
+		func(t0, 3);
+		func(t1, 3);
+	}
+	TFunc& func;
+	bool tris;
+};
+
+template <class TFunc>
+void StructuredBox::
+for_each_edge(TFunc& f) const
+{
+	for(int a = 0; a < 3; ++a){
+		const int b = (a + 1) % 3, c = (a + 2) % 3;
+		for(size_t pc = 0; pc <= m_n[c]; ++pc){
+			for(size_t pb = 0; pb <= m_n[b]; ++pb){
+				if(surface() && pb > 0 && pb < m_n[b] && pc > 0 && pc < m_n[c])
+					continue;
+				for(size_t pa = 0; pa < m_n[a]; ++pa){
+					size_t p[3];
+					p[a] = pa; p[b] = pb; p[c] = pc;
+					uint32_t e[2];
+					e[0] = vertex_index(p);
+					++p[a];	e[1] = vertex_index(p);
+					f(e, 2);
+				}
+			}
+		}
+	}
+
+	if(simplicial()){
+		QuadDiagonals<TFunc> diagonals(f);
+		for_each_quad(diagonals);
+	}
+
+	if(m_type == MT_TET){
+		for(size_t k = 0; k < m_n[2]; ++k){
+			for(size_t j = 0; j < m_n[1]; ++j){
+				for(size_t i = 0; i < m_n[0]; ++i){
+					const uint32_t e[2] = {vertex_index(i, j, k), vertex_index(i + 1, j + 1, k + 1)};
+					f(e, 2);
+				}
+			}
+		}
+	}
+}
+
+template <class TFunc>
+void StructuredBox::
+for_each_face(TFunc& f) const
+{
+	QuadFaces<TFunc> quadFaces(f, simplicial());
+	for_each_quad(quadFaces);
+
+	if(m_type != MT_TET)
+		return;
+
+//	the inner triangles of a cell contain its diagonal c[0]-c[6]
+	const int innerCorners[6] = {1, 2, 3, 4, 5, 7};
+	for(size_t k = 0; k < m_n[2]; ++k){
+		for(size_t j = 0; j < m_n[1]; ++j){
+			for(size_t i = 0; i < m_n[0]; ++i){
+				const uint32_t c[8] = {vertex_index(i, j, k), vertex_index(i+1, j, k),
+									   vertex_index(i+1, j+1, k), vertex_index(i, j+1, k),
+									   vertex_index(i, j, k+1), vertex_index(i+1, j, k+1),
+									   vertex_index(i+1, j+1, k+1), vertex_index(i, j+1, k+1)};
+				for(int t = 0; t < 6; ++t){
+					const uint32_t tri[3] = {c[0], c[innerCorners[t]], c[6]};
+					f(tri, 3);
+				}
+			}
+		}
+	}
+}
+
+template <class TFunc>
+void StructuredBox::
+for_each_volume(TFunc& f) const
+{
+	if(surface())
+		return;
+
+//	Kuhn subdivision, see topology_benchmark.cpp. Paths which are odd
+//	permutations of the axes are flipped to keep the orientation positive.
+	const int paths[6][2] = {{1, 2}, {1, 5}, {3, 2}, {3, 7}, {4, 5}, {4, 7}};
+	const bool odd[6] = {false, true, true, false, false, true};
+
+	for(size_t k = 0; k < m_n[2]; ++k){
+		for(size_t j = 0; j < m_n[1]; ++j){
+			for(size_t i = 0; i < m_n[0]; ++i){
+				const uint32_t c[8] = {vertex_index(i, j, k), vertex_index(i+1, j, k),
+									   vertex_index(i+1, j+1, k), vertex_index(i, j+1, k),
+									   vertex_index(i, j, k+1), vertex_index(i+1, j, k+1),
+									   vertex_index(i+1, j+1, k+1), vertex_index(i, j+1, k+1)};
+				if(m_type == MT_HEX){
+					f(c, 8);
+					continue;
+				}
+				for(int t = 0; t < 6; ++t){
+					uint32_t tet[4] = {c[0], c[paths[t][0]], c[paths[t][1]], c[6]};
+					if(odd[t])
+						swap(tet[1], tet[2]);
+					f(tet, 4);
+				}
+			}
+		}
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+const double PI = 3.14159265358979323846;
+
+///	analytic bending modes of a beam along the x-axis of the box
+/**	Each mode bends the box in y- or z-direction with a number of half waves
+ * along x. Cross sections rotate with the slope of the bending line, so that
+ * the displacement varies across the whole mesh. As for beams, eigenvalues
+ * grow with the fourth power of the wave number and the square of the
+ * thickness in bending direction. Modes are sorted by their eigenvalues.*/
+class SyntheticModes
+{
+	public:
+		SyntheticModes(const StructuredBox& box, int numModes)
+		{
+			for(int i = 0; i < 3; ++i)
+				m_extent[i] = box.extent(i);
+			m_amplitude = 0.1 * m_extent[0];
+
+		//	the first numModes of both directions contain the first numModes modes
+			for(int w = 1; w <= numModes; ++w){
+				for(int dir = 1; dir < 3; ++dir){
+					const double t = m_extent[dir] / m_extent[1];
+					Shape s;
+					s.waveNumber = w * PI / m_extent[0];
+					s.dir = dir;
+					s.eigenvalue = 2e4 * w * w * w * w * t * t;
+					m_shapes.push_back(s);
+				}
+			}
+			stable_sort(m_shapes.begin(), m_shapes.end());
+			m_shapes.resize(numModes);
+		}
+
+		int num_modes() const	{return (int)m_shapes.size();}
+
+		void displacement(double* uOut, const double* p, int mode) const
+		{
+			const Shape& s = m_shapes[mode];
+			const double h = p[s.dir] - 0.5 * m_extent[s.dir];
+			uOut[0] = -m_amplitude * s.waveNumber * h * cos(s.waveNumber * p[0]);
+			uOut[1] = uOut[2] = 0;
+			uOut[s.dir] = m_amplitude * sin(s.waveNumber * p[0]);
+		}
+
+		double eigenvalue(int mode) const	{return m_shapes[mode].eigenvalue;}
+
+	///	frequency in Hz, as ug computes it from the eigenvalue
+		double frequency(int mode) const
+		{
+			return sqrt(eigenvalue(mode) / DENSITY) / (2. * PI);
+		}
+
+	private:
+		struct Shape
+		{
+			double	waveNumber;
+			int		dir;
+			double	eigenvalue;
+			bool operator<(const Shape& s) const	{return eigenvalue < s.eigenvalue;}
+		};
+
+		double			m_extent[3];
+		double			m_amplitude;
+		vector<Shape>	m_shapes;
+};
+
+///	a linear combination of modes, which is added to the positions of the box
+struct ModeMix
+{
+	ModeMix()	{}
+	ModeMix(int mode, double weight)	{add(mode, weight);}
+
+	void add(int mode, double weight)
+	{
+		modes.push_back(mode);
+		weights.push_back(weight);
+	}
+
+	vector<int>		modes;
+	vector<double>	weights;
+};
+
+void Displacement(double* uOut, const double* p, const SyntheticModes& sm, const ModeMix& mix)
+{
+	uOut[0] = uOut[1] = uOut[2] = 0;
+	for(size_t i = 0; i < mix.modes.size(); ++i){
+		double u[3];
+		sm.displacement(u, p, mix.modes[i]);
+		for(int j = 0; j < 3; ++j)
+			uOut[j] += mix.weights[i] * u[j];
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//	ugx output
+
+///	computes the bounding box of the displaced vertices
+struct BoundingBoxCollector
+{
+	BoundingBoxCollector(const StructuredBox& b, const SyntheticModes& s,
+						 const ModeMix& m, UGXMetadata& meta) :
+		box(b), sm(s), mix(m), md(meta), first(true)	{}
+
+	void operator()(size_t i, size_t j, size_t k)
+	{
+		double p[3], u[3];
+		box.position(p, i, j, k);
+		Displacement(u, p, sm, mix);
+		for(int l = 0; l < 3; ++l){
+			const double v = p[l] + u[l];
+			if(first || v < md.bbox_min[l]) md.bbox_min[l] = v;
+			if(first || v > md.bbox_max[l]) md.bbox_max[l] = v;
+		}
+		first = false;
+	}
+
+	const StructuredBox&	box;
+	const SyntheticModes&	sm;
+	const ModeMix&			mix;
+	UGXMetadata&			md;
+	bool					first;
+};
+
+///	streams the displaced vertices to a ugx file
+struct UGXVertexWriter
+{
+	UGXVertexWriter(const StructuredBox& b, const SyntheticModes& s,
+					const ModeMix& m, UGXStreamWriter& o) :
+		box(b), sm(s), mix(m), out(o)	{buf.reserve(3 << 12);}
+
+	void operator()(size_t i, size_t j, size_t k)
+	{
+		double p[3], u[3];
+		box.position(p, i, j, k);
+		Displacement(u, p, sm, mix);
+		for(int l = 0; l < 3; ++l)
+			buf.push_back(p[l] + u[l]);
+		if(buf.size() == buf.capacity())
+			flush();
+	}
+
+	void flush()
+	{
+		if(!buf.empty())
+			out.append_vertices(&buf.front(), buf.size());
+		buf.clear();
+	}
+
+	const StructuredBox&	box;
+	const SyntheticModes&	sm;
+	const ModeMix&			mix;
+	UGXStreamWriter&		out;
+	vector<double>			buf;
+};
+
+///	streams element indices to a ugx file
+struct UGXIndexWriter
+{
+	UGXIndexWriter(UGXStreamWriter& o) : out(o)	{buf.reserve(1 << 14);}
+
+	void operator()(const uint32_t* ind, int num)
+	{
+		if(buf.size() + num > buf.capacity())
+			flush();
+		buf.insert(buf.end(), ind, ind + num);
+	}
+
+	void flush()
+	{
+		if(!buf.empty())
+			out.append_indices(&buf.front(), buf.size());
+		buf.clear();
+	}
+
+	UGXStreamWriter&	out;
+	vector<uint32_t>	buf;
+};
+
+bool WriteUGX(const string& filename, const StructuredBox& box, const SyntheticModes& sm,
+			  const ModeMix& mix, bool binary)
+{
+	UGXStreamWriter out(filename, binary);
+	if(!out.good()){
+		cerr << "could not open " << filename << endl;
+		return false;
+	}
+
+	UGXMetadata meta;
+	meta.num_vertices = box.num_vertices();
+	meta.num_edges = box.num_edges();
+	meta.num_faces = box.num_faces();
+	meta.num_volumes = box.num_volumes();
+	meta.has_bbox = true;
+	meta.subset_names.push_back("Inner");
+	BoundingBoxCollector bbox(box, sm, mix, meta);
+	box.for_each_vertex(bbox);
+
+	out.begin_grid();
+	out.write_metadata(meta);
+
+	out.begin_vertices(3);
+	UGXVertexWriter vrtWriter(box, sm, mix, out);
+	box.for_each_vertex(vrtWriter);
+	vrtWriter.flush();
+	out.end_vertices();
+
+	UGXIndexWriter indWriter(out);
+
+	out.begin_indices("edges");
+	box.for_each_edge(indWriter);
+	indWriter.flush();
+	out.end_indices("edges");
+
+	const char* faceTag = box.simplicial() ? "triangles" : "quadrilaterals";
+	out.begin_indices(faceTag);
+	box.for_each_face(indWriter);
+	indWriter.flush();
+	out.end_indices(faceTag);
+
+	if(box.num_volumes() > 0){
+		const char* volTag = box.type() == MT_TET ? "tetrahedrons" : "hexahedrons";
+		out.begin_indices(volTag);
+		box.for_each_volume(indWriter);
+		indWriter.flush();
+		out.end_indices(volTag);
+	}
+
+//	a single subset, as written by the vtu to ugx converter
+	const float color[] = {0, 0, 0, 1};
+	out.begin_subset_handler("defSH");
+	out.begin_subset("Inner", color, 393216);
+	out.write_subset_range("vertices", 0, meta.num_vertices);
+	out.write_subset_range("edges", 0, meta.num_edges);
+	out.write_subset_range("faces", 0, meta.num_faces);
+	out.write_subset_range("volumes", 0, meta.num_volumes);
+	out.end_subset();
+	out.end_subset_handler();
+
+	out.end_grid();
+	if(!out.close()){
+		cerr << "could not write " << filename << endl;
+		return false;
+	}
+	return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//	vtu output
+
+///	writes the values of an ascii DataArray, six per line as paraview does
+class VTUValueWriter
+{
+	public:
+		VTUValueWriter(FILE* file) : m_file(file), m_num(0)	{}
+		~VTUValueWriter()	{end();}
+
+		void put_float(double v)
+		{
+			begin_value();
+			fprintf(m_file, "%.9g", v);
+		}
+
+		void put_uint(uint64_t v)
+		{
+			begin_value();
+			fprintf(m_file, "%llu", (unsigned long long)v);
+		}
+
+		void end()
+		{
+			if(m_num > 0)
+				fputc('\n', m_file);
+			m_num = 0;
+		}
+
+	private:
+		void begin_value()
+		{
+			if(m_num == 6){
+				fputc('\n', m_file);
+				m_num = 0;
+			}
+			fputs(m_num == 0 ? "          " : " ", m_file);
+			++m_num;
+		}
+
+		FILE*	m_file;
+		int		m_num;
+};
+
+struct VTUDisplacementWriter
+{
+	VTUDisplacementWriter(const StructuredBox& b, const SyntheticModes& s,
+						  const ModeMix& m, VTUValueWriter& o) :
+		box(b), sm(s), mix(m), out(o)	{}
+
+	void operator()(size_t i, size_t j, size_t k)
+	{
+		double p[3], u[3];
+		box.position(p, i, j, k);
+		Displacement(u, p, sm, mix);
+		for(int l = 0; l < 3; ++l)
+			out.put_float(u[l]);
+	}
+
+	const StructuredBox&	box;
+	const SyntheticModes&	sm;
+	const ModeMix&			mix;
+	VTUValueWriter&			out;
+};
+
+struct VTUPointWriter
+{
+	VTUPointWriter(const StructuredBox& b, VTUValueWriter& o) : box(b), out(o)	{}
+
+	void operator()(size_t i, size_t j, size_t k)
+	{
+		double p[3];
+		box.position(p, i, j, k);
+		for(int l = 0; l < 3; ++l)
+			out.put_float(p[l]);
+	}
+
+	const StructuredBox&	box;
+	VTUValueWriter&			out;
+};
+
+///	writes connectivity, offsets or types of the cells
+struct VTUCellWriter
+{
+	enum Column {CONNECTIVITY, OFFSETS, TYPES};
+
+	VTUCellWriter(Column c, bool surf, VTUValueWriter& o) :
+		column(c), surface(surf), out(o), offset(0)	{}
+
+	void operator()(const uint32_t* ind, int num)
+	{
+		offset += num;
+		switch(column){
+			case CONNECTIVITY:
+				for(int i = 0; i < num; ++i)
+					out.put_uint(ind[i]);
+				break;
+			case OFFSETS:
+				out.put_uint(offset);
+				break;
+			case TYPES:
+				switch(num){
+					case 3:	out.put_uint(VTK_CELL_TRIANGLE); break;
+					case 4:	out.put_uint(surface ? VTK_CELL_QUAD : VTK_CELL_TETRA); break;
+					case 8:	out.put_uint(VTK_CELL_HEXAHEDRON); break;
+				}
+				break;
+		}
+	}
+
+	Column			column;
+	bool			surface;
+	VTUValueWriter&	out;
+	uint64_t		offset;
+};
+
+///	writes the rest positions and the displacements of mix as ascii vtu file
+/**	The cells are the elements of highest dimension. The layout follows the
+ * ascii files in debug_examples, so that PARSE and the vtu readers accept it.*/
+bool WriteVTU(const string& filename, const StructuredBox& box, const SyntheticModes& sm,
+			  const ModeMix& mix)
+{
+	FILE* file = fopen(filename.c_str(), "wb");
+	if(!file){
+		cerr << "could not open " << filename << endl;
+		return false;
+	}
+	vector<char> fileBuf(1 << 20);
+	setvbuf(file, &fileBuf.front(), _IOFBF, fileBuf.size());
+
+	fprintf(file, "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"LittleEndian\" header_type=\"UInt64\">\n"
+				  "  <UnstructuredGrid>\n"
+				  "    <Piece NumberOfPoints=\"%llu\" NumberOfCells=\"%llu\">\n"
+				  "      <PointData>\n"
+				  "        <DataArray type=\"Float32\" Name=\"displacement\" NumberOfComponents=\"3\" format=\"ascii\">\n",
+			(unsigned long long)box.num_vertices(), (unsigned long long)box.num_elements());
+	{
+		VTUValueWriter values(file);
+		VTUDisplacementWriter w(box, sm, mix, values);
+		box.for_each_vertex(w);
+	}
+	fprintf(file, "        </DataArray>\n"
+				  "      </PointData>\n"
+				  "      <CellData>\n"
+				  "      </CellData>\n"
+				  "      <Points>\n"
+				  "        <DataArray type=\"Float32\" Name=\"Points\" NumberOfComponents=\"3\" format=\"ascii\">\n");
+	{
+		VTUValueWriter values(file);
+		VTUPointWriter w(box, values);
+		box.for_each_vertex(w);
+	}
+	fprintf(file, "        </DataArray>\n"
+				  "      </Points>\n"
+				  "      <Cells>\n");
+
+	const char* headers[3] = {
+		"        <DataArray type=\"Int64\" Name=\"connectivity\" format=\"ascii\">\n",
+		"        <DataArray type=\"Int64\" Name=\"offsets\" format=\"ascii\">\n",
+		"        <DataArray type=\"UInt8\" Name=\"types\" format=\"ascii\">\n"};
+	for(int c = 0; c < 3; ++c){
+		fputs(headers[c], file);
+		{
+			VTUValueWriter values(file);
+			VTUCellWriter w((VTUCellWriter::Column)c, box.surface(), values);
+			if(box.surface())
+				box.for_each_face(w);
+			else
+				box.for_each_volume(w);
+		}
+		fputs("        </DataArray>\n", file);
+	}
+
+	fprintf(file, "      </Cells>\n"
+				  "    </Piece>\n"
+				  "  </UnstructuredGrid>\n"
+				  "</VTKFile>\n");
+
+	const bool ok = !ferror(file);
+	fclose(file);
+	return ok;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//	synthetic PINVIT run
+
+///	convergence history of a synthetic PINVIT run
+/**	The defects of all eigenpairs decrease geometrically from about 10^10 in
+ * iteration 0 to half the precision in the last iteration. The relative
+ * error of an iterate is its defect relative to the initial defect.*/
+class PINVITRun
+{
+	public:
+		PINVITRun(const SyntheticModes& sm, int numEvs, int numIterations, double precision) :
+			m_sm(sm), m_numEvs(numEvs), m_numIterations(max(numIterations, 2)), m_precision(precision)
+		{}
+
+		int num_evs() const			{return m_numEvs;}
+		int num_iterations() const	{return m_numIterations;}
+		double precision() const	{return m_precision;}
+
+		double defect(int it, int ev) const
+		{
+			const double d0 = initial_defect(ev);
+			const double q = pow(0.5 * m_precision / d0, 1. / (m_numIterations - 1));
+			return d0 * pow(q, it);
+		}
+
+		double relative_error(int it, int ev) const
+		{
+			return defect(it, ev) / initial_defect(ev);
+		}
+
+		double lambda(int it, int ev) const
+		{
+			if(it == 0)
+				return 4.7e10 * (1. + 0.02 * ev);
+			return m_sm.eigenvalue(ev) * (1. + 10. * relative_error(it, ev));
+		}
+
+	///	iterate of eigenvector ev: the mode, polluted by the shape of mode ev+num_evs
+		ModeMix iterate(int it, int ev) const
+		{
+			const double e = relative_error(it, ev);
+			ModeMix mix(ev, 1. - e);
+			mix.add(ev + m_numEvs, e);
+			return mix;
+		}
+
+		ModeMix defect_shape(int it, int ev) const
+		{
+			return ModeMix(ev + m_numEvs, relative_error(it, ev));
+		}
+
+	///	difference between the iterates it+1 and it
+		ModeMix correction(int it, int ev) const
+		{
+			const double de = relative_error(it, ev) - relative_error(it + 1, ev);
+			ModeMix mix(ev, de);
+			mix.add(ev + m_numEvs, -de);
+			return mix;
+		}
+
+	private:
+		double initial_defect(int ev) const	{return 1e10 * (0.95 + 0.01 * ev);}
+
+		const SyntheticModes&	m_sm;
+		int						m_numEvs;
+		int						m_numIterations;
+		double					m_precision;
+};
+
+///	writes a log in the format of ugshell's PINVIT output, as read by UG_LogParser
+/**	The durations are the times which the generator took to write the
+ * geometry (assembly) and the mode shapes (solver).*/
+bool WritePINVITLog(const string& filename, const string& gridName, const StructuredBox& box,
+					const SyntheticModes& sm, const PINVITRun& run,
+					double timeAssembly, double timeSolver)
+{
+	FILE* file = fopen(filename.c_str(), "wb");
+	if(!file){
+		cerr << "could not open " << filename << endl;
+		return false;
+	}
+
+	const int numEvs = run.num_evs();
+
+	fprintf(file,
+		"********************************************************************************\n"
+		"* synthetic PINVIT log, written by emvis_dataset_generator                     *\n"
+		"********************************************************************************\n"
+		" General parameters chosen:\n"
+		"    grid       = %s\n"
+		"    numRefs    = 0\n"
+		"    numPreRefs = 0\n"
+		"    numProcs   = 1\n"
+		"    material   = Iron\n"
+		"  evIterations = 100\n"
+		"  evPrec = %g\n"
+		"\n"
+		" Number of DoFs: %llu (Block 3)\n"
+		"Assemble Mass Matrix\n"
+		"Assemble Stiffness Matrix\n"
+		"PINVIT Eigensolver by Martin Rupp / G-CSC 2013-2015.\n"
+		" MaxIterations = 100\n"
+		" Precision = %g (absolute) \n"
+		" MinimumDefectToCalcCorrection = %g\n"
+		" Number of EV = %d\n"
+		" PINVIT = 2 = Preconditioned Block Gradient Method\n"
+		" Preconditioner: \n"
+		" | GeometricMultigrid (V-Cycle)\n"
+		" |  Smoother (3x pre, 3x post): Symmetric Gauss-Seidel( damping = ConstantDamping(1))\n"
+		" |  Basesolver ( Baselevel = 0, gathered base = true): \n"
+		" |  # LU Decomposition: Direct Solver for Linear Equation Systems.\n"
+		" |  #  Minimum Entries for Sparse LU: 4000\n"
+		"\n"
+		"\tAdditionaly storing %d eigenvectors\n"
+		"\n"
+		"Initializing... done.\n"
+		"PINVIT: Initializing preconditioner... done.\n",
+		gridName.c_str(), run.precision(), (unsigned long long)(3 * box.num_vertices()),
+		run.precision(), run.precision(), numEvs, max(numEvs - 2, 0));
+
+	for(int it = 0; it < run.num_iterations(); ++it){
+		fprintf(file, "=====================================================================================\n"
+					  "iteration %d\n", it);
+		for(int ev = 0; ev < numEvs; ++ev){
+			fprintf(file, "%d lambda: %14g defect: %14g", ev, run.lambda(it, ev), run.defect(it, ev));
+			if(it > 0)
+				fprintf(file, " reduction: %14g", run.relative_error(it, ev));
+			fputc('\n', file);
+		}
+		fputc('\n', file);
+	}
+
+	fprintf(file, "all eigenvectors converged\n"
+				  "Eigenvalues\n"
+				  "calculated frequencies:\n"
+				  "-----------------------------------------------------\n"
+				  "density: %g\n", DENSITY);
+	for(int ev = 0; ev < numEvs; ++ev)
+		fprintf(file, "Eigenvalue %d = %.14g = %.14g Hz\n", ev + 1, sm.eigenvalue(ev), sm.frequency(ev));
+
+	fprintf(file, "\n"
+				  "duration assembly: %.14gs\n"
+				  "duration solver: %.14gs\n"
+				  "duration total: %.14gs\n",
+			timeAssembly, timeSolver, timeAssembly + timeSolver);
+
+	const bool ok = !ferror(file);
+	fclose(file);
+	return ok;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//	datasets
+
+struct GeneratorOptions
+{
+	GeneratorOptions() :
+		type(MT_TET), numModes(10), numIterations(12), precision(0.001),
+		layout("eigenmodes"), debug(true), vtu(false), binary(false), outDir("synthetic")
+	{
+		extent[0] = 4; extent[1] = 1; extent[2] = 1;
+	}
+
+	MeshType		type;
+	vector<size_t>	numElements;
+	double			extent[3];
+	int				numModes;
+	int				numIterations;
+	double			precision;
+	string			layout;
+	bool			debug;
+	bool			vtu;
+	bool			binary;
+	string			outDir;
+};
+
+typedef chrono::steady_clock	GeneratorClock;
+
+double ElapsedSeconds(const GeneratorClock::time_point& start)
+{
+	return chrono::duration<double>(GeneratorClock::now() - start).count();
+}
+
+///	writes grid files and keeps track of their number and size
+class DatasetWriter
+{
+	public:
+		DatasetWriter(const GeneratorOptions& opts, const StructuredBox& box,
+					  const SyntheticModes& sm) :
+			m_opts(opts), m_box(box), m_sm(sm), m_numFiles(0), m_numBytes(0), m_ok(true)	{}
+
+	///	writes filename.ugx(c) and, if requested, the vtu file with the same stem
+		void write_grid(const string& stem, const string& ugxSuffix, const ModeMix& mix,
+						bool withVTU)
+		{
+			write_file(stem + ugxSuffix, mix, false);
+			if(withVTU && m_opts.vtu)
+				write_file(stem + ".vtu", mix, true);
+		}
+
+		void add_file(const string& filename)
+		{
+			++m_numFiles;
+			m_numBytes += fs::file_size(filename);
+		}
+
+		size_t num_files() const	{return m_numFiles;}
+		uintmax_t num_bytes() const	{return m_numBytes;}
+		bool ok() const				{return m_ok;}
+
+	private:
+		void write_file(const string& filename, const ModeMix& mix, bool vtu)
+		{
+			cerr << "  writing " << filename << endl;
+			const bool ok = vtu ? WriteVTU(filename, m_box, m_sm, mix)
+								: WriteUGX(filename, m_box, m_sm, mix, m_opts.binary);
+			if(ok)
+				add_file(filename);
+			m_ok = m_ok && ok;
+		}
+
+		const GeneratorOptions&	m_opts;
+		const StructuredBox&	m_box;
+		const SyntheticModes&	m_sm;
+		size_t					m_numFiles;
+		uintmax_t				m_numBytes;
+		bool					m_ok;
+};
+
+///	A.ugx, ev_i.ugxc and metadata.txt, as in examples/eigenmodes
+bool WriteEigenmodesLayout(DatasetWriter& writer, const string& dir,
+						   const GeneratorOptions& opts, const SyntheticModes& sm)
+{
+	writer.write_grid(dir + "/A", ".ugx", ModeMix(), false);
+
+	const string metaFile = dir + "/metadata.txt";
+	FILE* meta = fopen(metaFile.c_str(), "wb");
+	if(!meta){
+		cerr << "could not open " << metaFile << endl;
+		return false;
+	}
+	fprintf(meta, "A.ugx\n");
+
+	for(int i = 0; i < opts.numModes; ++i){
+		const string name = "ev_" + to_string(i + 1);
+		writer.write_grid(dir + "/" + name, ".ugxc", ModeMix(i, 1.), true);
+		fprintf(meta, "%s.ugxc %.14g 1.0\n", name.c_str(), sm.frequency(i));
+	}
+	fclose(meta);
+	writer.add_file(metaFile);
+	return writer.ok();
+}
+
+///	log.txt, solutions/ and debug/, as in debug_examples
+bool WriteDatasetLayout(DatasetWriter& writer, const string& dir, const GeneratorOptions& opts,
+						const StructuredBox& box, const SyntheticModes& sm)
+{
+	const string solDir = dir + "/solutions";
+	const string debugDir = dir + "/debug";
+	fs::create_directories(solDir);
+
+//	EmVis only reads the geometry of the first solution
+	GeneratorClock::time_point start = GeneratorClock::now();
+	writer.write_grid(solDir + "/ev_1_ascii", ".ugx", ModeMix(), false);
+	const double timeAssembly = ElapsedSeconds(start);
+
+	start = GeneratorClock::now();
+	for(int i = 0; i < opts.numModes; ++i)
+		writer.write_grid(solDir + "/ev_" + to_string(i + 1) + "_ascii", ".ugxc", ModeMix(i, 1.), true);
+
+	PINVITRun run(sm, opts.numModes, opts.numIterations, opts.precision);
+
+//	EmVis expects the iterates of all but the last iteration, eigenvectors are counted from 0
+	if(opts.debug){
+		fs::create_directories(debugDir);
+		for(int it = 0; it + 1 < run.num_iterations(); ++it){
+			for(int ev = 0; ev < run.num_evs(); ++ev){
+				const string prefix = debugDir + "/pinvit_it_" + to_string(it);
+				const string suffix = "_" + to_string(ev) + "_ascii";
+				writer.write_grid(prefix + "_ev" + suffix, ".ugxc", run.iterate(it, ev), true);
+				writer.write_grid(prefix + "_defect" + suffix, ".ugxc", run.defect_shape(it, ev), true);
+				writer.write_grid(prefix + "_corr" + suffix, ".ugxc", run.correction(it, ev), true);
+			}
+		}
+	}
+	const double timeSolver = ElapsedSeconds(start);
+
+	const string logFile = dir + "/log.txt";
+	const string gridName = string("synthetic_") + MeshTypeName(opts.type) + "_"
+						  + to_string(box.num_elements()) + ".ugx";
+	if(!WritePINVITLog(logFile, gridName, box, sm, run, timeAssembly, timeSolver))
+		return false;
+	writer.add_file(logFile);
+	return writer.ok();
+}
+
+bool GenerateDataset(const GeneratorOptions& opts, size_t numElements, const string& dir)
+{
+	StructuredBox box(opts.type, numElements, opts.extent);
+	if(box.num_vertices() > 0xFFFFFFFFull){
+		cerr << "too many vertices for 32 bit indices: " << box.num_vertices() << endl;
+		return false;
+	}
+
+	cerr << "generating " << dir << endl;
+	fs::create_directories(dir);
+
+	GeneratorClock::time_point start = GeneratorClock::now();
+//	the iterates of the dataset layout are polluted by the next numModes modes
+	SyntheticModes sm(box, 2 * opts.numModes);
+	DatasetWriter writer(opts, box, sm);
+	bool ok;
+	if(opts.layout == "dataset")
+		ok = WriteDatasetLayout(writer, dir, opts, box, sm);
+	else
+		ok = WriteEigenmodesLayout(writer, dir, opts, sm);
+
+	cout << MeshTypeName(opts.type) << " " << box.num_elements() << " elements ("
+		 << box.num_cells(0) << "x" << box.num_cells(1) << "x" << box.num_cells(2) << " cells): "
+		 << box.num_vertices() << " vertices, " << box.num_edges() << " edges, "
+		 << box.num_faces() << " faces, " << box.num_volumes() << " volumes; "
+		 << writer.num_files() << " files, " << writer.num_bytes() / 1e6 << " MB in "
+		 << ElapsedSeconds(start) << " s -> " << dir << endl;
+	return ok;
+}
+
+///	parses a comma separated list of counts like 1e4,1e5,2e6
+bool ParseCounts(vector<size_t>& countsOut, const string& str)
+{
+	stringstream ss(str);
+	string item;
+	while(getline(ss, item, ',')){
+		const double v = atof(item.c_str());
+		if(v < 1)
+			return false;
+		countsOut.push_back((size_t)llround(v));
+	}
+	return !countsOut.empty();
+}
+
+void PrintHelp()
+{
+	cout << "usage: emvis_dataset_generator [options]\n"
+			"  -type t          tet, hex (volume meshes), tri or quad (surface meshes), default tet\n"
+			"  -elements n,...  approximate number of volumes (tet, hex) or faces (tri, quad),\n"
+			"                   e.g. 1e4,1e5,1e6. Each count gets a subdirectory of -out\n"
+			"                   if more than one is given. Default 1e5\n"
+			"  -extent x y z    extent of the box, the modes bend it along x. Default 4 1 1\n"
+			"  -modes n         number of mode shapes, default 10\n"
+			"  -layout l        eigenmodes (A.ugx, ev_i.ugxc, metadata.txt) or\n"
+			"                   dataset (log.txt, solutions/, debug/), default eigenmodes\n"
+			"  -iterations n    number of PINVIT iterations of the dataset layout, default 12\n"
+			"  -nodebug         do not write the debug/ tree of the dataset layout\n"
+			"  -vtu             also write an ascii .vtu file for each mode shape\n"
+			"  -binary          write base64 encoded vertices and elements\n"
+			"  -out dir         output directory, default synthetic\n";
+}
+
+}// end of anonymous namespace
+
+
+int main(int argc, char** argv)
+{
+	GeneratorOptions opts;
+
+	for(int i = 1; i < argc; ++i){
+		const string arg = argv[i];
+		if(arg == "-type" && i + 1 < argc){
+			const string t = argv[++i];
+			if(t == "tet")			opts.type = MT_TET;
+			else if(t == "hex")		opts.type = MT_HEX;
+			else if(t == "tri")		opts.type = MT_TRI;
+			else if(t == "quad")	opts.type = MT_QUAD;
+			else{
+				cerr << "unknown mesh type: " << t << endl;
+				return 1;
+			}
+		}
+		else if(arg == "-elements" && i + 1 < argc){
+			if(!ParseCounts(opts.numElements, argv[++i])){
+				cerr << "bad element counts: " << argv[i] << endl;
+				return 1;
+			}
+		}
+		else if(arg == "-extent" && i + 3 < argc){
+			for(int j = 0; j < 3; ++j)
+				opts.extent[j] = atof(argv[++i]);
+			if(!(opts.extent[0] > 0 && opts.extent[1] > 0 && opts.extent[2] > 0)){
+				cerr << "the extent has to be positive" << endl;
+				return 1;
+			}
+		}
+		else if(arg == "-modes" && i + 1 < argc)
+			opts.numModes = max(1, atoi(argv[++i]));
+		else if(arg == "-layout" && i + 1 < argc){
+			opts.layout = argv[++i];
+			if(opts.layout != "eigenmodes" && opts.layout != "dataset"){
+				cerr << "unknown layout: " << opts.layout << endl;
+				return 1;
+			}
+		}
+		else if(arg == "-iterations" && i + 1 < argc)
+			opts.numIterations = max(2, atoi(argv[++i]));
+		else if(arg == "-nodebug")
+			opts.debug = false;
+		else if(arg == "-vtu")
+			opts.vtu = true;
+		else if(arg == "-binary")
+			opts.binary = true;
+		else if(arg == "-out" && i + 1 < argc)
+			opts.outDir = argv[++i];
+		else if(arg == "-help"){
+			PrintHelp();
+			return 0;
+		}
+		else{
+			cerr << "unknown option: " << arg << endl;
+			PrintHelp();
+			return 1;
+		}
+	}
+
+	if(opts.numElements.empty())
+		opts.numElements.push_back(100000);
+
+	bool ok = true;
+	for(size_t i = 0; i < opts.numElements.size(); ++i){
+		string dir = opts.outDir;
+		if(opts.numElements.size() > 1)
+			dir += string("/") + MeshTypeName(opts.type) + "_" + to_string(opts.numElements[i]);
+		ok = GenerateDataset(opts, opts.numElements[i], dir) && ok;
+	}
+	return ok ? 0 : 1;
+}
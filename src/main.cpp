@@ -38,6 +38,7 @@
 #include "common/util/path_provider.h"
 #include "common/util/plugin_util.h"
 #include "util/file_util.h"
+#include "util/trace_recorder.h"
 //TESTING
 #include <QDialog>
 #include <QVBoxLayout>
@@ -99,6 +100,8 @@ int main(int argc, char *argv[])
     	WriteToFileInUserDataDir ("promesh_home", app::AppDir().path());
     }
 
+	string traceFile;
+
     {
     //	no-gui script processing
 	    ArgTool args(argc, (const char**) argv);
@@ -112,6 +115,10 @@ int main(int argc, char *argv[])
 									"will be saved to this file.\n"
 									"Only relevant if '-script ...' is specified.");
 
+		traceFile = args.get_string ("--trace", "",
+									"(filename): Records load and render timelines from startup on\n"
+									"and writes them as Chrome trace to the given file on exit.");
+
 		if(args.has_param ("-help", "Prints help on command line usage")){
 			cout << "Command line options for ProMesh.\n\n";
 			cout << args.get_help() << endl;
@@ -121,6 +128,10 @@ int main(int argc, char *argv[])
 
     cout.sync_with_stdio(true);
 
+	TraceRecorder::instance().set_thread_name("gui");
+	if(!traceFile.empty())
+		TraceRecorder::instance().start();
+
 
 	QString qss = GetFileContent(":/styles/emvis_style.css");
 	QString varsStr = GetFileContent(":/styles/dark_theme_variables.txt");
@@ -185,5 +196,15 @@ int main(int argc, char *argv[])
 		UG_SET_DEBUG_LEVEL(ug::LIB_GRID, 1);
 	#endif
 
-	return myApp.exec();
+	int retVal = myApp.exec();
+
+	if(!traceFile.empty()){
+		TraceRecorder::instance().stop();
+		if(TraceRecorder::instance().write_chrome_trace(traceFile))
+			cout << "Trace written to " << traceFile << endl;
+		else
+			cerr << "Could not write trace to " << traceFile << endl;
+	}
+
+	return retVal;
 }
@@ -32,6 +32,7 @@
 #include <boost/archive/xml_iarchive.hpp>
 #include "main_window.h"
 #include "view3d/view3d.h"
+#include "view3d/camera_link.h"
 #include "scene/lg_scene.h"
 #include "scene/csg_object.h"
 #include "scene_inspector.h"
@@ -52,8 +53,15 @@
 #include "widgets/property_widget.h"
 #include "widgets/truncated_double_spin_box.h"
 #include "widgets/widget_list.h"
+#include "widgets/convergence_plot.h"
+#include "widgets/timeline_widget.h"
+#include "util/playback_engine.h"
+#include "util/trace_recorder.h"
 #include "tools/UG_LogParser.h"
 #include <boost/filesystem.hpp>
+#include "oscillation/mode_shading.h"
+#include "oscillation/vertex_correspondence.h"
+#include "vtustuff/ugx_metadata.hpp"
 #include "oscillation/oscillation.cpp"
 
 //tmp
@@ -77,6 +85,7 @@ using namespace boost::filesystem;
 ////////////////////////////////////////////////////////////////////////
 //	constructor
 MainWindow::MainWindow() :
+	m_cameraLink(NULL),
 	m_activeModule (NULL),
 	m_settings(),
 	m_elementModeListIndex(3),
@@ -94,7 +103,8 @@ MainWindow::MainWindow() :
 	m_dataset_loaded(false),
 	m_eigenmode_selection(0),
 	m_iteration_selection(0),
-	m_last_screen3_obj_idx(0)
+	m_last_screen3_obj_idx(0),
+	m_mode_shading(MS_NONE)
 {
 }
 
@@ -142,6 +152,13 @@ void MainWindow::init()
 	connect(m_scene_iterations, SIGNAL(visuals_updated()),
 			m_pView_iterations, SLOT(update()));
 
+	m_cameraLink = new CameraLink;
+	m_cameraLink->add_view(m_pView);
+	for(size_t i = 0; i < m_pViews.size(); ++i){
+		m_cameraLink->add_view(m_pViews[i]);
+	}
+	m_cameraLink->add_view(m_pView_iterations);
+
 
 	gridLayouts.push_back(new QGridLayout);
     gridLayouts[0]->addWidget(m_pViews[0],0,0,1,1);
@@ -174,6 +191,15 @@ void MainWindow::init()
     dataComboBox->addItem(tr("Correction"));
     dataComboBox->addItem(tr("Modal analysis"));
 
+	shadingComboBox = new QComboBox;
+	for(int i = 0; i < NUM_MODE_SHADINGS; ++i)
+		shadingComboBox->addItem(tr(ModeShadingName(i)));
+
+	connect(shadingComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(shadingMode_changed(int)));
+
+	shadingComboBoxLabel = new QLabel;
+	shadingComboBoxLabel->setText(tr(" shading: "));
+
     connect(oscillatingCheckBox, SIGNAL(toggled(bool)), this, SLOT(oscillating_toggled(bool)));
 
 	eigenmodeSpinBox = new QSpinBox;
@@ -234,6 +260,51 @@ void MainWindow::init()
 	addDockWidget(Qt::BottomDockWidgetArea, statisticsDock);
 	tabifyDockWidget(statisticsDock, m_pLog);
 
+//	create the convergence plot of the PINVIT iterations
+	m_convergencePlot = new ConvergencePlot();
+	QDockWidget* convergenceDock = new QDockWidget(tr("convergence"), this);
+	convergenceDock->setFeatures(QDockWidget::NoDockWidgetFeatures);
+	convergenceDock->setObjectName(tr("convergenceDock"));
+	convergenceDock->setWidget(m_convergencePlot);
+	addDockWidget(Qt::BottomDockWidgetArea, convergenceDock);
+	tabifyDockWidget(statisticsDock, convergenceDock);
+
+	connect(m_convergencePlot, SIGNAL(iterationClicked(int)),
+			iterationSpinBox, SLOT(setValue(int)));
+	connect(iterationSpinBox, SIGNAL(valueChanged(int)),
+			m_convergencePlot, SLOT(setCurrentIteration(int)));
+
+//	create the playback engine for time series and its timeline
+	m_playback = new PlaybackEngine(this);
+	m_timeline = new TimelineWidget();
+	m_timelineDock = new QDockWidget(tr("timeline"), this);
+	m_timelineDock->setObjectName(tr("timelineDock"));
+	m_timelineDock->setWidget(m_timeline);
+	addDockWidget(Qt::BottomDockWidgetArea, m_timelineDock);
+	m_timelineDock->hide();
+
+	connect(m_timeline, SIGNAL(playToggled(bool)), m_playback, SLOT(setPlaying(bool)));
+	connect(m_timeline, SIGNAL(seekRequested(double)), m_playback, SLOT(seek(double)));
+	connect(m_timeline, SIGNAL(loopToggled(bool)), m_playback, SLOT(setLoop(bool)));
+	connect(m_timeline, SIGNAL(rateChanged(double)), m_playback, SLOT(setRate(double)));
+	connect(m_playback, SIGNAL(positionChanged(double)), m_timeline, SLOT(setPosition(double)));
+	connect(m_playback, SIGNAL(playingChanged(bool)), m_timeline, SLOT(setPlaying(bool)));
+	connect(m_playback, SIGNAL(opened(int)), m_timeline, SLOT(setNumSteps(int)));
+	connect(m_playback, SIGNAL(opened(int)), m_timelineDock, SLOT(show()));
+	connect(m_playback, SIGNAL(failed(const QString&)),
+			this, SLOT(playbackFailed(const QString&)));
+
+//	the playback target must not outlive its object. Erased objects are
+//	removed first, so object_to_be_removed covers both.
+	connect(m_scene, SIGNAL(object_to_be_removed(ISceneObject*)),
+			this, SLOT(objectToBeRemoved(ISceneObject*)));
+	for(unsigned i = 0; i < m_scenes.size(); ++i){
+		connect(m_scenes[i], SIGNAL(object_to_be_removed(ISceneObject*)),
+				this, SLOT(objectToBeRemoved(ISceneObject*)));
+	}
+	connect(m_scene_iterations, SIGNAL(object_to_be_removed(ISceneObject*)),
+			this, SLOT(objectToBeRemoved(ISceneObject*)));
+
 
 
 //	redirect cout
@@ -268,6 +339,11 @@ void MainWindow::init()
 	m_actOpenDataset->setToolTip(tr("Load an Eigenmode dataset from directory."));
 	connect(m_actOpenDataset, SIGNAL(triggered()), this, SLOT(openDataset()));
 
+	m_actRecordTrace = new QAction(tr("Record Trace"), this);
+	m_actRecordTrace->setCheckable(true);
+	m_actRecordTrace->setToolTip(tr("Records load and render timelines. When stopped, they are saved as Chrome trace (chrome://tracing, Perfetto)."));
+	connect(m_actRecordTrace, SIGNAL(toggled(bool)), this, SLOT(recordTraceToggled(bool)));
+
 	m_actQuit = new QAction(tr("Quit"), this);
 	connect(m_actQuit, SIGNAL(triggered()), this, SLOT(quit()));
 
@@ -275,9 +351,34 @@ void MainWindow::init()
 	m_fileMenu->addAction(m_actOpen);
 	m_fileMenu->addAction(m_actOpenDataset);
 	m_fileMenu->addSeparator();
+	m_fileMenu->addAction(m_actRecordTrace);
 	m_fileMenu->addSeparator();
 	m_fileMenu->addAction(m_actQuit);
 
+//	view-menu
+	m_actProfilerOverlay = new QAction(tr("Frame Profiler"), this);
+	m_actProfilerOverlay->setCheckable(true);
+	m_actProfilerOverlay->setShortcut(tr("F12"));
+	m_actProfilerOverlay->setToolTip(tr("Shows per-stage timings, submitted triangles and fps in the views."));
+	connect(m_actProfilerOverlay, SIGNAL(toggled(bool)), this, SLOT(profilerOverlayToggled(bool)));
+
+	m_actLinkCameras = new QAction(tr("Link Cameras"), this);
+	m_actLinkCameras->setCheckable(true);
+	m_actLinkCameras->setToolTip(tr("Rotates, moves and zooms all views together."));
+	connect(m_actLinkCameras, SIGNAL(toggled(bool)), this, SLOT(linkCamerasToggled(bool)));
+	m_actLinkCameras->setChecked(settings().value("link-cameras", false).toBool());
+
+	m_actSmoothShading = new QAction(tr("Smooth Shading"), this);
+	m_actSmoothShading->setCheckable(true);
+	m_actSmoothShading->setToolTip(tr("Interpolates the normals of adjacent faces across surfaces."));
+	connect(m_actSmoothShading, SIGNAL(toggled(bool)), this, SLOT(smoothShadingToggled(bool)));
+	m_actSmoothShading->setChecked(settings().value("smooth-shading", false).toBool());
+
+	m_viewMenu = new QMenu("&View", menuBar());
+	m_viewMenu->addAction(m_actLinkCameras);
+	m_viewMenu->addAction(m_actSmoothShading);
+	m_viewMenu->addAction(m_actProfilerOverlay);
+
 //	create a tool bar for file handling
 	QToolBar* fileToolBar = addToolBar(tr("&File"));
 	fileToolBar->setObjectName(tr("file_toolbar"));
@@ -328,6 +429,7 @@ void MainWindow::init()
 
 MainWindow::~MainWindow()
 {
+	delete m_cameraLink;
 }
 
 QToolBar* MainWindow::createVisibilityToolbar()
@@ -390,6 +492,13 @@ QToolBar* MainWindow::createVisibilityToolbar()
 
 	visToolBar->addWidget(iterationSpinBox);
 
+	visToolBar->addSeparator();
+	visToolBar->addSeparator();
+
+	visToolBar->addWidget(shadingComboBoxLabel);
+
+	visToolBar->addWidget(shadingComboBox);
+
 	return visToolBar;
 }
 
@@ -689,6 +798,11 @@ bool MainWindow::openDataset()
 		return false;
 	}
 
+	TRACE_SCOPE("MainWindow::openDataset");
+
+//	time series belong to the geometry of the previous dataset
+	m_playback->close();
+
 	boost::filesystem::path p(dir);
 
 	bool has_log_file = false;
@@ -725,7 +839,9 @@ bool MainWindow::openDataset()
 
 
 	UG_LogParser LP(log_file);
-	LP.do_it();
+	if(!LP.do_it()){
+		UG_LOG("WARNING: " << log_file << " is incomplete, e.g. since the run was aborted.\n");
+	}
 
 	unsigned numevs = LP.num_evs();
 	unsigned numiters = LP.num_iterations();
@@ -772,6 +888,11 @@ bool MainWindow::openDataset()
 
 	m_picture->setText(QString::fromStdString(str_setup));
 
+	m_convergencePlot->clear();
+	m_convergencePlot->setNumSeries(numevs);
+	for(size_t i = 0; i < m_defects.size(); ++i)
+		m_convergencePlot->appendIteration(m_defects[i]);
+
 	boost::filesystem::path solutions_path(dir+"/solutions/");
 
 	std::vector<bool> sol_file_existent(numevs, false);
@@ -877,6 +998,32 @@ bool MainWindow::openDataset()
 	}
 
 	std::string geometry_file = dir + "/solutions/" + "ev_" + std::to_string(1) + "_ascii.ugx";
+
+//	validate the dataset by the metadata of its files before loading any grid
+	UGXMetadata geometry_meta;
+	if(!ScanUGXMetadata(geometry_file, geometry_meta)){
+		std::cerr << "no grid found in geometry file: " << geometry_file << std::endl;
+		return false;
+	}
+	std::cout << "geometry: " << geometry_meta.num_vertices << " vertices, "
+			  << geometry_meta.num_faces << " faces, " << geometry_meta.num_volumes << " volumes" << std::endl;
+
+//	only the vertex counts are compared, so legacy files without metadata
+//	header are not read beyond their vertices
+	for(unsigned i = 0; i < numevs; ++i){
+		std::string name = dir + "/solutions/" + "ev_" + std::to_string(i+1) + "_ascii.ugxc";
+		UGXMetadata meta;
+		if(!ScanUGXMetadata(name, meta, true)){
+			std::cerr << "no grid found in solution file: " << name << std::endl;
+			return false;
+		}
+		if(meta.num_vertices != geometry_meta.num_vertices){
+			std::cerr << "solution file " << name << " has " << meta.num_vertices
+					  << " vertices, the geometry has " << geometry_meta.num_vertices << std::endl;
+			return false;
+		}
+	}
+
 	if(!load_grid_from_file(geometry_file.c_str())){
 		std::cerr << "error loading geometry file: " << geometry_file << std::endl;
 		return false; 
@@ -893,6 +1040,8 @@ bool MainWindow::openDataset()
 		++m_num_objects;
 	}
 
+	apply_mode_shading();
+
 	for(unsigned i = 0; i < minimum(numiters-1, MAXITERS); ++i){
 		for(unsigned j = 0; j < minimum(numevs, MAXEVS); ++j){ //pinvit_it_0_ev_1_ascii.ugxc
 			std::string name = dir + "/debug/" + "pinvit_it_" + std::to_string(i) + "_ev_" + std::to_string(j) + "_ascii.ugxc";
@@ -942,6 +1091,40 @@ void MainWindow::setActiveObject(int index)
 	}
 }
 
+void MainWindow::shadingMode_changed(int mode)
+{
+	m_mode_shading = mode;
+	apply_mode_shading();
+}
+
+void MainWindow::apply_mode_shading()
+{
+	if(m_scene->num_objects() == 0)
+		return;
+
+	LGObject* refObj = m_scene->get_object(0);
+	std::vector<size_t> refInds;
+	for(unsigned i = 0; i < minimum(m_num_objects, EXTRASCENES); ++i){
+		if(m_scenes[i]->num_objects() == 0)
+			continue;
+
+		LGObject* obj = m_scenes[i]->get_object(0);
+		refInds.clear();
+	//	modes may list their vertices in another order than the reference
+		if(m_mode_shading != MS_NONE && !obj->displacement_attachment()
+		   && !FindModeVertexCorrespondence(refInds, obj->grid(), obj->m_fileName,
+											refObj->grid(), refObj->m_fileName))
+		{
+			UG_LOG("WARNING: the vertices of " << obj->name()
+				   << " could not be matched to the reference grid, it is not shaded.\n");
+			obj->clear_vertex_scalars();
+		}
+		else
+			ApplyModeShading(obj, refObj->grid(), m_mode_shading, &refInds);
+		m_scenes[i]->color_changed(obj);
+	}
+}
+
 void MainWindow::frontDrawModeChanged(int newMode)
 {
 	m_scene->set_draw_mode_front(newMode);
@@ -970,6 +1153,79 @@ void MainWindow::backgroundColorChanged(const QColor& color)
 	settings().setValue("bg-color", color.name());
 }
 
+void MainWindow::recordTraceToggled(bool record)
+{
+	TraceRecorder& recorder = TraceRecorder::instance();
+	if(record){
+		recorder.start();
+		return;
+	}
+
+	recorder.stop();
+	QString path = settings().value("file-path", ".").toString();
+	QString filename = QFileDialog::getSaveFileName(
+								this,
+								tr("Save Trace"),
+								path + "/emvis_trace.json",
+								tr("Chrome trace (*.json)"));
+	if(filename.isEmpty())
+		return;
+
+	if(recorder.write_chrome_trace(filename.toLocal8Bit().constData())){
+		UG_LOG("Trace with " << recorder.num_events() << " events written to "
+			   << filename.toLocal8Bit().constData() << "\n");
+		if(recorder.num_dropped_events() > 0)
+			UG_LOG("  " << recorder.num_dropped_events() << " events were dropped.\n");
+	}
+	else{
+		QMessageBox::warning(this, tr("Save Trace"),
+							 tr("Could not write ") + filename);
+	}
+}
+
+void MainWindow::profilerOverlayToggled(bool show)
+{
+	m_pView->set_profiler_overlay_visible(show);
+	for(size_t i = 0; i < m_pViews.size(); ++i){
+		m_pViews[i]->set_profiler_overlay_visible(show);
+	}
+	m_pView_iterations->set_profiler_overlay_visible(show);
+}
+
+void MainWindow::linkCamerasToggled(bool link)
+{
+//	the views take the camera of the page which is currently shown
+	View3D* source = m_pView;
+	if(stackedWidget->currentIndex() == 1)
+		source = m_pViews[0];
+	else if(stackedWidget->currentIndex() == 2)
+		source = m_pView_iterations;
+
+	m_cameraLink->set_enabled(link, source);
+	settings().setValue("link-cameras", link);
+}
+
+void MainWindow::smoothShadingToggled(bool smooth)
+{
+	m_scene->set_smooth_shading(smooth);
+	for(unsigned i = 0; i < m_scenes.size(); ++i){
+		m_scenes[i]->set_smooth_shading(smooth);
+	}
+	m_scene_iterations->set_smooth_shading(smooth);
+
+	settings().setValue("smooth-shading", smooth);
+}
+
+void MainWindow::objectToBeRemoved(ISceneObject* obj)
+{
+	m_playback->detach(obj);
+}
+
+void MainWindow::playbackFailed(const QString& message)
+{
+	UG_LOG("ERROR: playback stopped: " << message.toStdString() << "\n");
+}
+
 
 void MainWindow::elementDrawModeChanged()
 {
@@ -1058,6 +1314,7 @@ populateMenuBar ()
 	QMenuBar* bar = menuBar();
 	bar->clear();
 	bar->addMenu(m_fileMenu);
+	bar->addMenu(m_viewMenu);
 
 	for(vector<QMenu*>::iterator i = m_moduleMenus.begin();
 		i != m_moduleMenus.end(); ++i)
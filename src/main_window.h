@@ -51,6 +51,7 @@
 
 ////////////////////////////////////////////////////////////////////////
 //	predeclarations
+class CameraLink;
 class View3D;
 class LGScene;
 class ISceneObject;
@@ -71,6 +72,9 @@ class ToolManager;
 class ToolBrowser;
 class QScriptEditor;
 class TruncatedDoubleSpinBox;
+class ConvergencePlot;
+class PlaybackEngine;
+class TimelineWidget;
 
 
 enum SceneObjectType {
@@ -139,6 +143,7 @@ class MainWindow : public QMainWindow
 		void oscillating_toggled(bool b);
 		void eigenmodeSpinBox_activated(int);
 		void iterationSpinBox_activated(int);
+		void shadingMode_changed(int mode);
 		void quit();
 
 	protected slots:
@@ -148,6 +153,12 @@ class MainWindow : public QMainWindow
 		void view3dKeyReleased(QKeyEvent* event);
 		void elementDrawModeChanged();
 		void sceneInspectorClicked(QMouseEvent* event);
+		void recordTraceToggled(bool record);
+		void profilerOverlayToggled(bool show);
+		void linkCamerasToggled(bool link);
+		void smoothShadingToggled(bool smooth);
+		void objectToBeRemoved(ISceneObject* obj);
+		void playbackFailed(const QString& message);
 
 	protected:
 		void closeEvent(QCloseEvent *event);
@@ -162,6 +173,9 @@ class MainWindow : public QMainWindow
 
 		QToolBar* createVisibilityToolbar();
 
+	///	colors the split view modes by the selected displacement quantity
+		void apply_mode_shading();
+
 		uint getLGElementMode();
 
 		void beginMouseMoveAction(MouseMoveAction mma);
@@ -186,6 +200,9 @@ class MainWindow : public QMainWindow
 		View3D*		m_pView_iterations;
 		LGScene*	m_scene_iterations;
 
+	///	shares the camera of all views, see View > Link Cameras
+		CameraLink*	m_cameraLink;
+
 	//	Modules
 		IModule*				m_activeModule;
 		IModule::dock_list_t	m_moduleDockWidgets;
@@ -233,11 +250,19 @@ class MainWindow : public QMainWindow
 		QVBoxLayout*				layout;
 		QComboBox*					pageComboBox;
 		QComboBox*					dataComboBox;
+		QComboBox*					shadingComboBox;
+		QLabel*						shadingComboBoxLabel;
 
 		QCheckBox*					oscillatingCheckBox;
 
 		QLabel*				m_picture;
 		QLabel*				m_picture2;
+		ConvergencePlot*	m_convergencePlot;
+
+	//	playback of time series
+		PlaybackEngine*		m_playback;
+		TimelineWidget*		m_timeline;
+		QDockWidget*		m_timelineDock;
 
 		unsigned			m_modus;
 		unsigned 			m_num_objects;
@@ -248,6 +273,7 @@ class MainWindow : public QMainWindow
 		unsigned 			m_eigenmode_selection;
 		unsigned 			m_iteration_selection;
 		unsigned			m_last_screen3_obj_idx;
+		int					m_mode_shading;
 
 		std::vector<std::vector<double> > m_lambdas;
 		std::vector<std::vector<double> > m_defects;
@@ -256,11 +282,16 @@ class MainWindow : public QMainWindow
 
 	//	menus
 		QMenu* m_fileMenu;
+		QMenu* m_viewMenu;
 	//	actions
 		QAction*	m_actOpen;
 		QAction*	m_actOpenDataset;
 		QAction*	m_actExport;
 		QAction*	m_actQuit;
+		QAction*	m_actRecordTrace;
+		QAction*	m_actProfilerOverlay;
+		QAction*	m_actLinkCameras;
+		QAction*	m_actSmoothShading;
 
 		std::vector<QWidget*>	gridWidgets;
 };
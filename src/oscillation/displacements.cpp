@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#include "displacements.h"
+
+using namespace std;
+using namespace ug;
+
+void ComputeDisplacements(std::vector<ug::vector3>& displacementsOut,
+						  ug::Grid& modeGrid, ug::Grid& refGrid, double scale,
+						  const std::vector<size_t>* refInds)
+{
+	Grid::VertexAttachmentAccessor<APosition> aaPosRef(refGrid, aPosition);
+	Grid::VertexAttachmentAccessor<APosition> aaPosMode(modeGrid, aPosition);
+
+	displacementsOut.reserve(displacementsOut.size() + modeGrid.num_vertices());
+
+	if(refInds && !refInds->empty()){
+		vector<Vertex*> refVrts(refGrid.begin<Vertex>(), refGrid.end<Vertex>());
+		vector3 d;
+		size_t i = 0;
+		for(VertexIterator iter = modeGrid.begin<Vertex>();
+			iter != modeGrid.end<Vertex>() && i < refInds->size(); ++iter, ++i)
+		{
+			VecSubtract(d, aaPosMode[*iter], aaPosRef[refVrts[(*refInds)[i]]]);
+			VecScale(d, d, scale);
+			displacementsOut.push_back(d);
+		}
+		return;
+	}
+
+	VertexIterator iterMode = modeGrid.begin<Vertex>();
+	VertexIterator iterRef = refGrid.begin<Vertex>();
+
+	vector3 d;
+	for(; iterMode != modeGrid.end<Vertex>() && iterRef != refGrid.end<Vertex>();
+		++iterMode, ++iterRef)
+	{
+		VecSubtract(d, aaPosMode[*iterMode], aaPosRef[*iterRef]);
+		VecScale(d, d, scale);
+		displacementsOut.push_back(d);
+	}
+}
+
+void ReadDisplacements(std::vector<ug::vector3>& displacementsOut,
+					   ug::Grid& modeGrid, ug::AVector3& aDisp)
+{
+	Grid::VertexAttachmentAccessor<AVector3> aaDisp(modeGrid, aDisp);
+
+	displacementsOut.reserve(displacementsOut.size() + modeGrid.num_vertices());
+	for(VertexIterator iter = modeGrid.begin<Vertex>(); iter != modeGrid.end<Vertex>(); ++iter){
+		displacementsOut.push_back(aaDisp[*iter]);
+	}
+}
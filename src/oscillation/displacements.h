@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#ifndef __H__EMVIS_displacements__
+#define __H__EMVIS_displacements__
+
+#include <vector>
+#include "lib_grid/lib_grid.h"
+
+///	computes the displacements of the vertices of modeGrid relative to refGrid.
+/**	If refInds is given and not empty, the i-th vertex of modeGrid is compared
+ * to the refInds[i]-th vertex of refGrid, see FindVertexCorrespondence.
+ * Otherwise both grids have to contain their vertices in the same order. The
+ * displacements are appended to displacementsOut in the order of modeGrid.*/
+void ComputeDisplacements(std::vector<ug::vector3>& displacementsOut,
+						  ug::Grid& modeGrid, ug::Grid& refGrid, double scale = 1.0,
+						  const std::vector<size_t>* refInds = NULL);
+
+///	reads displacements which were loaded together with the mode, e.g. from a vtu file
+void ReadDisplacements(std::vector<ug::vector3>& displacementsOut,
+					   ug::Grid& modeGrid, ug::AVector3& aDisp);
+
+///	sets the vertex positions of grid to rest + scale * offsets.
+/**	rest and offsets are ordered as the vertices of grid. Vertices without
+ * offset are reset to their rest position, vertices without rest position
+ * are left untouched.*/
+template <class TAAPos>
+void SuperposeDisplacements(ug::Grid& grid, TAAPos& aaPos,
+							const std::vector<ug::vector3>& rest,
+							const std::vector<ug::vector3>& offsets,
+							number scale)
+{
+	using namespace ug;
+	const size_t numRest = rest.size();
+	const size_t numOffsets = offsets.size();
+	size_t i = 0;
+
+	for(VertexIterator ivrt = grid.begin<Vertex>();
+		(ivrt != grid.end<Vertex>()) && (i < numRest); ++ivrt, ++i)
+	{
+		if(i < numOffsets)
+			VecScaleAdd(aaPos[*ivrt], 1, rest[i], scale, offsets[i]);
+		else
+			aaPos[*ivrt] = rest[i];
+	}
+}
+
+#endif
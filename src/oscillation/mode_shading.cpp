@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "mode_shading.h"
+#include "vertex_correspondence.h"
+#include "scene/lg_object.h"
+#include "util/colormap.h"
+
+using namespace std;
+using namespace ug;
+
+const char* ModeShadingName(int shading)
+{
+	switch(shading){
+		case MS_NONE:			return "subset colors";
+		case MS_MAGNITUDE:		return "|displacement|";
+		case MS_COMPONENT_X:	return "displacement x";
+		case MS_COMPONENT_Y:	return "displacement y";
+		case MS_COMPONENT_Z:	return "displacement z";
+		case MS_STRAIN:			return "strain proxy";
+		default:				return "";
+	}
+}
+
+///	for each vertex the mean of the squared relative elongations of its edges
+static void ComputeStrainProxy(std::vector<float>& scalarsOut,
+							   const std::vector<ug::vector3>& displacements,
+							   Grid& refGrid)
+{
+	AInt aInd;
+	refGrid.attach_to_vertices(aInd);
+	Grid::VertexAttachmentAccessor<AInt> aaInd(refGrid, aInd);
+	Grid::VertexAttachmentAccessor<APosition> aaPos(refGrid, aPosition);
+
+	int ind = 0;
+	for(VertexIterator iter = refGrid.vertices_begin();
+		iter != refGrid.vertices_end(); ++iter, ++ind)
+	{
+		aaInd[*iter] = ind;
+	}
+
+	vector<int> numEdges(scalarsOut.size(), 0);
+	for(EdgeIterator iter = refGrid.edges_begin();
+		iter != refGrid.edges_end(); ++iter)
+	{
+		Edge* e = *iter;
+		const int i0 = aaInd[e->vertex(0)];
+		const int i1 = aaInd[e->vertex(1)];
+		const number len = VecDistance(aaPos[e->vertex(0)], aaPos[e->vertex(1)]);
+		if(len <= 0)
+			continue;
+
+		const number elong = VecDistance(displacements[i0], displacements[i1]) / len;
+		scalarsOut[i0] += (float)(elong * elong);
+		scalarsOut[i1] += (float)(elong * elong);
+		++numEdges[i0];
+		++numEdges[i1];
+	}
+
+	for(size_t i = 0; i < scalarsOut.size(); ++i){
+		if(numEdges[i] > 0)
+			scalarsOut[i] /= (float)numEdges[i];
+	}
+
+	refGrid.detach_from_vertices(aInd);
+}
+
+void ComputeModeScalars(std::vector<float>& scalarsOut,
+						float& rangeMinOut, float& rangeMaxOut,
+						const std::vector<ug::vector3>& displacements,
+						ug::Grid& refGrid, int shading)
+{
+	const size_t numVrts = displacements.size();
+	scalarsOut.assign(numVrts, 0);
+
+	switch(shading){
+		case MS_MAGNITUDE:
+			for(size_t i = 0; i < numVrts; ++i)
+				scalarsOut[i] = (float)VecLength(displacements[i]);
+			break;
+		case MS_COMPONENT_X:
+		case MS_COMPONENT_Y:
+		case MS_COMPONENT_Z:{
+			const int c = shading - MS_COMPONENT_X;
+			for(size_t i = 0; i < numVrts; ++i)
+				scalarsOut[i] = (float)displacements[i][c];
+		}break;
+		case MS_STRAIN:
+			ComputeStrainProxy(scalarsOut, displacements, refGrid);
+			break;
+		default:
+			break;
+	}
+
+	float maxAbs = 0;
+	for(size_t i = 0; i < numVrts; ++i)
+		maxAbs = max(maxAbs, fabs(scalarsOut[i]));
+	if(maxAbs <= 0)
+		maxAbs = 1.f;
+
+//	signed components are shown symmetric around zero, so that nodal lines
+//	appear in the neutral color of a diverging colormap.
+	if(shading >= MS_COMPONENT_X && shading <= MS_COMPONENT_Z){
+		rangeMinOut = -maxAbs;
+		rangeMaxOut = maxAbs;
+	}
+	else{
+		rangeMinOut = 0;
+		rangeMaxOut = maxAbs;
+	}
+}
+
+void ApplyModeShading(LGObject* modeObj, ug::Grid& refGrid, int shading,
+					  const std::vector<size_t>* refInds)
+{
+	static const vector<size_t> noRefInds;
+	const vector<size_t>& inds = refInds ? *refInds : noRefInds;
+
+	Grid& modeGrid = modeObj->grid();
+	AVector3* aDisp = modeObj->displacement_attachment();
+	if(shading == MS_NONE || modeGrid.num_vertices() == 0
+	   || (!aDisp && (modeGrid.num_vertices() != refGrid.num_vertices()
+					  || (!inds.empty() && inds.size() != modeGrid.num_vertices()))))
+	{
+		modeObj->clear_vertex_scalars();
+		return;
+	}
+
+	vector<vector3> displacements;
+	displacements.reserve(modeGrid.num_vertices());
+	if(aDisp){
+	//	the mode carries its displacements, its own grid is the reference
+		Grid::VertexAttachmentAccessor<AVector3> aaDisp(modeGrid, *aDisp);
+		for(VertexIterator iter = modeGrid.vertices_begin();
+			iter != modeGrid.vertices_end(); ++iter)
+		{
+			displacements.push_back(aaDisp[*iter]);
+		}
+	}
+	else{
+	//	the scalars are computed on refGrid, so the displacements are stored
+	//	at the indices of the corresponding reference vertices.
+		Grid::VertexAttachmentAccessor<APosition> aaPosMode(modeGrid, aPosition);
+		Grid::VertexAttachmentAccessor<APosition> aaPosRef(refGrid, aPosition);
+
+		vector<Vertex*> refVrts(refGrid.begin<Vertex>(), refGrid.end<Vertex>());
+		displacements.resize(refVrts.size(), vector3(0, 0, 0));
+		size_t i = 0;
+		for(VertexIterator iter = modeGrid.vertices_begin();
+			iter != modeGrid.vertices_end(); ++iter, ++i)
+		{
+			const size_t iRef = CorrespondingVertexIndex(inds, i);
+			if(iRef < refVrts.size())
+				VecSubtract(displacements[iRef], aaPosMode[*iter], aaPosRef[refVrts[iRef]]);
+		}
+	}
+
+	vector<float> scalars;
+	float rangeMin, rangeMax;
+	ComputeModeScalars(scalars, rangeMin, rangeMax, displacements,
+					   aDisp ? modeGrid : refGrid, shading);
+
+//	back to the order of the vertices of modeObj
+	if(!aDisp && !inds.empty()){
+		vector<float> refScalars;
+		refScalars.swap(scalars);
+		scalars.resize(inds.size(), 0);
+		for(size_t i = 0; i < inds.size(); ++i){
+			if(inds[i] < refScalars.size())
+				scalars[i] = refScalars[inds[i]];
+		}
+	}
+
+	modeObj->set_vertex_scalars(&scalars.front(), scalars.size());
+	modeObj->set_scalar_range(rangeMin, rangeMax);
+	if(shading >= MS_COMPONENT_X && shading <= MS_COMPONENT_Z)
+		modeObj->set_colormap(CM_COOL_WARM);
+	else
+		modeObj->set_colormap(CM_VIRIDIS);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef __H__EMVIS_mode_shading__
+#define __H__EMVIS_mode_shading__
+
+#include <vector>
+#include "lib_grid/lib_grid.h"
+
+class LGObject;
+
+///	scalar quantities of an eigenmode which can be shown through a colormap
+enum ModeShading
+{
+	MS_NONE,///< subset colors, no scalars
+	MS_MAGNITUDE,///< |u|
+	MS_COMPONENT_X,
+	MS_COMPONENT_Y,
+	MS_COMPONENT_Z,
+	MS_STRAIN,///< mean squared relative elongation of the adjacent edges
+	NUM_MODE_SHADINGS
+};
+
+const char* ModeShadingName(int shading);
+
+///	computes one scalar per vertex of refGrid from the displacements of a mode.
+/**	displacements have to be ordered as the vertices of refGrid.
+ * rangeMinOut and rangeMaxOut receive a range suitable for the colormap.*/
+void ComputeModeScalars(std::vector<float>& scalarsOut,
+						float& rangeMinOut, float& rangeMaxOut,
+						const std::vector<ug::vector3>& displacements,
+						ug::Grid& refGrid, int shading);
+
+///	assigns the scalars of the given shading to modeObj.
+/**	If modeObj carries a displacement field (see LGObject::displacement_attachment),
+ * it is used directly. Otherwise the displacements are the differences of the
+ * vertex positions of modeObj and refGrid. If refInds is given and not empty,
+ * the i-th vertex of modeObj is compared to the refInds[i]-th vertex of refGrid,
+ * see FindVertexCorrespondence. Otherwise both grids have to list their
+ * vertices in the same order. MS_NONE removes the scalars. Call
+ * LGScene::color_changed afterwards to repaint.*/
+void ApplyModeShading(LGObject* modeObj, ug::Grid& refGrid, int shading,
+					  const std::vector<size_t>* refInds = NULL);
+
+#endif
@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdint.h>
+#include <utility>
+#include "vertex_correspondence.h"
+#include "vtustuff/ugx_object_reader.hpp"
+#include "common/util/file_util.h"
+
+using namespace std;
+using namespace ug;
+
+///	the corners of an element by vertex index, sorted and padded with -1
+template <size_t N>
+struct SortedCorners
+{
+	int ind[N];
+
+	bool operator < (const SortedCorners& c) const
+		{return lexicographical_compare(ind, ind + N, c.ind, c.ind + N);}
+	bool operator == (const SortedCorners& c) const
+		{return equal(ind, ind + N, c.ind);}
+};
+
+template <size_t N, class TElem>
+static void CollectSortedCorners(vector<SortedCorners<N> >& cornersOut, Grid& grid,
+								 Grid::VertexAttachmentAccessor<AInt>& aaInd)
+{
+	typedef typename geometry_traits<TElem>::iterator iterator;
+
+	cornersOut.clear();
+	cornersOut.reserve(grid.num<TElem>());
+	for(iterator iter = grid.begin<TElem>(); iter != grid.end<TElem>(); ++iter){
+		TElem* e = *iter;
+		SortedCorners<N> c;
+		fill(c.ind, c.ind + N, -1);
+		const size_t numCorners = min<size_t>(e->num_vertices(), N);
+		for(size_t i = 0; i < numCorners; ++i)
+			c.ind[i] = aaInd[e->vertex(i)];
+		sort(c.ind, c.ind + numCorners);
+		cornersOut.push_back(c);
+	}
+	sort(cornersOut.begin(), cornersOut.end());
+}
+
+template <size_t N, class TElem>
+static bool SameCorners(Grid& modeGrid, Grid::VertexAttachmentAccessor<AInt>& aaIndMode,
+						Grid& refGrid, Grid::VertexAttachmentAccessor<AInt>& aaIndRef)
+{
+	if(modeGrid.num<TElem>() != refGrid.num<TElem>())
+		return false;
+
+	vector<SortedCorners<N> > modeCorners, refCorners;
+	CollectSortedCorners<N, TElem>(modeCorners, modeGrid, aaIndMode);
+	CollectSortedCorners<N, TElem>(refCorners, refGrid, aaIndRef);
+	return modeCorners == refCorners;
+}
+
+static void AssignVertexIndices(Grid& grid, Grid::VertexAttachmentAccessor<AInt>& aaInd)
+{
+	int ind = 0;
+	for(VertexIterator iter = grid.begin<Vertex>(); iter != grid.end<Vertex>(); ++iter, ++ind)
+		aaInd[*iter] = ind;
+}
+
+bool VerticesHaveSameOrder(Grid& modeGrid, Grid& refGrid)
+{
+	if(&modeGrid == &refGrid)
+		return true;
+	if(modeGrid.num_vertices() != refGrid.num_vertices())
+		return false;
+
+	AInt aInd;
+	modeGrid.attach_to_vertices(aInd);
+	refGrid.attach_to_vertices(aInd);
+	Grid::VertexAttachmentAccessor<AInt> aaIndMode(modeGrid, aInd);
+	Grid::VertexAttachmentAccessor<AInt> aaIndRef(refGrid, aInd);
+	AssignVertexIndices(modeGrid, aaIndMode);
+	AssignVertexIndices(refGrid, aaIndRef);
+
+//	the elements of the highest dimension determine the topology
+	bool same = true;
+	if(refGrid.num_volumes() > 0)
+		same = SameCorners<8, Volume>(modeGrid, aaIndMode, refGrid, aaIndRef);
+	else if(refGrid.num_faces() > 0)
+		same = SameCorners<4, Face>(modeGrid, aaIndMode, refGrid, aaIndRef);
+	else if(refGrid.num_edges() > 0)
+		same = SameCorners<2, Edge>(modeGrid, aaIndMode, refGrid, aaIndRef);
+
+	modeGrid.detach_from_vertices(aInd);
+	refGrid.detach_from_vertices(aInd);
+	return same;
+}
+
+///	hash of the cell of the spatial hash which contains p, offset by (dx, dy, dz) cells
+static uint64_t CellKey(const vector3& p, number cellSize, int dx, int dy, int dz)
+{
+	const int64_t c[3] = {(int64_t)floor(p.x() / cellSize) + dx,
+						  (int64_t)floor(p.y() / cellSize) + dy,
+						  (int64_t)floor(p.z() / cellSize) + dz};
+	uint64_t h = 0;
+	for(int i = 0; i < 3; ++i){
+		h = (h ^ (uint64_t)c[i]) * 0x9E3779B97F4A7C15ull;
+		h ^= h >> 29;
+	}
+	return h;
+}
+
+bool MatchVerticesByPosition(vector<size_t>& refIndsOut, Grid& modeGrid,
+							 Grid& refGrid, number tolerance)
+{
+	refIndsOut.clear();
+	const size_t numVrts = refGrid.num_vertices();
+	if(modeGrid.num_vertices() != numVrts)
+		return false;
+
+	Grid::VertexAttachmentAccessor<APosition> aaPosRef(refGrid, aPosition);
+	Grid::VertexAttachmentAccessor<APosition> aaPosMode(modeGrid, aPosition);
+
+	vector<vector3> refPos;
+	refPos.reserve(numVrts);
+	number maxCoord = 0;
+	for(VertexIterator iter = refGrid.begin<Vertex>(); iter != refGrid.end<Vertex>(); ++iter){
+		refPos.push_back(aaPosRef[*iter]);
+		for(int i = 0; i < 3; ++i)
+			maxCoord = max<number>(maxCoord, fabs(refPos.back()[i]));
+	}
+
+//	cells must not get so small that the cell coordinates overflow
+	tolerance = max<number>(tolerance, 1e-12 * (1 + maxCoord));
+
+//	since cells are twice as large as the tolerance, a partner can only lie
+//	in the cell of a vertex or in one of its 26 neighbours.
+	const number cellSize = 2 * tolerance;
+	vector<pair<uint64_t, size_t> > cells(numVrts);
+	for(size_t i = 0; i < numVrts; ++i)
+		cells[i] = make_pair(CellKey(refPos[i], cellSize, 0, 0, 0), i);
+	sort(cells.begin(), cells.end());
+
+	const number tolSq = tolerance * tolerance;
+	vector<bool> used(numVrts, false);
+	refIndsOut.reserve(numVrts);
+
+	for(VertexIterator iter = modeGrid.begin<Vertex>(); iter != modeGrid.end<Vertex>(); ++iter){
+		const vector3& p = aaPosMode[*iter];
+		size_t best = numVrts;
+		number bestDistSq = tolSq;
+
+		for(int dx = -1; dx <= 1; ++dx){
+			for(int dy = -1; dy <= 1; ++dy){
+				for(int dz = -1; dz <= 1; ++dz){
+					const uint64_t key = CellKey(p, cellSize, dx, dy, dz);
+					for(vector<pair<uint64_t, size_t> >::const_iterator c =
+							lower_bound(cells.begin(), cells.end(), make_pair(key, size_t(0)));
+						c != cells.end() && c->first == key; ++c)
+					{
+						const number distSq = VecDistanceSq(p, refPos[c->second]);
+						if(distSq < bestDistSq || (distSq == bestDistSq && c->second < best)){
+							best = c->second;
+							bestDistSq = distSq;
+						}
+					}
+				}
+			}
+		}
+
+		if(best == numVrts || used[best]){
+			refIndsOut.clear();
+			return false;
+		}
+
+		used[best] = true;
+		refIndsOut.push_back(best);
+	}
+
+	return true;
+}
+
+number DefaultVertexMatchTolerance(Grid& grid)
+{
+	if(grid.num_vertices() == 0)
+		return 0;
+
+	Grid::VertexAttachmentAccessor<APosition> aaPos(grid, aPosition);
+	vector3 vMin, vMax;
+	CalculateBoundingBox(vMin, vMax, grid.vertices_begin(), grid.vertices_end(), aaPos);
+	return 1e-5 * VecDistance(vMin, vMax);
+}
+
+///	permutations found by MatchVerticesByPosition, by (mode file, reference file)
+typedef map<pair<string, string>, vector<size_t> > CorrespondenceCache;
+
+static CorrespondenceCache& GetCorrespondenceCache()
+{
+	static CorrespondenceCache cache;
+	return cache;
+}
+
+///	true if refInds still maps each mode vertex to a reference vertex within tolerance
+static bool CorrespondenceIsValid(const vector<size_t>& refInds, Grid& modeGrid,
+								  Grid& refGrid, number tolerance)
+{
+	const size_t numVrts = refGrid.num_vertices();
+	if(refInds.size() != numVrts || modeGrid.num_vertices() != numVrts)
+		return false;
+
+	Grid::VertexAttachmentAccessor<APosition> aaPosRef(refGrid, aPosition);
+	Grid::VertexAttachmentAccessor<APosition> aaPosMode(modeGrid, aPosition);
+
+	vector<vector3> refPos;
+	refPos.reserve(numVrts);
+	for(VertexIterator iter = refGrid.begin<Vertex>(); iter != refGrid.end<Vertex>(); ++iter)
+		refPos.push_back(aaPosRef[*iter]);
+
+	const number tolSq = tolerance * tolerance;
+	size_t i = 0;
+	for(VertexIterator iter = modeGrid.begin<Vertex>(); iter != modeGrid.end<Vertex>(); ++iter, ++i){
+		if(refInds[i] >= numVrts
+		   || VecDistanceSq(aaPosMode[*iter], refPos[refInds[i]]) > tolSq)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FindVertexCorrespondence(vector<size_t>& refIndsOut,
+							  Grid& modeGrid, const string& modeFile,
+							  Grid& refGrid, const string& refFile)
+{
+	refIndsOut.clear();
+	if(VerticesHaveSameOrder(modeGrid, refGrid))
+		return true;
+
+	const number tolerance = DefaultVertexMatchTolerance(refGrid);
+	const bool cacheable = !modeFile.empty() && !refFile.empty();
+	const pair<string, string> key(modeFile, refFile);
+	CorrespondenceCache& cache = GetCorrespondenceCache();
+
+	if(cacheable){
+		CorrespondenceCache::iterator iter = cache.find(key);
+		if(iter != cache.end()){
+			if(CorrespondenceIsValid(iter->second, modeGrid, refGrid, tolerance)){
+				refIndsOut = iter->second;
+				return true;
+			}
+			cache.erase(iter);
+		}
+	}
+
+	if(!MatchVerticesByPosition(refIndsOut, modeGrid, refGrid, tolerance))
+		return false;
+
+	if(cacheable)
+		cache[key] = refIndsOut;
+	return true;
+}
+
+bool LoadRestGrid(Grid& restGridOut, string& restFileOut,
+				  Grid& modeGrid, const string& modeFile)
+{
+	const size_t suffixLen = 5;
+	if(modeFile.size() <= suffixLen
+	   || modeFile.compare(modeFile.size() - suffixLen, suffixLen, ".ugxc") != 0)
+	{
+		return false;
+	}
+
+	restFileOut = modeFile.substr(0, modeFile.size() - 1);
+	if(!FileExists(restFileOut.c_str()))
+		return false;
+
+	UGXObjectReader ugxReader;
+	if(!ugxReader.parse_file(restFileOut.c_str()) || ugxReader.num_grids() < 1
+	   || !ugxReader.grid_parallel(restGridOut, 0, aPosition))
+	{
+		UG_LOG("WARNING: could not load the rest positions " << restFileOut << "\n");
+		return false;
+	}
+	return restGridOut.num_vertices() == modeGrid.num_vertices();
+}
+
+bool FindModeVertexCorrespondence(vector<size_t>& refIndsOut,
+								  Grid& modeGrid, const string& modeFile,
+								  Grid& refGrid, const string& refFile)
+{
+	Grid restGrid(GRIDOPT_STANDARD_INTERCONNECTION);
+	string restFile;
+	if(LoadRestGrid(restGrid, restFile, modeGrid, modeFile))
+		return FindVertexCorrespondence(refIndsOut, restGrid, restFile, refGrid, refFile);
+	return FindVertexCorrespondence(refIndsOut, modeGrid, modeFile, refGrid, refFile);
+}
+
+void InvertVertexCorrespondence(vector<size_t>& invOut, const vector<size_t>& refInds)
+{
+	invOut.clear();
+	if(refInds.empty())
+		return;
+
+	invOut.assign(refInds.size(), refInds.size());
+	for(size_t i = 0; i < refInds.size(); ++i){
+		if(refInds[i] < invOut.size())
+			invOut[refInds[i]] = i;
+	}
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#ifndef __H__EMVIS_vertex_correspondence__
+#define __H__EMVIS_vertex_correspondence__
+
+#include <string>
+#include <vector>
+#include "lib_grid/lib_grid.h"
+
+///	true if both grids contain the same elements on the same vertex indices.
+/**	Elements may be stored in a different order. Only the corners of the
+ * elements of the highest dimension are compared, positions are ignored, so
+ * that a mode grid with displaced vertices can be compared to its reference
+ * grid. Grids without edges, faces and volumes are assumed to match.*/
+bool VerticesHaveSameOrder(ug::Grid& modeGrid, ug::Grid& refGrid);
+
+///	finds the vertex of refGrid at the position of each vertex of modeGrid.
+/**	refIndsOut[i] is the index of the reference vertex which lies closest to
+ * the i-th vertex of modeGrid, at a distance of at most tolerance. Reference
+ * vertices are looked up in a spatial hash with cells of size 2 * tolerance.
+ * Returns false if the grids have different numbers of vertices or if a vertex
+ * has no partner or shares it with another vertex.*/
+bool MatchVerticesByPosition(std::vector<size_t>& refIndsOut,
+							 ug::Grid& modeGrid, ug::Grid& refGrid,
+							 number tolerance);
+
+///	a tolerance for MatchVerticesByPosition relative to the extent of grid
+number DefaultVertexMatchTolerance(ug::Grid& grid);
+
+///	finds the correspondence of the vertices of a mode grid and its reference grid.
+/**	refIndsOut is cleared if both grids list their vertices in the same order,
+ * see VerticesHaveSameOrder. Otherwise the vertices are matched by position
+ * and refIndsOut[i] holds the index of the reference vertex of the i-th mode
+ * vertex. Such permutations are cached per pair of files and reused as long
+ * as the positions still match.
+ * Returns false if no correspondence was found. This happens if a reordered
+ * mode grid stores its displaced positions instead of its rest positions.*/
+bool FindVertexCorrespondence(std::vector<size_t>& refIndsOut,
+							  ug::Grid& modeGrid, const std::string& modeFile,
+							  ug::Grid& refGrid, const std::string& refFile);
+
+///	loads the rest positions of a mode file (*.ugxc) from the *.ugx file next to it
+/**	The vertices of both files are listed in the same order. Returns false if
+ * there is no such file or if it doesn't fit to modeGrid.*/
+bool LoadRestGrid(ug::Grid& restGridOut, std::string& restFileOut,
+				  ug::Grid& modeGrid, const std::string& modeFile);
+
+///	FindVertexCorrespondence for a mode grid with displaced positions.
+/**	The positions of a mode file (*.ugxc) are displaced. If its rest positions
+ * lie next to it (see LoadRestGrid), they are matched instead of modeGrid.*/
+bool FindModeVertexCorrespondence(std::vector<size_t>& refIndsOut,
+								  ug::Grid& modeGrid, const std::string& modeFile,
+								  ug::Grid& refGrid, const std::string& refFile);
+
+///	index of the reference vertex of the i-th mode vertex
+inline size_t CorrespondingVertexIndex(const std::vector<size_t>& refInds, size_t i)
+{
+	return refInds.empty() ? i : refInds[i];
+}
+
+///	invOut[refInds[i]] = i. invOut stays empty if refInds is empty.
+/**	Entries of invOut which no vertex maps to are set to refInds.size(),
+ * indices in refInds beyond that size are ignored.*/
+void InvertVertexCorrespondence(std::vector<size_t>& invOut,
+								const std::vector<size_t>& refInds);
+
+#endif
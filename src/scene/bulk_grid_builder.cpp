@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#include "bulk_grid_builder.h"
+
+using namespace std;
+using namespace ug;
+
+BulkGridBuilder::
+BulkGridBuilder(Grid& grid, APosition& aPos) :
+	m_grid(grid),
+	m_finished(false)
+{
+	m_gridOptions = grid.get_options();
+	grid.set_options(GRIDOPT_NONE);
+
+	if(!grid.has_vertex_attachment(aPos))
+		grid.attach_to_vertices(aPos);
+	m_aaPos.access(grid, aPos);
+}
+
+BulkGridBuilder::
+~BulkGridBuilder()
+{
+	finish();
+}
+
+void BulkGridBuilder::
+reserve(size_t numVrts, size_t numEdges, size_t numFaces, size_t numVols)
+{
+	m_grid.reserve<Vertex>(m_grid.num_vertices() + numVrts);
+	m_grid.reserve<Edge>(m_grid.num_edges() + numEdges);
+	m_grid.reserve<Face>(m_grid.num_faces() + numFaces);
+	m_grid.reserve<Volume>(m_grid.num_volumes() + numVols);
+	m_vrts.reserve(m_vrts.size() + numVrts);
+	m_edges.reserve(m_edges.size() + numEdges);
+	m_faces.reserve(m_faces.size() + numFaces);
+	m_vols.reserve(m_vols.size() + numVols);
+}
+
+void BulkGridBuilder::
+add_grid(Grid& src, APosition& aPosSrc)
+{
+	PROFILE_FUNC();
+
+	Grid::VertexAttachmentAccessor<APosition> aaPosSrc(src, aPosSrc);
+	AInt aIndex;
+	src.attach_to_vertices(aIndex);
+	Grid::VertexAttachmentAccessor<AInt> aaIndex(src, aIndex);
+
+//	flatten the source grid
+	vector<number> coords;
+	coords.reserve(3 * src.num_vertices());
+	int numVrts = (int)m_vrts.size();
+	for(VertexIterator iter = src.begin<Vertex>(); iter != src.end<Vertex>(); ++iter){
+		const vector3& p = aaPosSrc[*iter];
+		coords.push_back(p.x());
+		coords.push_back(p.y());
+		coords.push_back(p.z());
+		aaIndex[*iter] = numVrts++;
+	}
+
+	vector<int> edgeInds, triInds, quadInds, tetInds, hexInds, prismInds, pyraInds;
+	edgeInds.reserve(2 * src.num_edges());
+	for(EdgeIterator iter = src.begin<Edge>(); iter != src.end<Edge>(); ++iter){
+		edgeInds.push_back(aaIndex[(*iter)->vertex(0)]);
+		edgeInds.push_back(aaIndex[(*iter)->vertex(1)]);
+	}
+
+	for(FaceIterator iter = src.begin<Face>(); iter != src.end<Face>(); ++iter){
+		Face* f = *iter;
+		vector<int>& inds = (f->num_vertices() == 3) ? triInds : quadInds;
+		for(size_t i = 0; i < f->num_vertices(); ++i)
+			inds.push_back(aaIndex[f->vertex(i)]);
+	}
+
+	for(VolumeIterator iter = src.begin<Volume>(); iter != src.end<Volume>(); ++iter){
+		Volume* v = *iter;
+		vector<int>* inds = NULL;
+		switch(v->reference_object_id()){
+			case ROID_TETRAHEDRON:	inds = &tetInds; break;
+			case ROID_HEXAHEDRON:	inds = &hexInds; break;
+			case ROID_PRISM:		inds = &prismInds; break;
+			case ROID_PYRAMID:		inds = &pyraInds; break;
+			default:
+				UG_LOG("WARNING in BulkGridBuilder::add_grid: skipping unsupported volume.\n");
+				continue;
+		}
+		for(size_t i = 0; i < v->num_vertices(); ++i)
+			inds->push_back(aaIndex[v->vertex(i)]);
+	}
+
+	src.detach_from_vertices(aIndex);
+
+//	vertices and edges keep the order of the source grid, faces and volumes
+//	are grouped by their type
+	reserve(coords.size() / 3, src.num_edges(), src.num_faces(), src.num_volumes());
+	if(!coords.empty())		add_vertices(&coords.front(), coords.size() / 3);
+	if(!edgeInds.empty())	add_elements<RegularEdge>(&edgeInds.front(), edgeInds.size() / 2);
+	if(!triInds.empty())	add_elements<Triangle>(&triInds.front(), triInds.size() / 3);
+	if(!quadInds.empty())	add_elements<Quadrilateral>(&quadInds.front(), quadInds.size() / 4);
+	if(!tetInds.empty())	add_elements<Tetrahedron>(&tetInds.front(), tetInds.size() / 4);
+	if(!hexInds.empty())	add_elements<Hexahedron>(&hexInds.front(), hexInds.size() / 8);
+	if(!prismInds.empty())	add_elements<Prism>(&prismInds.front(), prismInds.size() / 6);
+	if(!pyraInds.empty())	add_elements<Pyramid>(&pyraInds.front(), pyraInds.size() / 5);
+}
+
+void BulkGridBuilder::
+finish()
+{
+	if(m_finished)
+		return;
+
+	PROFILE_FUNC();
+	m_finished = true;
+	m_grid.set_options(m_gridOptions);
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#ifndef __H__EMVIS_bulk_grid_builder__
+#define __H__EMVIS_bulk_grid_builder__
+
+#include <vector>
+#include "lib_grid/lib_grid.h"
+
+////////////////////////////////////////////////////////////////////////
+///	creates the elements of a grid from flat coordinate and index arrays.
+/**	While the builder is active all options of the grid are disabled, so that
+ * Grid::create neither generates missing sides nor registers neighbour
+ * associations for each new element. Storage of the elements and of their
+ * attachments is reserved per block. finish() (or the destructor) restores
+ * the options of the grid, which builds all associations in a single pass.
+ *
+ * Indices refer to the vertices created by the builder, in the order in which
+ * they were added. They are not checked, see add_elements.*/
+class BulkGridBuilder
+{
+	public:
+		BulkGridBuilder(ug::Grid& grid, ug::APosition& aPos = ug::aPosition);
+		~BulkGridBuilder();
+
+	///	reserves element storage of the grid for the given numbers of new elements
+		void reserve(size_t numVrts, size_t numEdges, size_t numFaces, size_t numVols);
+
+	///	creates numVrts vertices, coords holds numCoords values per vertex
+	/**	missing coordinates are set to 0, surplus ones are ignored.*/
+		template <class TReal>
+		void add_vertices(const TReal* coords, size_t numVrts, int numCoords = 3);
+
+	///	creates numElems elements of type TElem, each given by its corner indices
+	/**	TElem has to be one of RegularEdge, Triangle, Quadrilateral, Tetrahedron,
+	 * Hexahedron, Prism, Pyramid.*/
+		template <class TElem, class TIndex>
+		void add_elements(const TIndex* inds, size_t numElems);
+
+	///	creates a copy of all vertices, edges, faces and volumes of src
+	/**	Vertices and edges keep their order, faces and volumes are grouped by type.
+	 * Constrained elements are copied as regular elements.*/
+		void add_grid(ug::Grid& src, ug::APosition& aPosSrc = ug::aPosition);
+
+	///	restores the options of the grid and thus builds its associations
+		void finish();
+
+		ug::Grid& grid()							{return m_grid;}
+		std::vector<ug::Vertex*>& vertices()		{return m_vrts;}
+		std::vector<ug::Edge*>& edges()			{return m_edges;}
+		std::vector<ug::Face*>& faces()			{return m_faces;}
+		std::vector<ug::Volume*>& volumes()		{return m_vols;}
+
+	protected:
+		static size_t num_corners(ug::RegularEdge*)		{return 2;}
+		static size_t num_corners(ug::Triangle*)		{return 3;}
+		static size_t num_corners(ug::Quadrilateral*)	{return 4;}
+		static size_t num_corners(ug::Tetrahedron*)		{return 4;}
+		static size_t num_corners(ug::Hexahedron*)		{return 8;}
+		static size_t num_corners(ug::Prism*)			{return 6;}
+		static size_t num_corners(ug::Pyramid*)			{return 5;}
+
+		void add_element(ug::RegularEdge*, ug::Vertex** v)
+			{m_edges.push_back(*m_grid.create<ug::RegularEdge>(ug::EdgeDescriptor(v[0], v[1])));}
+		void add_element(ug::Triangle*, ug::Vertex** v)
+			{m_faces.push_back(*m_grid.create<ug::Triangle>(ug::TriangleDescriptor(v[0], v[1], v[2])));}
+		void add_element(ug::Quadrilateral*, ug::Vertex** v)
+			{m_faces.push_back(*m_grid.create<ug::Quadrilateral>(
+								ug::QuadrilateralDescriptor(v[0], v[1], v[2], v[3])));}
+		void add_element(ug::Tetrahedron*, ug::Vertex** v)
+			{m_vols.push_back(*m_grid.create<ug::Tetrahedron>(
+								ug::TetrahedronDescriptor(v[0], v[1], v[2], v[3])));}
+		void add_element(ug::Hexahedron*, ug::Vertex** v)
+			{m_vols.push_back(*m_grid.create<ug::Hexahedron>(
+								ug::HexahedronDescriptor(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7])));}
+		void add_element(ug::Prism*, ug::Vertex** v)
+			{m_vols.push_back(*m_grid.create<ug::Prism>(
+								ug::PrismDescriptor(v[0], v[1], v[2], v[3], v[4], v[5])));}
+		void add_element(ug::Pyramid*, ug::Vertex** v)
+			{m_vols.push_back(*m_grid.create<ug::Pyramid>(
+								ug::PyramidDescriptor(v[0], v[1], v[2], v[3], v[4])));}
+
+	protected:
+		ug::Grid&			m_grid;
+		ug::Grid::VertexAttachmentAccessor<ug::APosition>	m_aaPos;
+		uint				m_gridOptions;
+		bool				m_finished;
+
+		std::vector<ug::Vertex*>	m_vrts;
+		std::vector<ug::Edge*>		m_edges;
+		std::vector<ug::Face*>		m_faces;
+		std::vector<ug::Volume*>	m_vols;
+};
+
+
+template <class TReal>
+void BulkGridBuilder::
+add_vertices(const TReal* coords, size_t numVrts, int numCoords)
+{
+	const int minNumCoords = numCoords < 3 ? numCoords : 3;
+	m_grid.reserve<ug::Vertex>(m_grid.num_vertices() + numVrts);
+	m_vrts.reserve(m_vrts.size() + numVrts);
+
+	for(size_t i = 0; i < numVrts; ++i){
+		ug::vector3 v(0, 0, 0);
+		for(int j = 0; j < minNumCoords; ++j)
+			v[j] = coords[i * numCoords + j];
+
+		ug::RegularVertex* vrt = *m_grid.create<ug::RegularVertex>();
+		m_aaPos[vrt] = v;
+		m_vrts.push_back(vrt);
+	}
+}
+
+template <class TElem, class TIndex>
+void BulkGridBuilder::
+add_elements(const TIndex* inds, size_t numElems)
+{
+	typedef typename ug::geometry_traits<TElem>::grid_base_object TBaseElem;
+	const size_t numCorners = num_corners((TElem*)NULL);
+	m_grid.reserve<TBaseElem>(m_grid.num<TBaseElem>() + numElems);
+
+	ug::Vertex* corners[8];
+	for(size_t i = 0; i < numElems; ++i){
+		for(size_t j = 0; j < numCorners; ++j)
+			corners[j] = m_vrts[inds[i * numCorners + j]];
+		add_element((TElem*)NULL, corners);
+	}
+}
+
+#endif
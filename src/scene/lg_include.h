@@ -77,6 +77,87 @@ bool ClipFace(Face* f, const ug::Sphere3& boundingSphere, ug::Plane& clipPlane,
 bool ClipVolume(Volume* v, const ug::Sphere3& boundingSphere, ug::Plane& clipPlane,
 				Grid::VertexAttachmentAccessor<APosition>& aaPos);
 
+///	calculates the normals of the given faces on contiguous ranges in parallel.
+void CalculateFaceNormalsParallel(const std::vector<Face*>& faces,
+								  Grid::VertexAttachmentAccessor<APosition>& aaPos,
+								  Grid::FaceAttachmentAccessor<ANormal>& aaNorm);
+
+///	calculates the bounding spheres of the given faces on contiguous ranges in parallel.
+void CalculateBoundingSpheresParallel(const std::vector<Face*>& faces,
+									  Grid::VertexAttachmentAccessor<APosition>& aaPos,
+									  Grid::FaceAttachmentAccessor<ASphere>& aaSphere);
+
+///	calculates the bounding spheres of the given volumes on contiguous ranges in parallel.
+void CalculateBoundingSpheresParallel(const std::vector<Volume*>& vols,
+									  Grid::VertexAttachmentAccessor<APosition>& aaPos,
+									  Grid::VolumeAttachmentAccessor<ASphere>& aaSphere);
+
+///	calculates the bounding box of the given vertices on contiguous ranges in parallel.
+/**	If vrts is empty, both corners are set to the origin.*/
+void CalculateBoundingBoxParallel(vector3& vMinOut, vector3& vMaxOut,
+								  const std::vector<Vertex*>& vrts,
+								  Grid::VertexAttachmentAccessor<APosition>& aaPos);
+
+///	faces of each vertex of a grid in compressed row storage.
+/**	The faces of vertices[i] are faces[faceInds[j]] for j in
+ * [offsets[i], offsets[i+1]). vertices holds the corners of faces only. The
+ * adjacency only depends on the topology of the grid. It has to be rebuilt if
+ * elements are created or erased.*/
+struct VertexFaceAdjacency
+{
+	std::vector<Vertex*>		vertices;
+	std::vector<Face*>			faces;
+	std::vector<size_t>			offsets;
+	std::vector<unsigned int>	faceInds;
+///	area weighted face normals, reused by CalculateVertexNormalsParallel
+	std::vector<vector3>		weightedNormals;
+
+	void clear();
+	bool empty() const		{return offsets.empty();}
+};
+
+///	builds the vertex-to-face adjacency of all faces of grid.
+void BuildVertexFaceAdjacency(VertexFaceAdjacency& adjOut, Grid& grid);
+
+///	builds the vertex-to-face adjacency of the given faces of grid.
+void BuildVertexFaceAdjacency(VertexFaceAdjacency& adjOut, Grid& grid,
+							  const std::vector<Face*>& faces);
+
+///	calculates area weighted vertex normals on contiguous ranges in parallel.
+/**	First computes the weighted normal of each face of adj, then sums them up
+ * for each vertex and normalizes the result.*/
+void CalculateVertexNormalsParallel(VertexFaceAdjacency& adj,
+									Grid::VertexAttachmentAccessor<APosition>& aaPos,
+									Grid::VertexAttachmentAccessor<ANormal>& aaVrtNorm);
+
+///	recalculates the normals of the vertices adj.vertices[vrtInds[i]] only.
+/**	faceInds holds the indices in adj.faces of all faces of these vertices,
+ * see CollectVertexFaceAdjacencyRing. Only their weighted normals are
+ * updated, the ones of the other faces are reused.*/
+void CalculateVertexNormalsParallel(VertexFaceAdjacency& adj,
+									const std::vector<size_t>& vrtInds,
+									const std::vector<size_t>& faceInds,
+									Grid::VertexAttachmentAccessor<APosition>& aaPos,
+									Grid::VertexAttachmentAccessor<ANormal>& aaVrtNorm);
+
+///	collects the corners of faces and the faces of these corners in adj.
+/**	The indices refer to adj.vertices and adj.faces. Uses the marks of grid.*/
+void CollectVertexFaceAdjacencyRing(std::vector<size_t>& vrtIndsOut,
+									std::vector<size_t>& faceIndsOut,
+									const VertexFaceAdjacency& adj, Grid& grid,
+									const std::vector<Face*>& faces);
+
+///	writes the elements between begin and end to elemsOut.
+template <class TElem, class TIterator>
+void CollectElements(std::vector<TElem*>& elemsOut, TIterator begin, TIterator end,
+					 size_t numElems)
+{
+	elemsOut.clear();
+	elemsOut.reserve(numElems);
+	for(TIterator iter = begin; iter != end; ++iter)
+		elemsOut.push_back(*iter);
+}
+
 }
 ////////////////////////////////////////////////////////////////////////
 //	math
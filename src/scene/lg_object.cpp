@@ -26,14 +26,20 @@
  */
 
 #include <cstring>
+#include <sstream>
 #include <string>
 #include "main_window.h"
 #include "lg_object.h"
+#include "bulk_grid_builder.h"
+#include "util/frame_profiler.h"
+#include "oscillation/displacements.h"
 #include "lib_grid/file_io/file_io.h"
 #include "lib_grid/file_io/file_io_art.h"
 #include "lib_grid/file_io/file_io_dump.h"
 #include "lib_grid/file_io/file_io_ugx.h"
 #include "../vtustuff/ug_bridge_vtu.cpp"
+#include "../vtustuff/ug_bridge_ugx.cpp"
+#include "../vtustuff/ug_bridge_stl.cpp"
 #include "app.h"
 
 #include "common/util/index_list_util.h"
@@ -43,7 +49,7 @@ using namespace std;
 using namespace ug;
 
 const char* LG_SUPPORTED_FILE_FORMATS_OPEN =
-				"*.ugx *.ugxc *.vtu *.txt";
+				"*.ugx *.ugxc *.vtu *.stl *.txt";
 
 LGObject* CreateLGObjectFromFile(const char* filename, unsigned screen, unsigned idx)
 {
@@ -69,6 +75,8 @@ bool LoadLGObjectFromFile(LGObject* pObjOut, const char* filename,
                           bool performLoadPostprocessing, unsigned screen, unsigned idx)
 {
 	PROFILE_FUNC();
+	FRAME_PROFILE_STAGE(PS_LOAD);
+	TRACE_SCOPE("LoadLGObjectFromFile");
 
 	Grid& grid = pObjOut->grid();
 	SubsetHandler& sh = pObjOut->subset_handler();
@@ -86,7 +94,7 @@ bool LoadLGObjectFromFile(LGObject* pObjOut, const char* filename,
 	if(strcmp(pSuffix, ".ugx") == 0 || strcmp(pSuffix, ".ugxc") == 0)
 	{
 	//	load from ugx
-		GridReaderUGX ugxReader;
+		UGXObjectReader ugxReader;
 		if(!ugxReader.parse_file(filename)){
 			UG_LOG("ERROR in LoadGridFromUGX: File not found: " << filename << std::endl);
 			bLoadSuccessful = false;
@@ -96,10 +104,12 @@ bool LoadLGObjectFromFile(LGObject* pObjOut, const char* filename,
 				UG_LOG("ERROR in LoadGridFromUGX: File contains no grid.\n");
 				bLoadSuccessful = false;
 			}
+			else if(!ugxReader.grid_parallel(grid, 0, aPosition)){
+				UG_LOG("ERROR in LoadGridFromUGX: Invalid grid in " << filename << std::endl);
+				grid.clear_geometry();
+				bLoadSuccessful = false;
+			}
 			else{
-
-				ugxReader.grid(grid, 0, aPosition);
-
 				if(ugxReader.num_subset_handlers(0) > 0)
 					ugxReader.subset_handler(sh, 0, 0);
 
@@ -121,6 +131,10 @@ bool LoadLGObjectFromFile(LGObject* pObjOut, const char* filename,
 
 		bLoadSuccessful = LoadVTUObjectFromFile(pObjOut, filename);
 	}
+	else if(strcmp(pSuffix, ".stl") == 0 || strcmp(pSuffix, ".STL") == 0){
+		bLoadSuccessful = LoadSTLObjectFromFile(pObjOut, filename);
+		bSetDefaultSubsetColors = true;
+	}
 	else if(strcmp(pSuffix, ".txt") == 0){
 		std::ifstream fin(filename);
 		if(!fin){
@@ -144,6 +158,8 @@ bool LoadLGObjectFromFile(LGObject* pObjOut, const char* filename,
 
 	if(bLoadSuccessful)
 	{
+		pObjOut->topology_changed();
+
 	//	initialize the subset-colors
 		if(bSetDefaultSubsetColors)
 			AssignSubsetColors(pObjOut->subset_handler());
@@ -162,6 +178,7 @@ bool LoadLGObjectFromFile(LGObject* pObjOut, const char* filename,
 void PerformLoadPostprocessing(LGObject* obj)
 {
 	PROFILE_FUNC();
+	TRACE_SCOPE("PerformLoadPostprocessing");
 //	assign the name
 	std::string name = obj->m_fileName;
 	size_t slashPos = name.find_last_of('/');
@@ -192,7 +209,9 @@ void PerformLoadPostprocessing(LGObject* obj)
 bool ReloadLGObject(LGObject* obj, unsigned screen, unsigned idx)
 {
 	PROFILE_FUNC();
+	obj->clear_data_fields();
 	obj->grid().clear_geometry();
+	obj->topology_changed();
 	obj->subset_handler().clear();
 	obj->clear_action_log();
 	if(!LoadLGObjectFromFile(obj, obj->m_fileName.c_str(), true, screen, idx)){
@@ -219,6 +238,7 @@ LGObject::LGObject(const char* name)
 LGObject::~LGObject()
 {
 //TODO: release the display list.
+	clear_data_fields();
 }
 
 void LGObject::init()
@@ -242,8 +262,98 @@ void LGObject::init()
 	defSI.subsetState = LGSS_VISIBLE | LGSS_INITIALIZED;
 	m_subsetHandler.set_default_subset_info(defSI);
 
+	m_geometryChange = GC_FULL;
 	m_transformType = TT_NONE;
+	m_transformHasFixedVertices = false;
 	m_selectionDisplayListIndex = -1;
+	m_numRenderedTriangles = 0;
+
+	m_scalarMin = 0;
+	m_scalarMax = 1;
+	m_colormap = 0;
+
+	m_smoothShading = false;
+	m_transformNormalsCollected = false;
+	m_topologyStamp = 0;
+}
+
+void LGObject::set_vertex_scalars(const float* values, size_t num)
+{
+	if(num != m_vertexScalars.size())
+		m_scalarRenderData.valid = false;
+	m_vertexScalars.assign(values, values + num);
+}
+
+void LGObject::clear_vertex_scalars()
+{
+	m_vertexScalars.clear();
+	m_scalarRenderData = ScalarRenderData();
+}
+
+LGObject::DataField* LGObject::add_data_field(const char* name, int numComponents, int elemDim)
+{
+	if((numComponents != 1 && numComponents != 3)
+	   || (elemDim != 0 && elemDim != 2 && elemDim != 3))
+	{
+		return NULL;
+	}
+
+	DataField field;
+	field.name = name;
+	field.numComponents = numComponents;
+	field.elemDim = elemDim;
+	field.aNumber = NULL;
+	field.aVector = NULL;
+
+	IAttachment* a;
+	if(numComponents == 1)
+		a = field.aNumber = new ANumber;
+	else
+		a = field.aVector = new AVector3;
+
+	switch(elemDim){
+		case 0:	m_grid.attach_to_vertices(*a); break;
+		case 2:	m_grid.attach_to_faces(*a); break;
+		case 3:	m_grid.attach_to_volumes(*a); break;
+	}
+
+	m_dataFields.push_back(field);
+	return &m_dataFields.back();
+}
+
+void LGObject::clear_data_fields()
+{
+	for(size_t i = 0; i < m_dataFields.size(); ++i){
+		DataField& field = m_dataFields[i];
+		IAttachment* a = field.aNumber;
+		if(!a)
+			a = field.aVector;
+
+		switch(field.elemDim){
+			case 0:	m_grid.detach_from_vertices(*a); break;
+			case 2:	m_grid.detach_from_faces(*a); break;
+			case 3:	m_grid.detach_from_volumes(*a); break;
+		}
+
+		delete field.aNumber;
+		delete field.aVector;
+	}
+	m_dataFields.clear();
+}
+
+ug::AVector3* LGObject::displacement_attachment()
+{
+	AVector3* found = NULL;
+	for(size_t i = 0; i < m_dataFields.size(); ++i){
+		DataField& field = m_dataFields[i];
+		if(field.elemDim != 0 || !field.aVector)
+			continue;
+		if(field.name == "displacement")
+			return field.aVector;
+		if(field.name == "u" || !found)
+			found = field.aVector;
+	}
+	return found;
 }
 
 void LGObject::visuals_changed()
@@ -278,9 +388,22 @@ void LGObject::selection_changed()
 
 void LGObject::geometry_changed()
 {
-	CalculateFaceNormals(m_grid, m_grid.faces_begin(), m_grid.faces_end(), aPosition, aNormal);
+	FRAME_PROFILE_STAGE(PS_GEOMETRY_CHANGED);
+	m_geometryChange = GC_FULL;
+//	while positions are animated, normals are computed when the frame is prepared
+	if(!position_animation_active()){
+		calculate_face_normals();
+		calculate_vertex_normals();
+	}
 	update_bounding_shapes();
 
+//	the visuals of an animated object are prepared from the new positions by
+//	the scene. Reporting them as changed, too, would rebuild its display lists.
+	if(position_animation_active()){
+		emit sig_geometry_changed();
+		return;
+	}
+
 //	call base implementation
 	ISceneObject::geometry_changed();
 }
@@ -321,7 +444,7 @@ bool LGObject::load_ugx(const char* filename)
 	m_selector.clear();
 	m_grid.clear_geometry();
 
-	GridReaderUGX ugxReader;
+	UGXObjectReader ugxReader;
 	if(!ugxReader.parse_file(filename)){
 		UG_LOG("ERROR in LGObject::load_ugx: File not found: " << filename << std::endl);
 		return false;
@@ -331,9 +454,12 @@ bool LGObject::load_ugx(const char* filename)
 			UG_LOG("ERROR in LGObject::load_ugx: File contains no grid.\n");
 			return false;
 		}
+		else if(!ugxReader.grid_parallel(m_grid, 0, aPosition)){
+			UG_LOG("ERROR in LGObject::load_ugx: Invalid grid in " << filename << std::endl);
+			m_grid.clear_geometry();
+			return false;
+		}
 		else{
-			ugxReader.grid(m_grid, 0, aPosition);
-
 			if(ugxReader.num_subset_handlers(0) > 0)
 				ugxReader.subset_handler(m_subsetHandler, 0, 0);
 
@@ -371,11 +497,100 @@ void LGObject::set_num_display_lists(int num)
 	m_displayModes.resize(num, LGRM_DOUBLE_PASS_SHADED);
 }
 
+void LGObject::calculate_face_normals()
+{
+	if(!m_grid.has_face_attachment(aNormal))
+		m_grid.attach_to_faces(aNormal);
+
+	Grid::VertexAttachmentAccessor<APosition> aaPos(m_grid, aPosition);
+	Grid::FaceAttachmentAccessor<ANormal> aaNorm(m_grid, aNormal);
+	CalculateFaceNormalsParallel(face_list(), aaPos, aaNorm);
+}
+
+void LGObject::set_smooth_shading(bool enable)
+{
+	m_smoothShading = enable;
+	if(enable)
+		calculate_vertex_normals();
+	else
+		m_vrtFaceAdjacency.clear();
+}
+
+void LGObject::calculate_vertex_normals()
+{
+	if(!m_smoothShading)
+		return;
+
+//	the adjacency only has to be built once per topology. The rendered faces
+//	of volume grids are passed through set_shaded_faces.
+	if(m_vrtFaceAdjacency.empty()){
+		if(m_grid.num_volumes() > 0)
+			return;
+		BuildVertexFaceAdjacency(m_vrtFaceAdjacency, m_grid, face_list());
+		m_transformNormalsCollected = false;
+	}
+
+	if(!m_grid.has_vertex_attachment(aNormal))
+		m_grid.attach_to_vertices(aNormal);
+
+	Grid::VertexAttachmentAccessor<APosition> aaPos(m_grid, aPosition);
+	Grid::VertexAttachmentAccessor<ANormal> aaVrtNorm(m_grid, aNormal);
+	CalculateVertexNormalsParallel(m_vrtFaceAdjacency, aaPos, aaVrtNorm);
+}
+
+void LGObject::set_shaded_faces(const std::vector<Face*>& faces)
+{
+	if(!m_smoothShading)
+		return;
+
+	if(m_vrtFaceAdjacency.empty() || m_vrtFaceAdjacency.faces != faces){
+		BuildVertexFaceAdjacency(m_vrtFaceAdjacency, m_grid, faces);
+		m_transformNormalsCollected = false;
+	}
+	calculate_vertex_normals();
+}
+
+void LGObject::topology_changed()
+{
+	++m_topologyStamp;
+	m_vrtFaceAdjacency.clear();
+	m_transformNormalsCollected = false;
+	std::vector<Vertex*>().swap(m_vertexList);
+	std::vector<Face*>().swap(m_faceList);
+	std::vector<Volume*>().swap(m_volumeList);
+}
+
+//	the lists are empty after topology_changed, so that a mismatch of the
+//	sizes means that they have to be collected
+const std::vector<Vertex*>& LGObject::vertex_list()
+{
+	if(m_vertexList.size() != m_grid.num_vertices())
+		CollectElements(m_vertexList, m_grid.vertices_begin(), m_grid.vertices_end(),
+						m_grid.num_vertices());
+	return m_vertexList;
+}
+
+const std::vector<Face*>& LGObject::face_list()
+{
+	if(m_faceList.size() != m_grid.num_faces())
+		CollectElements(m_faceList, m_grid.faces_begin(), m_grid.faces_end(),
+						m_grid.num_faces());
+	return m_faceList;
+}
+
+const std::vector<Volume*>& LGObject::volume_list()
+{
+	if(m_volumeList.size() != m_grid.num_volumes())
+		CollectElements(m_volumeList, m_grid.volumes_begin(), m_grid.volumes_end(),
+						m_grid.num_volumes());
+	return m_volumeList;
+}
+
 void LGObject::update_bounding_shapes()
 {
 //	calculate mesh center and radius
 	Grid::VertexAttachmentAccessor<APosition> aaPos(m_grid, aPosition);
-	CalculateBoundingBox(m_boundBoxMin, m_boundBoxMax, m_grid.vertices_begin(), m_grid.vertices_end(), aaPos);
+	CalculateBoundingBoxParallel(m_boundBoxMin, m_boundBoxMax, vertex_list(), aaPos);
 	m_boundSphere.set_radius(VecDistance(m_boundBoxMin, m_boundBoxMax) / 2.f);
 	vector3 center;
 	VecAdd(center, m_boundBoxMin, m_boundBoxMax);
@@ -487,6 +702,108 @@ void LGObject::init_transform()
 										   m_transformVertices.end(), aaPos);
 	m_transformCur = m_transformStart;
 	m_transformCurScales = vector3(1.f, 1.f, 1.f);
+
+//	collect the elements which contain a transform vertex and the box of
+//	the vertices which stay in place. The grid doesn't necessarily store
+//	the faces of vertices, so we iterate over all elements once.
+	m_transformFaces.clear();
+	m_transformVolumes.clear();
+	m_transformNormalsCollected = false;
+
+	m_grid.begin_marking();
+	for(size_t i = 0; i < m_transformVertices.size(); ++i)
+		m_grid.mark(m_transformVertices[i]);
+
+	for(FaceIterator iter = m_grid.faces_begin(); iter != m_grid.faces_end(); ++iter){
+		Face* f = *iter;
+		for(size_t i = 0; i < f->num_vertices(); ++i){
+			if(m_grid.is_marked(f->vertex(i))){
+				m_transformFaces.push_back(f);
+				break;
+			}
+		}
+	}
+
+	for(VolumeIterator iter = m_grid.volumes_begin(); iter != m_grid.volumes_end(); ++iter){
+		Volume* v = *iter;
+		for(size_t i = 0; i < v->num_vertices(); ++i){
+			if(m_grid.is_marked(v->vertex(i))){
+				m_transformVolumes.push_back(v);
+				break;
+			}
+		}
+	}
+
+	std::vector<Vertex*> fixedVrts;
+	fixedVrts.reserve(m_grid.num_vertices() - m_transformVertices.size());
+	for(VertexIterator iter = m_grid.vertices_begin(); iter != m_grid.vertices_end(); ++iter){
+		if(!m_grid.is_marked(*iter))
+			fixedVrts.push_back(*iter);
+	}
+	m_grid.end_marking();
+
+	m_transformHasFixedVertices = !fixedVrts.empty();
+	CalculateBoundingBoxParallel(m_transformFixedBoxMin, m_transformFixedBoxMax,
+								 fixedVrts, aaPos);
+}
+
+void LGObject::transform_geometry_changed()
+{
+	FRAME_PROFILE_STAGE(PS_GEOMETRY_CHANGED);
+//	a full update which was not processed yet also covers the transform elements
+	if(m_geometryChange != GC_FULL)
+		m_geometryChange = GC_PARTIAL;
+
+	Grid::VertexAttachmentAccessor<APosition> aaPos(m_grid, aPosition);
+	if(!position_animation_active()){
+		if(!m_grid.has_face_attachment(aNormal))
+			m_grid.attach_to_faces(aNormal);
+		Grid::FaceAttachmentAccessor<ANormal> aaNorm(m_grid, aNormal);
+		CalculateFaceNormalsParallel(m_transformFaces, aaPos, aaNorm);
+		update_transform_vertex_normals();
+	}
+
+//	the box of the fixed vertices is known, only the moved ones are added
+	CalculateBoundingBoxParallel(m_boundBoxMin, m_boundBoxMax, m_transformVertices, aaPos);
+	if(m_transformHasFixedVertices){
+		if(m_transformVertices.empty()){
+			m_boundBoxMin = m_transformFixedBoxMin;
+			m_boundBoxMax = m_transformFixedBoxMax;
+		}
+		else{
+			VecCompMin(m_boundBoxMin, m_boundBoxMin, m_transformFixedBoxMin);
+			VecCompMax(m_boundBoxMax, m_boundBoxMax, m_transformFixedBoxMax);
+		}
+	}
+
+	m_boundSphere.set_radius(VecDistance(m_boundBoxMin, m_boundBoxMax) / 2.f);
+	vector3 center;
+	VecAdd(center, m_boundBoxMin, m_boundBoxMax);
+	VecScale(center, center, 0.5f);
+	m_boundSphere.set_center(center);
+
+	ISceneObject::geometry_changed();
+}
+
+void LGObject::update_transform_vertex_normals()
+{
+	if(!smooth_shading_active()){
+		calculate_vertex_normals();
+		return;
+	}
+
+//	only the corners of the moved faces get new normals. These depend on
+//	the faces around them, which are found through the adjacency.
+	if(!m_transformNormalsCollected){
+		CollectVertexFaceAdjacencyRing(m_transformNormalVrts, m_transformNormalFaces,
+									   m_vrtFaceAdjacency, m_grid, m_transformFaces);
+		m_transformNormalsCollected = true;
+	}
+
+	Grid::VertexAttachmentAccessor<APosition> aaPos(m_grid, aPosition);
+	Grid::VertexAttachmentAccessor<ANormal> aaVrtNorm(m_grid, aNormal);
+	CalculateVertexNormalsParallel(m_vrtFaceAdjacency, m_transformNormalVrts,
+								   m_transformNormalFaces, aaPos, aaVrtNorm);
 }
 
 void LGObject::begin_transform(TransformType tt)
@@ -519,8 +836,8 @@ void LGObject::grab(const ug::vector3& offset)
 
 	VecAdd(m_transformCur, m_transformStart, offset);
 
-//	the geometry has changed. We thus have to update them
-	geometry_changed();
+//	only the transform vertices moved. We thus only have to update their elements
+	transform_geometry_changed();
 }
 
 void LGObject::scale(const ug::vector3& scaleFacs)
@@ -543,8 +860,8 @@ void LGObject::scale(const ug::vector3& scaleFacs)
 
 	m_transformCurScales = scaleFacs;
 
-//	the geometry has changed. We thus have to update them
-	geometry_changed();
+//	only the transform vertices moved. We thus only have to update their elements
+	transform_geometry_changed();
 }
 
 void LGObject::end_transform(bool bApply)
@@ -585,6 +902,9 @@ void LGObject::end_transform(bool bApply)
 	}
 
 	m_transformType = TT_NONE;
+	m_transformFaces.clear();
+	m_transformVolumes.clear();
+	m_transformNormalsCollected = false;
 //	we call geometry_changed again, to generate an undo-entry
 //	(since transform type no is set to TT_NONE)
 	geometry_changed();
@@ -625,6 +945,433 @@ void LGObject::restore_vertex_coordinates_from_buffer()
 }
 
 
+bool LGObject::begin_position_animation(Grid& restGrid,
+										const std::vector<size_t>* restInds)
+{
+	PROFILE_FUNC();
+	const size_t numVrts = m_grid.num<Vertex>();
+	const size_t numRestVrts = restGrid.num<Vertex>();
+	if(restInds && !restInds->empty()){
+		bool valid = (restInds->size() == numVrts);
+		for(size_t i = 0; valid && i < restInds->size(); ++i)
+			valid = ((*restInds)[i] < numRestVrts);
+		if(!valid){
+			UG_LOG("ERROR in LGObject::begin_position_animation: invalid rest vertex indices for "
+				   << name() << "\n");
+			return false;
+		}
+	}
+	else if(numRestVrts != numVrts){
+		UG_LOG("ERROR in LGObject::begin_position_animation: the rest grid of "
+			   << name() << " has a different number of vertices\n");
+		return false;
+	}
+
+	buffer_current_vertex_coordinates();
+
+	Grid::VertexAttachmentAccessor<APosition> aaPosRest(restGrid, aPosition);
+	m_restPositions.clear();
+	m_restPositions.reserve(restGrid.num<Vertex>());
+	for(VertexIterator ivrt = restGrid.begin<Vertex>();
+		ivrt != restGrid.end<Vertex>(); ++ivrt)
+	{
+		m_restPositions.push_back(aaPosRest[*ivrt]);
+	}
+
+//	bring the rest positions into the order of our vertices
+	if(restInds && !restInds->empty()){
+		std::vector<vector3> restPositions(restInds->size());
+		for(size_t i = 0; i < restInds->size(); ++i)
+			restPositions[i] = m_restPositions[(*restInds)[i]];
+		m_restPositions.swap(restPositions);
+	}
+
+	set_animated_positions(std::vector<vector3>());
+	return true;
+}
+
+
+void LGObject::set_animated_positions(const std::vector<vector3>& offsets, number scale)
+{
+	FRAME_PROFILE_STAGE(PS_ANIMATION);
+	position_accessor_t aaPos = position_accessor();
+	SuperposeDisplacements(grid(), aaPos, m_restPositions, offsets, scale);
+}
+
+
+void LGObject::end_position_animation()
+{
+	if(!position_animation_active())
+		return;
+
+	std::vector<vector3>().swap(m_restPositions);
+	restore_vertex_coordinates_from_buffer();
+	std::vector<vector3>().swap(m_vertexCoordinateBuffer);
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//	memory
+LGMemoryFootprint& LGMemoryFootprint::operator += (const LGMemoryFootprint& m)
+{
+	grid += m.grid;
+	associations += m.associations;
+	attachments += m.attachments;
+	subsetHandlers += m.subsetHandlers;
+	glBuffers += m.glBuffers;
+	displacementCaches += m.displacementCaches;
+	return *this;
+}
+
+std::string LGMemoryFootprint::to_string() const
+{
+	const double mb = 1024. * 1024.;
+	std::stringstream ss;
+	ss.precision(2);
+	ss << std::fixed;
+	ss << "total:               " << total() / mb << " MB\n";
+	ss << "  grid elements:     " << grid / mb << " MB\n";
+	ss << "  associations:      " << associations / mb << " MB\n";
+	ss << "  attachments:       " << attachments / mb << " MB\n";
+	ss << "  subset handlers:   " << subsetHandlers / mb << " MB\n";
+	ss << "  gl buffers:        " << glBuffers / mb << " MB\n";
+	ss << "  displacement data: " << displacementCaches / mb << " MB";
+	return ss.str();
+}
+
+///	element storage including the links of the section container
+template <class TElem>
+static size_t ElementBytes(Grid& g)
+{
+	return g.num<TElem>() * (sizeof(TElem) + 2 * sizeof(void*));
+}
+
+template <class TElem>
+static size_t VectorBytes(const std::vector<TElem>& v)
+{
+	return v.capacity() * sizeof(TElem);
+}
+
+LGMemoryFootprint LGObject::memory_footprint()
+{
+	LGMemoryFootprint m;
+	Grid& g = m_grid;
+
+	const size_t numVrts = g.num<Vertex>();
+	const size_t numEdges = g.num<Edge>();
+	const size_t numFaces = g.num<Face>();
+	const size_t numVols = g.num<Volume>();
+	const size_t numTris = g.num<Triangle>();
+	const size_t numQuads = g.num<Quadrilateral>();
+	const size_t numTets = g.num<Tetrahedron>();
+	const size_t numHexes = g.num<Hexahedron>();
+	const size_t numPrisms = g.num<Prism>();
+	const size_t numPyras = g.num<Pyramid>();
+	const size_t numOtherFaces = numFaces - numTris - numQuads;
+	const size_t numOtherVols = numVols - numTets - numHexes - numPrisms - numPyras;
+
+	m.grid = ElementBytes<RegularVertex>(g)
+			+ (numVrts - g.num<RegularVertex>()) * (sizeof(ConstrainedVertex) + 2 * sizeof(void*))
+			+ numEdges * (sizeof(RegularEdge) + 2 * sizeof(void*))
+			+ ElementBytes<Triangle>(g) + ElementBytes<Quadrilateral>(g)
+			+ numOtherFaces * (sizeof(Quadrilateral) + 2 * sizeof(void*))
+			+ ElementBytes<Tetrahedron>(g) + ElementBytes<Hexahedron>(g)
+			+ ElementBytes<Prism>(g) + ElementBytes<Pyramid>(g)
+			+ numOtherVols * (sizeof(Hexahedron) + 2 * sizeof(void*));
+
+//	number of corners, edges and sides summed over all faces and volumes
+	const size_t faceCorners = 3 * numTris + 4 * (numQuads + numOtherFaces);
+	const size_t volCorners = 4 * numTets + 8 * numHexes + 6 * numPrisms + 5 * numPyras + 6 * numOtherVols;
+	const size_t volEdges = 6 * numTets + 12 * numHexes + 9 * numPrisms + 8 * numPyras + 12 * numOtherVols;
+	const size_t volSides = 4 * numTets + 6 * numHexes + 5 * numPrisms + 5 * numPyras + 8 * numOtherVols;
+
+//	each enabled option stores a vector of neighbours per element
+	const size_t ptr = sizeof(void*);
+	const size_t vec = sizeof(std::vector<void*>);
+	if(g.option_is_enabled(VRTOPT_STORE_ASSOCIATED_EDGES))
+		m.associations += numVrts * vec + 2 * numEdges * ptr;
+	if(g.option_is_enabled(VRTOPT_STORE_ASSOCIATED_FACES))
+		m.associations += numVrts * vec + faceCorners * ptr;
+	if(g.option_is_enabled(VRTOPT_STORE_ASSOCIATED_VOLUMES))
+		m.associations += numVrts * vec + volCorners * ptr;
+	if(g.option_is_enabled(EDGEOPT_STORE_ASSOCIATED_FACES))
+		m.associations += numEdges * vec + faceCorners * ptr;
+	if(g.option_is_enabled(EDGEOPT_STORE_ASSOCIATED_VOLUMES))
+		m.associations += numEdges * vec + volEdges * ptr;
+	if(g.option_is_enabled(FACEOPT_STORE_ASSOCIATED_EDGES))
+		m.associations += numFaces * vec + faceCorners * ptr;
+	if(g.option_is_enabled(FACEOPT_STORE_ASSOCIATED_VOLUMES))
+		m.associations += numFaces * vec + volSides * ptr;
+	if(g.option_is_enabled(VOLOPT_STORE_ASSOCIATED_EDGES))
+		m.associations += numVols * vec + volEdges * ptr;
+	if(g.option_is_enabled(VOLOPT_STORE_ASSOCIATED_FACES))
+		m.associations += numVols * vec + volSides * ptr;
+//	the element lists and the vertex-to-face adjacency of smooth shading
+	m.associations += VectorBytes(m_vertexList) + VectorBytes(m_faceList)
+					+ VectorBytes(m_volumeList);
+	m.associations += VectorBytes(m_vrtFaceAdjacency.vertices)
+					+ VectorBytes(m_vrtFaceAdjacency.faces)
+					+ VectorBytes(m_vrtFaceAdjacency.offsets)
+					+ VectorBytes(m_vrtFaceAdjacency.faceInds)
+					+ VectorBytes(m_vrtFaceAdjacency.weightedNormals);
+
+	if(g.has_vertex_attachment(aPosition))
+		m.attachments += numVrts * sizeof(vector3);
+	if(g.has_face_attachment(aNormal))
+		m.attachments += numFaces * sizeof(vector3);
+	if(g.has_vertex_attachment(aNormal))
+		m.attachments += numVrts * sizeof(vector3);
+
+//	subset handlers attach a subset index and a list iterator to each element
+//	and link each assigned element into a list
+	const size_t numElems = numVrts + numEdges + numFaces + numVols;
+	const size_t perElem = sizeof(int) + ptr;
+	const size_t perAssigned = 2 * ptr;
+	SubsetHandler& crease = crease_handler();
+	Selector& sel = selector();
+//	subset handler, crease handler and selector cover all elements,
+//	m_shFacesForVolRendering only the faces.
+	m.subsetHandlers = (3 * numElems + numFaces) * perElem
+		+ (m_subsetHandler.num<Vertex>() + m_subsetHandler.num<Edge>()
+		   + m_subsetHandler.num<Face>() + m_subsetHandler.num<Volume>()
+		   + crease.num<Vertex>() + crease.num<Edge>()
+		   + crease.num<Face>() + crease.num<Volume>()
+		   + sel.num<Vertex>() + sel.num<Edge>() + sel.num<Face>() + sel.num<Volume>()
+		   + m_shFacesForVolRendering.num<Face>()) * perAssigned;
+
+//	display lists hold a position and a normal per rendered corner
+	const size_t numRenderedFaces = volume_rendering_enabled() ?
+									m_shFacesForVolRendering.num<Face>() : numFaces;
+	const size_t cornersPerFace = numFaces > 0 ? (faceCorners + numFaces - 1) / numFaces : 0;
+	m.glBuffers = numRenderedFaces * cornersPerFace * 6 * sizeof(float)
+				+ m_subsetHandler.num<Edge>() * 2 * 3 * sizeof(float)
+				+ VectorBytes(m_scalarRenderData.positions)
+				+ VectorBytes(m_scalarRenderData.normals)
+				+ VectorBytes(m_scalarRenderData.indices);
+
+	for(size_t i = 0; i < m_dataFields.size(); ++i){
+		const DataField& field = m_dataFields[i];
+		size_t num = 0;
+		switch(field.elemDim){
+			case 0:	num = numVrts; break;
+			case 2:	num = numFaces; break;
+			case 3:	num = numVols; break;
+		}
+		m.displacementCaches += num * (field.aVector ? sizeof(vector3) : sizeof(number));
+	}
+	m.displacementCaches += VectorBytes(m_vertexScalars)
+						  + VectorBytes(m_restPositions)
+						  + VectorBytes(m_vertexCoordinateBuffer)
+						  + VectorBytes(m_transformInitialPositions)
+						  + VectorBytes(m_transformVertices);
+	return m;
+}
+
+
+///	appends the corner indices, subset indices and pointers of all elements of type TElem
+template <class TElem, class TBaseElem>
+static void CollectCompactElements(std::vector<int>& indsOut, std::vector<int>& subsetsOut,
+								   std::vector<TBaseElem*>& elemsOut, Grid& g, SubsetHandler& sh,
+								   Grid::VertexAttachmentAccessor<AInt>& aaInd)
+{
+	typedef typename geometry_traits<TElem>::iterator iter_t;
+	for(iter_t iter = g.begin<TElem>(); iter != g.end<TElem>(); ++iter){
+		TElem* e = *iter;
+		for(size_t i = 0; i < e->num_vertices(); ++i)
+			indsOut.push_back(aaInd[e->vertex(i)]);
+		subsetsOut.push_back(sh.get_subset_index(e));
+		elemsOut.push_back(e);
+	}
+}
+
+///	values of a data field, in the order of elems
+template <class TElem>
+static void SaveFieldValues(Grid& g, const LGObject::DataField& field,
+							const std::vector<TElem*>& elems,
+							std::vector<number>& numbersOut, std::vector<vector3>& vectorsOut)
+{
+	if(field.aNumber){
+		Grid::AttachmentAccessor<TElem, ANumber> aa(g, *field.aNumber);
+		for(size_t i = 0; i < elems.size(); ++i)
+			numbersOut.push_back(aa[elems[i]]);
+	}
+	else{
+		Grid::AttachmentAccessor<TElem, AVector3> aa(g, *field.aVector);
+		for(size_t i = 0; i < elems.size(); ++i)
+			vectorsOut.push_back(aa[elems[i]]);
+	}
+}
+
+template <class TElem>
+static void RestoreFieldValues(Grid& g, const LGObject::DataField& field,
+							   const std::vector<TElem*>& elems,
+							   const std::vector<number>& numbers, const std::vector<vector3>& vectors)
+{
+	if(field.aNumber){
+		Grid::AttachmentAccessor<TElem, ANumber> aa(g, *field.aNumber);
+		for(size_t i = 0; i < elems.size() && i < numbers.size(); ++i)
+			aa[elems[i]] = numbers[i];
+	}
+	else{
+		Grid::AttachmentAccessor<TElem, AVector3> aa(g, *field.aVector);
+		for(size_t i = 0; i < elems.size() && i < vectors.size(); ++i)
+			aa[elems[i]] = vectors[i];
+	}
+}
+
+template <class TElem>
+static void AssignSubsets(SubsetHandler& sh, const std::vector<TElem*>& elems,
+						  const std::vector<int>& subsets)
+{
+	for(size_t i = 0; i < elems.size(); ++i){
+		if(subsets[i] != -1)
+			sh.assign_subset(elems[i], subsets[i]);
+	}
+}
+
+bool LGObject::compact()
+{
+	PROFILE_FUNC();
+	Grid& g = m_grid;
+
+	if(m_transformType != TT_NONE || position_animation_active())
+		return false;
+
+//	BulkGridBuilder can only recreate regular elements
+	if(g.num<Vertex>() != g.num<RegularVertex>()
+	   || g.num<Edge>() != g.num<RegularEdge>()
+	   || g.num<Face>() != g.num<Triangle>() + g.num<Quadrilateral>()
+	   || g.num<Volume>() != g.num<Tetrahedron>() + g.num<Hexahedron>()
+							+ g.num<Prism>() + g.num<Pyramid>())
+	{
+		return false;
+	}
+
+	SubsetHandler& sh = m_subsetHandler;
+	SubsetHandler& crease = crease_handler();
+	selector().clear();
+
+//	flatten the grid
+	AInt aIndex;
+	g.attach_to_vertices(aIndex);
+	Grid::VertexAttachmentAccessor<AInt> aaInd(g, aIndex);
+	Grid::VertexAttachmentAccessor<APosition> aaPos(g, aPosition);
+
+	std::vector<number> coords;
+	std::vector<int> vrtSubsets;
+	std::vector<Vertex*> vrts;
+	coords.reserve(3 * g.num<Vertex>());
+	int numVrts = 0;
+	for(VertexIterator iter = g.begin<Vertex>(); iter != g.end<Vertex>(); ++iter){
+		const vector3& p = aaPos[*iter];
+		coords.push_back(p.x());
+		coords.push_back(p.y());
+		coords.push_back(p.z());
+		vrtSubsets.push_back(sh.get_subset_index(*iter));
+		vrts.push_back(*iter);
+		aaInd[*iter] = numVrts++;
+	}
+
+//	edges are only kept if they are rendered as part of a subset or a crease
+	std::vector<int> edgeInds, edgeSubsets, creaseSubsets;
+	for(EdgeIterator iter = g.begin<Edge>(); iter != g.end<Edge>(); ++iter){
+		Edge* e = *iter;
+		const int si = sh.get_subset_index(e);
+		const int ci = crease.get_subset_index(e);
+		if(si == -1 && ci == -1)
+			continue;
+		edgeInds.push_back(aaInd[e->vertex(0)]);
+		edgeInds.push_back(aaInd[e->vertex(1)]);
+		edgeSubsets.push_back(si);
+		creaseSubsets.push_back(ci);
+	}
+
+	std::vector<int> triInds, quadInds, faceSubsets;
+	std::vector<Face*> faces;
+	CollectCompactElements<Triangle>(triInds, faceSubsets, faces, g, sh, aaInd);
+	CollectCompactElements<Quadrilateral>(quadInds, faceSubsets, faces, g, sh, aaInd);
+
+	std::vector<int> tetInds, hexInds, prismInds, pyraInds, volSubsets;
+	std::vector<Volume*> vols;
+	CollectCompactElements<Tetrahedron>(tetInds, volSubsets, vols, g, sh, aaInd);
+	CollectCompactElements<Hexahedron>(hexInds, volSubsets, vols, g, sh, aaInd);
+	CollectCompactElements<Prism>(prismInds, volSubsets, vols, g, sh, aaInd);
+	CollectCompactElements<Pyramid>(pyraInds, volSubsets, vols, g, sh, aaInd);
+
+	g.detach_from_vertices(aIndex);
+
+	std::vector<std::vector<number> > fieldNumbers(m_dataFields.size());
+	std::vector<std::vector<vector3> > fieldVectors(m_dataFields.size());
+	for(size_t i = 0; i < m_dataFields.size(); ++i){
+		const DataField& field = m_dataFields[i];
+		switch(field.elemDim){
+			case 0:	SaveFieldValues(g, field, vrts, fieldNumbers[i], fieldVectors[i]); break;
+			case 2:	SaveFieldValues(g, field, faces, fieldNumbers[i], fieldVectors[i]); break;
+			case 3:	SaveFieldValues(g, field, vols, fieldNumbers[i], fieldVectors[i]); break;
+		}
+	}
+
+//	the scene looks up the sides of volumes and the volumes of sides while
+//	rendering, and the edges of faces, which are found through the vertices.
+	uint options = VRTOPT_STORE_ASSOCIATED_EDGES;
+	if(!vols.empty())
+		options |= VOLOPT_STORE_ASSOCIATED_FACES | FACEOPT_STORE_ASSOCIATED_VOLUMES;
+
+	g.clear_geometry();
+	g.set_options(options);
+
+	{
+		BulkGridBuilder builder(g);
+		builder.reserve(numVrts, edgeSubsets.size(), faces.size(), vols.size());
+		if(!coords.empty())
+			builder.add_vertices(&coords.front(), numVrts);
+		if(!edgeInds.empty())
+			builder.add_elements<RegularEdge>(&edgeInds.front(), edgeSubsets.size());
+		if(!triInds.empty())
+			builder.add_elements<Triangle>(&triInds.front(), triInds.size() / 3);
+		if(!quadInds.empty())
+			builder.add_elements<Quadrilateral>(&quadInds.front(), quadInds.size() / 4);
+		if(!tetInds.empty())
+			builder.add_elements<Tetrahedron>(&tetInds.front(), tetInds.size() / 4);
+		if(!hexInds.empty())
+			builder.add_elements<Hexahedron>(&hexInds.front(), hexInds.size() / 8);
+		if(!prismInds.empty())
+			builder.add_elements<Prism>(&prismInds.front(), prismInds.size() / 6);
+		if(!pyraInds.empty())
+			builder.add_elements<Pyramid>(&pyraInds.front(), pyraInds.size() / 5);
+		builder.finish();
+
+		vrts.swap(builder.vertices());
+		faces.swap(builder.faces());
+		vols.swap(builder.volumes());
+
+		AssignSubsets(sh, vrts, vrtSubsets);
+		AssignSubsets(sh, builder.edges(), edgeSubsets);
+		AssignSubsets(crease, builder.edges(), creaseSubsets);
+		AssignSubsets(sh, faces, faceSubsets);
+		AssignSubsets(sh, vols, volSubsets);
+	}
+
+	for(size_t i = 0; i < m_dataFields.size(); ++i){
+		const DataField& field = m_dataFields[i];
+		switch(field.elemDim){
+			case 0:	RestoreFieldValues(g, field, vrts, fieldNumbers[i], fieldVectors[i]); break;
+			case 2:	RestoreFieldValues(g, field, faces, fieldNumbers[i], fieldVectors[i]); break;
+			case 3:	RestoreFieldValues(g, field, vols, fieldNumbers[i], fieldVectors[i]); break;
+		}
+	}
+
+	std::vector<vector3>().swap(m_vertexCoordinateBuffer);
+	std::vector<vector3>().swap(m_transformInitialPositions);
+	std::vector<Vertex*>().swap(m_transformVertices);
+	m_scalarRenderData = ScalarRenderData();
+	topology_changed();
+
+	geometry_changed();
+	return true;
+}
+
+
 void LGObject::
 log_action(const QString& str)
 {
@@ -83,9 +83,38 @@ extern const char* LG_SUPPORTED_FILE_FORMATS_OPEN;
 LGObject* CreateLGObjectFromFile(const char* filename, unsigned screen, unsigned idx);
 LGObject* CreateEmptyLGObject(const char* name);
 bool LoadLGObjectFromFile(LGObject* pObjOut, const char* filename, bool performLoadPostprocessing, unsigned screen, unsigned idx);
+///	streams the grid and the subset handler of obj to a ugx file, see UGXStreamWriter
+bool SaveLGObjectToUGX(LGObject* obj, const char* filename, bool binary);
 void PerformLoadPostprocessing(LGObject* obj);
 bool ReloadLGObject(LGObject* obj, unsigned screen, unsigned idx);
 
+////////////////////////////////////////////////////////////////////////
+//	LGMemoryFootprint
+///	estimated memory in bytes which is occupied by an LGObject.
+/**	The numbers are derived from element counts, grid options and container
+ * sizes. GL does not report the size of display lists, so glBuffers holds an
+ * estimate of the vertex data which was compiled into them.*/
+struct LGMemoryFootprint
+{
+	LGMemoryFootprint() : grid(0), associations(0), attachments(0),
+		subsetHandlers(0), glBuffers(0), displacementCaches(0)	{}
+
+	size_t grid;				///< vertices, edges, faces and volumes
+	size_t associations;		///< neighbourhood lists enabled through the grid options
+	size_t attachments;			///< positions, normals and render attachments
+	size_t subsetHandlers;		///< subset handlers and the selector
+	size_t glBuffers;			///< display lists and the vertex arrays of scalar fields
+	size_t displacementCaches;	///< data fields, animation and coordinate buffers
+
+	size_t total() const
+		{return grid + associations + attachments + subsetHandlers + glBuffers + displacementCaches;}
+
+	LGMemoryFootprint& operator += (const LGMemoryFootprint& m);
+
+///	one line per category, in MB
+	std::string to_string() const;
+};
+
 ////////////////////////////////////////////////////////////////////////
 //	LGObject
 ///	holds a grid, a subset-handler and the render-object.
@@ -165,11 +194,107 @@ class LGObject : public ISceneObject, public ug::promesh::Mesh
 		bool edge_rendering_enabled()				{return (m_grid.num_edges() > 0) && ((m_elementMode & LGEM_EDGE) == LGEM_EDGE);}
 		bool vertex_rendering_enabled()				{return (m_grid.num_vertices() > 0) && ((m_elementMode & LGEM_VERTEX) == LGEM_VERTEX);}
 
+	//	per-vertex scalar values
+	///	assigns one scalar value per vertex, ordered as the vertices of the grid.
+	/**	If scalars are present, faces are drawn through the colormap instead of
+	 * the subset colors. Changing only the values does not require an update of
+	 * the display lists. Call LGScene::color_changed to trigger a repaint.*/
+		void set_vertex_scalars(const float* values, size_t num);
+		void clear_vertex_scalars();
+		bool has_vertex_scalars() const					{return !m_vertexScalars.empty();}
+		const std::vector<float>& vertex_scalars() const	{return m_vertexScalars;}
+
+	///	values in [min, max] are mapped onto the colormap
+		void set_scalar_range(float min, float max)		{m_scalarMin = min; m_scalarMax = max;}
+		float scalar_min() const						{return m_scalarMin;}
+		float scalar_max() const						{return m_scalarMax;}
+
+	///	see util/colormap.h for available colormaps
+		void set_colormap(int colormap)					{m_colormap = colormap;}
+		int colormap() const							{return m_colormap;}
+
+	//	data fields
+	///	a named data array which was loaded together with the geometry.
+	/**	Fields with one component are stored in aNumber, fields with three
+	 * components in aVector. The attachment is attached to the elements of
+	 * dimension elemDim, i.e. to the vertices for point data and to the
+	 * faces or volumes for cell data.*/
+		struct DataField{
+			std::string		name;
+			int				numComponents;
+			int				elemDim;
+			ug::ANumber*	aNumber;
+			ug::AVector3*	aVector;
+		};
+
+	///	creates and attaches a new field. Only 1 or 3 components are supported.
+	/**	returns NULL if numComponents or elemDim is not supported.*/
+		DataField* add_data_field(const char* name, int numComponents, int elemDim);
+		void clear_data_fields();
+		size_t num_data_fields() const					{return m_dataFields.size();}
+		const DataField& data_field(size_t i) const		{return m_dataFields[i];}
+
+	///	returns the vertex field which holds the displacements of a mode or NULL.
+	/**	Prefers a field named "displacement", then "u", then the first vector field.*/
+		ug::AVector3* displacement_attachment();
+
+	//	memory
+	///	estimates the memory occupied by the object, see LGMemoryFootprint
+	/**	Attachments which a scene adds to the grid are not included,
+	 * see LGScene::memory_footprint.*/
+		LGMemoryFootprint memory_footprint();
+
+	///	drops everything the object does not need for rendering.
+	/**	Rebuilds the grid without edges which are neither assigned to a subset
+	 * nor to a crease, and with only those element associations enabled which
+	 * the scene uses to render faces and volumes. Clears the selection and all
+	 * coordinate buffers. Data fields and subsets are kept.
+	 * Returns false and leaves the object untouched, if the grid contains
+	 * elements which can not be recreated (e.g. constrained elements or
+	 * octahedrons) or if a transform or position animation is active.*/
+		bool compact();
+
 	//	geometry info
 		void update_bounding_shapes();
 		inline ug::Sphere3& get_bounding_sphere()	{return m_boundSphere;}
 		inline void get_bounding_box(ug::vector3& vMinOut, ug::vector3& vMaxOut)
 			{vMinOut = m_boundBoxMin; vMaxOut = m_boundBoxMax;}
+	///	calculates the normals of all faces, see CalculateFaceNormalsParallel
+		void calculate_face_normals();
+
+	//	smooth shading
+	///	enables area weighted vertex normals, which are updated with the geometry.
+	/**	The vertex-to-face adjacency which is required to compute them is built
+	 * once and reused until topology_changed is called. Vertex normals are
+	 * averaged over all faces of the grid or, if set_shaded_faces was called,
+	 * over the rendered faces only.*/
+		void set_smooth_shading(bool enable);
+		bool smooth_shading() const			{return m_smoothShading;}
+	///	true if faces are drawn with the normals of their vertices
+		bool smooth_shading_active()
+			{return m_smoothShading && !m_vrtFaceAdjacency.empty()
+					&& m_grid.has_vertex_attachment(ug::aNormal);}
+	///	calculates the vertex normals, if smooth shading is active
+	/**	Grids with volumes have no vertex normals until set_shaded_faces was
+	 * called, since averaging over all their faces would include inner faces.*/
+		void calculate_vertex_normals();
+	///	averages the vertex normals over the given faces only, e.g. the boundary faces of volumes.
+	/**	The adjacency is only rebuilt if the faces differ from the last call.
+	 * Calculates the vertex normals, if smooth shading is active.*/
+		void set_shaded_faces(const std::vector<ug::Face*>& faces);
+
+	///	call this method after elements were created or erased.
+	/**	Releases data which depends on the topology of the grid.*/
+		void topology_changed();
+	///	changes whenever topology_changed is called.
+	/**	Allows holders of element pointers to detect that they were invalidated.*/
+		unsigned int topology_stamp() const	{return m_topologyStamp;}
+
+	///	all vertices, faces and volumes of the grid
+	/**	Each list is collected once and reused until topology_changed is called.*/
+		const std::vector<ug::Vertex*>& vertex_list();
+		const std::vector<ug::Face*>& face_list();
+		const std::vector<ug::Volume*>& volume_list();
 
 	////////////////////////////////////////////////////////////////////////////
 	//	TRANSFORMS
@@ -208,6 +333,47 @@ class LGObject : public ISceneObject, public ug::promesh::Mesh
 	 * was changed since the last call to 'buffer_current_vertex_coordinates',
 	 * restoring vertex coordinates with this method may lead to unexpected results.*/
 		void restore_vertex_coordinates_from_buffer();
+
+	////////////////////////////////////////////////////////////////////////////
+	//	POSITION ANIMATION
+	///	starts to animate the vertex positions around the positions of restGrid.
+	/**	The object keeps its own topology and only stores the rest positions,
+	 * so that no copy of the grid is required to animate it. restGrid has to
+	 * have the same number of vertices in the same order, it may be the grid of
+	 * the object itself. The current coordinates are buffered and restored by
+	 * end_position_animation.
+	 * If restInds is given and not empty, the i-th vertex of the object rests
+	 * at the restInds[i]-th vertex of restGrid instead, see FindVertexCorrespondence.
+	 * Returns false and leaves the object untouched if restGrid or restInds
+	 * don't provide a rest position for each vertex.*/
+		bool begin_position_animation(ug::Grid& restGrid,
+									  const std::vector<size_t>* restInds = NULL);
+
+	///	sets the position of the i-th vertex to restPosition[i] + scale * offsets[i]
+	/**	Only has effect between begin_position_animation and end_position_animation.
+	 * Call geometry_changed afterwards.*/
+		void set_animated_positions(const std::vector<ug::vector3>& offsets, number scale = 1);
+
+	///	restores the coordinates from before begin_position_animation
+		void end_position_animation();
+
+		bool position_animation_active() const		{return !m_restPositions.empty();}
+
+	////////////////////////////////////////////////////////////////////////////
+	//	PARTIAL GEOMETRY UPDATES
+	///	true if only the vertices of the current transform moved since the last processed update.
+	/**	In this case only the elements in transform_faces and transform_volumes
+	 * have to be updated. Normals and bounding shapes of the object are
+	 * already up to date.*/
+		bool geometry_change_is_partial() const		{return m_geometryChange == GC_PARTIAL;}
+
+	///	called by the scene once it has processed a geometry change.
+		void geometry_change_processed()			{m_geometryChange = GC_NONE;}
+
+	///	faces which contain a vertex of the current transform
+		const std::vector<ug::Face*>& transform_faces() const		{return m_transformFaces;}
+	///	volumes which contain a vertex of the current transform
+		const std::vector<ug::Volume*>& transform_volumes() const	{return m_transformVolumes;}
 		
 	///	returns true if something was changed since the last save
 		bool save_required() const					{return m_saveRequired;}
@@ -237,9 +403,17 @@ class LGObject : public ISceneObject, public ug::promesh::Mesh
 		void init();
 
 	///	collects the vertices which will be affected and calculates the center.
-	/**	Uses Grid::mark()*/
+	/**	Also collects the faces and volumes of those vertices and the bounding
+	 * box of all other vertices, so that grab and scale only have to update
+	 * the moved parts. Uses Grid::mark()*/
 		void init_transform();
 
+	///	updates normals and bounding shapes after the transform vertices moved.
+		void transform_geometry_changed();
+
+	///	updates the vertex normals of the corners of the transform faces only
+		void update_transform_vertex_normals();
+
 	///	loads a file from ugx without emitting signals
 		bool load_ugx(const char* filename);
 
@@ -247,6 +421,18 @@ class LGObject : public ISceneObject, public ug::promesh::Mesh
 		typedef std::vector<GLuint>	DisplayListVec;
 		typedef std::vector<int>	DisplayModeVec;
 
+	///	vertex arrays of the rendered faces, used to draw scalar values.
+	/**	Built by LGScene from the faces of the current display lists. Vertices
+	 * are shared, so that the scalar values can directly serve as texture
+	 * coordinates.*/
+		struct ScalarRenderData{
+			ScalarRenderData() : valid(false)	{}
+			std::vector<float>			positions;
+			std::vector<float>			normals;
+			std::vector<unsigned int>	indices;
+			bool						valid;
+		};
+
 	public:
 	//protected:
 		std::string			m_fileName;
@@ -261,6 +447,21 @@ class LGObject : public ISceneObject, public ug::promesh::Mesh
 		DisplayListVec		m_displayLists;
 		DisplayModeVec		m_displayModes;
 
+		std::vector<float>	m_vertexScalars;
+		float				m_scalarMin;
+		float				m_scalarMax;
+		int					m_colormap;
+		ScalarRenderData	m_scalarRenderData;
+
+		std::vector<DataField>	m_dataFields;
+
+		bool					m_smoothShading;
+		ug::VertexFaceAdjacency	m_vrtFaceAdjacency;
+		unsigned int			m_topologyStamp;
+		std::vector<ug::Vertex*>	m_vertexList;
+		std::vector<ug::Face*>		m_faceList;
+		std::vector<ug::Volume*>	m_volumeList;
+
 	//	the type of the elements that shall be rendered.
 		uint				m_elementMode;
 
@@ -273,10 +474,22 @@ class LGObject : public ISceneObject, public ug::promesh::Mesh
 		
 	//	currently used by LGScene to update the selection visuals only.
 		int					m_selectionDisplayListIndex;
+	//	number of triangles (quads count twice) in the face display lists.
+	//	Set by LGScene to report submitted triangles to the FrameProfiler.
+		size_t				m_numRenderedTriangles;
 		
 		QString				m_actionLog;
 
 	private:
+		enum GeometryChange{
+			GC_NONE,
+			GC_PARTIAL,
+			GC_FULL
+		};
+
+	//	the kind of geometry change which the scene did not process yet
+		GeometryChange		m_geometryChange;
+
 	//	transform
 		TransformType		m_transformType;
 		ug::vector3			m_transformStart;	// center where transform started
@@ -284,7 +497,17 @@ class LGObject : public ISceneObject, public ug::promesh::Mesh
 		ug::vector3			m_transformCurScales;
 		std::vector<ug::Vertex*>	m_transformVertices;
 		std::vector<ug::vector3>	m_transformInitialPositions;
+		std::vector<ug::Face*>		m_transformFaces;
+		std::vector<ug::Volume*>	m_transformVolumes;
+	//	vertices of m_vrtFaceAdjacency whose normals change during the transform and their faces
+		std::vector<size_t>			m_transformNormalVrts;
+		std::vector<size_t>			m_transformNormalFaces;
+		bool						m_transformNormalsCollected;
+		ug::vector3			m_transformFixedBoxMin;	// bounding box of the vertices which don't move
+		ug::vector3			m_transformFixedBoxMax;
+		bool				m_transformHasFixedVertices;
 		std::vector<ug::vector3>	m_vertexCoordinateBuffer;///< used in calls to 'buffer_current_vertex_coordinates' and 'restore_vertex_coordinates_from_buffer'
+		std::vector<ug::vector3>	m_restPositions;///< used during a position animation
 
 	protected:
 		struct IndicatorPoint{
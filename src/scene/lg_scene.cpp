@@ -28,7 +28,14 @@
 #include <QtOpenGL>
 #include <algorithm>
 #include "lg_scene.h"
+#include "render_data_worker.h"
 #include "gl_includes.h"
+#include "util/colormap.h"
+#include "util/frame_profiler.h"
+
+#ifndef GL_CLAMP_TO_EDGE
+	#define GL_CLAMP_TO_EDGE 0x812F
+#endif
 
 using namespace std;
 using namespace ug;
@@ -42,7 +49,9 @@ LGScene::LGScene() :
 	m_drawVertices(true),
 	m_drawEdges(true),
 	m_drawFaces(true),
-	m_drawVolumes(true)
+	m_drawVolumes(true),
+	m_smoothShading(false),
+	m_capture(NULL)
 {
 	m_drawModeFront = m_drawModeBack = DM_SOLID_WIRE;
 
@@ -52,6 +61,20 @@ LGScene::LGScene() :
 	}
 }
 
+LGScene::~LGScene()
+{
+	for(map<LGObject*, AnimationRenderData*>::iterator iter = m_animationData.begin();
+		iter != m_animationData.end(); ++iter)
+	{
+		delete iter->second;
+	}
+}
+
+LGScene::AnimationRenderData::~AnimationRenderData()
+{
+	delete worker;
+}
+
 void LGScene::set_draw_mode_front(unsigned int drawMode)
 {
 	m_drawModeFront = drawMode;
@@ -150,15 +173,76 @@ int LGScene::add_object(LGObject* obj, bool autoDelete)
 	connect(obj, SIGNAL(sig_selection_changed()), this, SLOT(object_selection_changed()));
 	connect(obj, SIGNAL(sig_properties_changed()), this, SLOT(object_properties_changed()));
 
-	calculate_bounding_spheres(obj);
+	if(obj->smooth_shading() != m_smoothShading)
+		obj->set_smooth_shading(m_smoothShading);
+
 	int retVal = BaseClass::add_object(obj, autoDelete);
-	update_visuals(obj);
+	invalidate(obj, DF_GEOMETRY);
 
 	emit geometry_changed();
 
 	return retVal;
 }
 
+bool LGScene::remove_object(int index)
+{
+	if(index_is_valid(index)){
+		m_pendingUpdates.erase(get_object(index));
+		release_animation_data(get_object(index));
+	}
+	return BaseClass::remove_object(index);
+}
+
+void LGScene::invalidate(LGObject* pObj, unsigned int flags)
+{
+	FRAME_PROFILE_COUNT(PC_INVALIDATIONS, 1);
+
+	map<LGObject*, unsigned int>::iterator iter = m_pendingUpdates.find(pObj);
+	if(iter != m_pendingUpdates.end()){
+	//	the update is already scheduled and will cover this one, too
+		iter->second |= flags;
+		FRAME_PROFILE_COUNT(PC_UPDATES_MERGED, 1);
+		return;
+	}
+
+	m_pendingUpdates[pObj] = flags;
+	emit visuals_updated();
+}
+
+void LGScene::process_pending_updates()
+{
+	if(m_pendingUpdates.empty())
+		return;
+
+//	swap the pending updates out first, since the rebuilds may invalidate again
+	map<LGObject*, unsigned int> pending;
+	pending.swap(m_pendingUpdates);
+
+	for(map<LGObject*, unsigned int>::iterator iter = pending.begin();
+		iter != pending.end(); ++iter)
+	{
+		LGObject* obj = iter->first;
+		const unsigned int flags = iter->second;
+
+		if(flags & DF_GEOMETRY){
+			if(!(flags & DF_VISUALS) && submit_animation_snapshot(obj))
+				continue;
+		//	during a transform only the elements of the moved vertices change
+			if(obj->geometry_change_is_partial())
+				calculate_bounding_spheres(obj, obj->transform_faces(), obj->transform_volumes());
+			else
+				calculate_bounding_spheres(obj);
+			obj->geometry_change_processed();
+		}
+
+	//	a full rebuild includes the selection
+		if(flags & (DF_GEOMETRY | DF_VISUALS))
+			rebuild_visuals(obj);
+		else if(flags & DF_SELECTION)
+			rebuild_selection_visuals(obj);
+	}
+}
+
 void LGScene::visibility_changed(ISceneObject* pObj)
 {
 //	update the geometry if volumes are contained
@@ -185,10 +269,8 @@ void LGScene::object_geometry_changed()
 //	LGObject* obj = qobject_cast<LGObject*>(sender());
 	LGObject* obj = dynamic_cast<LGObject*>(sender());
 	if(obj){
-		calculate_bounding_spheres(obj);
-		Grid& g = obj->grid();
-		CalculateFaceNormals(g, g.begin<Face>(), g.end<Face>(), aPosition, aNormal);
-		update_visuals(obj);
+	//	face normals were already updated by LGObject::geometry_changed
+		invalidate(obj, DF_GEOMETRY);
 		emit geometry_changed();
 	}
 }
@@ -217,6 +299,50 @@ void LGScene::object_properties_changed()
 	}
 }
 
+LGMemoryFootprint LGScene::memory_footprint(LGObject* pObj)
+{
+	LGMemoryFootprint m = pObj->memory_footprint();
+	Grid& g = pObj->grid();
+	const size_t numElems = g.num<Vertex>() + g.num<Edge>() + g.num<Face>() + g.num<Volume>();
+
+	if(g.has_face_attachment(m_aSphere))
+		m.attachments += (g.num<Face>() + g.num<Volume>()) * sizeof(Sphere3);
+	if(g.has_vertex_attachment(m_aRendered))
+		m.attachments += numElems * sizeof(bool);
+	if(g.has_vertex_attachment(m_aHidden))
+		m.attachments += numElems * sizeof(bool);
+	if(g.has_vertex_attachment(m_aInt))
+		m.attachments += g.num<Vertex>() * sizeof(int);
+	return m;
+}
+
+LGMemoryFootprint LGScene::memory_footprint()
+{
+	LGMemoryFootprint m;
+	for(int i = 0; i < num_objects(); ++i)
+		m += memory_footprint(get_object(i));
+	return m;
+}
+
+QString LGScene::info_text()
+{
+	return QString("memory of all objects\n").append(
+				QString::fromStdString(memory_footprint().to_string()));
+}
+
+QString LGScene::object_info_text(ISceneObject* pObj)
+{
+	LGObject* obj = dynamic_cast<LGObject*>(pObj);
+	if(!obj)
+		return QString();
+
+	Grid& g = obj->grid();
+	QString info = QString("%1 vertices, %2 edges, %3 faces, %4 volumes\n")
+					.arg(g.num<Vertex>()).arg(g.num<Edge>())
+					.arg(g.num<Face>()).arg(g.num<Volume>());
+	return info.append(QString::fromStdString(memory_footprint(obj).to_string()));
+}
+
 void LGScene::get_bounding_box(ug::vector3& vMinOut, ug::vector3& vMaxOut)
 {
 //	get the bounding box that surrounds all objects
@@ -276,6 +402,13 @@ void LGScene::setClipPlane(int index, const ug::Plane& plane)
 }
 
 void LGScene::calculate_bounding_spheres(LGObject* pObj)
+{
+	calculate_bounding_spheres(pObj, pObj->face_list(), pObj->volume_list());
+}
+
+void LGScene::calculate_bounding_spheres(LGObject* pObj,
+										 const vector<Face*>& faces,
+										 const vector<Volume*>& vols)
 {
 	Grid& grid = pObj->grid();
 
@@ -284,10 +417,8 @@ void LGScene::calculate_bounding_spheres(LGObject* pObj)
 	Grid::FaceAttachmentAccessor<ASphere>	aaSphereFACE(grid, m_aSphere);
 	Grid::VolumeAttachmentAccessor<ASphere>	aaSphereVOL(grid, m_aSphere);
 
-	for(FaceIterator iter = grid.faces_begin(); iter != grid.faces_end(); ++iter)
-		CalculateBoundingSphere(aaSphereFACE[*iter], *iter, aaPos);
-	for(VolumeIterator iter = grid.volumes_begin(); iter != grid.volumes_end(); ++iter)
-		CalculateBoundingSphere(aaSphereVOL[*iter], *iter, aaPos);
+	CalculateBoundingSpheresParallel(faces, aaPos, aaSphereFACE);
+	CalculateBoundingSpheresParallel(vols, aaPos, aaSphereVOL);
 }
 
 bool LGScene::clip_vertex(Vertex* v, Grid::VertexAttachmentAccessor<APosition>& aaPos)
@@ -475,6 +606,11 @@ static QColor ColorAdjust(const QColor& c)
 
 void LGScene::draw()
 {
+//	perform the collected updates once, before anything is drawn
+	process_pending_updates();
+
+	FRAME_PROFILE_STAGE(PS_DRAW);
+
 	static GLfloat lightDirection[] = { 0, 0.0f, 1.0f, 0.0f };
 	static GLfloat lightDirectionInv[] = { 0, 0.0f, -1.0f, 0.0f };
 	static GLfloat lightAmbientLow[4] = { 0.2f, 0.2f, 0.2f, 1.0f };
@@ -493,8 +629,12 @@ void LGScene::draw()
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 		LGObject* obj = get_object(i);
+		glShadeModel(obj->smooth_shading_active() ? GL_SMOOTH : GL_FLAT);
 		if(obj->is_visible())
 		{
+		//	animated objects are drawn from the most recently prepared arrays
+			AnimationRenderData* anim = animation_arrays(obj);
+
 		//	first we'll check which drawmodes are required
 			bool drawDoublePassShaded = false;
 			bool drawSinglePassColor = false;
@@ -545,6 +685,20 @@ void LGScene::draw()
 
 					QColor objCol = obj->get_color();
 
+				//	scalar values replace the solid pass of the face display lists
+					const bool drawScalars = obj->has_vertex_scalars();
+					if(drawScalars && (drawMode[iPass] & DM_SOLID))
+					{
+						glDepthMask(true);
+						glDisable(GL_BLEND);
+						glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
+						draw_scalar_field(obj, anim ? &anim->worker->front() : NULL);
+					}
+
+				//	the face display lists of a pass hold all rendered triangles
+					bool submitted = false;
+					bool submittedWire = false;
+
 //TODO: either iterate over subsets or add a visible state and colors per display-list
 					for(int j = 0; j < obj->num_display_lists(); ++j)
 					{
@@ -554,7 +708,7 @@ void LGScene::draw()
 						if(/*obj->subset_is_visible(si) &&*/
 						   (obj->get_display_list_mode(j) == LGRM_DOUBLE_PASS_SHADED))
 						{
-							if(drawMode[iPass] & DM_SOLID)
+							if((drawMode[iPass] & DM_SOLID) && !drawScalars)
 							{
 							//	draw solid
 								glDepthMask(true);
@@ -569,7 +723,8 @@ void LGScene::draw()
 
 								glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, faceColor);
 								glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, faceColor);
-								glCallList(obj->get_display_list(j));
+								call_display_list(obj, j, anim);
+								submitted = true;
 							}
 
 							if(drawMode[iPass] & DM_WIRE)
@@ -595,11 +750,17 @@ void LGScene::draw()
 								glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
 								glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, wireColor);
-								glCallList(obj->get_display_list(j));
+								call_display_list(obj, j, anim);
 								glEnable(GL_POLYGON_OFFSET_FILL);
+								submittedWire = true;
 							}
 						}
 					}
+
+					if(submitted)
+						FRAME_PROFILE_COUNT(PC_TRIANGLES_SUBMITTED, obj->m_numRenderedTriangles);
+					if(submittedWire)
+						FRAME_PROFILE_COUNT(PC_TRIANGLES_SUBMITTED, obj->m_numRenderedTriangles);
 				}
 				glDepthMask(true);
 			}
@@ -630,7 +791,7 @@ void LGScene::draw()
 						else
 							glEnable(GL_CULL_FACE);
 
-						glCallList(obj->get_display_list(j));
+						call_display_list(obj, j, anim);
 
 						glEnable(GL_POLYGON_OFFSET_FILL);
 						glEnable(GL_LIGHTING);
@@ -692,7 +853,7 @@ void LGScene::draw()
 						glMaterialfv( GL_FRONT_AND_BACK, GL_DIFFUSE, glCol);
 						glMaterialfv( GL_FRONT_AND_BACK, GL_AMBIENT, glCol);
 
-						glCallList(obj->get_display_list(j));
+						call_display_list(obj, j, anim);
 
 						glEnable(GL_POLYGON_OFFSET_FILL);
 						glEnable(GL_LIGHTING);
@@ -721,11 +882,22 @@ void LGScene::update_visuals(ISceneObject* pObj)
 	LGObject* pLGObj = dynamic_cast<LGObject*>(pObj);
 	if(pLGObj)
 		update_visuals(pLGObj);
-	emit visuals_updated();
 }
 
 void LGScene::update_visuals(LGObject* pObj)
 {
+	invalidate(pObj, DF_VISUALS);
+}
+
+void LGScene::update_selection_visuals(LGObject* obj)
+{
+	invalidate(obj, DF_SELECTION);
+}
+
+void LGScene::rebuild_visuals(LGObject* pObj)
+{
+	FRAME_PROFILE_STAGE(PS_UPDATE_VISUALS);
+
 //	check whether a clip plane is enabled
 	bool clipPlaneEnabled = false;
 	for(int i = 0; i < numClipPlanes(); ++i)
@@ -785,12 +957,20 @@ void LGScene::update_visuals(LGObject* pObj)
 	if(bDrawSelection)
 		numDisplayLists++;
 
+//	the set of rendered faces may change below
+	pObj->m_scalarRenderData.valid = false;
+
 	bool bDrawMarks = (pObj->crease_handler().num<Vertex>(REM_FIXED) > 0)
 					  || (pObj->crease_handler().num<Edge>(REM_CREASE) > 0);
 	if(bDrawMarks)
 		numDisplayLists++;
 
 	pObj->set_num_display_lists(numDisplayLists);
+	FRAME_PROFILE_COUNT(PC_DISPLAY_LISTS_REBUILT, numDisplayLists);
+
+//	the display lists of animated objects are recorded, so that the following
+//	frames can be drawn from arrays which are prepared in the background
+	begin_animation_capture(pObj, clipPlaneEnabled);
 
 	int curDisplayListIndex = 0;
 
@@ -807,6 +987,9 @@ void LGScene::update_visuals(LGObject* pObj)
 	if(drawFaces)
 	{
 		assert(curDisplayListIndex + numSubsets < numDisplayLists);
+	//	the inner faces of volumes are rendered, too, so they are shaded as well
+		if(pObj->smooth_shading() && grid.num_volumes() > 0)
+			pObj->set_shaded_faces(pObj->face_list());
 	//	render faces
 		if(clipPlaneEnabled)
 			render_faces_with_clip_plane(pObj);
@@ -845,19 +1028,320 @@ void LGScene::update_visuals(LGObject* pObj)
 		++curDisplayListIndex;
 	}
 
-	emit visuals_updated();
+//	count the triangles of the face display lists for the frame profiler
+	pObj->m_numRenderedTriangles = 0;
+	if(drawVolumes || drawFaces){
+		for(FaceIterator iter = grid.faces_begin(); iter != grid.faces_end(); ++iter){
+			if(aaRenderedFACE[*iter])
+				pObj->m_numRenderedTriangles += (*iter)->num_vertices() - 2;
+		}
+	}
+
+	end_animation_capture(pObj);
 }
 
-void LGScene::update_selection_visuals(LGObject* obj)
+void LGScene::rebuild_selection_visuals(LGObject* pObj)
 {
-	if(obj->m_selectionDisplayListIndex < 0)
-		update_visuals(obj);
+	if(pObj->m_selectionDisplayListIndex < 0)
+		rebuild_visuals(pObj);
+	else{
+		FRAME_PROFILE_STAGE(PS_UPDATE_VISUALS);
+		FRAME_PROFILE_COUNT(PC_DISPLAY_LISTS_REBUILT, 1);
+		render_selection(pObj, pObj->m_selectionDisplayListIndex);
+	}
+}
+
+void LGScene::begin_animation_capture(LGObject* pObj, bool clipPlaneEnabled)
+{
+	if(!pObj->position_animation_active()){
+		release_animation_data(pObj);
+		return;
+	}
+
+//	LGObject doesn't update normals while its positions are animated, but the
+//	display lists are shaded with them
+	pObj->calculate_face_normals();
+	pObj->calculate_vertex_normals();
+
+//	clipping depends on the positions, so clipped objects are always rebuilt
+	if(clipPlaneEnabled){
+		release_animation_data(pObj);
+		return;
+	}
+
+	Grid& grid = pObj->grid();
+
+//	the vertices and the worker are kept as long as the topology is unchanged
+	AnimationRenderData* anim = NULL;
+	map<LGObject*, AnimationRenderData*>::iterator iter = m_animationData.find(pObj);
+	if(iter != m_animationData.end()){
+		if(iter->second->topologyStamp == pObj->topology_stamp())
+			anim = iter->second;
+		else
+			release_animation_data(pObj);
+	}
+
+	if(!anim){
+		anim = new AnimationRenderData;
+		anim->topologyStamp = pObj->topology_stamp();
+		anim->vertices.reserve(grid.num_vertices());
+		for(VertexIterator vrtIter = grid.vertices_begin();
+			vrtIter != grid.vertices_end(); ++vrtIter)
+		{
+			anim->vertices.push_back(*vrtIter);
+		}
+		m_animationData[pObj] = anim;
+	}
+
+//	m_aInt is used by other renderers, too
+	if(!grid.has_vertex_attachment(m_aInt))
+		grid.attach_to_vertices(m_aInt);
+	Grid::VertexAttachmentAccessor<AInt> aaInd(grid, m_aInt);
+	for(size_t i = 0; i < anim->vertices.size(); ++i)
+		aaInd[anim->vertices[i]] = (int)i;
+
+	anim->listModes.clear();
+	anim->listIndices.clear();
+	anim->listFaceSizes.clear();
+	m_capture = anim;
+}
+
+void LGScene::end_animation_capture(LGObject* pObj)
+{
+	if(!m_capture)
+		return;
+
+	AnimationRenderData* anim = m_capture;
+	m_capture = NULL;
+
+	const size_t numLists = (size_t)max(0, pObj->num_display_lists());
+	anim->listModes.resize(numLists, GL_NONE);
+	anim->listIndices.resize(numLists);
+	anim->listFaceSizes.resize(numLists);
+	anim->listFirstCorners.assign(numLists, 0);
+
+//	the faces are shaded as in the display lists
+	RenderTriangles triangles;
+	triangles.smooth = pObj->smooth_shading_active();
+	for(size_t i = 0; i < numLists; ++i){
+		if(anim->listModes[i] == GL_TRIANGLES){
+			anim->listFirstCorners[i] = triangles.indices.size();
+			triangles.indices.insert(triangles.indices.end(),
+									 anim->listIndices[i].begin(),
+									 anim->listIndices[i].end());
+			triangles.faceSizes.insert(triangles.faceSizes.end(),
+									   anim->listFaceSizes[i].begin(),
+									   anim->listFaceSizes[i].end());
+		}
+	}
+
+	if(anim->worker)
+		anim->worker->set_triangles(triangles);
 	else{
-		render_selection(obj, obj->m_selectionDisplayListIndex);
-		emit visuals_updated();
+		anim->worker = new RenderDataWorker(anim->vertices.size(), triangles);
+		connect(anim->worker, SIGNAL(prepared()), this, SIGNAL(visuals_updated()));
+	}
+
+//	arrays of older snapshots may not match the new display lists
+	anim->firstSnapshot = submit_positions(pObj, anim);
+}
+
+///	makes sure that modes and indices have an entry for the given display list
+static vector<unsigned int>& CapturedList(vector<GLenum>& modes,
+										  vector<vector<unsigned int> >& indices,
+										  int displayListIndex, GLenum mode)
+{
+	if((int)modes.size() <= displayListIndex){
+		modes.resize(displayListIndex + 1, GL_NONE);
+		indices.resize(displayListIndex + 1);
+	}
+	modes[displayListIndex] = mode;
+	indices[displayListIndex].clear();
+	return indices[displayListIndex];
+}
+
+void LGScene::capture_faces(LGObject* pObj, int displayListIndex,
+							SubsetHandler& sh, int subsetIndex)
+{
+	Grid& grid = pObj->grid();
+	Grid::VertexAttachmentAccessor<AInt> aaInd(grid, m_aInt);
+	Grid::FaceAttachmentAccessor<ABool> aaRenderedFACE(grid, m_aRendered);
+
+	vector<unsigned int>& inds = CapturedList(m_capture->listModes,
+						m_capture->listIndices, displayListIndex, GL_TRIANGLES);
+	vector<vector<unsigned char> >& faceSizes = m_capture->listFaceSizes;
+	if((int)faceSizes.size() <= displayListIndex)
+		faceSizes.resize(displayListIndex + 1);
+	vector<unsigned char>& sizes = faceSizes[displayListIndex];
+	sizes.clear();
+
+//	faces are triangulated as fans
+	for(FaceIterator iter = sh.begin<Face>(subsetIndex);
+		iter != sh.end<Face>(subsetIndex); ++iter)
+	{
+		Face* f = *iter;
+		if(!aaRenderedFACE[f] || f->num_vertices() < 3)
+			continue;
+
+		sizes.push_back((unsigned char)(f->num_vertices() - 2));
+		for(size_t i = 1; i + 1 < f->num_vertices(); ++i){
+			inds.push_back(aaInd[f->vertex(0)]);
+			inds.push_back(aaInd[f->vertex(i)]);
+			inds.push_back(aaInd[f->vertex(i + 1)]);
+		}
+	}
+}
+
+void LGScene::capture_edges(LGObject* pObj, int displayListIndex, int subsetIndex)
+{
+	Grid& grid = pObj->grid();
+	SubsetHandler& sh = pObj->subset_handler();
+	Grid::VertexAttachmentAccessor<AInt> aaInd(grid, m_aInt);
+	Grid::EdgeAttachmentAccessor<ABool> aaHiddenEDGE(grid, m_aHidden);
+
+	vector<unsigned int>& inds = CapturedList(m_capture->listModes,
+						m_capture->listIndices, displayListIndex, GL_LINES);
+
+	for(EdgeIterator iter = sh.begin<Edge>(subsetIndex);
+		iter != sh.end<Edge>(subsetIndex); ++iter)
+	{
+		Edge* e = *iter;
+		if(aaHiddenEDGE[e])
+			continue;
+		inds.push_back(aaInd[e->vertex(0)]);
+		inds.push_back(aaInd[e->vertex(1)]);
+	}
+}
+
+void LGScene::capture_vertices(LGObject* pObj, int displayListIndex, int subsetIndex)
+{
+	Grid& grid = pObj->grid();
+	SubsetHandler& sh = pObj->subset_handler();
+	Grid::VertexAttachmentAccessor<AInt> aaInd(grid, m_aInt);
+	Grid::VertexAttachmentAccessor<ABool> aaHiddenVRT(grid, m_aHidden);
+
+	vector<unsigned int>& inds = CapturedList(m_capture->listModes,
+						m_capture->listIndices, displayListIndex, GL_POINTS);
+
+	for(VertexIterator iter = sh.begin<Vertex>(subsetIndex);
+		iter != sh.end<Vertex>(subsetIndex); ++iter)
+	{
+		if(!aaHiddenVRT[*iter])
+			inds.push_back(aaInd[*iter]);
 	}
 }
 
+bool LGScene::submit_animation_snapshot(LGObject* pObj)
+{
+	map<LGObject*, AnimationRenderData*>::iterator iter = m_animationData.find(pObj);
+	if(iter == m_animationData.end())
+		return false;
+
+	bool clipPlaneEnabled = false;
+	for(int i = 0; i < numClipPlanes(); ++i)
+		clipPlaneEnabled |= clipPlaneIsEnabled(i);
+
+	AnimationRenderData* anim = iter->second;
+	if(!pObj->position_animation_active() || clipPlaneEnabled
+	   || anim->topologyStamp != pObj->topology_stamp())
+	{
+		release_animation_data(pObj);
+		return false;
+	}
+
+	submit_positions(pObj, anim);
+	return true;
+}
+
+uint64_t LGScene::submit_positions(LGObject* pObj, AnimationRenderData* anim)
+{
+	Grid::VertexAttachmentAccessor<APosition> aaPos(pObj->grid(), aPosition);
+	vector<float>& snapshot = anim->snapshot;
+	snapshot.resize(3 * anim->vertices.size());
+	for(size_t i = 0; i < anim->vertices.size(); ++i){
+		const vector3& v = aaPos[anim->vertices[i]];
+		snapshot[3 * i] = v.x();
+		snapshot[3 * i + 1] = v.y();
+		snapshot[3 * i + 2] = v.z();
+	}
+
+	return anim->worker->submit(snapshot);
+}
+
+void LGScene::release_animation_data(LGObject* pObj)
+{
+	map<LGObject*, AnimationRenderData*>::iterator iter = m_animationData.find(pObj);
+	if(iter != m_animationData.end()){
+		delete iter->second;
+		m_animationData.erase(iter);
+	}
+}
+
+LGScene::AnimationRenderData* LGScene::animation_arrays(LGObject* pObj)
+{
+	map<LGObject*, AnimationRenderData*>::iterator iter = m_animationData.find(pObj);
+	if(iter == m_animationData.end() || !iter->second->worker)
+		return NULL;
+
+	RenderDataWorker* worker = iter->second->worker;
+	worker->swap_buffers();
+
+//	until a snapshot after the last capture is prepared, the display lists are up to date
+	if(worker->front().snapshot < iter->second->firstSnapshot)
+		return NULL;
+	return iter->second;
+}
+
+void LGScene::call_display_list(LGObject* pObj, int displayListIndex,
+								AnimationRenderData* anim)
+{
+	if(!anim || displayListIndex >= (int)anim->listModes.size()
+	   || anim->listModes[displayListIndex] == GL_NONE)
+	{
+		glCallList(pObj->get_display_list(displayListIndex));
+		return;
+	}
+
+	const vector<unsigned int>& inds = anim->listIndices[displayListIndex];
+	const PreparedRenderData& rd = anim->worker->front();
+	if(inds.empty() || rd.positions.empty())
+		return;
+
+	const GLenum mode = anim->listModes[displayListIndex];
+	glEnableClientState(GL_VERTEX_ARRAY);
+
+//	flat shaded triangles are drawn from unshared corners with face normals
+	if(mode == GL_TRIANGLES && !rd.flatPositions.empty()){
+		const size_t first = anim->listFirstCorners[displayListIndex];
+		if(3 * (first + inds.size()) <= rd.flatPositions.size()){
+			glEnableClientState(GL_NORMAL_ARRAY);
+			glVertexPointer(3, GL_FLOAT, 0, &rd.flatPositions.front());
+			glNormalPointer(GL_FLOAT, 0, &rd.flatNormals.front());
+			glDrawArrays(GL_TRIANGLES, (GLint)first, (GLsizei)inds.size());
+		}
+		glDisableClientState(GL_NORMAL_ARRAY);
+		glDisableClientState(GL_VERTEX_ARRAY);
+		return;
+	}
+
+	glVertexPointer(3, GL_FLOAT, 0, &rd.positions.front());
+	if(mode == GL_TRIANGLES){
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glNormalPointer(GL_FLOAT, 0, &rd.normals.front());
+	}
+	else{
+	//	the same state as set by the display lists of edges and vertices
+		if(mode == GL_POINTS)
+			glPointSize(5.f);
+		glColor4f(1., 1., 1., 1.);
+	}
+
+	glDrawElements(mode, (GLsizei)inds.size(), GL_UNSIGNED_INT, &inds.front());
+
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
 void LGScene::render_skeleton(LGObject* pObj)
 {
 	Grid& grid = pObj->grid();
@@ -1037,6 +1521,9 @@ void LGScene::render_point_subsets(LGObject* pObj, int baseDisplayListIndex)
 		glEnd();
 
 		glEndList();
+
+		if(m_capture)
+			capture_vertices(pObj, dispListIndex, i);
 	}
 }
 
@@ -1112,6 +1599,9 @@ void LGScene::render_edge_subsets(LGObject* pObj, int baseDisplayListIndex)
 		glEnd();
 
 		glEndList();
+
+		if(m_capture)
+			capture_edges(pObj, dispListIndex, i);
 	}
 }
 
@@ -1123,6 +1613,12 @@ void LGScene::render_triangles(LGObject* pObj, const ug::vector4& color,
 {
 	Grid::FaceAttachmentAccessor<ABool> aaRenderedFACE(pObj->grid(), m_aRendered);
 
+//	faces are shaded with the normals of their vertices, if smooth shading is active
+	const bool smooth = pObj->smooth_shading_active();
+	Grid::VertexAttachmentAccessor<ANormal> aaVrtNorm;
+	if(smooth)
+		aaVrtNorm.access(pObj->grid(), aNormal);
+
 	glColor4f(color.x(), color.y(), color.z(), color.w());
 	glBegin(GL_TRIANGLES);
 
@@ -1132,11 +1628,17 @@ void LGScene::render_triangles(LGObject* pObj, const ug::vector4& color,
 		Face* tri = *iter;
 
 		if(aaRenderedFACE[tri]){
-			vector3& n = aaNorm[tri];
-			glNormal3f(n.x(), n.y(), n.z());
+			if(!smooth){
+				vector3& n = aaNorm[tri];
+				glNormal3f(n.x(), n.y(), n.z());
+			}
 
 			for(int i = 0; i < 3; ++i)
 			{
+				if(smooth){
+					vector3& n = aaVrtNorm[tri->vertex(i)];
+					glNormal3f(n.x(), n.y(), n.z());
+				}
 				vector3& v = aaPos[tri->vertex(i)];
 				glVertex3f(v.x(), v.y(), v.z());
 			}
@@ -1155,6 +1657,12 @@ void LGScene::render_quadrilaterals(LGObject* pObj,
 {
 	Grid::FaceAttachmentAccessor<ABool> aaRenderedFACE(pObj->grid(), m_aRendered);
 
+//	faces are shaded with the normals of their vertices, if smooth shading is active
+	const bool smooth = pObj->smooth_shading_active();
+	Grid::VertexAttachmentAccessor<ANormal> aaVrtNorm;
+	if(smooth)
+		aaVrtNorm.access(pObj->grid(), aNormal);
+
 	glColor4f(color.x(), color.y(), color.z(), color.w());
 	glBegin(GL_QUADS);
 
@@ -1164,11 +1672,17 @@ void LGScene::render_quadrilaterals(LGObject* pObj,
 		Face* q = *iter;
 
 		if(aaRenderedFACE[q]){
-			vector3& n = aaNorm[q];
-			glNormal3f(n.x(), n.y(), n.z());
+			if(!smooth){
+				vector3& n = aaNorm[q];
+				glNormal3f(n.x(), n.y(), n.z());
+			}
 
 			for(int i = 0; i < 4; ++i)
 			{
+				if(smooth){
+					vector3& n = aaVrtNorm[q->vertex(i)];
+					glNormal3f(n.x(), n.y(), n.z());
+				}
 				vector3& v = aaPos[q->vertex(i)];
 				glVertex3f(v.x(), v.y(), v.z());
 			}
@@ -1260,6 +1774,7 @@ void LGScene::render_faces(LGObject* pObj, Grid& grid,
 						   SubsetHandler& sh, bool renderAll)
 {
 	PROFILE_FUNC();
+	FRAME_PROFILE_STAGE(PS_RENDER_FACES);
 //	this method allows to fill the contents of the display lists
 //	with differing grids and subsets.
 	Grid::VertexAttachmentAccessor<APosition> aaPos(grid, aPosition);
@@ -1270,6 +1785,12 @@ void LGScene::render_faces(LGObject* pObj, Grid& grid,
 
 	Grid::FaceAttachmentAccessor<ABool> aaHidden(grid, m_aHidden);
 
+//	faces are shaded with the normals of their vertices, if smooth shading is active
+	const bool smooth = pObj->smooth_shading_active();
+	Grid::VertexAttachmentAccessor<ANormal> aaVrtNorm;
+	if(smooth)
+		aaVrtNorm.access(grid, aNormal);
+
 //	iterate through all subsets
 //	each subset has its own display list
 	Grid::edge_traits::secure_container	assEdges;
@@ -1299,12 +1820,18 @@ void LGScene::render_faces(LGObject* pObj, Grid& grid,
 
 			aaRenderedFACE[tri] = true;
 
-			vector3& n = aaNorm[tri];
-			glNormal3f(n.x(), n.y(), n.z());
+			if(!smooth){
+				vector3& n = aaNorm[tri];
+				glNormal3f(n.x(), n.y(), n.z());
+			}
 
 			for(int i = 0; i < 3; ++i)
 			{
 				aaRenderedVRT[tri->vertex(i)] = true;
+				if(smooth){
+					vector3& n = aaVrtNorm[tri->vertex(i)];
+					glNormal3f(n.x(), n.y(), n.z());
+				}
 				vector3& v = aaPos[tri->vertex(i)];
 				glVertex3f(v.x(), v.y(), v.z());
 			}
@@ -1325,12 +1852,18 @@ void LGScene::render_faces(LGObject* pObj, Grid& grid,
 
 			aaRenderedFACE[tri] = true;
 
-			vector3& n = aaNorm[tri];
-			glNormal3f(n.x(), n.y(), n.z());
+			if(!smooth){
+				vector3& n = aaNorm[tri];
+				glNormal3f(n.x(), n.y(), n.z());
+			}
 
 			for(int i = 0; i < 3; ++i)
 			{
 				aaRenderedVRT[tri->vertex(i)] = true;
+				if(smooth){
+					vector3& n = aaVrtNorm[tri->vertex(i)];
+					glNormal3f(n.x(), n.y(), n.z());
+				}
 				vector3& v = aaPos[tri->vertex(i)];
 				glVertex3f(v.x(), v.y(), v.z());
 			}
@@ -1352,12 +1885,18 @@ void LGScene::render_faces(LGObject* pObj, Grid& grid,
 
 			aaRenderedFACE[tri] = true;
 
-			vector3& n = aaNorm[tri];
-			glNormal3f(n.x(), n.y(), n.z());
+			if(!smooth){
+				vector3& n = aaNorm[tri];
+				glNormal3f(n.x(), n.y(), n.z());
+			}
 
 			for(int i = 0; i < 3; ++i)
 			{
 				aaRenderedVRT[tri->vertex(i)] = true;
+				if(smooth){
+					vector3& n = aaVrtNorm[tri->vertex(i)];
+					glNormal3f(n.x(), n.y(), n.z());
+				}
 				vector3& v = aaPos[tri->vertex(i)];
 				glVertex3f(v.x(), v.y(), v.z());
 			}
@@ -1384,12 +1923,18 @@ void LGScene::render_faces(LGObject* pObj, Grid& grid,
 
 			aaRenderedFACE[q] = true;
 
-			vector3& n = aaNorm[q];
-			glNormal3f(n.x(), n.y(), n.z());
+			if(!smooth){
+				vector3& n = aaNorm[q];
+				glNormal3f(n.x(), n.y(), n.z());
+			}
 
 			for(int i = 0; i < 4; ++i)
 			{
 				aaRenderedVRT[q->vertex(i)] = true;
+				if(smooth){
+					vector3& n = aaVrtNorm[q->vertex(i)];
+					glNormal3f(n.x(), n.y(), n.z());
+				}
 				vector3& v = aaPos[q->vertex(i)];
 				glVertex3f(v.x(), v.y(), v.z());
 			}
@@ -1411,12 +1956,18 @@ void LGScene::render_faces(LGObject* pObj, Grid& grid,
 
 			aaRenderedFACE[q] = true;
 
-			vector3& n = aaNorm[q];
-			glNormal3f(n.x(), n.y(), n.z());
+			if(!smooth){
+				vector3& n = aaNorm[q];
+				glNormal3f(n.x(), n.y(), n.z());
+			}
 
 			for(int i = 0; i < 4; ++i)
 			{
 				aaRenderedVRT[q->vertex(i)] = true;
+				if(smooth){
+					vector3& n = aaVrtNorm[q->vertex(i)];
+					glNormal3f(n.x(), n.y(), n.z());
+				}
 				vector3& v = aaPos[q->vertex(i)];
 				glVertex3f(v.x(), v.y(), v.z());
 			}
@@ -1438,12 +1989,18 @@ void LGScene::render_faces(LGObject* pObj, Grid& grid,
 
 			aaRenderedFACE[q] = true;
 
-			vector3& n = aaNorm[q];
-			glNormal3f(n.x(), n.y(), n.z());
+			if(!smooth){
+				vector3& n = aaNorm[q];
+				glNormal3f(n.x(), n.y(), n.z());
+			}
 
 			for(int i = 0; i < 4; ++i)
 			{
 				aaRenderedVRT[q->vertex(i)] = true;
+				if(smooth){
+					vector3& n = aaVrtNorm[q->vertex(i)];
+					glNormal3f(n.x(), n.y(), n.z());
+				}
 				vector3& v = aaPos[q->vertex(i)];
 				glVertex3f(v.x(), v.y(), v.z());
 			}
@@ -1458,6 +2015,9 @@ void LGScene::render_faces(LGObject* pObj, Grid& grid,
 
 		glEnd();
 		glEndList();
+
+		if(m_capture)
+			capture_faces(pObj, i, sh, i);
 	}
 }
 
@@ -1471,6 +2031,7 @@ void LGScene::render_faces_without_clip_plane(LGObject* pObj)
 void LGScene::render_volumes(LGObject* pObj)
 {
 	PROFILE_FUNC();
+	FRAME_PROFILE_STAGE(PS_RENDER_VOLUMES);
 //	renders the volumes of an object.
 //	clip planes are used.
 	Grid& grid = pObj->grid();
@@ -1628,12 +2189,177 @@ void LGScene::render_volumes(LGObject* pObj)
 	if(shFace.num_subsets() < sh.num_subsets())
 		shFace.set_subset_info(sh.num_subsets() - 1, SubsetInfo());
 
+//	vertex normals are averaged over the rendered faces only, since the inner
+//	faces of the volumes would cancel out their normals
+	if(pObj->smooth_shading()){
+		vector<Face*> shadedFaces;
+		shadedFaces.reserve(shFace.num<Face>());
+		for(int i = 0; i < shFace.num_subsets(); ++i){
+			shadedFaces.insert(shadedFaces.end(), shFace.begin<Face>(i),
+							   shFace.end<Face>(i));
+		}
+		pObj->set_shaded_faces(shadedFaces);
+	}
+
 //	finally render the faces that we collected in the subset handler.
 	render_faces(pObj, grid, shFace, true);
 }
 
+void LGScene::update_scalar_render_data(LGObject* pObj)
+{
+	PROFILE_FUNC();
+	FRAME_PROFILE_STAGE(PS_RENDER_SCALARS);
+	Grid& grid = pObj->grid();
+	LGObject::ScalarRenderData& rd = pObj->m_scalarRenderData;
+
+	if(!grid.has_vertex_attachment(m_aInt))
+		grid.attach_to_vertices(m_aInt);
+
+	Grid::VertexAttachmentAccessor<AInt> aaInd(grid, m_aInt);
+	Grid::VertexAttachmentAccessor<APosition> aaPos(grid, aPosition);
+	Grid::FaceAttachmentAccessor<ANormal> aaNorm(grid, aNormal);
+	Grid::FaceAttachmentAccessor<ABool> aaRenderedFACE(grid, m_aRendered);
+
+	const size_t numVrts = grid.num_vertices();
+	rd.positions.resize(3 * numVrts);
+	rd.normals.assign(3 * numVrts, 0);
+	rd.indices.clear();
+
+	int ind = 0;
+	for(VertexIterator iter = grid.vertices_begin();
+		iter != grid.vertices_end(); ++iter, ++ind)
+	{
+		aaInd[*iter] = ind;
+		const vector3& v = aaPos[*iter];
+		rd.positions[3 * ind] = v.x();
+		rd.positions[3 * ind + 1] = v.y();
+		rd.positions[3 * ind + 2] = v.z();
+	}
+
+//	vertex normals are the averaged normals of the adjacent rendered faces.
+//	faces are triangulated as fans.
+	for(FaceIterator iter = grid.faces_begin(); iter != grid.faces_end(); ++iter)
+	{
+		Face* f = *iter;
+		if(!aaRenderedFACE[f] || f->num_vertices() < 3)
+			continue;
+
+		const vector3& n = aaNorm[f];
+		const size_t numCorners = f->num_vertices();
+		for(size_t i = 0; i < numCorners; ++i){
+			const int vi = aaInd[f->vertex(i)];
+			rd.normals[3 * vi] += n.x();
+			rd.normals[3 * vi + 1] += n.y();
+			rd.normals[3 * vi + 2] += n.z();
+		}
+
+		for(size_t i = 1; i + 1 < numCorners; ++i){
+			rd.indices.push_back(aaInd[f->vertex(0)]);
+			rd.indices.push_back(aaInd[f->vertex(i)]);
+			rd.indices.push_back(aaInd[f->vertex(i + 1)]);
+		}
+	}
+
+	for(size_t i = 0; i < numVrts; ++i){
+		float* n = &rd.normals[3 * i];
+		const float len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if(len > 0){
+			n[0] /= len;
+			n[1] /= len;
+			n[2] /= len;
+		}
+	}
+
+	rd.valid = true;
+}
+
+GLuint LGScene::colormap_texture(int colormap)
+{
+	if(colormap < 0 || colormap >= NUM_COLORMAPS)
+		colormap = CM_COOL_WARM;
+
+	if(m_colormapTextures.empty())
+		m_colormapTextures.resize(NUM_COLORMAPS, 0);
+
+	GLuint& tex = m_colormapTextures[colormap];
+	if(tex == 0){
+		const size_t numEntries = 256;
+		vector<float> table(3 * numEntries);
+		CreateColormapTable(colormap, &table.front(), numEntries);
+
+		glGenTextures(1, &tex);
+		glBindTexture(GL_TEXTURE_1D, tex);
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, (GLsizei)numEntries, 0,
+					 GL_RGB, GL_FLOAT, &table.front());
+	}
+	return tex;
+}
+
+void LGScene::draw_scalar_field(LGObject* pObj, const PreparedRenderData* arrays)
+{
+	LGObject::ScalarRenderData& rd = pObj->m_scalarRenderData;
+	if(!rd.valid)
+		update_scalar_render_data(pObj);
+
+	const vector<float>& scalars = pObj->vertex_scalars();
+	if(rd.indices.empty() || 3 * scalars.size() != rd.positions.size())
+		return;
+
+//	the prepared arrays of an animated object use the same vertex order
+	const float* positions = &rd.positions.front();
+	const float* normals = &rd.normals.front();
+	if(arrays && arrays->positions.size() == rd.positions.size()){
+		positions = &arrays->positions.front();
+		normals = &arrays->normals.front();
+	}
+
+	GLfloat white[4] = {1.f, 1.f, 1.f, 1.f};
+	glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, white);
+	glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, white);
+
+	glEnable(GL_TEXTURE_1D);
+	glBindTexture(GL_TEXTURE_1D, colormap_texture(pObj->colormap()));
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+//	the texture matrix maps [min, max] to [0, 1]. The scalar values can thus
+//	be used as texture coordinates as they are.
+	float range = pObj->scalar_max() - pObj->scalar_min();
+	if(range <= 0)
+		range = 1.f;
+	glMatrixMode(GL_TEXTURE);
+	glPushMatrix();
+	glLoadIdentity();
+	glScalef(1.f / range, 1.f, 1.f);
+	glTranslatef(-pObj->scalar_min(), 0, 0);
+	glMatrixMode(GL_MODELVIEW);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, positions);
+	glNormalPointer(GL_FLOAT, 0, normals);
+	glTexCoordPointer(1, GL_FLOAT, 0, &scalars.front());
+
+	glDrawElements(GL_TRIANGLES, (GLsizei)rd.indices.size(), GL_UNSIGNED_INT,
+				   &rd.indices.front());
+	FRAME_PROFILE_COUNT(PC_TRIANGLES_SUBMITTED, rd.indices.size() / 3);
+
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	glMatrixMode(GL_TEXTURE);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glDisable(GL_TEXTURE_1D);
+}
+
 void LGScene::render_faces_with_clip_plane(LGObject* pObj)
 {
+	FRAME_PROFILE_STAGE(PS_RENDER_FACES);
 //	renders the faces of an object.
 //	visibility is handled by the draw routine.
 	Grid& grid = pObj->grid();
@@ -1969,6 +2695,8 @@ ug::Vertex* LGScene::
 get_clicked_vertex(LGObject* obj, const ug::vector3& from,
 				   const ug::vector3& to)
 {
+	process_pending_updates();
+
 	Vertex* vrtClosest = NULL;
 
 	if(obj){
@@ -2001,6 +2729,8 @@ ug::Edge* LGScene::
 get_clicked_edge(LGObject* obj, const ug::vector3& from,
 				 const ug::vector3& to, bool closestToTo)
 {
+	process_pending_updates();
+
 	Edge* eClosest = NULL;
 
 	if(obj){
@@ -2074,6 +2804,8 @@ ug::Face* LGScene::
 get_clicked_face(LGObject* pObj, const ug::vector3& from,
 				 const ug::vector3& to)
 {
+	process_pending_updates();
+
 	vector3 dir;
 	VecSubtract(dir, to, from);
 
@@ -2180,6 +2912,8 @@ ug::Volume* LGScene::
 get_clicked_volume(LGObject* pObj, const ug::vector3& from,
 					const ug::vector3& to)
 {
+	process_pending_updates();
+
 //	get the clicked face and check its associated volumes.
 //	if a visible volume is associated, it is considered to be clicked.
 	Grid& grid = pObj->grid();
@@ -2213,6 +2947,8 @@ get_vertices_in_rect(std::vector<Vertex*>& vrtsOut,
 					LGObject* obj,
 					float xMin, float yMin, float xMax, float yMax)
 {
+	process_pending_updates();
+
 //	iterate over all vertices and select them if they are visible
 	vrtsOut.clear();
 	yMin = m_viewHeight - yMin;
@@ -2268,6 +3004,8 @@ get_edges_in_rect(std::vector<Edge*>& edgesOut,
 					LGObject* obj,
 					float xMin, float yMin, float xMax, float yMax)
 {
+	process_pending_updates();
+
 	edgesOut.clear();
 	yMin = m_viewHeight - yMin;
 	yMax = m_viewHeight - yMax;
@@ -2331,6 +3069,8 @@ get_faces_in_rect(std::vector<Face*>& facesOut,
 					LGObject* obj,
 					float xMin, float yMin, float xMax, float yMax)
 {
+	process_pending_updates();
+
 	facesOut.clear();
 	yMin = m_viewHeight - yMin;
 	yMax = m_viewHeight - yMax;
@@ -2393,6 +3133,8 @@ get_volumes_in_rect(std::vector<Volume*>& volsOut,
 					LGObject* obj,
 					float xMin, float yMin, float xMax, float yMax)
 {
+	process_pending_updates();
+
 	volsOut.clear();
 	yMin = m_viewHeight - yMin;
 	yMax = m_viewHeight - yMax;
@@ -2460,6 +3202,8 @@ get_edges_in_rect_cut(std::vector<Edge*>& edgesOut,
 					LGObject* obj,
 					float xMin, float yMin, float xMax, float yMax)
 {
+	process_pending_updates();
+
 	edgesOut.clear();
 	yMin = m_viewHeight - yMin;
 	yMax = m_viewHeight - yMax;
@@ -2535,6 +3279,8 @@ get_faces_in_rect_cut(std::vector<Face*>& facesOut,
 				  LGObject* obj,
 				  float xMin, float yMin, float xMax, float yMax)
 {
+	process_pending_updates();
+
 	facesOut.clear();
 	yMin = m_viewHeight - yMin;
 	yMax = m_viewHeight - yMax;
@@ -2624,6 +3370,8 @@ get_volumes_in_rect_cut(std::vector<Volume*>& volsOut,
 				  LGObject* obj,
 				  float xMin, float yMin, float xMax, float yMax)
 {
+	process_pending_updates();
+
 	volsOut.clear();
 	yMin = m_viewHeight - yMin;
 	yMax = m_viewHeight - yMax;
@@ -2731,3 +3479,14 @@ set_element_draw_mode(bool drawVrts, bool drawEdges, bool drawFaces, bool drawVo
 	m_drawFaces = drawFaces;
 	m_drawVolumes = drawVols;
 }
+
+void LGScene::
+set_smooth_shading(bool enable)
+{
+	m_smoothShading = enable;
+	for(int i = 0; i < num_objects(); ++i){
+		LGObject* obj = get_object(i);
+		obj->set_smooth_shading(enable);
+		invalidate(obj, DF_VISUALS);
+	}
+}
@@ -28,6 +28,8 @@
 #ifndef __H__LG_SCENE__
 #define __H__LG_SCENE__
 
+#include <map>
+#include <stdint.h>
 #include <string>
 #include "lg_include.h"
 #include "lg_object.h"
@@ -37,29 +39,63 @@
 //TODO:	remove this restriction
 const int MAX_NUM_CLIP_PLANES = 3;
 
+class RenderDataWorker;
+struct PreparedRenderData;
+
 class LGScene : public TScene<LGObject>
 {
 	Q_OBJECT
 
 	typedef TScene<LGObject> BaseClass;
 
+	public:
+	///	kinds of invalidations which are collected per object, see invalidate.
+		enum DirtyFlags
+		{
+			DF_GEOMETRY = 1,	///< bounding spheres and all display lists
+			DF_VISUALS = 2,		///< all display lists
+			DF_SELECTION = 4	///< the display list of the selection
+		};
+
 	public:
 		LGScene();
-		virtual ~LGScene()	{}
+		virtual ~LGScene();
 
 	///	adds obj to the scene and updates its visuals.
 		virtual int add_object(LGObject* obj, bool autoDelete = true);
 
+	///	removes the object and drops its pending updates.
+		virtual bool remove_object(int index);
+
 	///	updates all visuals of the scene
 		virtual void update_visuals();
 
 	///	updates the visuals of the object at the given index.
 		virtual void update_visuals(int objIndex);
 
-	///	updates the visuals of pObj.
+	///	updates the visuals of pObj before the next frame is drawn.
 		virtual void update_visuals(LGObject* pObj);
 		virtual void update_selection_visuals(LGObject* obj);
 
+	///	marks pObj for an update before the next frame and requests a repaint.
+	/**	flags is a combination of DirtyFlags. Invalidations of an object are
+	 * merged until process_pending_updates is called, so that e.g. a geometry
+	 * change followed by a visuals and a selection change leads to a single
+	 * rebuild of the display lists of pObj.*/
+		void invalidate(LGObject* pObj, unsigned int flags);
+
+	///	performs the updates which were collected by invalidate.
+	/**	Called at the beginning of draw. Methods which read the render state of
+	 * the objects, e.g. picking, call it, too.
+	 *
+	 * Geometry updates of an object whose positions are animated (see
+	 * LGObject::begin_position_animation) do not rebuild its display lists.
+	 * Instead a snapshot of the positions is handed to a RenderDataWorker,
+	 * which prepares vertex and normal arrays in the background. Bounding
+	 * spheres are not updated for such snapshots.*/
+		void process_pending_updates();
+		inline bool has_pending_updates() const	{return !m_pendingUpdates.empty();}
+
 		ug::Vertex* get_clicked_vertex(LGObject* pObj,
 									const ug::vector3& from,
 									const ug::vector3& to);
@@ -165,6 +201,15 @@ class LGScene : public TScene<LGObject>
 	//	derived from TScene
 		virtual void update_visuals(ISceneObject* pObj);
 
+	//	memory
+	///	memory of pObj including the attachments of the scene, see LGObject::memory_footprint
+		LGMemoryFootprint memory_footprint(LGObject* pObj);
+	///	memory of all objects of the scene
+		LGMemoryFootprint memory_footprint();
+
+		virtual QString info_text();
+		virtual QString object_info_text(ISceneObject* pObj);
+
 	//	geometry
 	///	returns the bounding box of the scene
 		void get_bounding_box(ug::vector3& vMinOut, ug::vector3& vMaxOut);
@@ -196,6 +241,12 @@ class LGScene : public TScene<LGObject>
 		void set_element_draw_mode(bool drawVrts, bool drawEdges, bool drawFaces,
 								   bool drawVols);
 
+	///	draws the faces of all objects with interpolated vertex normals.
+	/**	Also applies to objects which are added later on. Rebuilds the visuals
+	 * of all objects. See LGObject::set_smooth_shading.*/
+		void set_smooth_shading(bool enable);
+		bool smooth_shading() const		{return m_smoothShading;}
+
 	signals:
 		void geometry_changed();
 		void selection_changed();
@@ -210,10 +261,70 @@ class LGScene : public TScene<LGObject>
 		void object_selection_changed();
 		void object_properties_changed();
 
+	protected:
+	///	index arrays which replace the display lists of an animated object
+	/**	Recorded while the display lists of the object are rebuilt. Indices
+	 * refer to the vertices in the order of 'vertices', which are only valid
+	 * as long as the topology stamp of the object equals 'topologyStamp'.
+	 * Display lists with mode GL_NONE, e.g. the selection, are still called
+	 * as they are.*/
+		struct AnimationRenderData{
+			AnimationRenderData() : topologyStamp(0), firstSnapshot(0), worker(NULL)	{}
+			~AnimationRenderData();
+
+			unsigned int							topologyStamp;
+			uint64_t								firstSnapshot;///< the first one after the capture
+			std::vector<ug::Vertex*>				vertices;
+			std::vector<GLenum>						listModes;
+			std::vector<std::vector<unsigned int> >	listIndices;
+		///	number of triangles of each captured face, for lists of triangles
+			std::vector<std::vector<unsigned char> >	listFaceSizes;
+		///	first corner of each list of triangles in the flat arrays
+			std::vector<size_t>						listFirstCorners;
+			std::vector<float>						snapshot;
+			RenderDataWorker*						worker;
+		};
+
 	protected:
 		ug::Plane near_clip_plane();
 		
 		void calculate_bounding_spheres(LGObject* pObj);
+	///	only calculates the bounding spheres of the given elements of pObj
+		void calculate_bounding_spheres(LGObject* pObj,
+										const std::vector<ug::Face*>& faces,
+										const std::vector<ug::Volume*>& vols);
+
+	///	rebuilds all display lists of pObj right away
+		void rebuild_visuals(LGObject* pObj);
+	///	rebuilds the display list of the selection of pObj right away
+		void rebuild_selection_visuals(LGObject* pObj);
+
+	///	starts to record the display lists of pObj if its positions are animated
+	/**	The recorded vertices and the worker of a previous capture are kept
+	 * if the topology of pObj didn't change since.*/
+		void begin_animation_capture(LGObject* pObj, bool clipPlaneEnabled);
+	///	stops recording and hands the recorded triangles to the RenderDataWorker
+		void end_animation_capture(LGObject* pObj);
+	///	records the elements of a display list which is currently rebuilt
+		void capture_faces(LGObject* pObj, int displayListIndex,
+						   ug::SubsetHandler& sh, int subsetIndex);
+		void capture_edges(LGObject* pObj, int displayListIndex, int subsetIndex);
+		void capture_vertices(LGObject* pObj, int displayListIndex, int subsetIndex);
+
+	///	hands the current positions of an animated object to its worker.
+	/**	Returns false if the object has to be updated synchronously instead.*/
+		bool submit_animation_snapshot(LGObject* pObj);
+	///	copies the current positions of pObj to the worker of anim. Returns the snapshot id.
+		uint64_t submit_positions(LGObject* pObj, AnimationRenderData* anim);
+		void release_animation_data(LGObject* pObj);
+
+	///	swaps in the most recently prepared arrays of pObj.
+	/**	Returns NULL if pObj has to be drawn from its display lists.*/
+		AnimationRenderData* animation_arrays(LGObject* pObj);
+
+	///	calls the display list or draws its recorded elements from the prepared arrays
+		void call_display_list(LGObject* pObj, int displayListIndex,
+							   AnimationRenderData* anim);
 
 		void render_skeleton(LGObject* pObj);
 
@@ -261,6 +372,17 @@ class LGScene : public TScene<LGObject>
 		void render_faces_without_clip_plane(LGObject* pObj);
 		void render_faces_with_clip_plane(LGObject* pObj);
 
+	///	collects the vertex arrays of all rendered faces for scalar drawing
+		void update_scalar_render_data(LGObject* pObj);
+
+	///	draws the rendered faces colored by the vertex scalars of pObj
+	/**	If arrays is given, its positions and normals are used.*/
+		void draw_scalar_field(LGObject* pObj,
+							   const PreparedRenderData* arrays = NULL);
+
+	///	returns a 1d texture holding the given colormap. Created on first use.
+		GLuint colormap_texture(int colormap);
+
 		bool clip_vertex(ug::Vertex* vrt,
 						 ug::Grid::VertexAttachmentAccessor<ug::APosition>& aaPos);
 		bool clip_edge(ug::Edge* e,
@@ -302,10 +424,19 @@ class LGScene : public TScene<LGObject>
 		bool		m_clipPlaneEnabled[MAX_NUM_CLIP_PLANES];
 
 	//	rendering
+		std::vector<GLuint>	m_colormapTextures;
 		bool	m_drawVertices;
 		bool	m_drawEdges;
 		bool	m_drawFaces;
 		bool	m_drawVolumes;
+		bool	m_smoothShading;
+
+	///	DirtyFlags of the objects whose updates are pending
+		std::map<LGObject*, unsigned int>	m_pendingUpdates;
+
+	//	animation
+		std::map<LGObject*, AnimationRenderData*>	m_animationData;
+		AnimationRenderData*	m_capture;///< set while display lists are recorded
 };
 
 
@@ -30,7 +30,9 @@
 //	at some point in the near future.
 ////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include "lg_include.h"
+#include "util/parallel_for.h"
 
 namespace ug
 {
@@ -173,4 +175,246 @@ bool ClipVolume(Volume* v, const ug::Sphere3& boundingSphere, ug::Plane& clipPla
 }
 
 
+////////////////////////////////////////////////////////////////////////
+//	CalculateFaceNormalsParallel
+void CalculateFaceNormalsParallel(const std::vector<Face*>& faces,
+								  Grid::VertexAttachmentAccessor<APosition>& aaPos,
+								  Grid::FaceAttachmentAccessor<ANormal>& aaNorm)
+{
+	ParallelForRanges(faces.size(),
+		[&faces, &aaPos, &aaNorm](size_t, size_t begin, size_t end){
+			for(size_t i = begin; i < end; ++i)
+				CalculateNormal(aaNorm[faces[i]], faces[i], aaPos);
+		});
+}
+
+////////////////////////////////////////////////////////////////////////
+//	CalculateBoundingSpheresParallel
+void CalculateBoundingSpheresParallel(const std::vector<Face*>& faces,
+									  Grid::VertexAttachmentAccessor<APosition>& aaPos,
+									  Grid::FaceAttachmentAccessor<ASphere>& aaSphere)
+{
+	ParallelForRanges(faces.size(),
+		[&faces, &aaPos, &aaSphere](size_t, size_t begin, size_t end){
+			for(size_t i = begin; i < end; ++i)
+				CalculateBoundingSphere(aaSphere[faces[i]], faces[i], aaPos);
+		});
+}
+
+void CalculateBoundingSpheresParallel(const std::vector<Volume*>& vols,
+									  Grid::VertexAttachmentAccessor<APosition>& aaPos,
+									  Grid::VolumeAttachmentAccessor<ASphere>& aaSphere)
+{
+	ParallelForRanges(vols.size(),
+		[&vols, &aaPos, &aaSphere](size_t, size_t begin, size_t end){
+			for(size_t i = begin; i < end; ++i)
+				CalculateBoundingSphere(aaSphere[vols[i]], vols[i], aaPos);
+		});
+}
+
+////////////////////////////////////////////////////////////////////////
+//	CalculateBoundingBoxParallel
+void CalculateBoundingBoxParallel(vector3& vMinOut, vector3& vMaxOut,
+								  const std::vector<Vertex*>& vrts,
+								  Grid::VertexAttachmentAccessor<APosition>& aaPos)
+{
+	vMinOut = vMaxOut = vector3(0, 0, 0);
+	if(vrts.empty())
+		return;
+
+//	each range computes the box of its vertices, the boxes are merged afterwards
+	const size_t numRanges = NumParallelRanges(vrts.size());
+	std::vector<vector3> mins(numRanges), maxs(numRanges);
+
+	ParallelForRanges(vrts.size(),
+		[&vrts, &aaPos, &mins, &maxs](size_t range, size_t begin, size_t end){
+			vector3 vMin = aaPos[vrts[begin]];
+			vector3 vMax = vMin;
+			for(size_t i = begin + 1; i < end; ++i){
+				vector3& v = aaPos[vrts[i]];
+				VecCompMin(vMin, vMin, v);
+				VecCompMax(vMax, vMax, v);
+			}
+			mins[range] = vMin;
+			maxs[range] = vMax;
+		});
+
+	vMinOut = mins[0];
+	vMaxOut = maxs[0];
+	for(size_t i = 1; i < numRanges; ++i){
+		VecCompMin(vMinOut, vMinOut, mins[i]);
+		VecCompMax(vMaxOut, vMaxOut, maxs[i]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////
+//	VertexFaceAdjacency
+void VertexFaceAdjacency::clear()
+{
+	std::vector<Vertex*>().swap(vertices);
+	std::vector<Face*>().swap(faces);
+	std::vector<size_t>().swap(offsets);
+	std::vector<unsigned int>().swap(faceInds);
+	std::vector<vector3>().swap(weightedNormals);
+}
+
+void BuildVertexFaceAdjacency(VertexFaceAdjacency& adjOut, Grid& grid)
+{
+	std::vector<Face*> faces;
+	CollectElements(faces, grid.faces_begin(), grid.faces_end(), grid.num_faces());
+	BuildVertexFaceAdjacency(adjOut, grid, faces);
+}
+
+void BuildVertexFaceAdjacency(VertexFaceAdjacency& adjOut, Grid& grid,
+							  const std::vector<Face*>& faces)
+{
+	adjOut.clear();
+	adjOut.faces = faces;
+
+//	the corners of the faces are indexed in the order of their first appearance
+	AInt aIndex;
+	grid.attach_to_vertices_dv(aIndex, -1);
+	Grid::VertexAttachmentAccessor<AInt> aaIndex(grid, aIndex);
+	for(size_t i = 0; i < faces.size(); ++i){
+		Face* f = faces[i];
+		for(size_t j = 0; j < f->num_vertices(); ++j){
+			Vertex* v = f->vertex(j);
+			if(aaIndex[v] < 0){
+				aaIndex[v] = (int)adjOut.vertices.size();
+				adjOut.vertices.push_back(v);
+			}
+		}
+	}
+
+//	count the faces of each vertex and turn the counts into offsets
+	adjOut.offsets.assign(adjOut.vertices.size() + 1, 0);
+	for(size_t i = 0; i < adjOut.faces.size(); ++i){
+		Face* f = adjOut.faces[i];
+		for(size_t j = 0; j < f->num_vertices(); ++j)
+			++adjOut.offsets[aaIndex[f->vertex(j)] + 1];
+	}
+
+	for(size_t i = 1; i < adjOut.offsets.size(); ++i)
+		adjOut.offsets[i] += adjOut.offsets[i - 1];
+
+	adjOut.faceInds.resize(adjOut.offsets.back());
+	std::vector<size_t> fill(adjOut.offsets.begin(), adjOut.offsets.end() - 1);
+	for(size_t i = 0; i < adjOut.faces.size(); ++i){
+		Face* f = adjOut.faces[i];
+		for(size_t j = 0; j < f->num_vertices(); ++j)
+			adjOut.faceInds[fill[aaIndex[f->vertex(j)]]++] = (unsigned int)i;
+	}
+
+	grid.detach_from_vertices(aIndex);
+}
+
+////////////////////////////////////////////////////////////////////////
+//	CalculateVertexNormalsParallel
+///	the cross product of the diagonals of a face is twice its area times its
+///	normal. For triangles this is the cross product of two of its edges.
+static void CalculateWeightedNormal(vector3& nOut, Face* f,
+									Grid::VertexAttachmentAccessor<APosition>& aaPos)
+{
+	vector3 d0, d1;
+	if(f->num_vertices() == 4){
+		VecSubtract(d0, aaPos[f->vertex(2)], aaPos[f->vertex(0)]);
+		VecSubtract(d1, aaPos[f->vertex(3)], aaPos[f->vertex(1)]);
+	}
+	else{
+		VecSubtract(d0, aaPos[f->vertex(1)], aaPos[f->vertex(0)]);
+		VecSubtract(d1, aaPos[f->vertex(2)], aaPos[f->vertex(0)]);
+	}
+	VecCross(nOut, d0, d1);
+}
+
+///	sums the weighted normals of the faces of adj.vertices[i] and normalizes the result
+static void SumVertexNormal(VertexFaceAdjacency& adj, size_t i,
+							Grid::VertexAttachmentAccessor<ANormal>& aaVrtNorm)
+{
+	vector3& n = aaVrtNorm[adj.vertices[i]];
+	n = vector3(0, 0, 0);
+	for(size_t j = adj.offsets[i]; j < adj.offsets[i + 1]; ++j)
+		VecAdd(n, n, adj.weightedNormals[adj.faceInds[j]]);
+	const number len = VecLength(n);
+	if(len > 0)
+		VecScale(n, n, 1. / len);
+}
+
+void CalculateVertexNormalsParallel(VertexFaceAdjacency& adj,
+									Grid::VertexAttachmentAccessor<APosition>& aaPos,
+									Grid::VertexAttachmentAccessor<ANormal>& aaVrtNorm)
+{
+	const std::vector<Face*>& faces = adj.faces;
+	std::vector<vector3>& weighted = adj.weightedNormals;
+	weighted.resize(faces.size());
+
+	ParallelForRanges(faces.size(),
+		[&faces, &weighted, &aaPos](size_t, size_t begin, size_t end){
+			for(size_t i = begin; i < end; ++i)
+				CalculateWeightedNormal(weighted[i], faces[i], aaPos);
+		});
+
+	ParallelForRanges(adj.vertices.size(),
+		[&adj, &aaVrtNorm](size_t, size_t begin, size_t end){
+			for(size_t i = begin; i < end; ++i)
+				SumVertexNormal(adj, i, aaVrtNorm);
+		});
+}
+
+void CalculateVertexNormalsParallel(VertexFaceAdjacency& adj,
+									const std::vector<size_t>& vrtInds,
+									const std::vector<size_t>& faceInds,
+									Grid::VertexAttachmentAccessor<APosition>& aaPos,
+									Grid::VertexAttachmentAccessor<ANormal>& aaVrtNorm)
+{
+//	the weighted normals of the other faces have to be known already
+	if(adj.weightedNormals.size() != adj.faces.size()){
+		CalculateVertexNormalsParallel(adj, aaPos, aaVrtNorm);
+		return;
+	}
+
+	ParallelForRanges(faceInds.size(),
+		[&adj, &faceInds, &aaPos](size_t, size_t begin, size_t end){
+			for(size_t i = begin; i < end; ++i){
+				CalculateWeightedNormal(adj.weightedNormals[faceInds[i]],
+										adj.faces[faceInds[i]], aaPos);
+			}
+		});
+
+	ParallelForRanges(vrtInds.size(),
+		[&adj, &vrtInds, &aaVrtNorm](size_t, size_t begin, size_t end){
+			for(size_t i = begin; i < end; ++i)
+				SumVertexNormal(adj, vrtInds[i], aaVrtNorm);
+		});
+}
+
+void CollectVertexFaceAdjacencyRing(std::vector<size_t>& vrtIndsOut,
+									std::vector<size_t>& faceIndsOut,
+									const VertexFaceAdjacency& adj, Grid& grid,
+									const std::vector<Face*>& faces)
+{
+	vrtIndsOut.clear();
+	faceIndsOut.clear();
+
+	grid.begin_marking();
+	for(size_t i = 0; i < faces.size(); ++i){
+		Face* f = faces[i];
+		for(size_t j = 0; j < f->num_vertices(); ++j)
+			grid.mark(f->vertex(j));
+	}
+
+	for(size_t i = 0; i < adj.vertices.size(); ++i){
+		if(!grid.is_marked(adj.vertices[i]))
+			continue;
+		vrtIndsOut.push_back(i);
+		for(size_t j = adj.offsets[i]; j < adj.offsets[i + 1]; ++j)
+			faceIndsOut.push_back(adj.faceInds[j]);
+	}
+	grid.end_marking();
+
+	std::sort(faceIndsOut.begin(), faceIndsOut.end());
+	faceIndsOut.erase(std::unique(faceIndsOut.begin(), faceIndsOut.end()),
+					  faceIndsOut.end());
+}
+
 }
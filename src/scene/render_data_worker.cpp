@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+
+#include <algorithm>
+#include <cmath>
+#include "render_data_worker.h"
+#include "util/frame_profiler.h"
+#include "util/trace_recorder.h"
+
+using namespace std;
+
+RenderDataWorker::
+RenderDataWorker(size_t numVertices, const RenderTriangles& triangles,
+				 QObject* parent) :
+	QObject(parent),
+	m_numVertices(numVertices),
+	m_triangles(triangles),
+	m_stop(false),
+	m_snapshotId(0),
+	m_hasSnapshot(false),
+	m_hasNewTriangles(false),
+	m_backReady(false)
+{
+	m_worker = thread(&RenderDataWorker::worker_loop, this);
+}
+
+RenderDataWorker::
+~RenderDataWorker()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_snapshotSubmitted.notify_one();
+	m_worker.join();
+}
+
+uint64_t RenderDataWorker::
+submit(std::vector<float>& positions)
+{
+	uint64_t id;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_snapshot.swap(positions);
+		id = ++m_snapshotId;
+		m_hasSnapshot = true;
+	}
+	m_snapshotSubmitted.notify_one();
+	return id;
+}
+
+void RenderDataWorker::
+set_triangles(const RenderTriangles& triangles)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_newTriangles = triangles;
+	m_hasNewTriangles = true;
+}
+
+bool RenderDataWorker::
+swap_buffers()
+{
+	lock_guard<mutex> lock(m_mutex);
+	if(!m_backReady)
+		return false;
+
+	swap(m_front, m_back);
+	m_backReady = false;
+	return true;
+}
+
+void RenderDataWorker::
+worker_loop()
+{
+	TraceRecorder::instance().set_thread_name("render data worker");
+
+	vector<float> snapshot;
+	PreparedRenderData work;
+	unique_lock<mutex> lock(m_mutex);
+
+	while(!m_stop){
+		if(!m_hasSnapshot){
+			m_snapshotSubmitted.wait(lock);
+			continue;
+		}
+
+	//	take the snapshot and hand the buffer of the last one back for recycling
+		snapshot.swap(m_snapshot);
+		work.snapshot = m_snapshotId;
+		m_hasSnapshot = false;
+		if(m_hasNewTriangles){
+			swap(m_triangles, m_newTriangles);
+			m_hasNewTriangles = false;
+		}
+
+		lock.unlock();
+		prepare(snapshot, work);
+		lock.lock();
+
+	//	publish the arrays. A back buffer which was not yet swapped to the
+	//	front is outdated now and will be overwritten by the next preparation.
+		swap(work, m_back);
+		m_backReady = true;
+
+		lock.unlock();
+		emit prepared();
+		lock.lock();
+	}
+}
+
+///	normalizes v in place, if it is not zero
+static void NormalizeInPlace(float* v)
+{
+	const float len = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	if(len > 0){
+		v[0] /= len;
+		v[1] /= len;
+		v[2] /= len;
+	}
+}
+
+void RenderDataWorker::
+prepare(std::vector<float>& snapshot, PreparedRenderData& out)
+{
+	FRAME_PROFILE_STAGE(PS_PREPARE_RENDER_DATA);
+
+	const size_t numCoords = 3 * m_numVertices;
+	snapshot.resize(numCoords, 0);
+	out.positions.swap(snapshot);
+	out.normals.assign(numCoords, 0);
+
+	const vector<unsigned int>& tris = m_triangles.indices;
+	const float* p = out.positions.empty() ? NULL : &out.positions.front();
+	float* n = out.normals.empty() ? NULL : &out.normals.front();
+
+//	the cross product of two triangle edges is twice the area weighted normal
+	for(size_t i = 0; i + 2 < tris.size(); i += 3){
+		const float* p0 = p + 3 * tris[i];
+		const float* p1 = p + 3 * tris[i + 1];
+		const float* p2 = p + 3 * tris[i + 2];
+
+		const float a[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+		const float b[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+		const float c[3] = {a[1] * b[2] - a[2] * b[1],
+							a[2] * b[0] - a[0] * b[2],
+							a[0] * b[1] - a[1] * b[0]};
+
+		for(int j = 0; j < 3; ++j){
+			float* nj = n + 3 * tris[i + j];
+			nj[0] += c[0];
+			nj[1] += c[1];
+			nj[2] += c[2];
+		}
+	}
+
+	for(size_t i = 0; i < m_numVertices; ++i)
+		NormalizeInPlace(n + 3 * i);
+
+	if(m_triangles.smooth){
+		out.flatPositions.clear();
+		out.flatNormals.clear();
+	}
+	else
+		prepare_flat(out);
+}
+
+void RenderDataWorker::
+prepare_flat(PreparedRenderData& out)
+{
+	const vector<unsigned int>& tris = m_triangles.indices;
+	const vector<unsigned char>& faceSizes = m_triangles.faceSizes;
+	out.flatPositions.resize(3 * tris.size());
+	out.flatNormals.resize(3 * tris.size());
+	if(tris.empty())
+		return;
+
+	const float* p = &out.positions.front();
+	float* fp = &out.flatPositions.front();
+	float* fn = &out.flatNormals.front();
+
+//	like the face normals of the display lists, the normal of a face is the
+//	normalized sum of the unit normals of its fan triangles
+	size_t tri = 0;
+	const size_t numTris = tris.size() / 3;
+	for(size_t iface = 0; tri < numTris; ++iface){
+		const size_t faceSize = iface < faceSizes.size() ? faceSizes[iface] : 1;
+		const size_t triEnd = min(numTris, tri + max<size_t>(faceSize, 1));
+		float fnorm[3] = {0, 0, 0};
+		for(size_t t = tri; t < triEnd; ++t){
+			const float* p0 = p + 3 * tris[3 * t];
+			const float* p1 = p + 3 * tris[3 * t + 1];
+			const float* p2 = p + 3 * tris[3 * t + 2];
+			const float a[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+			const float b[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+			float c[3] = {a[1] * b[2] - a[2] * b[1],
+						  a[2] * b[0] - a[0] * b[2],
+						  a[0] * b[1] - a[1] * b[0]};
+			NormalizeInPlace(c);
+			fnorm[0] += c[0];
+			fnorm[1] += c[1];
+			fnorm[2] += c[2];
+		}
+		NormalizeInPlace(fnorm);
+
+		for(size_t i = 9 * tri; i < 9 * triEnd; i += 3){
+			const float* pi = p + 3 * tris[i / 3];
+			fp[i] = pi[0];
+			fp[i + 1] = pi[1];
+			fp[i + 2] = pi[2];
+			fn[i] = fnorm[0];
+			fn[i + 1] = fnorm[1];
+			fn[i + 2] = fnorm[2];
+		}
+		tri = triEnd;
+	}
+}
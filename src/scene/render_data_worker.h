@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+
+#ifndef __H__EMVIS_render_data_worker__
+#define __H__EMVIS_render_data_worker__
+
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include <QObject>
+
+///	the triangles of the rendered faces of an animated object
+struct RenderTriangles
+{
+	RenderTriangles() : smooth(false)	{}
+
+	std::vector<unsigned int>	indices;	///< 3 vertex indices per triangle
+	std::vector<unsigned char>	faceSizes;	///< number of triangles of each face, which are triangulated as fans
+	bool						smooth;		///< shade with vertex normals instead of face normals
+};
+
+///	vertex and normal arrays which were prepared by a RenderDataWorker
+struct PreparedRenderData
+{
+	PreparedRenderData() : snapshot(0)	{}
+
+	std::vector<float>	positions;	///< 3 floats per vertex
+	std::vector<float>	normals;	///< 3 floats per vertex, averaged over the adjacent triangles
+///	3 corners of 3 floats per triangle, in the order of RenderTriangles::indices.
+/**	Only filled if the triangles are shaded flat.*/
+	std::vector<float>	flatPositions;
+	std::vector<float>	flatNormals;///< the normal of its face for each corner of flatPositions
+	uint64_t			snapshot;	///< id of the snapshot the arrays were built from, 0 if empty
+};
+
+
+///	Prepares the render arrays of an animated object on a background thread.
+/**	While the positions of an object are animated, its topology stays the same,
+ * so that the triangles of the rendered faces can be handed to the worker once.
+ * The gui thread then only submits snapshots of the vertex positions. The worker
+ * builds the vertex and normal arrays of the next frame into its back buffer,
+ * publishes it by setting a fence and emits prepared(). Triangles which are
+ * shaded flat additionally get arrays of unshared corners, which carry the
+ * normal of their face, as the display lists do.
+ *
+ * swap_buffers, called by the gui thread before drawing, exchanges the front
+ * and the back buffer if the fence is set and keeps the previous front buffer
+ * otherwise. The gui thread thus never waits for the worker, and the worker
+ * never writes to the front buffer. If snapshots are submitted faster than
+ * they can be prepared, only the most recent one is prepared.*/
+class RenderDataWorker : public QObject
+{
+	Q_OBJECT
+
+	public:
+	///	the indices of triangles refer to the vertex arrays
+		RenderDataWorker(size_t numVertices,
+						 const RenderTriangles& triangles,
+						 QObject* parent = 0);
+		virtual ~RenderDataWorker();
+
+		size_t num_vertices() const		{return m_numVertices;}
+
+	///	replaces the triangles, e.g. since faces were hidden.
+	/**	Used from the next prepared snapshot on.*/
+		void set_triangles(const RenderTriangles& triangles);
+
+	///	hands a snapshot of 3 * num_vertices() coordinates to the worker.
+	/**	The contents of positions are swapped with a recycled buffer.
+	 * Returns the id of the snapshot, see PreparedRenderData::snapshot.*/
+		uint64_t submit(std::vector<float>& positions);
+
+	///	makes the most recently prepared arrays the front buffer.
+	/**	Returns true if the front buffer changed. Call from the gui thread only.*/
+		bool swap_buffers();
+
+	///	the arrays which are drawn. Only valid on the gui thread.
+		const PreparedRenderData& front() const		{return m_front;}
+
+	signals:
+	///	emitted by the worker thread whenever a new back buffer was published
+		void prepared();
+
+	private:
+		void worker_loop();
+
+	///	builds positions and area weighted vertex normals from the snapshot
+		void prepare(std::vector<float>& snapshot, PreparedRenderData& out);
+	///	builds the arrays of unshared corners with the normals of their faces
+		void prepare_flat(PreparedRenderData& out);
+
+		size_t						m_numVertices;
+		RenderTriangles				m_triangles;///< only accessed by the worker thread
+
+		std::thread					m_worker;
+		std::mutex					m_mutex;
+		std::condition_variable		m_snapshotSubmitted;
+		bool						m_stop;
+
+	//	the following members are protected by m_mutex
+		std::vector<float>			m_snapshot;
+		uint64_t					m_snapshotId;
+		bool						m_hasSnapshot;
+		RenderTriangles				m_newTriangles;
+		bool						m_hasNewTriangles;
+		PreparedRenderData			m_back;
+		bool						m_backReady;///< the fence of the back buffer
+
+		PreparedRenderData			m_front;///< only accessed by the gui thread
+};
+
+#endif
@@ -70,6 +70,11 @@ class IScene : public QObject, public IRenderer3D
 		virtual void object_changed(int objIndex) = 0;
 		virtual void object_changed(ISceneObject* pObj) = 0;
 
+	///	a description of the scene, e.g. shown as tooltip by the scene inspector
+		virtual QString info_text()							{return QString();}
+	///	a description of pObj, e.g. shown as tooltip by the scene inspector
+		virtual QString object_info_text(ISceneObject* pObj)	{return QString();}
+
 	public slots:
 		virtual void visibility_changed(ISceneObject* pObj) = 0;
 		virtual void color_changed(ISceneObject* pObj) = 0;
@@ -133,6 +133,12 @@ QVariant SceneItemModel::headerData ( int section,
 		{
 			if(role == Qt::DisplayRole)
 				return QString(tr("geometry name"));
+			if(role == Qt::ToolTipRole && m_scene)
+			{
+				QString info = m_scene->info_text();
+				if(!info.isEmpty())
+					return info;
+			}
 		}break;
 		case 1:
 		{
@@ -182,6 +188,12 @@ QVariant SceneItemModel::data ( const QModelIndex & index,
 		{
 			case 0:
 			{
+				if(role == Qt::ToolTipRole && itemInfo->type == SIT_OBJECT)
+				{
+					QString info = m_scene->object_info_text(itemInfo->obj);
+					if(!info.isEmpty())
+						return info;
+				}
 				if(role == Qt::DisplayRole)
 				{
 					switch(itemInfo->type)
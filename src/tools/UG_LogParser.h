@@ -1,15 +1,15 @@
 
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
 #include <vector>
-#include <QCoreApplication>
-#include <QGuiApplication>
-#include <QScreen>
-#include <QFileDialog>
 #include <math.h>
 #include <stdlib.h>
-#include "app.h"
-#include "standard_tools.h"
-#include "tooltips.h"
 
+//	also defined by vtu_ugx_converter.hpp
+#ifndef __EMVIS_myatoi
+#define __EMVIS_myatoi
 inline unsigned myatoi(std::string line, unsigned& v, char end=0){
 	unsigned idx = 0;
 	v = line[idx]-'0';
@@ -21,10 +21,16 @@ inline unsigned myatoi(std::string line, unsigned& v, char end=0){
 	}
 	return idx;
 }
+#endif
 
 class UG_LogParser{
 public:
-	UG_LogParser(std::string &filename){
+	UG_LogParser(std::string &filename) :
+		_eof(false),
+		_numRefs(0), _numPreRefs(0), _numProcs(0), _evIterations(0), _evPrec(0),
+		_numevs(0), _baselevel(0),
+		_time_assembly(0), _time_solver(0), _time_total(0)
+	{
 		std::cerr << "UG parser filename: " << filename << std::endl;
 		_is = new std::ifstream(filename);
 	}
@@ -33,10 +39,11 @@ public:
 		delete _is;
 	}
 
+	//	an empty line at the end of the file or if it could not be read, see eof
 	std::string get_line(){
-		getline(*_is, _line);
-
-		if(_is->eof()){
+		if(!getline(*_is, _line)){
+			_line.clear();
+			_eof = true;
 			return std::string();
 		}
 		else{
@@ -86,16 +93,29 @@ public:
 		return true;
 	}
 
-	void skip_until(std::string token){
+	bool eof(){
+		return _eof;
+	}
+
+	//	returns false if the file ends before the token was found
+	bool skip_until(std::string token){
 		while(_line.find(token) == std::string::npos){
+			if(_eof){
+				return false;
+			}
 			get_line();
 		}
+		return true;
 	}
 
-	void skip_until2(std::string token1, std::string token2){
+	bool skip_until2(std::string token1, std::string token2){
 		while(_line.find(token1) == std::string::npos && _line.find(token2) == std::string::npos){
+			if(_eof){
+				return false;
+			}
 			get_line();
 		}
+		return true;
 	}
 
 	std::string get_value(std::string &line, std::string token, char delim='='){
@@ -111,8 +131,10 @@ public:
 		return line.substr(pos+token.size(), pos2-pos-token.size());
 	}
 
-	void parse_general_parameters(){
-		skip_until("General parameters chosen");
+	bool parse_general_parameters(){
+		if(!skip_until("General parameters chosen")){
+			return false;
+		}
 		get_line();
 
 		std::string s_grid = get_value(_line, "grid");
@@ -136,10 +158,13 @@ public:
 
 		std::cout.precision(s_evPrec.size());
 		_evPrec = std::stod(s_evPrec);
+		return true;
 	}
 
-	void parse_solver_parameters(){
- 		skip_until("Number of EV");
+	bool parse_solver_parameters(){
+		if(!skip_until("Number of EV")){
+			return false;
+		}
 		std::string s_numevs = get_value(_line, "Number of EV");
 		myatoi(s_numevs, _numevs);
 
@@ -186,10 +211,13 @@ public:
 
 		std::string s_additional_evs = _line;
 		_additional_evs = s_additional_evs;
+		return !_eof;
 	}
 
-	void parse_iterations(){
-		skip_until("iteration");
+	bool parse_iterations(){
+		if(!skip_until("iteration")){
+			return false;
+		}
 		get_line();
 
 		unsigned iter = 0;
@@ -197,6 +225,11 @@ public:
 			_lambdas.push_back(std::vector<double>(_numevs));
 			_defects.push_back(std::vector<double>(_numevs));
 			for(unsigned ev = 0; ev < _numevs; ++ev){
+				if(_eof){
+					_lambdas.pop_back();
+					_defects.pop_back();
+					return false;
+				}
 				std::string ss = get_value(_line, "defect: ", "reduction:");
 				std::string dd = get_value(_line, "lambda: ", "defect:");
 				remove_initial_spaces(ss);
@@ -206,26 +239,33 @@ public:
 				std::cout.precision(dd.size());
 				double d2 = std::stod(dd);
 
-				_lambdas[iter][ev] = d;
-				_defects[iter][ev] = d2;
+				_lambdas[iter][ev] = d2;
+				_defects[iter][ev] = d;
 
 				get_line();
 			}
 			++iter;
-			skip_until2("iteration", "Eigenvalue");
+			if(!skip_until2("iteration", "Eigenvalue")){
+				return false;
+			}
 			if(is_contained("Eigenvalue")){
-				return;
+				return true;
 			}
 			get_line();
 		}
 	
 	}
 
-	void parse_solution_frequencies(){
+	bool parse_solution_frequencies(){
 		get_line();
-		skip_until("Eigenvalue");
+		if(!skip_until("Eigenvalue")){
+			return false;
+		}
 
 		for(unsigned ev = 0; ev < _numevs; ++ev){
+			if(_eof){
+				return false;
+			}
 			remove_until(_line, '=');
 			remove_until(_line, '=');
 			std::string f = _line.substr(1, _line.size()-3);
@@ -234,10 +274,13 @@ public:
 			_frequencies.push_back(std::stod(f));
 			get_line();
 		}
+		return true;
 	}
 
-	void parse_time(){
-		skip_until("duration");
+	bool parse_time(){
+		if(!skip_until("duration")){
+			return false;
+		}
 		std::string s_assembly = get_value(_line, "duration assembly", ':');
 		s_assembly = s_assembly.substr(0, s_assembly.size()-1);
 
@@ -259,14 +302,23 @@ public:
 		
 		std::cout.precision(s_total.size());
 		_time_total = std::stod(s_total);
+		return true;
 	}
 
-	void do_it(){
-		parse_general_parameters();
-		parse_solver_parameters();
-		parse_iterations();
-		parse_solution_frequencies();
-		parse_time();
+	//	returns false if the log ends early, e.g. since the run was aborted, or
+	//	if a value could not be read. The values of the sections which were not
+	//	read stay 0 or empty.
+	bool do_it(){
+		try{
+			return parse_general_parameters()
+				&& parse_solver_parameters()
+				&& parse_iterations()
+				&& parse_solution_frequencies()
+				&& parse_time();
+		}
+		catch(std::exception&){
+			return false;
+		}
 	}
 
 	unsigned num_evs(){
@@ -352,6 +404,7 @@ public:
 public:
 	std::ifstream* _is;
 	std::string _line;
+	bool _eof;
 
 	//General parameters choosen
     unsigned _numRefs;
@@ -93,7 +93,7 @@ class ToolTopView : public ITool
 			newCam.quatOrientation.set_values(0, 0, -1, 0);
 
 			view->camera().set_camera_state(newCam);
-			view->update();
+			view->camera_changed();
 		}
 
 		const char* get_name()		{return "Top View";}
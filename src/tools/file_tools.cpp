@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#include <chrono>
+#include "app.h"
+#include "standard_tools.h"
+#include "tooltips.h"
+
+using namespace std;
+using namespace ug;
+
+class ToolExportUGX : public ITool
+{
+	public:
+		void execute(LGObject* obj, QWidget* widget){
+			ToolWidget* dlg = dynamic_cast<ToolWidget*>(widget);
+			std::string filename = dlg->to_string(0).toStdString();
+			bool binary = dlg->to_bool(1);
+
+			if(filename.empty()){
+				UG_LOG("ERROR: no file selected\n");
+				return;
+			}
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			if(SaveLGObjectToUGX(obj, filename.c_str(), binary)){
+				UG_LOG("saved " << filename << " in "
+					   << std::chrono::duration<double, std::milli>(
+							std::chrono::steady_clock::now() - start).count()
+					   << " ms\n");
+			}
+		}
+
+		const char* get_name()		{return "Export UGX";}
+		const char* get_tooltip()	{return "Writes the grid and subsets of the active object to a ugx file.";}
+		const char* get_group()		{return "File";}
+
+		ToolWidget* get_dialog(QWidget* parent){
+			ToolWidget *dlg = new ToolWidget(get_name(), parent, this,
+									IDB_APPLY | IDB_OK | IDB_CLOSE);
+
+			dlg->addFileBrowser("file", FWT_SAVE, "*.ugx");
+			dlg->addCheckBox("binary blocks", false);
+
+			return dlg;
+		}
+};
+
+void RegisterFileTools(ToolManager* toolMgr)
+{
+	toolMgr->register_tool(new ToolExportUGX);
+}
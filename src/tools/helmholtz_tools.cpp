@@ -36,6 +36,7 @@
 #include "app.h"
 #include "standard_tools.h"
 #include "tooltips.h"
+#include "util/time_series_field.h"
 
 using namespace std;
 using namespace ug;
@@ -45,18 +46,6 @@ typedef std::vector<std::vector<double> > dom2d;
 typedef std::vector<std::vector<std::vector<double> > > dom3d;
 typedef std::vector<std::vector<std::vector<std::vector<double> > > > dom4d;
 
-inline unsigned myatoi(std::string line, unsigned& v, char end=0){
-	unsigned idx = 0;
-	v = line[idx]-'0';
-	++idx;
-	while(line[idx]!=end && idx < line.size()){
-		v *= 10;
-		v += line[idx]-'0';
-		++idx;
-	}
-	return idx;
-}
-
 class ToolHelmholtz : public ITool
 {
 public:
@@ -86,44 +75,27 @@ public:
 			return;
 		}
 
-		//load data
-		std::ifstream fin(data_file);
-		if(!fin){
-			UG_LOG("ERROR: could not open data file " << data_file << "\n");
+		//load data, a single step of a time series
+		TimeSeriesReader reader;
+		std::string error;
+		if(!OpenTimeSeries(reader, data_file,
+						   app::UserTmpDir().path().toStdString(), &error))
+		{
+			UG_LOG("ERROR: could not load data: " << error << "\n");
+			return;
 		}
-		std::string line;
-		getline(fin,line);
-
-		unsigned pos = line.find(" ");
-		std::string s_dim = line.substr(0, pos);
-		line = line.substr(pos+1, line.size()-1);
-		pos = line.find(" ");
-		pos = line.find("\n");
-		std::string s_num_space = line.substr(0, pos);
 
-		unsigned dim;
-		unsigned num_space;
-
-		myatoi(s_dim, dim);
-		myatoi(s_num_space, num_space);
+		unsigned dim = reader.dim();
 
 		if(!(dim == 1 || dim == 2)){
 			UG_LOG("ERROR: dim must be 1 or 2\n");
 			return;
 		}
 
-		std::vector<double> data(num_space);
-
-		std::string token;
-		unsigned k = 0;
-		getline(fin,line);
-		for(unsigned j = 0; j < num_space; ++j){
-			pos = line.find(" ");
-			token = line.substr(0, pos);
-			line = line.substr(pos+1, line.size()-1);
-			std::cout.precision(token.size());
-			data[k] = std::stod(token);
-			++k;
+		const float* data = reader.step(0);
+		if(!data){
+			UG_LOG("ERROR: data file contains no values\n");
+			return;
 		}
 
 		LGScene* scene = app::getActiveScene();
@@ -132,6 +104,11 @@ public:
 
 		Grid::AttachmentAccessor<Vertex, APosition> aaPos(grid, aPosition);
 
+		if(reader.num_points() != grid.num<Vertex>()){
+			UG_LOG("ERROR: data does not match the number of vertices\n");
+			return;
+		}
+
 		unsigned j = 0;
 		for(VertexIterator iter = grid.begin<Vertex>();
 					iter != grid.end<Vertex>(); ++iter){
@@ -163,7 +140,7 @@ public:
 
 		dlg->addSpinBox("reference grid: ", 0, 10, 0, 1, 0);
 		dlg->addSpinBox("scale: ", 0.1, 10000.0, 1.0, 0.1, 1);
-		dlg->addFileBrowser("data", FWT_OPEN, "*.txt");
+		dlg->addFileBrowser("data", FWT_OPEN, "*.emts *.txt");
 
 		return dlg;
 	}
@@ -26,9 +26,12 @@
  */
 
 #include <vector>
+#include <chrono>
+#include <fstream>
 #include "app.h"
 #include "standard_tools.h"
 #include "tooltips.h"
+#include "util/playback_engine.h"
 
 using namespace std;
 using namespace ug;
@@ -90,6 +93,184 @@ class ToolPrintSelectionInfo : public ITool
 };
 
 
+///	loads the selected files repeatedly and logs the load times.
+/**	The objects are not added to a scene, so that only parsing and grid
+ * creation are measured. Run it on examples/pinvit_iterations to detect
+ * regressions in the loading path.*/
+class ToolBenchmarkLoading : public ITool
+{
+	public:
+		void execute(LGObject*, QWidget* widget){
+			ToolWidget* dlg = dynamic_cast<ToolWidget*>(widget);
+			QStringList files = dlg->to_string_list(0);
+			int numRuns = max(1, dlg->to_int(1));
+
+			if(files.empty()){
+				UG_LOG("ERROR: no files selected\n");
+				return;
+			}
+
+			typedef std::chrono::steady_clock clock;
+			double totalMs = 0;
+			double totalMB = 0;
+
+			UG_LOG("Load Benchmark (" << numRuns << " runs per file):\n");
+			for(int i = 0; i < files.size(); ++i){
+				std::string filename = files[i].toStdString();
+
+				std::ifstream in(filename.c_str(), std::ios::binary | std::ios::ate);
+				const double sizeMB = in ? (double)in.tellg() / (1024. * 1024.) : 0;
+
+				double minMs = -1, sumMs = 0;
+				size_t numVrts = 0, numVols = 0;
+				bool ok = true;
+				for(int run = 0; run < numRuns && ok; ++run){
+					LGObject* pObj = CreateEmptyLGObject("benchmark");
+					clock::time_point start = clock::now();
+					ok = LoadLGObjectFromFile(pObj, filename.c_str(), false, 1, 0);
+					const double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+					numVrts = pObj->grid().num_vertices();
+					numVols = pObj->grid().num_volumes();
+					delete pObj;
+
+					sumMs += ms;
+					if(minMs < 0 || ms < minMs)
+						minMs = ms;
+				}
+
+				if(!ok){
+					UG_LOG("  " << filename << ": loading failed\n");
+					continue;
+				}
+
+				const double meanMs = sumMs / numRuns;
+				UG_LOG("  " << filename << ": min " << minMs << " ms, mean " << meanMs << " ms, "
+					   << sizeMB / (meanMs / 1000.) << " MB/s (" << numVrts << " vertices, "
+					   << numVols << " volumes)\n");
+				totalMs += meanMs;
+				totalMB += sizeMB;
+			}
+
+			UG_LOG("  total: " << totalMs << " ms for " << totalMB << " MB\n");
+			UG_LOG(endl);
+		}
+
+		const char* get_name()		{return "Benchmark Loading";}
+		const char* get_tooltip()	{return "Loads the selected files repeatedly and prints the load times.";}
+		const char* get_group()		{return "Info";}
+
+		bool accepts_null_object_ptr()	{return true;}
+
+		ToolWidget* get_dialog(QWidget* parent){
+			ToolWidget *dlg = new ToolWidget(get_name(), parent, this,
+									IDB_APPLY | IDB_OK | IDB_CLOSE);
+
+			dlg->addFileBrowser("files", FWT_OPEN_SEVERAL, "*.vtu *.ugx *.ugxc");
+			dlg->addSpinBox("runs per file: ", 1, 1000, 5, 1, 0);
+
+			return dlg;
+		}
+};
+
+
+///	prints the estimated memory of the active object and of all scenes
+class ToolPrintMemoryInfo : public ITool
+{
+	public:
+		void execute(LGObject* obj, QWidget*){
+			LGScene* scene = app::getActiveScene();
+			UG_LOG("Memory Info (estimated):\n");
+			if(obj){
+				UG_LOG("active object '" << obj->name() << "':\n"
+					   << scene->memory_footprint(obj).to_string() << endl);
+			}
+
+			LGMemoryFootprint total = scene->memory_footprint();
+			UG_LOG("main scene (" << scene->num_objects() << " objects):\n"
+				   << total.to_string() << endl);
+
+			for(unsigned i = 0; i < app::numScenes(); ++i){
+				LGScene* s = app::getScene(i);
+				if(s == scene || s->num_objects() == 0)
+					continue;
+				LGMemoryFootprint m = s->memory_footprint();
+				UG_LOG("scene " << i << " (" << s->num_objects() << " objects): "
+					   << m.total() / (1024. * 1024.) << " MB\n");
+				total += m;
+			}
+			UG_LOG("all scenes:\n" << total.to_string() << endl);
+			UG_LOG(endl);
+		}
+
+		const char* get_name()		{return "Print Memory Info";}
+		const char* get_tooltip()	{return "Prints the estimated memory of the active object and of all scenes.";}
+		const char* get_group()		{return "Info";}
+
+		bool accepts_null_object_ptr()	{return true;}
+};
+
+///	drops edges and element associations which are not required for rendering
+class ToolCompactObjects : public ITool
+{
+	public:
+		void execute(LGObject* obj, QWidget* widget){
+			ToolWidget* dlg = dynamic_cast<ToolWidget*>(widget);
+			bool allObjects = dlg->to_bool(0);
+
+			std::vector<LGScene*> scenes;
+			scenes.push_back(app::getActiveScene());
+			if(allObjects){
+				for(unsigned i = 0; i < app::numScenes(); ++i){
+					if(app::getScene(i) != scenes.front())
+						scenes.push_back(app::getScene(i));
+				}
+			}
+
+			size_t before = 0, after = 0;
+			int numCompacted = 0, numSkipped = 0;
+			for(size_t is = 0; is < scenes.size(); ++is){
+				LGScene* scene = scenes[is];
+				for(int i = 0; i < scene->num_objects(); ++i){
+					LGObject* o = scene->get_object(i);
+					if(!allObjects && o != obj)
+						continue;
+
+					before += scene->memory_footprint(o).total();
+				//	time series playback writes to the vertices of its object
+					if(!app::getPlaybackEngine()->has_subject(o) && o->compact())
+						++numCompacted;
+					else
+						++numSkipped;
+					after += scene->memory_footprint(o).total();
+				}
+			}
+
+			UG_LOG("compacted " << numCompacted << " objects: "
+				   << before / (1024. * 1024.) << " MB -> " << after / (1024. * 1024.) << " MB\n");
+			if(numSkipped > 0){
+				UG_LOG("  skipped " << numSkipped << " objects with constrained elements, "
+					   "octahedrons, an active animation or time series playback\n");
+			}
+		}
+
+		const char* get_name()		{return "Compact Objects";}
+		const char* get_tooltip()	{return "Drops edges and element associations which are not required to render the objects.";}
+		const char* get_group()		{return "Info";}
+
+		bool accepts_null_object_ptr()	{return true;}
+
+		ToolWidget* get_dialog(QWidget* parent){
+			ToolWidget *dlg = new ToolWidget(get_name(), parent, this,
+									IDB_APPLY | IDB_OK | IDB_CLOSE);
+
+			dlg->addCheckBox("all objects of all scenes", true);
+
+			return dlg;
+		}
+};
+
+
 template <class TGeomObj>
 static bool SubsetContainsSelected(SubsetHandler& sh, Selector& sel, int si)
 {
@@ -110,5 +291,8 @@ void RegisterInfoTools(ToolManager* toolMgr)
 {
 	toolMgr->register_tool(new ToolPrintGeometryInfo, Qt::Key_I);
 	toolMgr->register_tool(new ToolPrintSelectionInfo);
+	toolMgr->register_tool(new ToolBenchmarkLoading);
+	toolMgr->register_tool(new ToolPrintMemoryInfo);
+	toolMgr->register_tool(new ToolCompactObjects);
 }
 
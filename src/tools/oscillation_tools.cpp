@@ -36,10 +36,40 @@
 #include "app.h"
 #include "standard_tools.h"
 #include "tooltips.h"
+#include "oscillation/vertex_correspondence.h"
 
 using namespace std;
 using namespace ug;
 
+///	finds the reference vertex of each vertex of mode, see FindModeVertexCorrespondence
+/**	Returns false if no correspondence was found.*/
+static bool MatchToReference(std::vector<size_t>& refIndsOut, LGObject* mode, LGObject* ref)
+{
+	const bool found = FindModeVertexCorrespondence(refIndsOut, mode->grid(), mode->m_fileName,
+													ref->grid(), ref->m_fileName);
+	if(!found){
+		UG_LOG("ERROR: the vertices of " << mode->name()
+			   << " could not be matched to the reference grid.\n");
+	}
+	return found;
+}
+
+///	true if inds maps each of numVrts vertices to one of numTargetVrts vertices
+/**	An empty list maps each vertex to the vertex with the same index.*/
+static bool CorrespondenceIsComplete(const std::vector<size_t>& inds,
+									 size_t numVrts, size_t numTargetVrts)
+{
+	if(inds.empty())
+		return numVrts == numTargetVrts;
+	if(inds.size() != numVrts)
+		return false;
+	for(size_t i = 0; i < inds.size(); ++i){
+		if(inds[i] >= numTargetVrts)
+			return false;
+	}
+	return true;
+}
+
 class ToolOscillation : public ITool
 {
 public:
@@ -140,14 +170,22 @@ public:
 			return;
 		}
 
-		for(unsigned i = 0; i < (unsigned)scene->num_objects(); ++i){
-			LGObject* o = scene->get_object(i);
-			o->set_visibility(false);
-
-		}
-
 		LGObject* ref = scene->get_object(ref_idx);
 		Grid& refgrid = ref->grid();
+		std::vector<Vertex*> ref_vrts(refgrid.begin<Vertex>(), refgrid.end<Vertex>());
+
+		//the first displacement grid is animated. The files may list their
+		//vertices in different orders, so displacements are stored in its order.
+		LGObject* work = scene->get_object(dis_idx_min);
+		const size_t num_work_vrts = work->grid().num_vertices();
+		std::vector<size_t> work_ref_inds;
+		if(!MatchToReference(work_ref_inds, work, ref)
+		   || !CorrespondenceIsComplete(work_ref_inds, num_work_vrts, ref_vrts.size()))
+		{
+			UG_LOG("ERROR: oscillation aborted, " << work->name()
+				   << " does not fit to the reference grid.\n");
+			return;
+		}
 
 		double max_freq;
 
@@ -158,8 +196,6 @@ public:
 		//compute displacement
 		for(unsigned dis_idx = dis_idx_min; dis_idx <= dis_idx_max; ++dis_idx){
 			LGObject* dis = scene->get_object(dis_idx);
-			dis->set_visibility(false);
-
 			Grid& disgrid = dis->grid();
 
 			initial_displacements.push_back(std::vector<ug::vector3>());
@@ -171,14 +207,30 @@ public:
 			Grid::AttachmentAccessor<Vertex, AVertex> aaVrtDIS(disgrid, aVrt, true);
 			Grid::AttachmentAccessor<Vertex, APosition> aaPosDIS(disgrid, aPosition);
 
-
-			VertexIterator iterDIS = disgrid.begin<Vertex>();
-			VertexIterator iterREF = refgrid.begin<Vertex>();
+			std::vector<Vertex*> dis_vrts(disgrid.begin<Vertex>(), disgrid.end<Vertex>());
+			std::vector<size_t> dis_ref_inds, ref_dis_inds;
+			if(!MatchToReference(dis_ref_inds, dis, ref)
+			   || !CorrespondenceIsComplete(dis_ref_inds, dis_vrts.size(), ref_vrts.size()))
+			{
+				UG_LOG("ERROR: oscillation aborted, " << dis->name()
+					   << " does not fit to the reference grid.\n");
+				return;
+			}
+			InvertVertexCorrespondence(ref_dis_inds, dis_ref_inds);
+			if(!CorrespondenceIsComplete(ref_dis_inds, ref_vrts.size(), dis_vrts.size())){
+				UG_LOG("ERROR: oscillation aborted, not every vertex of the reference grid"
+					   " corresponds to a vertex of " << dis->name() << ".\n");
+				return;
+			}
 
 			ug::vector3 point_dis;
 
-			for(; iterDIS != disgrid.end<Vertex>();){
-				VecSubtract(point_dis, aaPosDIS[*iterDIS], aaPosREF[*iterREF]);
+			for(size_t i = 0; i < num_work_vrts; ++i){
+				//i-th vertex of the animated grid -> reference vertex -> vertex of this grid
+				const size_t iREF = CorrespondingVertexIndex(work_ref_inds, i);
+				const size_t iDIS = CorrespondingVertexIndex(ref_dis_inds, iREF);
+
+				VecSubtract(point_dis, aaPosDIS[dis_vrts[iDIS]], aaPosREF[ref_vrts[iREF]]);
 				
 				if(adj_amplitude){
 					point_dis[0] *= phases[dis_idx-dis_idx_min];
@@ -190,81 +242,21 @@ public:
 				point_dis[2] *= scale;
 
 				initial_displacements[dis_idx-dis_idx_min].push_back(point_dis);
-				++iterREF;
-				++iterDIS;
 			}
 		}
 
-		//create new grid which is a copy of disgrid
-		AVertex aVrt;
-
-		LGObject* dis = scene->get_object(dis_idx_min);
-		Grid& disgrid = dis->grid();
-
-		Grid::AttachmentAccessor<Vertex, APosition> aaPosREF(refgrid, aPosition);
-
-		Grid::AttachmentAccessor<Vertex, AVertex> aaVrtDIS(disgrid, aVrt, true);
-		Grid::AttachmentAccessor<Vertex, APosition> aaPosDIS(disgrid, aPosition);
-
-		LGObject* work = app::createEmptyObject("oscillation", SOT_LG, 1, 0);
-		Grid& workgrid = work->grid();
-		SubsetHandler& workSH = work->subset_handler();
-
-
-		Grid::AttachmentAccessor<Vertex, APosition> aaPosWORK(workgrid, aPosition);
-
-		int subsetBaseInd = 0;
-
-		//	copy vertices
-		for(VertexIterator iter = disgrid.begin<Vertex>();
-					iter != disgrid.end<Vertex>(); ++iter){
-			Vertex* nvrt = *workgrid.create_by_cloning(*iter);
-			aaPosWORK[nvrt] = aaPosDIS[*iter];
-			aaVrtDIS[*iter] = nvrt;
-			workSH.assign_subset(nvrt, subsetBaseInd);
-		}
-
-		//	copy edges
-		EdgeDescriptor ed;
-		for(EdgeIterator iter = disgrid.begin<Edge>();
-					iter != disgrid.end<Edge>(); ++iter){
-			Edge* eSrc = *iter;
-			ed.set_vertices(aaVrtDIS[eSrc->vertex(0)], aaVrtDIS[eSrc->vertex(1)]);
-			Edge* e = *workgrid.create_by_cloning(eSrc, ed);
-			workSH.assign_subset(e, subsetBaseInd);
-		}
-
-		//	copy faces
-		FaceDescriptor fd;
-		for(FaceIterator iter = disgrid.begin<Face>();
-				iter != disgrid.end<Face>(); ++iter){
-			Face* fSrc = *iter;
-			fd.set_num_vertices((uint)fSrc->num_vertices());
-			for(size_t i = 0; i < fd.num_vertices(); ++i)
-				fd.set_vertex((uint)i, aaVrtDIS[fSrc->vertex(i)]);
-
-			Face* f = *workgrid.create_by_cloning(fSrc, fd);
-			workSH.assign_subset(f, subsetBaseInd);
+		//animate the first displacement grid in place around the reference positions
+		if(!work->begin_position_animation(refgrid, &work_ref_inds)){
+			UG_LOG("ERROR: oscillation aborted\n");
+			return;
 		}
+		std::vector<ug::vector3> offsets(num_work_vrts);
 
-		//	copy volumes
-		VolumeDescriptor vd;
-		for(VolumeIterator iter = disgrid.begin<Volume>();
-				iter != disgrid.end<Volume>(); ++iter){
-			Volume* vSrc = *iter;
-			vd.set_num_vertices((uint)vSrc->num_vertices());
-			for(size_t i = 0; i < vd.num_vertices(); ++i)
-				vd.set_vertex((uint)i, aaVrtDIS[vSrc->vertex(i)]);
-
-			Volume* v = *workgrid.create_by_cloning(vSrc, vd);
-			workSH.assign_subset(v, subsetBaseInd);
+		for(unsigned i = 0; i < (unsigned)scene->num_objects(); ++i){
+			LGObject* o = scene->get_object(i);
+			o->set_visibility(o == work);
 		}
 
-		disgrid.detach_from_vertices(aVrt);
-
-		ref->set_visibility(false);
-		work->set_visibility(true);
-
 		scene->object_changed(work);
 		work->geometry_changed();
 
@@ -286,14 +278,8 @@ public:
 		}
 
 		while(unsigned(arg_sine/3.1415) < num_periods*2){
-			unsigned i = 0;
-			for(VertexIterator iter = workgrid.begin<Vertex>();
-						iter != workgrid.end<Vertex>(); ++iter){
-
-				ug::vector3 tmp;
-				ug::vector3 tmp2;
-
-				VecAdd(aaPosWORK[*iter], aaPosREF[*iter], ug::vector3());
+			for(unsigned i = 0; i < offsets.size(); ++i){
+				offsets[i] = ug::vector3(0, 0, 0);
 
 				for(unsigned j = 0; j < initial_displacements.size(); ++j){
 					ug::vector3 scaled_point_dis;
@@ -306,11 +292,10 @@ public:
 					else{
 						VecScale(scaled_point_dis, initial_displacements[j][i], sin(arg_sine));
 					}
-					VecAdd(aaPosWORK[*iter], scaled_point_dis, aaPosWORK[*iter]);
+					VecAdd(offsets[i], scaled_point_dis, offsets[i]);
 				}
-				++i;
-				
 			}
+			work->set_animated_positions(offsets);
 
 			arg_sine += step_size;
 
@@ -346,8 +331,9 @@ public:
 		}
 
 
+		work->end_position_animation();
+		work->set_visibility(false);
 		scene->object_changed(work);
-		work->geometry_changed();
 
 		QCoreApplication::processEvents();
 
@@ -357,9 +343,6 @@ public:
 				scene->remove_object(0);
 			}
 		}
-		else{
-			scene->remove_object((int)scene->num_objects()-1);
-		}
 	}
 
 	const char* get_name()		{return "Visualize";}
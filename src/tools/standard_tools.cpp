@@ -45,6 +45,7 @@ void RegisterStandardTools(ToolManager* toolMgr)
 
 //	camera
 	RegisterCameraTools(toolMgr);
+	RegisterFileTools(toolMgr);
 	RegisterInfoTools(toolMgr);
 	RegisterOscillationTools(toolMgr);
 	RegisterWaveTools(toolMgr);
@@ -34,6 +34,7 @@ void RegisterStandardTools(ToolManager* toolMgr);
 
 void RegisterCameraTools(ToolManager* toolMgr);
 
+void RegisterFileTools(ToolManager* toolMgr);
 void RegisterInfoTools(ToolManager* toolMgr);
 void RegisterOscillationTools(ToolManager* toolMgr);
 void RegisterWaveTools(ToolManager* toolMgr);
@@ -26,6 +26,8 @@
  * GNU Lesser General Public License for more details.
  */
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include <QCoreApplication>
 #include <QGuiApplication>
@@ -36,6 +38,8 @@
 #include "app.h"
 #include "standard_tools.h"
 #include "tooltips.h"
+#include "util/colormap.h"
+#include "util/playback_engine.h"
 
 using namespace std;
 using namespace ug;
@@ -45,18 +49,104 @@ typedef std::vector<std::vector<double> > dom2d;
 typedef std::vector<std::vector<std::vector<double> > > dom3d;
 typedef std::vector<std::vector<std::vector<std::vector<double> > > > dom4d;
 
-inline unsigned myatoi(std::string line, unsigned& v, char end=0){
-	unsigned idx = 0;
-	v = line[idx]-'0';
-	++idx;
-	while(line[idx]!=end && idx < line.size()){
-		v *= 10;
-		v += line[idx]-'0';
-		++idx;
+///	Writes the values of a 1d/2d wave simulation to the height of the vertices.
+/**	The vertices are collected again whenever the topology of the object
+ * changed, e.g. since it was reloaded or compacted.*/
+class WaveHeightTarget : public IPlaybackTarget
+{
+public:
+	WaveHeightTarget(LGScene* scene, LGObject* obj, unsigned dim, double scale) :
+		m_scene(scene), m_obj(obj), m_scale(scale)
+	{
+		m_coord = (dim == 1) ? 1 : 2;
+		collect_vertices();
+	}
+
+	bool apply_frame(const std::vector<float>& values, double){
+		if(m_obj->topology_stamp() != m_topologyStamp)
+			collect_vertices();
+		if(m_vrts.size() != values.size())
+			return false;
+
+		for(size_t j = 0; j < m_vrts.size(); ++j)
+			m_aaPos[m_vrts[j]][m_coord] = m_scale * values[j];
+
+		m_scene->object_changed(m_obj);
+		m_obj->geometry_changed();
+		return true;
+	}
+
+	const QObject* subject() const	{return m_obj;}
+
+private:
+	void collect_vertices(){
+		Grid& grid = m_obj->grid();
+		m_topologyStamp = m_obj->topology_stamp();
+		m_aaPos.access(grid, aPosition);
+		m_vrts.clear();
+		m_vrts.reserve(grid.num<Vertex>());
+		for(VertexIterator iter = grid.begin<Vertex>();
+					iter != grid.end<Vertex>(); ++iter){
+			m_vrts.push_back(*iter);
+		}
+	}
+
+	LGScene*	m_scene;
+	LGObject*	m_obj;
+	double		m_scale;
+	int			m_coord;
+	unsigned int	m_topologyStamp;
+	Grid::VertexAttachmentAccessor<APosition> m_aaPos;
+	std::vector<Vertex*>	m_vrts;
+};
+
+///	Passes the values of a 3d wave simulation as vertex scalars to the object.
+class WaveScalarTarget : public IPlaybackTarget
+{
+public:
+	WaveScalarTarget(LGScene* scene, LGObject* obj) :
+		m_scene(scene), m_obj(obj)
+	{}
+
+	bool apply_frame(const std::vector<float>& values, double){
+		if(values.size() != m_obj->grid().num<Vertex>())
+			return false;
+		m_obj->set_vertex_scalars(&values.front(), values.size());
+		m_scene->color_changed(m_obj);
+		return true;
+	}
+
+	const QObject* subject() const	{return m_obj;}
+
+private:
+	LGScene*	m_scene;
+	LGObject*	m_obj;
+};
+
+///	opens the time step data in the playback engine and checks its layout
+static bool OpenWavePlayback(PlaybackEngine* playback, const std::string& file,
+							 LGObject* obj)
+{
+	if(file.size() == 0){
+		UG_LOG("ERROR: no time step data file specified\n");
+		return false;
 	}
-	return idx;
+
+	std::string error;
+	if(!playback->open(file, app::UserTmpDir().path().toStdString(), &error)){
+		UG_LOG("ERROR: could not load time step data: " << error << "\n");
+		return false;
+	}
+
+	if(playback->step_size() != obj->grid().num<Vertex>()){
+		UG_LOG("ERROR: time step data does not match the number of vertices\n");
+		playback->close();
+		return false;
+	}
+	return true;
 }
 
+
 class ToolWave : public ITool
 {
 public:
@@ -65,90 +155,28 @@ public:
 
 		unsigned ref_idx = static_cast<unsigned>(dlg->to_int(0));
 		double scale = static_cast<double>(dlg->to_double(1));
-		unsigned speed = static_cast<unsigned>(dlg->to_int(2));
+		double steps_per_second = static_cast<double>(dlg->to_double(2));
 		QString Qtimestep_file = static_cast<QString>(dlg->to_string(3));
 		std::string timestep_file = Qtimestep_file.toStdString();
 
-		if(timestep_file.size() == 0){
-			UG_LOG("ERROR: no time step data file specified\n");
-			return;
-		}
+		LGScene* scene = app::getActiveScene();
+		obj = scene->get_object(ref_idx);
 
-		//load time step data
-		std::ifstream fin(timestep_file);
-		if(!fin){
-			UG_LOG("ERROR: could not open time step data file " << timestep_file << "\n");
+		PlaybackEngine* playback = app::getPlaybackEngine();
+		if(!OpenWavePlayback(playback, timestep_file, obj)){
+			return;
 		}
-		std::string line;
-		getline(fin,line);
-
-		unsigned pos = line.find(" ");
-		std::string s_dim = line.substr(0, pos);
-		line = line.substr(pos+1, line.size()-1);
-		pos = line.find(" ");
-		std::string s_num_time = line.substr(0, pos);
-		line = line.substr(pos+1, line.size()-1);
-		pos = line.find("\n");
-		std::string s_num_space = line.substr(0, pos);
-
-		unsigned dim;
-		unsigned num_time;
-		unsigned num_space;
-
-		myatoi(s_dim, dim);
-		myatoi(s_num_time, num_time);
-		myatoi(s_num_space, num_space);
 
+		unsigned dim = playback->dim();
 		if(!(dim == 1 || dim == 2)){
 			UG_LOG("ERROR: dim must be 1 or 2\n");
+			playback->close();
 			return;
 		}
 
-		std::vector<double> timestep_data(num_time*num_space);
-
-		std::string token;
-		unsigned k = 0;
-		for(unsigned i = 0; i < num_time; ++i){
-			getline(fin,line);
-			for(unsigned j = 0; j < num_space; ++j){
-				pos = line.find(" ");
-				token = line.substr(0, pos);
-				line = line.substr(pos+1, line.size()-1);
-				std::cout.precision(token.size());
-				timestep_data[k] = std::stod(token);
-				++k;
-			}
-		}
-
-		LGScene* scene = app::getActiveScene();
-		obj = scene->get_object(ref_idx);
-		Grid& grid = obj->grid();
-
-		Grid::AttachmentAccessor<Vertex, APosition> aaPos(grid, aPosition);
-
-		for(unsigned i = 0; i < num_time; ++i){
-			for(unsigned k = 0; k < speed; ++k){
-				unsigned j = 0;
-				for(VertexIterator iter = grid.begin<Vertex>();
-							iter != grid.end<Vertex>(); ++iter){
-
-					switch(dim){
-						case 1:
-							aaPos[*iter][1] = scale*timestep_data[i*num_space+j];
-							break;
-						case 2: //TODO
-							aaPos[*iter][2] = scale*timestep_data[i*num_space+j];
-							break;
-					}
-					++j;
-				}
-
-				scene->object_changed(obj);		
-				obj->geometry_changed();
-
-				QCoreApplication::processEvents();
-			}
-		}
+		playback->set_steps_per_second(steps_per_second);
+		playback->set_target(new WaveHeightTarget(scene, obj, dim, scale));
+		playback->play();
 	}
 
 	const char* get_name()		{return "Visualize";}
@@ -161,8 +189,8 @@ public:
 
 		dlg->addSpinBox("reference grid: ", 0, 10, 0, 1, 0);
 		dlg->addSpinBox("scale: ", 0.1, 10000.0, 1.0, 0.1, 1);
-		dlg->addSpinBox("speed scale: ", 1.0, 10000.0, 1.0, 1.0, 1);
-		dlg->addFileBrowser("timestep data", FWT_OPEN, "*.txt");
+		dlg->addSpinBox("steps per second: ", 0.1, 10000.0, 25.0, 1.0, 1);
+		dlg->addFileBrowser("timestep data", FWT_OPEN, "*.emts *.txt");
 
 		return dlg;
 	}
@@ -177,129 +205,99 @@ public:
 
 		unsigned ref_idx = static_cast<unsigned>(dlg->to_int(0));
 		double scale = static_cast<double>(dlg->to_double(1));
-		unsigned speed = static_cast<unsigned>(dlg->to_int(2));
+		double steps_per_second = static_cast<double>(dlg->to_double(2));
 		QString Qtimestep_file = static_cast<QString>(dlg->to_string(3));
 		std::string timestep_file = Qtimestep_file.toStdString();
 
-		if(timestep_file.size() == 0){
-			UG_LOG("ERROR: no time step data file specified\n");
+		int colormap = dlg->to_int(4);
+		double fixed_range = static_cast<double>(dlg->to_double(5));
+
+		LGScene* scene = app::getActiveScene();
+		obj = scene->get_object(ref_idx);
+
+		PlaybackEngine* playback = app::getPlaybackEngine();
+		if(!OpenWavePlayback(playback, timestep_file, obj)){
 			return;
 		}
 
-		//load time step data
-		std::ifstream fin(timestep_file);
-		if(!fin){
-			UG_LOG("ERROR: could not open time step data file " << timestep_file << "\n");
-		}
-		std::string line;
-		getline(fin,line);
-
-		unsigned pos = line.find(" ");
-		std::string s_dim = line.substr(0, pos);
-		line = line.substr(pos+1, line.size()-1);
-		pos = line.find(" ");
-		std::string s_num_time = line.substr(0, pos);
-		line = line.substr(pos+1, line.size()-1);
-		pos = line.find("\n");
-		std::string s_num_space = line.substr(0, pos);
-
-		unsigned dim;
-		unsigned num_time;
-		unsigned num_space;
-
-		myatoi(s_dim, dim);
-		myatoi(s_num_time, num_time);
-		myatoi(s_num_space, num_space);
-
-		if(dim != 3){
+		if(playback->dim() != 3){
 			UG_LOG("ERROR: dim must be 3\n");
+			playback->close();
 			return;
 		}
 
-		std::vector<double> timestep_data(num_time*num_space);
-
-		std::string token;
-		unsigned k = 0;
-		for(unsigned i = 0; i < num_time; ++i){
-			getline(fin,line);
-			for(unsigned j = 0; j < num_space; ++j){
-				pos = line.find(" ");
-				token = line.substr(0, pos);
-				line = line.substr(pos+1, line.size()-1);
-				std::cout.precision(token.size());
-				timestep_data[k] = std::stod(token);
-				++k;
-			}
-		}
+	//	the range table avoids a pass over all time steps
+		float min, max;
+		playback->global_range(min, max);
+		float range = static_cast<float>(fixed_range);
+		if(range <= 0)
+			range = std::max(std::abs(min), std::abs(max)) / scale;
+		if(range <= 0)
+			range = 1.0f;
+
+		obj->set_scalar_range(-range, range);
+		obj->set_colormap(colormap);
+
+		playback->set_steps_per_second(steps_per_second);
+		playback->set_target(new WaveScalarTarget(scene, obj));
+		playback->play();
+	}
 
-		LGScene* scene = app::getActiveScene();
-		obj = scene->get_object(ref_idx);
-		Grid& grid = obj->grid();
+	const char* get_name()		{return "Visualize 3D";}
+	const char* get_tooltip()	{return "";}
+	const char* get_group()		{return "Wave";}
 
-		Grid::AttachmentAccessor<Vertex, APosition> aaPos(grid, aPosition);
+	ToolWidget* get_dialog(QWidget* parent){
+		ToolWidget *dlg = new ToolWidget(get_name(), parent, this,
+								IDB_APPLY | IDB_OK | IDB_CLOSE);
 
-		SubsetHandler& sh = obj->subset_handler();
+		dlg->addSpinBox("reference grid: ", 0, 10, 0, 1, 0);
+		dlg->addSpinBox("scale: ", 0.1, 10000.0, 1.0, 0.1, 1);
+		dlg->addSpinBox("steps per second: ", 0.1, 10000.0, 25.0, 1.0, 1);
+		dlg->addFileBrowser("timestep data", FWT_OPEN, "*.emts *.txt");
 
-		//create one subset per vertex
-		unsigned j = 0;
-		for(VertexIterator iter = grid.begin<Vertex>();
-					iter != grid.end<Vertex>(); ++iter){
-			sh.assign_subset(*iter, j);
-			++j;
-		}
+		QStringList colormaps;
+		for(int i = 0; i < NUM_COLORMAPS; ++i)
+			colormaps.push_back(ColormapName(i));
+		dlg->addComboBox("colormap: ", colormaps, CM_COOL_WARM);
+		dlg->addSpinBox("range (0: automatic): ", 0.0, 1.e+10, 0.0, 0.1, 3);
+
+		return dlg;
+	}
+};
+
+class ToolConvertTimeSeries : public ITool
+{
+public:
+	void execute(LGObject* obj, QWidget* widget){
+		ToolWidget* dlg = dynamic_cast<ToolWidget*>(widget);
 
-		double min = +1.0f;
-		double max = -1.0f;
+		std::string txt_file = dlg->to_string(0).toStdString();
+		std::string bin_file = dlg->to_string(1).toStdString();
 
-		for(unsigned l = 0; l < timestep_data.size(); ++l){
-			if(timestep_data[l] < min){
-				min = timestep_data[l];
-			}
-			if(timestep_data[l] > max){
-				max = timestep_data[l];
-			}
+		if(txt_file.size() == 0 || bin_file.size() == 0){
+			UG_LOG("ERROR: input and output file have to be specified\n");
+			return;
 		}
-			
-		for(unsigned i = 0; i < num_time; ++i){
-			for(unsigned k = 0; k < speed; ++k){
-				unsigned j = 0;
-				for(VertexIterator iter = grid.begin<Vertex>();
-							iter != grid.end<Vertex>(); ++iter){
-					if(abs(scale*timestep_data[i*num_space+j]/max*255) < 0.1){
-						obj->set_subset_color(j, app::getMainWindow()->getView3D()->get_background_color());
-					}
-					else if(timestep_data[i*num_space+j] > 0){
-						QColor c(scale*timestep_data[i*num_space+j]/max*255, 0, 0);
-						obj->set_subset_color(j, c);
-					}
-					else{
-						QColor c(0, 0, -scale*timestep_data[i*num_space+j]/max*255);
-						obj->set_subset_color(j, c);
-					}
-					++j;
-				}
-
-				scene->color_changed(obj);
-				scene->object_changed(obj);		
-				obj->geometry_changed();
-
-				QCoreApplication::processEvents();
-			}
+
+		std::string error;
+		if(!ConvertTextTimeSeries(txt_file.c_str(), bin_file.c_str(), &error)){
+			UG_LOG("ERROR: conversion failed: " << error << "\n");
+			return;
 		}
+		UG_LOG("time step data written to " << bin_file << "\n");
 	}
 
-	const char* get_name()		{return "Visualize 3D";}
-	const char* get_tooltip()	{return "";}
+	const char* get_name()		{return "Convert Time Step Data";}
+	const char* get_tooltip()	{return "Converts text time step data to the binary *.emts format.";}
 	const char* get_group()		{return "Wave";}
 
 	ToolWidget* get_dialog(QWidget* parent){
 		ToolWidget *dlg = new ToolWidget(get_name(), parent, this,
 								IDB_APPLY | IDB_OK | IDB_CLOSE);
 
-		dlg->addSpinBox("reference grid: ", 0, 10, 0, 1, 0);
-		dlg->addSpinBox("scale: ", 0.1, 10000.0, 1.0, 0.1, 1);
-		dlg->addSpinBox("speed scale: ", 1.0, 10000.0, 1.0, 1.0, 1);
-		dlg->addFileBrowser("timestep data", FWT_OPEN, "*.txt");
+		dlg->addFileBrowser("text data", FWT_OPEN, "*.txt");
+		dlg->addFileBrowser("binary data", FWT_SAVE, "*.emts");
 
 		return dlg;
 	}
@@ -309,5 +307,6 @@ void RegisterWaveTools(ToolManager* toolMgr)
 {
 	toolMgr->register_tool(new ToolWave);
 	toolMgr->register_tool(new ToolWave3D);
+	toolMgr->register_tool(new ToolConvertTimeSeries);
 }
 
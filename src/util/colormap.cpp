@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <algorithm>
+#include "colormap.h"
+
+namespace{
+struct ColorKey{
+	float t, r, g, b;
+};
+
+const ColorKey COOL_WARM[] = {
+	{0.f,	0.230f, 0.299f, 0.754f},
+	{0.25f,	0.552f, 0.690f, 0.996f},
+	{0.5f,	0.865f, 0.865f, 0.865f},
+	{0.75f,	0.958f, 0.604f, 0.482f},
+	{1.f,	0.706f, 0.016f, 0.150f}
+};
+
+const ColorKey VIRIDIS[] = {
+	{0.f,	0.267f, 0.005f, 0.329f},
+	{0.25f,	0.229f, 0.322f, 0.546f},
+	{0.5f,	0.128f, 0.567f, 0.551f},
+	{0.75f,	0.369f, 0.789f, 0.383f},
+	{1.f,	0.993f, 0.906f, 0.144f}
+};
+
+const ColorKey JET[] = {
+	{0.f,	0.f, 0.f, 0.5f},
+	{0.125f,0.f, 0.f, 1.f},
+	{0.375f,0.f, 1.f, 1.f},
+	{0.625f,1.f, 1.f, 0.f},
+	{0.875f,1.f, 0.f, 0.f},
+	{1.f,	0.5f, 0.f, 0.f}
+};
+
+const ColorKey GRAYSCALE[] = {
+	{0.f,	0.f, 0.f, 0.f},
+	{1.f,	1.f, 1.f, 1.f}
+};
+
+template <size_t N>
+void Interpolate(const ColorKey (&keys)[N], float t, float rgbOut[3])
+{
+	size_t i = 1;
+	while(i + 1 < N && keys[i].t < t)
+		++i;
+
+	const ColorKey& k0 = keys[i - 1];
+	const ColorKey& k1 = keys[i];
+	const float s = (t - k0.t) / (k1.t - k0.t);
+	rgbOut[0] = k0.r + s * (k1.r - k0.r);
+	rgbOut[1] = k0.g + s * (k1.g - k0.g);
+	rgbOut[2] = k0.b + s * (k1.b - k0.b);
+}
+}//	end of anonymous namespace
+
+
+const char* ColormapName(int colormap)
+{
+	switch(colormap){
+		case CM_COOL_WARM:	return "cool-warm";
+		case CM_VIRIDIS:	return "viridis";
+		case CM_JET:		return "jet";
+		case CM_GRAYSCALE:	return "grayscale";
+		default:			return "";
+	}
+}
+
+void SampleColormap(int colormap, float t, float rgbOut[3])
+{
+	t = std::min(std::max(t, 0.f), 1.f);
+	switch(colormap){
+		case CM_VIRIDIS:	Interpolate(VIRIDIS, t, rgbOut); break;
+		case CM_JET:		Interpolate(JET, t, rgbOut); break;
+		case CM_GRAYSCALE:	Interpolate(GRAYSCALE, t, rgbOut); break;
+		default:			Interpolate(COOL_WARM, t, rgbOut); break;
+	}
+}
+
+void CreateColormapTable(int colormap, float* rgbOut, size_t numEntries)
+{
+	for(size_t i = 0; i < numEntries; ++i){
+		const float t = (numEntries > 1) ? (float)i / (float)(numEntries - 1) : 0.f;
+		SampleColormap(colormap, t, rgbOut + 3 * i);
+	}
+}
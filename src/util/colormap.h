@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef __H__EMVIS_colormap__
+#define __H__EMVIS_colormap__
+
+#include <cstddef>
+
+///	colormaps which can be used to visualize scalar values
+enum Colormap
+{
+	CM_COOL_WARM,
+	CM_VIRIDIS,
+	CM_JET,
+	CM_GRAYSCALE,
+	NUM_COLORMAPS
+};
+
+///	returns a human readable name of the given colormap
+const char* ColormapName(int colormap);
+
+///	evaluates the colormap at t in [0, 1]. Values outside are clamped.
+void SampleColormap(int colormap, float t, float rgbOut[3]);
+
+///	fills numEntries rgb triples (3 * numEntries floats) with the colormap.
+void CreateColormapTable(int colormap, float* rgbOut, size_t numEntries);
+
+#endif
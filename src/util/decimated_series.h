@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef __H__EMVIS_decimated_series__
+#define __H__EMVIS_decimated_series__
+
+#include <vector>
+#include <cstddef>
+
+///	An append-only sample series with a bounded min/max summary.
+/**	All samples are kept, but for drawing the series is summarized into at
+ * most 'capacity' buckets. Each bucket covers a power-of-two number of
+ * consecutive samples and stores its first, last, minimal and maximal value.
+ * Once all buckets are in use, neighbouring buckets are merged pairwise, so
+ * appending a sample is amortized O(1) and drawing costs O(capacity),
+ * independent of the length of the series.*/
+class DecimatedSeries
+{
+	public:
+		struct Bucket{
+			size_t	first;///< index of the first sample in this bucket
+			size_t	last;///< index of the last sample in this bucket
+			double	firstVal;
+			double	lastVal;
+			double	minVal;
+			double	maxVal;
+		};
+
+		DecimatedSeries(size_t capacity = 512) :
+			m_capacity(capacity < 2 ? 2 : capacity),
+			m_bucketSize(1)
+		{}
+
+		void clear()
+		{
+			m_samples.clear();
+			m_buckets.clear();
+			m_bucketSize = 1;
+		}
+
+		void append(double val)
+		{
+			size_t ind = m_samples.size();
+			m_samples.push_back(val);
+
+			if(m_buckets.empty() || m_buckets.back().last + 1
+									 - m_buckets.back().first >= m_bucketSize)
+			{
+				if(m_buckets.size() == m_capacity)
+					merge_buckets();
+			}
+
+			if(!m_buckets.empty()
+			   && m_buckets.back().last + 1 - m_buckets.back().first < m_bucketSize)
+			{
+				Bucket& b = m_buckets.back();
+				b.last = ind;
+				b.lastVal = val;
+				if(val < b.minVal) b.minVal = val;
+				if(val > b.maxVal) b.maxVal = val;
+			}
+			else{
+				Bucket b;
+				b.first = b.last = ind;
+				b.firstVal = b.lastVal = b.minVal = b.maxVal = val;
+				m_buckets.push_back(b);
+			}
+		}
+
+		size_t size() const								{return m_samples.size();}
+		double sample(size_t i) const					{return m_samples[i];}
+		const std::vector<double>& samples() const		{return m_samples;}
+
+		size_t num_buckets() const						{return m_buckets.size();}
+		const Bucket& bucket(size_t i) const			{return m_buckets[i];}
+
+	///	number of samples summarized in one bucket
+		size_t bucket_size() const						{return m_bucketSize;}
+
+	private:
+		void merge_buckets()
+		{
+			size_t numMerged = 0;
+			for(size_t i = 0; i + 1 < m_buckets.size(); i += 2){
+				Bucket b = m_buckets[i];
+				const Bucket& n = m_buckets[i + 1];
+				b.last = n.last;
+				b.lastVal = n.lastVal;
+				if(n.minVal < b.minVal) b.minVal = n.minVal;
+				if(n.maxVal > b.maxVal) b.maxVal = n.maxVal;
+				m_buckets[numMerged++] = b;
+			}
+			if(m_buckets.size() % 2)
+				m_buckets[numMerged++] = m_buckets.back();
+			m_buckets.resize(numMerged);
+			m_bucketSize *= 2;
+		}
+
+		std::vector<double>	m_samples;
+		std::vector<Bucket>	m_buckets;
+		size_t				m_capacity;
+		size_t				m_bucketSize;
+};
+
+#endif
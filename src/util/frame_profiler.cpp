@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include "frame_profiler.h"
+
+using namespace std;
+
+///	number of frames which are kept in the ring buffer
+static const size_t FRAME_HISTORY = 240;
+
+///	the profiler between begin_frame and end_frame on this thread
+static thread_local FrameProfiler* g_paintingProfiler = NULL;
+
+const char* ProfileStageName(int stage)
+{
+	switch(stage){
+		case PS_LOAD:				return "load";
+		case PS_GEOMETRY_CHANGED:	return "geometry changed";
+		case PS_ANIMATION:			return "animation";
+		case PS_UPDATE_VISUALS:		return "update visuals";
+		case PS_RENDER_FACES:		return "render faces";
+		case PS_RENDER_VOLUMES:		return "render volumes";
+		case PS_RENDER_SCALARS:		return "render scalars";
+		case PS_PREPARE_RENDER_DATA:	return "prepare arrays";
+		case PS_DRAW:				return "draw";
+		default:					return "unknown";
+	}
+}
+
+FrameRecord::
+FrameRecord() :
+	frameMs(0),
+	timestamp(0)
+{
+	fill(stageMs, stageMs + NUM_PROFILE_STAGES, 0.);
+	fill(counters, counters + NUM_PROFILE_COUNTERS, uint64_t(0));
+}
+
+
+FrameProfiler& FrameProfiler::
+instance()
+{
+	static FrameProfiler profiler;
+	return profiler;
+}
+
+FrameProfiler& FrameProfiler::
+current()
+{
+	if(g_paintingProfiler)
+		return *g_paintingProfiler;
+	return instance();
+}
+
+FrameProfiler::
+FrameProfiler() :
+	m_sharedInitialized(false),
+	m_frames(FRAME_HISTORY),
+	m_numFrames(0),
+	m_next(0),
+	m_startTime(now_ns()),
+	m_frameBegin(m_startTime)
+{
+	for(int i = 0; i < NUM_PROFILE_STAGES; ++i){
+		m_stageNs[i] = 0;
+		m_sharedStageNs[i] = 0;
+	}
+	for(int i = 0; i < NUM_PROFILE_COUNTERS; ++i){
+		m_counters[i] = 0;
+		m_sharedCounters[i] = 0;
+	}
+}
+
+void FrameProfiler::
+begin_frame()
+{
+	g_paintingProfiler = this;
+
+	lock_guard<mutex> lock(m_mutex);
+	m_frameBegin = now_ns();
+
+//	background work from before the first frame is not reported
+	FrameProfiler& shared = instance();
+	if(!m_sharedInitialized && this != &shared){
+		for(int i = 0; i < NUM_PROFILE_STAGES; ++i)
+			m_sharedStageNs[i] = shared.m_stageNs[i].load();
+		for(int i = 0; i < NUM_PROFILE_COUNTERS; ++i)
+			m_sharedCounters[i] = shared.m_counters[i].load();
+		m_sharedInitialized = true;
+	}
+}
+
+void FrameProfiler::
+end_frame()
+{
+	const int64_t t = now_ns();
+	if(g_paintingProfiler == this)
+		g_paintingProfiler = NULL;
+
+	FrameRecord rec;
+	for(int i = 0; i < NUM_PROFILE_STAGES; ++i)
+		rec.stageMs[i] = 1.e-6 * (double)m_stageNs[i].exchange(0);
+	for(int i = 0; i < NUM_PROFILE_COUNTERS; ++i)
+		rec.counters[i] = m_counters[i].exchange(0);
+	rec.timestamp = 1.e-9 * (double)(t - m_startTime);
+
+//	add the background work since the previous frame of this profiler
+	FrameProfiler& shared = instance();
+	if(this != &shared){
+		for(int i = 0; i < NUM_PROFILE_STAGES; ++i){
+			const int64_t total = shared.m_stageNs[i].load();
+			rec.stageMs[i] += 1.e-6 * (double)(total - m_sharedStageNs[i]);
+			m_sharedStageNs[i] = total;
+		}
+		for(int i = 0; i < NUM_PROFILE_COUNTERS; ++i){
+			const uint64_t total = shared.m_counters[i].load();
+			rec.counters[i] += total - m_sharedCounters[i];
+			m_sharedCounters[i] = total;
+		}
+	}
+
+	lock_guard<mutex> lock(m_mutex);
+	rec.frameMs = 1.e-6 * (double)(t - m_frameBegin);
+	if(TraceRecorder::active())
+		TraceRecorder::instance().record("frame", m_frameBegin, t);
+	m_frames[m_next] = rec;
+	m_next = (m_next + 1) % m_frames.size();
+	m_numFrames = min(m_numFrames + 1, m_frames.size());
+}
+
+size_t FrameProfiler::
+num_frames() const
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_numFrames;
+}
+
+FrameRecord FrameProfiler::
+frame(size_t i) const
+{
+	lock_guard<mutex> lock(m_mutex);
+	if(i >= m_numFrames)
+		return FrameRecord();
+	const size_t n = m_frames.size();
+	return m_frames[(m_next + n - 1 - i) % n];
+}
+
+void FrameProfiler::
+summary(FrameRecord& avgOut, FrameRecord& maxOut, size_t numFrames) const
+{
+	avgOut = FrameRecord();
+	maxOut = FrameRecord();
+
+	lock_guard<mutex> lock(m_mutex);
+	numFrames = min(numFrames, m_numFrames);
+	if(numFrames == 0)
+		return;
+
+	const size_t n = m_frames.size();
+	for(size_t i = 0; i < numFrames; ++i){
+		const FrameRecord& r = m_frames[(m_next + n - 1 - i) % n];
+		for(int j = 0; j < NUM_PROFILE_STAGES; ++j){
+			avgOut.stageMs[j] += r.stageMs[j];
+			maxOut.stageMs[j] = max(maxOut.stageMs[j], r.stageMs[j]);
+		}
+		for(int j = 0; j < NUM_PROFILE_COUNTERS; ++j){
+			avgOut.counters[j] += r.counters[j];
+			maxOut.counters[j] = max(maxOut.counters[j], r.counters[j]);
+		}
+		avgOut.frameMs += r.frameMs;
+		maxOut.frameMs = max(maxOut.frameMs, r.frameMs);
+	}
+
+	for(int j = 0; j < NUM_PROFILE_STAGES; ++j)
+		avgOut.stageMs[j] /= (double)numFrames;
+	for(int j = 0; j < NUM_PROFILE_COUNTERS; ++j)
+		avgOut.counters[j] /= numFrames;
+	avgOut.frameMs /= (double)numFrames;
+
+	const FrameRecord& last = m_frames[(m_next + n - 1) % n];
+	avgOut.timestamp = maxOut.timestamp = last.timestamp;
+}
+
+double FrameProfiler::
+fps() const
+{
+	lock_guard<mutex> lock(m_mutex);
+	if(m_numFrames == 0)
+		return 0;
+
+	const size_t n = m_frames.size();
+	const double now = 1.e-9 * (double)(now_ns() - m_startTime);
+	size_t num = 0;
+	for(; num < m_numFrames; ++num){
+		if(now - m_frames[(m_next + n - 1 - num) % n].timestamp > 1.)
+			break;
+	}
+	return (double)num;
+}
+
+std::string FrameProfiler::
+overlay_text(size_t numFrames) const
+{
+	FrameRecord avg, mx;
+	summary(avg, mx, numFrames);
+	const FrameRecord last = frame(0);
+
+	stringstream ss;
+	char line[128];
+	snprintf(line, sizeof(line), "%-17s %7s %7s %7s\n", "[ms]", "last", "avg", "max");
+	ss << line;
+	snprintf(line, sizeof(line), "%-17s %7.2f %7.2f %7.2f\n", "frame",
+			 last.frameMs, avg.frameMs, mx.frameMs);
+	ss << line;
+	for(int i = 0; i < NUM_PROFILE_STAGES; ++i){
+		snprintf(line, sizeof(line), "%-17s %7.2f %7.2f %7.2f\n", ProfileStageName(i),
+				 last.stageMs[i], avg.stageMs[i], mx.stageMs[i]);
+		ss << line;
+	}
+	ss << "triangles:      " << last.counters[PC_TRIANGLES_SUBMITTED] << "\n";
+	ss << "display lists:  " << last.counters[PC_DISPLAY_LISTS_REBUILT] << "\n";
+	ss << "invalidations:  " << last.counters[PC_INVALIDATIONS]
+	   << " (" << last.counters[PC_UPDATES_MERGED] << " merged)\n";
+	snprintf(line, sizeof(line), "fps:            %.1f\n", fps());
+	ss << line;
+	return ss.str();
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#ifndef __H__EMVIS_frame_profiler__
+#define __H__EMVIS_frame_profiler__
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "trace_recorder.h"
+
+///	stages of the visualization pipeline which are timed by the FrameProfiler
+/**	Stages may be nested, e.g. PS_RENDER_FACES runs inside PS_UPDATE_VISUALS.
+ * The time of a stage is always inclusive.*/
+enum ProfileStage
+{
+	PS_LOAD,
+	PS_GEOMETRY_CHANGED,
+	PS_ANIMATION,
+	PS_UPDATE_VISUALS,
+	PS_RENDER_FACES,
+	PS_RENDER_VOLUMES,
+	PS_RENDER_SCALARS,
+	PS_PREPARE_RENDER_DATA,	///< runs on the thread of a RenderDataWorker
+	PS_DRAW,
+	NUM_PROFILE_STAGES
+};
+
+///	counters which are summed up per frame
+enum ProfileCounter
+{
+	PC_TRIANGLES_SUBMITTED,
+	PC_DISPLAY_LISTS_REBUILT,
+	PC_INVALIDATIONS,	///< calls to LGScene::invalidate
+	PC_UPDATES_MERGED,	///< invalidations which were merged into a pending update
+	NUM_PROFILE_COUNTERS
+};
+
+///	returns a human readable name of the given stage
+const char* ProfileStageName(int stage);
+
+///	timings and counters of a single frame
+struct FrameRecord
+{
+	FrameRecord();
+
+	double		stageMs[NUM_PROFILE_STAGES];
+	uint64_t	counters[NUM_PROFILE_COUNTERS];
+	double		frameMs;	///< duration of the paint call
+	double		timestamp;	///< end of the frame in seconds since program start
+};
+
+
+///	Always-available, low-overhead timing of the stages of each frame.
+/**	Each view owns a FrameProfiler and wraps its paint calls in begin_frame and
+ * end_frame. Scoped timers (see FRAME_PROFILE_STAGE) add their durations to
+ * the atomic accumulators of current(): inside a paint call on the gui
+ * thread this is the profiler of the painting view, otherwise, e.g. on worker
+ * threads or in event handlers, the shared instance().
+ *
+ * The work which was collected by instance() since the previous frame of a
+ * view is added to the next frame of that view, so in split view every view
+ * reports the background work once, but neither the paint calls nor the
+ * frames of the other views. The records of the most recent frames are kept
+ * in a ring buffer.
+ *
+ * While the TraceRecorder is active, frames and stages are recorded as trace
+ * events, too.*/
+class FrameProfiler
+{
+	public:
+		FrameProfiler();
+
+	///	collects the work which doesn't happen inside a paint call
+		static FrameProfiler& instance();
+
+	///	the profiler whose frame is painted on the calling thread, or instance()
+		static FrameProfiler& current();
+
+	///	nanoseconds of a monotonic clock, the same as used by the TraceRecorder
+		static inline int64_t now_ns()	{return TraceRecorder::now_ns();}
+
+		inline void add_stage_time(ProfileStage stage, int64_t ns)
+		{
+			m_stageNs[stage].fetch_add(ns, std::memory_order_relaxed);
+		}
+
+		inline void add_count(ProfileCounter counter, uint64_t num)
+		{
+			m_counters[counter].fetch_add(num, std::memory_order_relaxed);
+		}
+
+	///	marks the start of a paint call. Makes this the current() profiler.
+		void begin_frame();
+	///	finishes the current frame and stores its record in the ring buffer.
+		void end_frame();
+
+	///	number of frames in the ring buffer
+		size_t num_frames() const;
+	///	returns the i-th most recent frame, i.e. frame(0) is the last one.
+		FrameRecord frame(size_t i) const;
+
+	///	averages (avgOut) and maxima (maxOut) over the numFrames most recent frames
+		void summary(FrameRecord& avgOut, FrameRecord& maxOut, size_t numFrames) const;
+
+	///	frames per second over the frames of the last second
+		double fps() const;
+
+	///	multi-line text with per-stage milliseconds, counters and fps
+		std::string overlay_text(size_t numFrames = 30) const;
+
+	private:
+		FrameProfiler(const FrameProfiler&);
+		FrameProfiler& operator=(const FrameProfiler&);
+
+		std::atomic<int64_t>	m_stageNs[NUM_PROFILE_STAGES];
+		std::atomic<uint64_t>	m_counters[NUM_PROFILE_COUNTERS];
+
+	//	totals of instance() which were already added to a frame of this profiler.
+	//	The accumulators of instance() are never reset.
+		int64_t					m_sharedStageNs[NUM_PROFILE_STAGES];
+		uint64_t				m_sharedCounters[NUM_PROFILE_COUNTERS];
+		bool					m_sharedInitialized;
+
+		mutable std::mutex			m_mutex;
+		std::vector<FrameRecord>	m_frames;	///< ring buffer
+		size_t						m_numFrames;
+		size_t						m_next;
+		int64_t						m_startTime;
+		int64_t						m_frameBegin;
+};
+
+
+///	adds the time between its construction and destruction to a stage
+/**	If a stage is entered again while it is active on the same thread, e.g.
+ * through a recursive load, only the outermost timer counts.*/
+class ScopedStageTimer
+{
+	public:
+		explicit ScopedStageTimer(ProfileStage stage) :
+			m_stage(stage),
+			m_outermost(depth(stage)++ == 0),
+			m_start(m_outermost ? FrameProfiler::now_ns() : 0),
+			m_profiler(FrameProfiler::current())	{}
+
+		~ScopedStageTimer()
+		{
+			--depth(m_stage);
+			if(m_outermost){
+				const int64_t end = FrameProfiler::now_ns();
+				m_profiler.add_stage_time(m_stage, end - m_start);
+				if(TraceRecorder::active()){
+					TraceRecorder::instance().record(ProfileStageName(m_stage),
+													 m_start, end);
+				}
+			}
+		}
+
+	private:
+		static inline int& depth(ProfileStage stage)
+		{
+			static thread_local int d[NUM_PROFILE_STAGES] = {0};
+			return d[stage];
+		}
+
+		ProfileStage	m_stage;
+		bool			m_outermost;
+		int64_t			m_start;
+		FrameProfiler&	m_profiler;
+};
+
+///	times the enclosing scope as the given ProfileStage
+#define FRAME_PROFILE_STAGE(stage)	ScopedStageTimer frameProfileStageTimer(stage)
+
+///	adds num to the given ProfileCounter of the current frame
+#define FRAME_PROFILE_COUNT(counter, num)\
+	FrameProfiler::current().add_count(counter, (uint64_t)(num))
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "parallel_for.h"
+
+using namespace std;
+
+///	true on the threads of the pool and while a thread takes part in a job
+static thread_local bool g_inParallelRanges = false;
+
+///	threads which process the ranges of RunParallelRanges
+class ParallelRangesPool
+{
+	public:
+		static ParallelRangesPool& instance()
+		{
+			static ParallelRangesPool pool;
+			return pool;
+		}
+
+		void run(size_t numRanges, const function<void(size_t)>& func);
+
+	private:
+		ParallelRangesPool();
+		~ParallelRangesPool();
+
+		void worker_loop();
+
+	///	processes ranges of the current job until none is left. Call with locked m_mutex.
+		void process_ranges(unique_lock<mutex>& lock);
+
+		vector<thread>				m_threads;
+		mutex						m_runMutex;///< held while a job runs
+		mutex						m_mutex;
+		condition_variable			m_jobPosted;
+		condition_variable			m_jobDone;
+
+	//	the following members are protected by m_mutex
+		const function<void(size_t)>*	m_func;
+		size_t						m_numRanges;
+		size_t						m_nextRange;
+		size_t						m_numDone;
+		bool						m_stop;
+};
+
+ParallelRangesPool::
+ParallelRangesPool() :
+	m_func(NULL),
+	m_numRanges(0),
+	m_nextRange(0),
+	m_numDone(0),
+	m_stop(false)
+{
+	const unsigned numThreads = thread::hardware_concurrency();
+	for(unsigned i = 1; i < numThreads; ++i)
+		m_threads.push_back(thread(&ParallelRangesPool::worker_loop, this));
+}
+
+ParallelRangesPool::
+~ParallelRangesPool()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_jobPosted.notify_all();
+	for(size_t i = 0; i < m_threads.size(); ++i)
+		m_threads[i].join();
+}
+
+void ParallelRangesPool::
+run(size_t numRanges, const function<void(size_t)>& func)
+{
+	unique_lock<mutex> runLock(m_runMutex, try_to_lock);
+	if(g_inParallelRanges || m_threads.empty() || !runLock.owns_lock()){
+		for(size_t i = 0; i < numRanges; ++i)
+			func(i);
+		return;
+	}
+
+	unique_lock<mutex> lock(m_mutex);
+	m_func = &func;
+	m_numRanges = numRanges;
+	m_nextRange = 0;
+	m_numDone = 0;
+	m_jobPosted.notify_all();
+
+//	the calling thread takes part in the job
+	g_inParallelRanges = true;
+	process_ranges(lock);
+	g_inParallelRanges = false;
+
+	while(m_numDone < m_numRanges)
+		m_jobDone.wait(lock);
+	m_func = NULL;
+}
+
+void ParallelRangesPool::
+process_ranges(unique_lock<mutex>& lock)
+{
+	while(m_nextRange < m_numRanges){
+		const size_t range = m_nextRange++;
+		const function<void(size_t)>& func = *m_func;
+
+		lock.unlock();
+		func(range);
+		lock.lock();
+
+		if(++m_numDone == m_numRanges)
+			m_jobDone.notify_all();
+	}
+}
+
+void ParallelRangesPool::
+worker_loop()
+{
+	g_inParallelRanges = true;
+
+	unique_lock<mutex> lock(m_mutex);
+	while(!m_stop){
+		if(m_nextRange >= m_numRanges){
+			m_jobPosted.wait(lock);
+			continue;
+		}
+		process_ranges(lock);
+	}
+}
+
+void RunParallelRanges(size_t numRanges, const std::function<void(size_t)>& func)
+{
+	ParallelRangesPool::instance().run(numRanges, func);
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+
+#ifndef __H__EMVIS_parallel_for__
+#define __H__EMVIS_parallel_for__
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <thread>
+
+///	number of contiguous ranges which ParallelForRanges creates for num elements
+/**	Each range holds at least minRangeSize elements, and there are no more
+ * ranges than hardware threads.*/
+inline size_t NumParallelRanges(size_t num, size_t minRangeSize = 4096)
+{
+	size_t numRanges = std::thread::hardware_concurrency();
+	numRanges = std::min(numRanges, num / std::max<size_t>(minRangeSize, 1));
+	return std::max<size_t>(numRanges, 1);
+}
+
+///	calls func(rangeIndex) for each rangeIndex in [0, numRanges) and waits for all calls.
+/**	The calls are distributed over a pool of threads which is started once
+ * and kept alive, and the calling thread. Calls from the threads of the pool
+ * or while another thread uses the pool are processed on the calling thread.*/
+void RunParallelRanges(size_t numRanges, const std::function<void(size_t)>& func);
+
+///	calls func(rangeIndex, begin, end) for contiguous ranges which cover [0, num)
+/**	The ranges are processed in parallel by RunParallelRanges. Inputs which
+ * are too small to be split, see NumParallelRanges, are processed on the
+ * calling thread only. rangeIndex lies in
+ * [0, NumParallelRanges(num, minRangeSize)), so that each range may write its
+ * partial result to its own slot.*/
+template <class TFunc>
+void ParallelForRanges(size_t num, TFunc func, size_t minRangeSize = 4096)
+{
+	if(num == 0)
+		return;
+
+//	since there are never more ranges than elements, no range is empty
+	const size_t numRanges = NumParallelRanges(num, minRangeSize);
+	if(numRanges == 1){
+		func(size_t(0), size_t(0), num);
+		return;
+	}
+
+	RunParallelRanges(numRanges, [&func, num, numRanges](size_t i){
+		func(i, num * i / numRanges, num * (i + 1) / numRanges);
+	});
+}
+
+#endif
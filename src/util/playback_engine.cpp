@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "playback_engine.h"
+#include "frame_profiler.h"
+#include "trace_recorder.h"
+
+using namespace std;
+
+///	number of time steps which are decoded ahead of the current position
+static const size_t DECODE_WINDOW = 8;
+
+///	interval between two frames in milliseconds
+static const int FRAME_INTERVAL = 30;
+
+PlaybackEngine::
+PlaybackEngine(QObject* parent) :
+	QObject(parent),
+	m_numSteps(0),
+	m_stepSize(0),
+	m_dim(0),
+	m_rangeMin(0),
+	m_rangeMax(0),
+	m_windowStart(0),
+	m_stopDecoder(false),
+	m_framePending(false),
+	m_front(0),
+	m_target(NULL),
+	m_position(0),
+	m_rate(1.0),
+	m_stepsPerSecond(25.0),
+	m_loop(false),
+	m_interpolate(true)
+{
+	m_timer.setInterval(FRAME_INTERVAL);
+	connect(&m_timer, SIGNAL(timeout()), this, SLOT(tick()));
+	connect(this, SIGNAL(stepDecoded()), this, SLOT(stepReady()),
+			Qt::QueuedConnection);
+}
+
+PlaybackEngine::
+~PlaybackEngine()
+{
+	close();
+}
+
+bool PlaybackEngine::
+open(const std::string& filename, const std::string& tmpDir,
+	 std::string* errorOut)
+{
+	close();
+
+	if(!OpenTimeSeries(m_reader, filename, tmpDir, errorOut))
+		return false;
+
+	m_numSteps = m_reader.num_steps();
+	m_stepSize = m_reader.step_size();
+	m_dim = m_reader.dim();
+	m_reader.global_range(m_rangeMin, m_rangeMax);
+
+	m_slots.assign(DECODE_WINDOW, Slot());
+	m_windowStart = 0;
+	m_position = 0;
+	m_decodeError.clear();
+	m_framePending = false;
+
+	start_decoder();
+
+	emit opened((int)m_numSteps);
+	emit positionChanged(m_position);
+	return true;
+}
+
+void PlaybackEngine::
+close()
+{
+	pause();
+	stop_decoder();
+	m_reader.close();
+	m_slots.clear();
+	m_frames[0].clear();
+	m_frames[1].clear();
+	m_numSteps = 0;
+	m_stepSize = 0;
+	m_framePending = false;
+
+	delete m_target;
+	m_target = NULL;
+}
+
+void PlaybackEngine::
+set_target(IPlaybackTarget* target)
+{
+	if(m_target != target)
+		delete m_target;
+	m_target = target;
+	produce_frame();
+}
+
+void PlaybackEngine::
+detach(const QObject* subject)
+{
+	if(has_subject(subject))
+		close();
+}
+
+void PlaybackEngine::
+fail(const std::string& message)
+{
+	close();
+	emit failed(QString::fromStdString(message));
+}
+
+void PlaybackEngine::
+global_range(float& minOut, float& maxOut) const
+{
+	minOut = m_rangeMin;
+	maxOut = m_rangeMax;
+}
+
+void PlaybackEngine::
+play()
+{
+	if(m_numSteps == 0 || is_playing())
+		return;
+
+	if(!m_loop && m_position >= (double)(m_numSteps - 1))
+		m_position = 0;
+
+	m_clock.start();
+	m_timer.start();
+	emit playingChanged(true);
+}
+
+void PlaybackEngine::
+pause()
+{
+	if(!is_playing())
+		return;
+	m_timer.stop();
+	emit playingChanged(false);
+}
+
+void PlaybackEngine::
+setPlaying(bool play)
+{
+	if(play)
+		this->play();
+	else
+		pause();
+}
+
+void PlaybackEngine::
+seek(double position)
+{
+	if(m_numSteps == 0)
+		return;
+
+	m_position = min(max(position, 0.), (double)(m_numSteps - 1));
+	m_clock.restart();
+	produce_frame();
+	emit positionChanged(m_position);
+}
+
+void PlaybackEngine::
+setLoop(bool loop)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_loop = loop;
+	m_decodeRequest.notify_one();
+}
+
+void PlaybackEngine::
+setRate(double rate)
+{
+	m_rate = max(rate, 0.);
+}
+
+void PlaybackEngine::
+tick()
+{
+	if(m_numSteps == 0){
+		pause();
+		return;
+	}
+
+	const double dt = 0.001 * (double)m_clock.restart();
+	double pos = m_position + dt * m_stepsPerSecond * m_rate;
+
+	if(m_loop)
+		pos = fmod(pos, (double)m_numSteps);
+	else if(pos >= (double)(m_numSteps - 1)){
+		pos = (double)(m_numSteps - 1);
+		pause();
+	}
+
+	m_position = pos;
+	produce_frame();
+	emit positionChanged(m_position);
+}
+
+void PlaybackEngine::
+stepReady()
+{
+	if(m_framePending)
+		produce_frame();
+}
+
+void PlaybackEngine::
+produce_frame()
+{
+	if(m_numSteps == 0 || !m_target)
+		return;
+
+	FRAME_PROFILE_STAGE(PS_ANIMATION);
+
+	const size_t s0 = min((size_t)m_position, m_numSteps - 1);
+	size_t s1 = s0 + 1;
+	if(s1 >= m_numSteps)
+		s1 = m_loop ? 0 : s0;
+	const float t = (float)(m_position - (double)s0);
+
+	const bool interpolate = m_interpolate && s1 != s0 && t > 0;
+	vector<float>& back = m_frames[1 - m_front];
+	string error;
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_windowStart = s0;
+		m_decodeRequest.notify_one();
+
+		const Slot* a = find_step(s0);
+		const Slot* b = interpolate ? find_step(s1) : a;
+		m_framePending = m_decodeError.empty() && (!a || !b);
+		if(!m_decodeError.empty())
+			error = m_decodeError;
+		else if(m_framePending)
+			return;
+		else if(!interpolate)
+			back = a->data;
+		else{
+			back.resize(m_stepSize);
+			const float* da = &a->data.front();
+			const float* db = &b->data.front();
+			for(size_t i = 0; i < m_stepSize; ++i)
+				back[i] = (1.f - t) * da[i] + t * db[i];
+		}
+	}
+
+	if(!error.empty()){
+		fail(error);
+		return;
+	}
+
+	m_front = 1 - m_front;
+	if(!m_target->apply_frame(m_frames[m_front], m_position))
+		fail("the target object of the time series changed");
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//	decoder thread
+void PlaybackEngine::
+start_decoder()
+{
+	m_stopDecoder = false;
+	m_decoder = thread(&PlaybackEngine::decoder_loop, this);
+}
+
+void PlaybackEngine::
+stop_decoder()
+{
+	if(!m_decoder.joinable())
+		return;
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stopDecoder = true;
+	}
+	m_decodeRequest.notify_one();
+	m_decoder.join();
+}
+
+///	returns true if step lies in the decode window of the given engine state
+static bool InWindow(size_t step, size_t windowStart, size_t numSteps, bool loop)
+{
+	if(loop)
+		return (step + numSteps - windowStart) % numSteps < DECODE_WINDOW;
+	return step >= windowStart && step - windowStart < DECODE_WINDOW;
+}
+
+long PlaybackEngine::
+next_step_to_decode() const
+{
+	for(size_t i = 0; i < DECODE_WINDOW; ++i){
+		size_t s = m_windowStart + i;
+		if(s >= m_numSteps){
+			if(!m_loop)
+				break;
+			s %= m_numSteps;
+		}
+
+		bool decoded = false;
+		for(size_t j = 0; j < m_slots.size(); ++j){
+			if(m_slots[j].step == (long)s){
+				decoded = true;
+				break;
+			}
+		}
+
+		if(!decoded)
+			return (long)s;
+	}
+	return -1;
+}
+
+const PlaybackEngine::Slot* PlaybackEngine::
+find_step(size_t step) const
+{
+	for(size_t i = 0; i < m_slots.size(); ++i){
+		if(m_slots[i].step == (long)step)
+			return &m_slots[i];
+	}
+	return NULL;
+}
+
+void PlaybackEngine::
+decoder_loop()
+{
+	TraceRecorder::instance().set_thread_name("playback decoder");
+
+	vector<float> buffer;
+	unique_lock<mutex> lock(m_mutex);
+
+	while(!m_stopDecoder){
+		long step = next_step_to_decode();
+		if(step < 0){
+			m_decodeRequest.wait(lock);
+			continue;
+		}
+
+	//	the file is read without holding the lock, so that the gui thread
+	//	may continue to interpolate already decoded steps.
+		lock.unlock();
+		bool ok;
+		{
+			TRACE_SCOPE("PlaybackEngine::read_step");
+			ok = m_reader.read_step((size_t)step, buffer);
+		}
+		lock.lock();
+
+	//	the error is reported by the gui thread, see produce_frame
+		if(!ok){
+			m_decodeError = "could not read time step " + to_string(step);
+			emit stepDecoded();
+			break;
+		}
+
+	//	the window may have moved in the meantime. Replace a slot which
+	//	is no longer needed.
+		if(!InWindow((size_t)step, m_windowStart, m_numSteps, m_loop))
+			continue;
+
+		for(size_t i = 0; i < m_slots.size(); ++i){
+			Slot& slot = m_slots[i];
+			if(slot.step < 0 || slot.step == step
+			   || !InWindow((size_t)slot.step, m_windowStart, m_numSteps, m_loop))
+			{
+				slot.step = step;
+				slot.data.swap(buffer);
+				break;
+			}
+		}
+		emit stepDecoded();
+	}
+}
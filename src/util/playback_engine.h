@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef __H__EMVIS_playback_engine__
+#define __H__EMVIS_playback_engine__
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "time_series_field.h"
+
+///	Receives the frames produced by a PlaybackEngine.
+class IPlaybackTarget
+{
+	public:
+		virtual ~IPlaybackTarget()	{}
+
+	///	called on the gui thread with step_size() values per frame.
+	/**	position is the (possibly fractional) time step of the frame.
+	 * Return false if the frame can no longer be applied, e.g. since the
+	 * target object changed. The engine is closed then.*/
+		virtual bool apply_frame(const std::vector<float>& values,
+								 double position) = 0;
+
+	///	the object to which the frames are written, see PlaybackEngine::detach
+		virtual const QObject* subject() const	{return NULL;}
+};
+
+
+///	Plays a time series (*.emts) with pause, seek, loop and playback rate.
+/**	Time steps are decoded ahead of the current position by a background
+ * thread into a small window of step buffers. Frames are interpolated
+ * linearly between neighbouring steps into a back buffer, which is swapped
+ * with the front buffer before it is passed to the target. Since steps are
+ * accessed randomly in the file, seeking only costs the read of the steps
+ * around the new position.
+ *
+ * The gui thread never waits for the decoder. If a step is not decoded yet,
+ * the frame is produced as soon as the decoder delivers it. If a step can't
+ * be read, playback is closed and failed() is emitted.*/
+class PlaybackEngine : public QObject
+{
+	Q_OBJECT
+
+	public:
+		PlaybackEngine(QObject* parent = 0);
+		virtual ~PlaybackEngine();
+
+	///	opens a time series. See OpenTimeSeries for supported files.
+		bool open(const std::string& filename, const std::string& tmpDir,
+				  std::string* errorOut = NULL);
+
+	///	stops playback and releases the file and the target.
+		void close();
+
+	///	The engine takes ownership of the target. Replaces an existing one.
+		void set_target(IPlaybackTarget* target);
+
+	///	closes the engine if the subject of its target is the given object.
+	/**	Has to be called before the object is removed from its scene.*/
+		void detach(const QObject* subject);
+
+	///	true if the frames of an open time series are written to subject
+		bool has_subject(const QObject* subject) const
+			{return m_target && subject && m_target->subject() == subject;}
+
+		size_t num_steps() const		{return m_numSteps;}
+		size_t step_size() const		{return m_stepSize;}
+		uint32_t dim() const			{return m_dim;}
+		void global_range(float& minOut, float& maxOut) const;
+
+		double position() const			{return m_position;}
+		bool is_playing() const			{return m_timer.isActive();}
+		bool loop() const				{return m_loop;}
+		double rate() const				{return m_rate;}
+
+	///	number of time steps played per second at rate 1
+		void set_steps_per_second(double sps)	{m_stepsPerSecond = sps;}
+		void set_interpolation(bool enable)		{m_interpolate = enable;}
+
+	signals:
+		void positionChanged(double position);
+		void playingChanged(bool playing);
+		void opened(int numSteps);
+		void failed(const QString& message);
+
+	///	emitted by the decoder thread after each decoded step
+		void stepDecoded();
+
+	public slots:
+		void play();
+		void pause();
+		void setPlaying(bool play);
+		void seek(double position);
+		void setLoop(bool loop);
+		void setRate(double rate);
+
+	protected slots:
+		void tick();
+		void stepReady();
+
+	private:
+		struct Slot{
+			Slot() : step(-1)	{}
+			long				step;
+			std::vector<float>	data;
+		};
+
+		void start_decoder();
+		void stop_decoder();
+		void decoder_loop();
+
+	///	the step which has to be decoded next or -1. Call with locked m_mutex.
+		long next_step_to_decode() const;
+
+	///	the slot of the given step or NULL if it isn't decoded yet.
+	/**	Call with locked m_mutex.*/
+		const Slot* find_step(size_t step) const;
+
+		void produce_frame();
+
+	///	closes the engine and emits failed
+		void fail(const std::string& message);
+
+		TimeSeriesReader	m_reader;///< only accessed by the decoder thread
+		size_t				m_numSteps;
+		size_t				m_stepSize;
+		uint32_t			m_dim;
+		float				m_rangeMin;
+		float				m_rangeMax;
+
+		std::thread					m_decoder;
+		std::mutex					m_mutex;
+		std::condition_variable		m_decodeRequest;
+		std::vector<Slot>			m_slots;
+		size_t						m_windowStart;
+		bool						m_stopDecoder;
+		std::string					m_decodeError;
+		bool						m_framePending;///< waits for a step
+
+		std::vector<float>	m_frames[2];
+		int					m_front;
+
+		IPlaybackTarget*	m_target;
+		QTimer				m_timer;
+		QElapsedTimer		m_clock;
+		double				m_position;
+		double				m_rate;
+		double				m_stepsPerSecond;
+		bool				m_loop;
+		bool				m_interpolate;
+};
+
+#endif
@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include "time_series_field.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+//	TimeSeriesWriter
+TimeSeriesWriter::
+TimeSeriesWriter()
+{
+	memset(&m_header, 0, sizeof(TimeSeriesHeader));
+}
+
+TimeSeriesWriter::
+~TimeSeriesWriter()
+{
+	if(m_out.is_open())
+		close();
+}
+
+bool TimeSeriesWriter::
+open(const char* filename, uint32_t dim, uint32_t numComponents,
+	 uint64_t numPoints, uint64_t stepsPerChunk)
+{
+	m_out.open(filename, ios::binary | ios::trunc);
+	if(!m_out)
+		return false;
+
+	memset(&m_header, 0, sizeof(TimeSeriesHeader));
+	memcpy(m_header.magic, "EMTS", 4);
+	m_header.version = TIME_SERIES_VERSION;
+	m_header.dim = dim;
+	m_header.numComponents = max<uint32_t>(numComponents, 1);
+	m_header.numPoints = numPoints;
+	m_header.stepsPerChunk = max<uint64_t>(stepsPerChunk, 1);
+	m_ranges.clear();
+
+//	the header is rewritten in close(), once numSteps is known
+	m_out.write((const char*)&m_header, sizeof(TimeSeriesHeader));
+	return m_out.good();
+}
+
+bool TimeSeriesWriter::
+write_step(const float* data)
+{
+	const size_t num = m_header.numPoints * m_header.numComponents;
+	float vmin = numeric_limits<float>::max();
+	float vmax = -numeric_limits<float>::max();
+	for(size_t i = 0; i < num; ++i){
+		vmin = min(vmin, data[i]);
+		vmax = max(vmax, data[i]);
+	}
+	if(num == 0)
+		vmin = vmax = 0;
+
+	m_ranges.push_back(vmin);
+	m_ranges.push_back(vmax);
+	++m_header.numSteps;
+
+	m_out.write((const char*)data, num * sizeof(float));
+	return m_out.good();
+}
+
+bool TimeSeriesWriter::
+close()
+{
+	if(!m_out.is_open())
+		return false;
+
+	m_header.rangeTableOffset = (uint64_t)m_out.tellp();
+	if(!m_ranges.empty())
+		m_out.write((const char*)&m_ranges.front(), m_ranges.size() * sizeof(float));
+
+	m_out.seekp(0);
+	m_out.write((const char*)&m_header, sizeof(TimeSeriesHeader));
+
+	bool success = m_out.good();
+	m_out.close();
+	return success;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//	TimeSeriesReader
+TimeSeriesReader::
+TimeSeriesReader(size_t windowSize) :
+	m_window(max<size_t>(windowSize, 2)),
+	m_useCounter(0)
+{
+	memset(&m_header, 0, sizeof(TimeSeriesHeader));
+}
+
+TimeSeriesReader::
+~TimeSeriesReader()
+{
+}
+
+bool TimeSeriesReader::
+open(const char* filename)
+{
+	close();
+
+	m_in.open(filename, ios::binary);
+	if(!m_in)
+		return false;
+
+	m_in.read((char*)&m_header, sizeof(TimeSeriesHeader));
+	if(!m_in || strncmp(m_header.magic, "EMTS", 4) != 0
+	   || m_header.version != TIME_SERIES_VERSION
+	   || m_header.numComponents == 0 || m_header.stepsPerChunk == 0)
+	{
+		close();
+		return false;
+	}
+
+	m_ranges.resize(2 * m_header.numSteps);
+	m_in.seekg(m_header.rangeTableOffset);
+	if(!m_ranges.empty())
+		m_in.read((char*)&m_ranges.front(), m_ranges.size() * sizeof(float));
+	if(!m_in){
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void TimeSeriesReader::
+close()
+{
+	if(m_in.is_open())
+		m_in.close();
+	m_in.clear();
+	m_ranges.clear();
+	for(size_t i = 0; i < m_window.size(); ++i){
+		m_window[i].index = -1;
+		m_window[i].data.clear();
+	}
+	memset(&m_header, 0, sizeof(TimeSeriesHeader));
+}
+
+void TimeSeriesReader::
+global_range(float& minOut, float& maxOut) const
+{
+	if(m_ranges.empty()){
+		minOut = maxOut = 0;
+		return;
+	}
+
+	minOut = numeric_limits<float>::max();
+	maxOut = -numeric_limits<float>::max();
+	for(size_t i = 0; i < num_steps(); ++i){
+		minOut = min(minOut, step_min(i));
+		maxOut = max(maxOut, step_max(i));
+	}
+}
+
+TimeSeriesReader::Chunk* TimeSeriesReader::
+load_chunk(size_t chunkIndex)
+{
+	Chunk* lru = &m_window[0];
+	for(size_t i = 0; i < m_window.size(); ++i){
+		if(m_window[i].index == (long)chunkIndex){
+			m_window[i].lastUse = ++m_useCounter;
+			return &m_window[i];
+		}
+		if(m_window[i].lastUse < lru->lastUse)
+			lru = &m_window[i];
+	}
+
+	const size_t firstStep = chunkIndex * m_header.stepsPerChunk;
+	const size_t numSteps = min<size_t>(m_header.stepsPerChunk,
+										num_steps() - firstStep);
+
+	lru->data.resize(numSteps * step_size());
+	m_in.clear();
+	m_in.seekg(sizeof(TimeSeriesHeader)
+			   + (uint64_t)firstStep * step_size() * sizeof(float));
+	m_in.read((char*)&lru->data.front(), lru->data.size() * sizeof(float));
+	if(!m_in){
+		lru->index = -1;
+		return NULL;
+	}
+
+	lru->index = (long)chunkIndex;
+	lru->lastUse = ++m_useCounter;
+	return lru;
+}
+
+const float* TimeSeriesReader::
+step(size_t step)
+{
+	if(!is_open() || step >= num_steps() || step_size() == 0)
+		return NULL;
+
+	const size_t chunkIndex = step / m_header.stepsPerChunk;
+	Chunk* chunk = load_chunk(chunkIndex);
+	if(!chunk)
+		return NULL;
+
+	const size_t localStep = step - chunkIndex * m_header.stepsPerChunk;
+
+//	read ahead once the end of a chunk is reached
+	const size_t nextChunk = chunkIndex + 1;
+	if(localStep + 1 == m_header.stepsPerChunk
+	   && nextChunk * m_header.stepsPerChunk < num_steps())
+	{
+		load_chunk(nextChunk);
+		chunk->lastUse = ++m_useCounter;
+	}
+
+	return &chunk->data[localStep * step_size()];
+}
+
+bool TimeSeriesReader::
+read_step(size_t step, std::vector<float>& dataOut)
+{
+	const float* data = this->step(step);
+	if(!data)
+		return false;
+	dataOut.assign(data, data + step_size());
+	return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//	conversion of legacy text files
+///	parses up to maxNum whitespace separated numbers from str without copying
+static size_t ParseNumbers(const char* str, std::vector<double>& valsOut,
+						   size_t maxNum)
+{
+	valsOut.clear();
+	char* end = NULL;
+	while(valsOut.size() < maxNum){
+		double d = strtod(str, &end);
+		if(end == str)
+			break;
+		valsOut.push_back(d);
+		str = end;
+	}
+	return valsOut.size();
+}
+
+static bool SetError(std::string* errorOut, const std::string& msg)
+{
+	if(errorOut)
+		*errorOut = msg;
+	return false;
+}
+
+///	writes the converted time series to binFile, which may be incomplete on failure
+static bool WriteTextTimeSeries(const char* txtFile, const char* binFile,
+								std::string* errorOut)
+{
+	ifstream in(txtFile);
+	if(!in)
+		return SetError(errorOut, string("could not open ") + txtFile);
+
+	string line;
+	vector<double> vals;
+	getline(in, line);
+	const size_t numHeader = ParseNumbers(line.c_str(), vals, 3);
+	if(numHeader < 2)
+		return SetError(errorOut, string("bad header in ") + txtFile);
+
+	const uint32_t dim = (uint32_t)vals[0];
+	const size_t numTime = (numHeader == 3) ? (size_t)vals[1] : 1;
+	const size_t numSpace = (size_t)vals[numHeader - 1];
+
+	TimeSeriesWriter writer;
+	if(!writer.open(binFile, dim, 1, numSpace))
+		return SetError(errorOut, string("could not write ") + binFile);
+
+	vector<float> step(numSpace);
+	for(size_t i = 0; i < numTime; ++i){
+		if(!getline(in, line))
+			return SetError(errorOut, string("unexpected end of file in ") + txtFile);
+
+		if(ParseNumbers(line.c_str(), vals, numSpace) != numSpace)
+			return SetError(errorOut, string("too few values in a time step of ") + txtFile);
+
+		for(size_t j = 0; j < numSpace; ++j)
+			step[j] = (float)vals[j];
+		if(!writer.write_step(&step.front()))
+			return SetError(errorOut, string("could not write ") + binFile);
+	}
+
+	if(!writer.close())
+		return SetError(errorOut, string("could not write ") + binFile);
+	return true;
+}
+
+bool ConvertTextTimeSeries(const char* txtFile, const char* binFile,
+						   std::string* errorOut)
+{
+	namespace fs = boost::filesystem;
+
+//	binFile only appears once it is complete, so that a partial file is
+//	never taken for an up to date conversion, see OpenTimeSeries.
+	const string tmpFile = string(binFile) + ".part";
+	boost::system::error_code ec;
+	if(!WriteTextTimeSeries(txtFile, tmpFile.c_str(), errorOut)){
+		fs::remove(tmpFile, ec);
+		return false;
+	}
+
+	fs::rename(tmpFile, binFile, ec);
+	if(ec){
+		fs::remove(tmpFile, ec);
+		return SetError(errorOut, string("could not write ") + binFile);
+	}
+	return true;
+}
+
+bool OpenTimeSeries(TimeSeriesReader& reader, const std::string& filename,
+					const std::string& tmpDir, std::string* errorOut)
+{
+	namespace fs = boost::filesystem;
+
+	fs::path path(filename);
+	if(path.extension() == TIME_SERIES_SUFFIX){
+		if(!reader.open(filename.c_str()))
+			return SetError(errorOut, "could not read " + filename);
+		return true;
+	}
+
+//	the hash of the full path avoids clashes of equally named files
+	std::ostringstream binName;
+	binName << path.stem().string() << "_"
+			<< std::hash<std::string>()(fs::absolute(path).string())
+			<< TIME_SERIES_SUFFIX;
+	fs::path binPath = fs::path(tmpDir) / binName.str();
+
+	boost::system::error_code ec;
+	bool upToDate = fs::exists(binPath, ec)
+					&& fs::last_write_time(binPath, ec) >= fs::last_write_time(path, ec)
+					&& !ec;
+
+	if(!upToDate){
+		if(!ConvertTextTimeSeries(filename.c_str(), binPath.string().c_str(), errorOut))
+			return false;
+	}
+
+	if(!reader.open(binPath.string().c_str()))
+		return SetError(errorOut, "could not read " + binPath.string());
+	return true;
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef __H__EMVIS_time_series_field__
+#define __H__EMVIS_time_series_field__
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+///	Binary storage of per-vertex fields over time steps (*.emts).
+/**	Layout (native little endian):
+ *	- header (TimeSeriesHeader)
+ *	- numSteps blocks of numPoints * numComponents floats, one per time step
+ *	- a range table with the minimal and maximal value of each step
+ *
+ * Steps have a fixed size, so any step can be reached with a single seek.
+ * Readers load stepsPerChunk steps with one read call.*/
+struct TimeSeriesHeader
+{
+	char		magic[4];///< "EMTS"
+	uint32_t	version;
+	uint32_t	dim;///< dimension of the simulation, as in the legacy text files
+	uint32_t	numComponents;///< 1 for scalar and dim for vector fields
+	uint64_t	numSteps;
+	uint64_t	numPoints;
+	uint64_t	stepsPerChunk;
+	uint64_t	rangeTableOffset;
+};
+
+const uint32_t TIME_SERIES_VERSION = 1;
+const char* const TIME_SERIES_SUFFIX = ".emts";
+
+
+///	Writes a time series step by step. The header is completed in close().
+class TimeSeriesWriter
+{
+	public:
+		TimeSeriesWriter();
+		~TimeSeriesWriter();
+
+		bool open(const char* filename, uint32_t dim, uint32_t numComponents,
+				  uint64_t numPoints, uint64_t stepsPerChunk = 16);
+
+	///	writes numPoints * numComponents values
+		bool write_step(const float* data);
+
+		bool close();
+
+	private:
+		std::ofstream		m_out;
+		TimeSeriesHeader	m_header;
+		std::vector<float>	m_ranges;
+};
+
+
+///	Random access to the steps of a time series with a bounded read window.
+/**	At most windowSize chunks are kept in memory. Accessing a step which is
+ * not in the window loads its chunk and replaces the least recently used one.
+ * Whenever the last step of a chunk is accessed, the following chunk is read
+ * ahead, so that sequential playback never waits for a whole chunk at once.*/
+class TimeSeriesReader
+{
+	public:
+		TimeSeriesReader(size_t windowSize = 2);
+		~TimeSeriesReader();
+
+		bool open(const char* filename);
+		void close();
+		bool is_open() const						{return m_in.is_open();}
+
+		uint32_t dim() const						{return m_header.dim;}
+		uint32_t num_components() const				{return m_header.numComponents;}
+		size_t num_steps() const					{return (size_t)m_header.numSteps;}
+		size_t num_points() const					{return (size_t)m_header.numPoints;}
+		size_t step_size() const					{return num_points() * num_components();}
+
+		float step_min(size_t step) const			{return m_ranges[2 * step];}
+		float step_max(size_t step) const			{return m_ranges[2 * step + 1];}
+
+	///	minimum and maximum over all steps, taken from the range table
+		void global_range(float& minOut, float& maxOut) const;
+
+	///	returns a pointer to the values of the given step or NULL on failure.
+	/**	The pointer is valid until the next call to step().*/
+		const float* step(size_t step);
+
+	///	copies the values of the given step to dataOut
+		bool read_step(size_t step, std::vector<float>& dataOut);
+
+	private:
+		struct Chunk{
+			Chunk() : index(-1), lastUse(0)	{}
+			long				index;
+			size_t				lastUse;
+			std::vector<float>	data;
+		};
+
+		Chunk* load_chunk(size_t chunkIndex);
+
+		std::ifstream			m_in;
+		TimeSeriesHeader		m_header;
+		std::vector<float>		m_ranges;
+		std::vector<Chunk>		m_window;
+		size_t					m_useCounter;
+};
+
+
+///	Converts the legacy whitespace separated text format to *.emts.
+/**	The first line of the text file holds either "dim numTime numSpace" or
+ * "dim numSpace" (a single step). Each following line holds the numSpace
+ * values of one time step. The text file is processed line by line.
+ * binFile is only created or replaced if the whole file could be converted.*/
+bool ConvertTextTimeSeries(const char* txtFile, const char* binFile,
+						   std::string* errorOut = NULL);
+
+///	Opens a *.emts file or a legacy text file.
+/**	Text files are converted to a *.emts file in tmpDir first. The converted
+ * file is reused as long as it is newer than the text file.*/
+bool OpenTimeSeries(TimeSeriesReader& reader, const std::string& filename,
+					const std::string& tmpDir, std::string* errorOut = NULL);
+
+#endif
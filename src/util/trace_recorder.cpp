@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#include <cstdio>
+#include <fstream>
+#include "trace_recorder.h"
+
+using namespace std;
+
+///	maximum number of events which are stored per thread
+static const size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+std::atomic<bool> TraceRecorder::s_active(false);
+
+///	writes str as json string
+static void WriteJSONString(ostream& out, const char* str)
+{
+	out << '"';
+	for(const char* c = str; *c; ++c){
+		switch(*c){
+			case '"':	out << "\\\""; break;
+			case '\\':	out << "\\\\"; break;
+			case '\n':	out << "\\n"; break;
+			case '\t':	out << "\\t"; break;
+			default:
+				if((unsigned char)*c < 0x20){
+					char tmp[8];
+					snprintf(tmp, sizeof(tmp), "\\u%04x", (unsigned)*c);
+					out << tmp;
+				}
+				else
+					out << *c;
+		}
+	}
+	out << '"';
+}
+
+///	converts a duration in nanoseconds to microseconds, the unit of the trace format
+static void WriteMicroseconds(ostream& out, int64_t ns)
+{
+	char tmp[32];
+	snprintf(tmp, sizeof(tmp), "%.3f", 1.e-3 * (double)ns);
+	out << tmp;
+}
+
+
+TraceRecorder& TraceRecorder::
+instance()
+{
+	static TraceRecorder recorder;
+	return recorder;
+}
+
+struct TraceRecorder::ThreadBufferHandle{
+	ThreadBufferHandle() : buf(NULL)	{}
+	~ThreadBufferHandle()
+	{
+		if(buf)
+			TraceRecorder::instance().release_thread_buffer(buf);
+	}
+	ThreadBuffer*	buf;
+};
+
+TraceRecorder::
+TraceRecorder() :
+	m_numDropped(0),
+	m_startTime(now_ns()),
+	m_nextTid(1)
+{
+}
+
+TraceRecorder::ThreadBuffer& TraceRecorder::
+thread_buffer()
+{
+	static thread_local ThreadBufferHandle handle;
+	if(!handle.buf){
+		lock_guard<mutex> lock(m_mutex);
+		m_threads.push_back(unique_ptr<ThreadBuffer>(new ThreadBuffer));
+		handle.buf = m_threads.back().get();
+		handle.buf->tid = m_nextTid++;
+	}
+	return *handle.buf;
+}
+
+void TraceRecorder::
+release_thread_buffer(ThreadBuffer* buf)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+//	recorded events are kept until they may have been written, see start
+	{
+		lock_guard<mutex> tlock(buf->mutex);
+		buf->exited = true;
+		if(!buf->events.empty())
+			return;
+	}
+
+	for(size_t i = 0; i < m_threads.size(); ++i){
+		if(m_threads[i].get() == buf){
+			m_threads.erase(m_threads.begin() + i);
+			return;
+		}
+	}
+}
+
+void TraceRecorder::
+start()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		size_t numThreads = 0;
+		for(size_t i = 0; i < m_threads.size(); ++i){
+			if(m_threads[i]->exited)
+				continue;
+			{
+				lock_guard<mutex> tlock(m_threads[i]->mutex);
+				m_threads[i]->events.clear();
+			}
+			m_threads[numThreads++].swap(m_threads[i]);
+		}
+		m_threads.resize(numThreads);
+		m_numDropped = 0;
+		m_startTime = now_ns();
+	}
+	s_active = true;
+}
+
+void TraceRecorder::
+stop()
+{
+	s_active = false;
+}
+
+void TraceRecorder::
+record(const char* name, int64_t beginNs, int64_t endNs)
+{
+	ThreadBuffer& buf = thread_buffer();
+	lock_guard<mutex> lock(buf.mutex);
+	if(buf.events.size() >= MAX_EVENTS_PER_THREAD){
+		++m_numDropped;
+		return;
+	}
+	TraceEvent e = {name, beginNs, endNs};
+	buf.events.push_back(e);
+}
+
+void TraceRecorder::
+set_thread_name(const std::string& name)
+{
+	ThreadBuffer& buf = thread_buffer();
+	lock_guard<mutex> lock(buf.mutex);
+	buf.name = name;
+}
+
+size_t TraceRecorder::
+num_events() const
+{
+	lock_guard<mutex> lock(m_mutex);
+	size_t num = 0;
+	for(size_t i = 0; i < m_threads.size(); ++i){
+		lock_guard<mutex> tlock(m_threads[i]->mutex);
+		num += m_threads[i]->events.size();
+	}
+	return num;
+}
+
+bool TraceRecorder::
+write_chrome_trace(const std::string& filename) const
+{
+	ofstream out(filename.c_str());
+	if(!out)
+		return false;
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+		   "\"args\":{\"name\":\"EmVis\"}}";
+
+	lock_guard<mutex> lock(m_mutex);
+	for(size_t i = 0; i < m_threads.size(); ++i){
+		const ThreadBuffer& buf = *m_threads[i];
+		lock_guard<mutex> tlock(buf.mutex);
+
+		if(!buf.name.empty()){
+			out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+				<< buf.tid << ",\"args\":{\"name\":";
+			WriteJSONString(out, buf.name.c_str());
+			out << "}}";
+		}
+
+		for(size_t j = 0; j < buf.events.size(); ++j){
+			const TraceEvent& e = buf.events[j];
+			out << ",\n{\"name\":";
+			WriteJSONString(out, e.name);
+			out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buf.tid << ",\"ts\":";
+			WriteMicroseconds(out, e.begin - m_startTime);
+			out << ",\"dur\":";
+			WriteMicroseconds(out, e.end - e.begin);
+			out << "}";
+		}
+	}
+
+	out << "\n]}\n";
+	return out.good();
+}
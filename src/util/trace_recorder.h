@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#ifndef __H__EMVIS_trace_recorder__
+#define __H__EMVIS_trace_recorder__
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+///	Records timestamped begin/end events per thread and writes them as Chrome trace.
+/**	The written json files can be inspected in chrome://tracing or Perfetto.
+ * Recording is off by default. While it is off, a ScopedTrace costs a single
+ * relaxed atomic load. Each thread appends to a buffer of its own, so that
+ * threads do not contend while recording. The buffer of a thread is released
+ * when the thread exits, or, if it still holds events, by the next start.
+ *
+ * Event names are not copied and thus have to outlive the recorder, e.g.
+ * string literals.*/
+class TraceRecorder
+{
+	public:
+		static TraceRecorder& instance();
+
+	///	nanoseconds of a monotonic clock
+		static inline int64_t now_ns()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		static inline bool active()
+		{
+			return s_active.load(std::memory_order_relaxed);
+		}
+
+	///	discards all recorded events and starts recording.
+		void start();
+	///	stops recording. Recorded events are kept until the next start.
+		void stop();
+
+	///	adds an event of the calling thread, which started at beginNs and ended at endNs.
+		void record(const char* name, int64_t beginNs, int64_t endNs);
+
+	///	names the calling thread in the written trace
+		void set_thread_name(const std::string& name);
+
+		size_t num_events() const;
+	///	number of events which were discarded since a thread buffer was full
+		size_t num_dropped_events() const	{return m_numDropped;}
+
+	///	writes the recorded events in the Chrome trace event format
+		bool write_chrome_trace(const std::string& filename) const;
+
+	private:
+		struct TraceEvent{
+			const char*	name;
+			int64_t		begin;
+			int64_t		end;
+		};
+
+		struct ThreadBuffer{
+			ThreadBuffer() : tid(0), exited(false)	{}
+			int						tid;
+			std::string				name;
+			std::vector<TraceEvent>	events;
+			bool					exited;
+			mutable std::mutex		mutex;
+		};
+
+	///	thread local handle, which releases the buffer of its thread on exit
+		struct ThreadBufferHandle;
+
+		TraceRecorder();
+		TraceRecorder(const TraceRecorder&);
+		TraceRecorder& operator=(const TraceRecorder&);
+
+		ThreadBuffer& thread_buffer();
+		void release_thread_buffer(ThreadBuffer* buf);
+
+		static std::atomic<bool>	s_active;
+
+		mutable std::mutex			m_mutex;	///< protects m_threads
+		std::vector<std::unique_ptr<ThreadBuffer> >	m_threads;
+		std::atomic<size_t>			m_numDropped;
+		int64_t						m_startTime;
+		int							m_nextTid;
+};
+
+
+///	records an event from its construction to its destruction
+class ScopedTrace
+{
+	public:
+		explicit ScopedTrace(const char* name) :
+			m_name(name),
+			m_start(TraceRecorder::active() ? TraceRecorder::now_ns() : 0)	{}
+
+		~ScopedTrace()
+		{
+			if(m_start != 0 && TraceRecorder::active())
+				TraceRecorder::instance().record(m_name, m_start, TraceRecorder::now_ns());
+		}
+
+	private:
+		const char*	m_name;
+		int64_t		m_start;
+};
+
+///	records the enclosing scope as event with the given name
+#define TRACE_SCOPE(name)	ScopedTrace traceScope(name)
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#include <algorithm>
+#include "camera_link.h"
+#include "view3d.h"
+
+using namespace std;
+
+CameraLink::
+CameraLink() :
+	m_enabled(false)
+{
+}
+
+CameraLink::
+~CameraLink()
+{
+	for(size_t i = 0; i < m_views.size(); ++i)
+		m_views[i]->set_camera_link(NULL);
+}
+
+void CameraLink::
+add_view(View3D* view)
+{
+	if(find(m_views.begin(), m_views.end(), view) != m_views.end())
+		return;
+	m_views.push_back(view);
+	view->set_camera_link(this);
+}
+
+void CameraLink::
+remove_view(View3D* view)
+{
+	vector<View3D*>::iterator iter = find(m_views.begin(), m_views.end(), view);
+	if(iter == m_views.end())
+		return;
+	m_views.erase(iter);
+	view->set_camera_link(NULL);
+}
+
+void CameraLink::
+set_enabled(bool enable, View3D* source)
+{
+	m_enabled = enable;
+	if(enable && source)
+		camera_changed(source);
+}
+
+void CameraLink::
+camera_changed(View3D* source)
+{
+	if(!m_enabled)
+		return;
+
+	cam::SCameraState state = source->camera().get_camera_state();
+	for(size_t i = 0; i < m_views.size(); ++i){
+		if(m_views[i] != source)
+			m_views[i]->apply_linked_camera_state(state);
+	}
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#ifndef __H__EMVIS_camera_link__
+#define __H__EMVIS_camera_link__
+
+#include <vector>
+
+class View3D;
+
+///	shares the camera of several views
+/**	While the link is enabled, every camera change of a linked view (drag,
+ * scroll, fly_to) is copied to all other views of the link. Views repaint
+ * through QWidget::update, which merges all requests of one event loop
+ * iteration into a single paint event and skips hidden views. A drag thus
+ * repaints each visible view once per batch of mouse events, however many
+ * views are linked.
+ *
+ * Only the camera state is shared. Window sizes and world scales stay per view.*/
+class CameraLink
+{
+	public:
+		CameraLink();
+		~CameraLink();
+
+	///	adds a view to the link, a view may only be part of one link.
+		void add_view(View3D* view);
+		void remove_view(View3D* view);
+
+	///	when enabled, the camera of source (if given) is copied to all views.
+		void set_enabled(bool enable, View3D* source = 0);
+		bool enabled() const	{return m_enabled;}
+
+	///	called by View3D whenever its camera changed.
+		void camera_changed(View3D* source);
+
+	private:
+		std::vector<View3D*>	m_views;
+		bool					m_enabled;
+};
+
+#endif
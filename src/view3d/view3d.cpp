@@ -30,6 +30,8 @@
 #include "gl_includes.h"
 #include "view3d.h"
 #include "renderer3d_interface.h"
+#include "camera_link.h"
+#include "util/frame_profiler.h"
 
 using namespace std;
 
@@ -45,9 +47,10 @@ View3D::View3D(QWidget *parent) :
 	m_zFar = 1000.f;
 
 	m_bDrawSelRect = false;
+	m_bShowProfilerOverlay = false;
 
 	m_pRenderer = NULL;
-	setFormat(QGLFormat(QGL::DoubleBuffer | QGL::DepthBuffer));
+	m_pCameraLink = NULL;
 
 	glViewport(0, 0, m_viewWidth, m_viewHeight);
 
@@ -64,6 +67,8 @@ View3D::View3D(QWidget *parent) :
 
 View3D::~View3D()
 {
+	if(m_pCameraLink)
+		m_pCameraLink->remove_view(this);
 }
 
 void View3D::set_renderer(IRenderer3D* renderer)
@@ -127,6 +132,8 @@ void View3D::resizeGL(int width, int height)
 
 void View3D::paintGL()
 {
+	m_profiler.begin_frame();
+
 //	setup gl
 	qglClearColor(m_bgColor);
 	glShadeModel(GL_FLAT);
@@ -265,6 +272,39 @@ void View3D::paintGL()
 //									 m_zNear, m_zFar);
 	}
 
+	m_profiler.end_frame();
+
+	if(m_bShowProfilerOverlay)
+		draw_profiler_overlay();
+}
+
+void View3D::
+set_profiler_overlay_visible(bool show)
+{
+	m_bShowProfilerOverlay = show;
+	update();
+}
+
+void View3D::
+draw_profiler_overlay()
+{
+//	the text shows the frame which was just finished
+	QString text = QString::fromStdString(m_profiler.overlay_text());
+	QStringList lines = text.split('\n', QString::SkipEmptyParts);
+
+	QFont font("Monospace");
+	font.setStyleHint(QFont::TypeWriter);
+	font.setPointSize(9);
+	const int lineHeight = QFontMetrics(font).height();
+
+	glDisable(GL_LIGHTING);
+	if(m_bgColor.lightness() > 127)
+		glColor3f(0, 0, 0);
+	else
+		glColor3f(1, 1, 0);
+
+	for(int i = 0; i < lines.size(); ++i)
+		renderText(8, 8 + (i + 1) * lineHeight, lines[i], font);
 }
 
 void  View3D::
@@ -448,6 +488,23 @@ void View3D::refocus_by_screen_coords(int screenX, int screenY)
 	}
 }
 
+void View3D::
+camera_changed()
+{
+	if(m_pCameraLink)
+		m_pCameraLink->camera_changed(this);
+	update();
+}
+
+void View3D::
+apply_linked_camera_state(const cam::SCameraState& state)
+{
+	m_pTimer->stop();
+	cam::SCameraState cs = state;
+	m_camera.set_camera_state(cs);
+	update();
+}
+
 void View3D::start_interpolation()
 {
 //	starts the timer and resets m_interpDur
@@ -466,7 +523,7 @@ void View3D::interpolate_cam_states()
 
 	cam::SCameraState cs = m_camera.interpolate_camera_states(m_csOld, m_csNew, ia);
 	m_camera.set_camera_state(cs);
-	updateGL();
+	camera_changed();
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -506,7 +563,7 @@ void View3D::mouseMoveEvent(QMouseEvent *event)
 	if(m_camera.dragging())
 	{
 		m_camera.drag_to(scaledEvent->x(), scaledEvent->y(), cdf);
-		updateGL();
+		camera_changed();
 	}
 
 	emit View3D::mouseMoved(scaledEvent);
@@ -527,7 +584,7 @@ void View3D::mouseReleaseEvent(QMouseEvent *event)
 	if(m_camera.dragging())
 	{
 		m_camera.end_drag(scaledEvent->x(), scaledEvent->y(), cdf);
-		updateGL();
+		camera_changed();
 	}
 	emit View3D::mouseReleased(scaledEvent);
 }
@@ -538,7 +595,7 @@ void View3D::wheelEvent(QWheelEvent *event)
 	float numSteps = numDegrees / 15.;
     m_camera.scroll(-numSteps * 0.1, get_camera_drag_flags());
 	event->accept();
-	updateGL();
+	camera_changed();
 }
 
 void View3D::mouseDoubleClickEvent(QMouseEvent *event)
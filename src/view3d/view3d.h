@@ -33,8 +33,10 @@
 #include <QTime>
 #include <QColor>
 #include "camera/camera.h"
+#include "util/frame_profiler.h"
 
 //	predeclarations
+class CameraLink;
 class IRenderer3D;
 class QTimer;
 class QTime;
@@ -65,6 +67,18 @@ class View3D : public QGLWidget
 		void fly_to(const cam::vector3& destTo, float distance);
 		void fly_to(const cam::vector3& destTo);
 
+	///	call after the camera was modified through camera().
+	/**	Passes the new state to the views of the camera link and schedules a repaint.*/
+		void camera_changed();
+
+	///	set by CameraLink::add_view
+		void set_camera_link(CameraLink* link)		{m_pCameraLink = link;}
+		CameraLink* camera_link()					{return m_pCameraLink;}
+
+	///	takes the camera state of a linked view, without passing it on.
+	/**	A running camera interpolation of this view is stopped.*/
+		void apply_linked_camera_state(const cam::SCameraState& state);
+
 	///	calculated the ray from the screen-position to the back-plane.
 		void get_ray(cam::vector3& vFromOut, cam::vector3& vToOut,
 					float screenX, float screenY);
@@ -81,6 +95,12 @@ class View3D : public QGLWidget
 	///	if bDrawIt is true, the view will draw a the given rect until the method is called with bDrawIt == false.
 		void drawSelectionRect(bool bDrawIt, float xMin = 0, float yMin = 0,
 								 float xMax = 0, float yMax = 0);
+
+	///	shows per-stage timings of the FrameProfiler on top of the scene.
+		void set_profiler_overlay_visible(bool show);
+		bool profiler_overlay_visible() const		{return m_bShowProfilerOverlay;}
+	///	records the frames of this view only
+		FrameProfiler& profiler()					{return m_profiler;}
 	signals:
 		void mousePressed(QMouseEvent* event);
 		void mouseMoved(QMouseEvent* event);
@@ -100,6 +120,7 @@ class View3D : public QGLWidget
 		void keyReleaseEvent(QKeyEvent * event);
 
 	//	helper methods
+		void draw_profiler_overlay();
 		unsigned int get_camera_drag_flags();
 		void refocus_by_screen_coords(int screenX, int screenY);
 		void start_interpolation();
@@ -129,11 +150,15 @@ class View3D : public QGLWidget
 		QColor				m_bgColor;
 		QTimer*				m_pTimer;
 		QTime				m_time;
+		CameraLink*			m_pCameraLink;
 		
 	//	selection rect
 		bool m_bDrawSelRect;
 		cam::vector2 m_selRectMin;
 		cam::vector2 m_selRectMax;
+
+		bool m_bShowProfilerOverlay;
+		FrameProfiler	m_profiler;
 };
 
 #endif
@@ -0,0 +1,287 @@
+#ifndef __HPP__EMVIS_parallel_tokenizer
+#define __HPP__EMVIS_parallel_tokenizer
+
+#include <atomic>
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include "../util/trace_recorder.h"
+
+///	a whitespace separated sequence of numbers which is tokenized by one worker
+struct TokenChunk{
+	const char* begin;
+	const char* end;
+	bool real;///< parse floating point numbers into reals, integers into ints otherwise
+	bool base64;///< the chunk holds base64 encoded little endian Float64 or Int32 values
+	bool ok;///< false if the chunk contained something which is not a number
+	std::vector<double> reals;
+	std::vector<int> ints;
+};
+
+inline bool is_token_space(char c){
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+///	parses a floating point number independent of the current C locale.
+/**	EmVis sets LC_NUMERIC to "C" in main, but the tokenizer is also used by
+ * the standalone tools, which don't, and strtod would stop at the '.' for
+ * e.g. german locales. Numbers with at most 15 significant digits and a
+ * small exponent are converted exactly without the much slower strtod.
+ * Returns the position after the number, or p if there is no number at p.*/
+inline const char* ParseDouble(const char* p, const char* end, double &val){
+	static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+								   1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+								   1e20, 1e21, 1e22};
+	const char* c = p;
+	bool neg = false;
+	if(c < end && (*c == '-' || *c == '+')){
+		neg = (*c == '-');
+		++c;
+	}
+
+	uint64_t mantissa = 0;
+	int num_digits = 0, exp10 = 0;
+	bool any_digit = false;
+	for(; c < end && *c >= '0' && *c <= '9'; ++c){
+		any_digit = true;
+		if(mantissa == 0 && *c == '0') continue;
+		if(num_digits < 19){ mantissa = 10 * mantissa + (*c - '0'); ++num_digits; }
+		else ++exp10;
+	}
+	if(c < end && *c == '.'){
+		for(++c; c < end && *c >= '0' && *c <= '9'; ++c){
+			any_digit = true;
+			if(mantissa == 0 && *c == '0'){ --exp10; continue; }
+			if(num_digits < 19){ mantissa = 10 * mantissa + (*c - '0'); ++num_digits; --exp10; }
+		}
+	}
+	if(!any_digit){
+		//	nan, inf and the like
+		char* next;
+		val = strtod(p, &next);
+		return next;
+	}
+	if(c < end && (*c == 'e' || *c == 'E')){
+		const char* e = c + 1;
+		bool eneg = false;
+		if(e < end && (*e == '-' || *e == '+')){
+			eneg = (*e == '-');
+			++e;
+		}
+		if(e < end && *e >= '0' && *e <= '9'){
+			int ev = 0;
+			for(; e < end && *e >= '0' && *e <= '9'; ++e){
+				if(ev < 100000) ev = 10 * ev + (*e - '0');
+			}
+			exp10 += eneg ? -ev : ev;
+			c = e;
+		}
+	}
+
+	if(num_digits <= 15 && exp10 >= -22 && exp10 <= 22){
+		double d = (double)mantissa;
+		d = exp10 < 0 ? d / pow10[-exp10] : d * pow10[exp10];
+		val = neg ? -d : d;
+		return c;
+	}
+
+//	correctly rounded conversion by strtod with the decimal point of the locale
+	char buf[64];
+	size_t len = (size_t)(c - p);
+	if(len >= sizeof(buf)){
+		len = sizeof(buf) - 1;
+	}
+	memcpy(buf, p, len);
+	buf[len] = 0;
+	const char point = *localeconv()->decimal_point;
+	for(size_t i = 0; i < len; ++i){
+		if(buf[i] == '.') buf[i] = point;
+	}
+	val = strtod(buf, NULL);
+	return c;
+}
+
+///	appends chunks of roughly chunk_size bytes which cover [begin, end).
+/**	Chunks only end at whitespace, so that no number is split. The text has to be
+ * followed by a non-numeric character (e.g. the terminating 0 of rapidxml values).*/
+inline void SplitTokenChunks(std::vector<TokenChunk> &chunks, const char* begin, const char* end,
+                             bool real, size_t chunk_size = 1 << 20){
+	while(begin < end){
+		const char* stop = (size_t)(end - begin) > chunk_size ? begin + chunk_size : end;
+		while(stop < end && !is_token_space(*stop)){
+			++stop;
+		}
+
+		TokenChunk chunk;
+		chunk.begin = begin;
+		chunk.end = stop;
+		chunk.real = real;
+		chunk.base64 = false;
+		chunk.ok = true;
+		chunks.push_back(chunk);
+		begin = stop;
+	}
+}
+
+///	appends chunks which cover the base64 encoded values in [begin, end).
+/**	The text must not contain whitespace. Chunks start at multiples of 32
+ * characters, i.e. 24 bytes, so that no Float64 or Int32 value is split.*/
+inline void SplitBase64Chunks(std::vector<TokenChunk> &chunks, const char* begin, const char* end,
+                              bool real, size_t chunk_size = 1 << 20){
+	chunk_size -= chunk_size % 32;
+	while(begin < end){
+		TokenChunk chunk;
+		chunk.begin = begin;
+		chunk.end = (size_t)(end - begin) > chunk_size ? begin + chunk_size : end;
+		chunk.real = real;
+		chunk.base64 = true;
+		chunk.ok = true;
+		chunks.push_back(chunk);
+		begin = chunk.end;
+	}
+}
+
+inline void DecodeBase64Chunk(TokenChunk &chunk){
+	std::vector<unsigned char> bytes;
+	bytes.reserve((chunk.end - chunk.begin) * 3 / 4);
+	unsigned int acc = 0;
+	int num_bits = 0;
+	for(const char* c = chunk.begin; c < chunk.end; ++c){
+		int v;
+		if(*c >= 'A' && *c <= 'Z')		v = *c - 'A';
+		else if(*c >= 'a' && *c <= 'z')	v = *c - 'a' + 26;
+		else if(*c >= '0' && *c <= '9')	v = *c - '0' + 52;
+		else if(*c == '+')				v = 62;
+		else if(*c == '/')				v = 63;
+		else if(*c == '=' || is_token_space(*c)) continue;
+		else{
+			chunk.ok = false;
+			return;
+		}
+
+		acc = (acc << 6) | (unsigned int)v;
+		num_bits += 6;
+		if(num_bits >= 8){
+			num_bits -= 8;
+			bytes.push_back((unsigned char)((acc >> num_bits) & 0xFF));
+		}
+	}
+
+	const size_t size = chunk.real ? 8 : 4;
+	const size_t num = bytes.size() / size;
+	if(chunk.real){
+		chunk.reals.resize(num);
+	}
+	else{
+		chunk.ints.resize(num);
+	}
+	for(size_t i = 0; i < num; ++i){
+		uint64_t bits = 0;
+		for(size_t j = 0; j < size; ++j){
+			bits |= (uint64_t)bytes[i * size + j] << (8 * j);
+		}
+		if(chunk.real){
+			memcpy(&chunk.reals[i], &bits, 8);
+		}
+		else{
+			chunk.ints[i] = (int)(int32_t)(uint32_t)bits;
+		}
+	}
+}
+
+inline void TokenizeChunk(TokenChunk &chunk){
+	if(chunk.base64){
+		DecodeBase64Chunk(chunk);
+		return;
+	}
+
+	const char* p = chunk.begin;
+	const char* end = chunk.end;
+	//	one number per 4 bytes is a rough guess for index lists, coordinates are longer
+	if(chunk.real){
+		chunk.reals.reserve((end - p) / 8);
+	}
+	else{
+		chunk.ints.reserve((end - p) / 4);
+	}
+
+	while(true){
+		while(p < end && is_token_space(*p)){
+			++p;
+		}
+		if(p >= end){
+			break;
+		}
+
+		if(chunk.real){
+			double val;
+			const char* next = ParseDouble(p, end, val);
+			if(next == p){
+				chunk.ok = false;
+				return;
+			}
+			chunk.reals.push_back(val);
+			p = next;
+		}
+		else{
+			bool neg = (*p == '-');
+			if(neg || *p == '+'){
+				++p;
+			}
+			if(p >= end || *p < '0' || *p > '9'){
+				chunk.ok = false;
+				return;
+			}
+			const int maxVal = std::numeric_limits<int>::max();
+			int val = 0;
+			while(p < end && *p >= '0' && *p <= '9'){
+				const int digit = *p - '0';
+				if(val > (maxVal - digit) / 10){
+					chunk.ok = false;
+					return;
+				}
+				val = 10 * val + digit;
+				++p;
+			}
+			if(p < end && !is_token_space(*p)){
+				chunk.ok = false;
+				return;
+			}
+			chunk.ints.push_back(neg ? -val : val);
+		}
+	}
+}
+
+///	tokenizes all chunks, distributing them over num_threads workers.
+/**	num_threads == 0 uses all hardware threads. The calling thread participates.*/
+inline void TokenizeChunksParallel(std::vector<TokenChunk> &chunks, unsigned num_threads = 0){
+	if(num_threads == 0){
+		num_threads = std::thread::hardware_concurrency();
+	}
+	if(num_threads > chunks.size()){
+		num_threads = (unsigned)chunks.size();
+	}
+
+	std::atomic<size_t> next(0);
+	auto work = [&chunks, &next](){
+		TRACE_SCOPE("TokenizeChunks");
+		for(size_t i = next++; i < chunks.size(); i = next++){
+			TokenizeChunk(chunks[i]);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for(unsigned i = 1; i < num_threads; ++i){
+		workers.push_back(std::thread(work));
+	}
+	work();
+	for(size_t i = 0; i < workers.size(); ++i){
+		workers[i].join();
+	}
+}
+
+#endif //guard
@@ -31,6 +31,9 @@
  * coordinates of triangles with each other, so that the resulting coordinate
  * array does not contain the same coordinate-triple multiple times.
  *
+ * Matching corners are identified through a hash table on their coordinates,
+ * binary files are mapped into memory where mmap is available.
+ *
  * The function operates on template container types. Those containers should
  * have similar interfaces as `std::vector` and operate on `float` or `double` types
  * (`TNumberContainer`) or on `int` or `size_t` types (`TIndexContainer`).
@@ -126,11 +129,25 @@
 #define __H__STL_READER
 
 #include <algorithm>
+#include <cctype>
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
 #include <exception>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
+#include <stdint.h>
 #include <vector>
 
+#if defined(__unix__) || defined(__APPLE__)
+	#define STL_READER_USE_MMAP
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
 #ifdef STL_READER_NO_EXCEPTIONS
 	#define STL_READER_THROW(msg) return false;
 	#define STL_READER_COND_THROW(cond, msg) if(cond) return false;
@@ -218,9 +235,10 @@ bool ReadStlFile_BINARY(const char* filename,
 					    TIndexContainer& solidRangesOut);
 
 /// Determines whether a stl file has ASCII format
-/** The underlying mechanism is simply checks whether the provided file starts
- * with the keyword solid. This should work for many stl files, but may
- * fail, of course.
+/** The underlying mechanism checks whether the provided file starts with the
+ * keyword solid. Since some exporters also start the header of binary files
+ * with solid, files whose size matches the triangle count of a binary header
+ * are treated as binary.
  */
 inline bool StlFileHasASCIIFormat(const char* filename);
 
@@ -396,84 +414,171 @@ private:
 
 namespace stl_reader_impl {
 
-	// a coordinate triple with an additional index. The index is required
-	// for RemoveDoubles, so that triangles can be reindexed properly.
-	template <typename number_t, typename index_t>
-	struct CoordWithIndex {
-		number_t data[3];
-		index_t index;
-
-		bool operator == (const CoordWithIndex& c) const
+	// read-only view of the contents of a file. The file is mapped into memory
+	// if mmap is available and read into a buffer otherwise.
+	class FileView {
+	public:
+		FileView (const char* filename) : m_data (NULL), m_size (0), m_good (false)
 		{
-			return (c[0] == data[0]) && (c[1] == data[1]) && (c[2] == data[2]);
+		#ifdef STL_READER_USE_MMAP
+			m_mapped = false;
+			int fd = open (filename, O_RDONLY);
+			if(fd < 0)
+				return;
+
+			struct stat st;
+			if(fstat (fd, &st) == 0){
+				m_size = static_cast<size_t> (st.st_size);
+				m_good = true;
+				if(m_size > 0){
+					void* addr = mmap (NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+					if(addr != MAP_FAILED){
+						m_data = static_cast<const char*> (addr);
+						m_mapped = true;
+					}
+					else
+						m_good = false;
+				}
+			}
+			close (fd);
+		#else
+			std::ifstream in (filename, std::ios::binary);
+			if(!in)
+				return;
+			in.seekg (0, std::ios::end);
+			m_size = static_cast<size_t> (in.tellg());
+			in.seekg (0, std::ios::beg);
+			m_buffer.resize (m_size);
+			if(m_size > 0)
+				in.read (&m_buffer[0], m_size);
+			m_good = !in.fail();
+			m_data = m_buffer.empty() ? NULL : &m_buffer[0];
+		#endif
 		}
 
-		bool operator != (const CoordWithIndex& c) const
+		~FileView ()
 		{
-			return (c[0] != data[0]) || (c[1] != data[1]) || (c[2] != data[2]);
+		#ifdef STL_READER_USE_MMAP
+			if(m_mapped)
+				munmap (const_cast<char*> (m_data), m_size);
+		#endif
 		}
 
-		bool operator < (const CoordWithIndex& c) const
-		{
-			return		(data[0] < c[0])
-					||	(data[0] == c[0] && data[1] < c[1])
-					||	(data[0] == c[0] && data[1] == c[1] && data[2] < c[2]);
+		bool good () const			{return m_good;}
+		const char* data () const	{return m_data;}
+		size_t size () const		{return m_size;}
+
+	private:
+		FileView (const FileView&);
+		FileView& operator = (const FileView&);
+
+		const char*	m_data;
+		size_t		m_size;
+		bool		m_good;
+	#ifdef STL_READER_USE_MMAP
+		bool		m_mapped;
+	#else
+		std::vector<char>	m_buffer;
+	#endif
+	};
+
+
+	// converts a number independent of the decimal point of the current C locale
+	inline double ToNumber (const std::string& str)
+	{
+		const char point = *localeconv()->decimal_point;
+		if(point == '.')
+			return atof (str.c_str());
+
+		std::string tmp = str;
+		std::replace (tmp.begin(), tmp.end(), '.', point);
+		return atof (tmp.c_str());
+	}
+
+
+	// hash of the bit patterns of a coordinate triple. -0 and 0 are mapped to
+	// the same value, since they compare equal.
+	template <typename number_t>
+	inline uint64_t HashCoord (const number_t* c)
+	{
+		uint64_t h = 0;
+		for(int i = 0; i < 3; ++i){
+			number_t v = c[i];
+			if(v == 0)
+				v = 0;
+			uint64_t bits = 0;
+			memcpy (&bits, &v, sizeof(number_t) < 8 ? sizeof(number_t) : 8);
+			h = (h ^ bits) * 0x9E3779B97F4A7C15ull;
+			h ^= h >> 29;
 		}
+		return h;
+	}
 
-		inline number_t& operator [] (const size_t i)		{return data[i];}
-		inline number_t operator [] (const size_t i) const	{return data[i];}
-	};
 
-	// sorts the array coordsWithIndexInOut and copies unique indices to coordsOut.
-	// Triangle-corners are re-indexed on the fly and degenerated triangles are removed.
+	// identifies equal coordinate triples in cornerCoords through a hash table and
+	// copies unique coordinates to uniqueCoordsOut in the order of their first
+	// occurrence. Triangle-corners are re-indexed on the fly and degenerated
+	// triangles are removed, solidRangesInOut is adjusted accordingly.
 	template <class TNumberContainer, class TIndexContainer>
 	void RemoveDoubles (TNumberContainer& uniqueCoordsOut,
 	                    TIndexContainer& trisInOut,
-	                    std::vector <CoordWithIndex<
-                    		typename TNumberContainer::value_type,
-                    		typename TIndexContainer::value_type> >
-                    			&coordsWithIndexInOut)
+	                    TIndexContainer& solidRangesInOut,
+	                    const std::vector<typename TNumberContainer::value_type>& cornerCoords)
 	{
 		using namespace std;
 
 		typedef typename TNumberContainer::value_type	number_t;
 		typedef typename TIndexContainer::value_type	index_t;
 
-		sort (coordsWithIndexInOut.begin(), coordsWithIndexInOut.end());
-	
-	//	first count unique indices
-		size_t numUnique = 1;
-		for(size_t i = 1; i < coordsWithIndexInOut.size(); ++i){
-			if(coordsWithIndexInOut[i] != coordsWithIndexInOut[i - 1])
-				++numUnique;
+		const size_t numCorners = cornerCoords.size() / 3;
+		const size_t empty = static_cast<size_t> (-1);
+
+	//	open addressing with linear probing, at most half of the slots are used
+		size_t tableSize = 16;
+		while(tableSize < 2 * numCorners)
+			tableSize *= 2;
+		const size_t mask = tableSize - 1;
+		vector<size_t> table (tableSize, empty);
+
+		uniqueCoordsOut.resize (numCorners * 3);
+		vector<index_t> newIndex (numCorners);
+		size_t numUnique = 0;
+
+		for(size_t i = 0; i < numCorners; ++i){
+			const number_t* c = &cornerCoords[i * 3];
+			size_t slot = static_cast<size_t> (HashCoord (c)) & mask;
+			while(true){
+				const size_t ui = table[slot];
+				if(ui == empty){
+					table[slot] = numUnique;
+					for(size_t j = 0; j < 3; ++j)
+						uniqueCoordsOut[numUnique * 3 + j] = c[j];
+					newIndex[i] = static_cast<index_t> (numUnique);
+					++numUnique;
+					break;
+				}
+				if(	uniqueCoordsOut[ui * 3] == c[0]
+				 && uniqueCoordsOut[ui * 3 + 1] == c[1]
+				 && uniqueCoordsOut[ui * 3 + 2] == c[2])
+				{
+					newIndex[i] = static_cast<index_t> (ui);
+					break;
+				}
+				slot = (slot + 1) & mask;
+			}
 		}
 
 		uniqueCoordsOut.resize (numUnique * 3);
-		vector<index_t> newIndex (coordsWithIndexInOut.size());
-
-	//	copy unique coordinates to 'uniqueCoordsOut' and create an index-map
-	//	'newIndex', which allows to re-index triangles later on.
-		size_t curInd = 0;
-		newIndex[0] = 0;
-		for(size_t i = 0; i < 3; ++i)
-			uniqueCoordsOut[i] = coordsWithIndexInOut[0][i];
-
-		for(size_t i = 1; i < coordsWithIndexInOut.size(); ++i){
-			const CoordWithIndex <number_t, index_t> c = coordsWithIndexInOut[i];
-			if(c != coordsWithIndexInOut[i - 1]){
-				++curInd;
-				for(size_t j = 0; j < 3; ++j)
-					uniqueCoordsOut[curInd * 3 + j] = coordsWithIndexInOut[i][j];
-			}
-
-			newIndex[c.index] = curInd;
-		}
 
 	//	re-index triangles, so that they refer to 'uniqueCoordsOut'
 	//	make sure to only add triangles which refer to three different indices
 		size_t numUniqueTriInds = 0;
+		size_t curSolid = 0;
 		for(size_t i = 0; i < trisInOut.size(); i+=3){
-			int ni[3];
+			while(curSolid < solidRangesInOut.size() && solidRangesInOut[curSolid] <= i / 3)
+				solidRangesInOut[curSolid++] = static_cast<index_t> (numUniqueTriInds / 3);
+
+			index_t ni[3];
 			for(int j = 0; j < 3; ++j)
 				ni[j] = newIndex[trisInOut[i+j]];
 
@@ -484,6 +589,9 @@ namespace stl_reader_impl {
 			}
 		}
 
+		while(curSolid < solidRangesInOut.size())
+			solidRangesInOut[curSolid++] = static_cast<index_t> (numUniqueTriInds / 3);
+
 		if(numUniqueTriInds < trisInOut.size())
 			trisInOut.resize (numUniqueTriInds);
 	}
@@ -525,7 +633,7 @@ bool ReadStlFile_ASCII(const char* filename,
 	ifstream in(filename);
 	STL_READER_COND_THROW(!in, "Couldn't open file " << filename);
 
-	vector<CoordWithIndex <number_t, index_t> > coordsWithIndex;
+	vector<number_t> cornerCoords;
 
 	string buffer;
 	vector<string> tokens;
@@ -561,11 +669,8 @@ bool ReadStlFile_ASCII(const char* filename,
 				}
 				
 			//	read the position
-				CoordWithIndex <number_t, index_t> c;
 				for(size_t i = 0; i < 3; ++i)
-					c[i] = atof(tokens[i+1].c_str());
-				c.index = static_cast<index_t>(coordsWithIndex.size());
-				coordsWithIndex.push_back(c);
+					cornerCoords.push_back (static_cast<number_t> (ToNumber (tokens[i+1])));
 				++numFaceVrts;
 			}
 			else if(tok.compare("facet") == 0)
@@ -580,7 +685,7 @@ bool ReadStlFile_ASCII(const char* filename,
 				
 			//	read the normal
 				for(size_t i = 0; i < 3; ++i)
-					normalsOut.push_back (atof(tokens[i+2].c_str()));
+					normalsOut.push_back (static_cast<number_t> (ToNumber (tokens[i+2])));
 
 				numFaceVrts = 0;
 			}
@@ -594,9 +699,10 @@ bool ReadStlFile_ASCII(const char* filename,
 					"ERROR while reading from " << filename <<
 					": bad number of vertices specified for face in line " << lineCount);
 
-				trisOut.push_back(coordsWithIndex.size() - 3);
-				trisOut.push_back(coordsWithIndex.size() - 2);
-				trisOut.push_back(coordsWithIndex.size() - 1);
+				const size_t numCorners = cornerCoords.size() / 3;
+				trisOut.push_back(static_cast<index_t>(numCorners - 3));
+				trisOut.push_back(static_cast<index_t>(numCorners - 2));
+				trisOut.push_back(static_cast<index_t>(numCorners - 1));
 			}
 			else if(tok.compare("solid") == 0){
 				solidRangesOut.push_back(trisOut.size() / 3);
@@ -607,7 +713,7 @@ bool ReadStlFile_ASCII(const char* filename,
 
 	solidRangesOut.push_back(trisOut.size() / 3);
 
-	RemoveDoubles (coordsOut, trisOut, coordsWithIndex);
+	RemoveDoubles (coordsOut, trisOut, solidRangesOut, cornerCoords);
 
 	return true;
 }
@@ -631,48 +737,39 @@ bool ReadStlFile_BINARY(const char* filename,
 	trisOut.clear();
 	solidRangesOut.clear();
 
-	ifstream in(filename, ios::binary);
-	STL_READER_COND_THROW(!in, "Couldnt open file " << filename);
+	FileView file(filename);
+	STL_READER_COND_THROW(!file.good(), "Couldnt open file " << filename);
+	STL_READER_COND_THROW(file.size() < 84, "Error while parsing binary stl header in file " << filename);
 
-	char stl_header[80];
-	in.read(stl_header, 80);
-	STL_READER_COND_THROW(!in, "Error while parsing binary stl header in file " << filename);
+	const char* data = file.data();
+	uint32_t numTris = 0;
+	memcpy(&numTris, data + 80, 4);
+	STL_READER_COND_THROW((file.size() - 84) / 50 < numTris,
+		"Error while parsing trianlge in binary stl file " << filename);
 
-	unsigned int numTris = 0;
-	in.read((char*)&numTris, 4);
-	STL_READER_COND_THROW(!in, "Couldnt determine number of triangles in binary stl file " << filename);
+	vector<number_t> cornerCoords(9 * static_cast<size_t>(numTris));
+	normalsOut.resize(3 * static_cast<size_t>(numTris));
+	trisOut.resize(3 * static_cast<size_t>(numTris));
 
-	vector<CoordWithIndex <number_t, index_t> > coordsWithIndex;
-
-	for(unsigned int tri = 0; tri < numTris; ++tri){
+//	each triangle holds a normal, 3 corners and 2 bytes of additional data
+	for(size_t tri = 0; tri < numTris; ++tri){
 		float d[12];
-		in.read((char*)d, 12 * 4);
-		STL_READER_COND_THROW(!in, "Error while parsing trianlge in binary stl file " << filename);
-
-		for(int i = 0; i < 3; ++i)
-			normalsOut.push_back (d[i]);
-
-		for(size_t ivrt = 1; ivrt < 4; ++ivrt){
-			CoordWithIndex <number_t, index_t> c;
-			for(size_t i = 0; i < 3; ++i)
-				c[i] = d[ivrt * 3 + i];
-			c.index = static_cast<index_t>(coordsWithIndex.size());
-			coordsWithIndex.push_back(c);
-		}
+		memcpy(d, data + 84 + 50 * tri, 12 * 4);
 
-		trisOut.push_back(coordsWithIndex.size() - 3);
-		trisOut.push_back(coordsWithIndex.size() - 2);
-		trisOut.push_back(coordsWithIndex.size() - 1);
+		for(size_t i = 0; i < 3; ++i)
+			normalsOut[3 * tri + i] = d[i];
 
-		char addData[2];
-		in.read(addData, 2);
-		STL_READER_COND_THROW(!in, "Error while parsing additional triangle data in binary stl file " << filename);
+		for(size_t i = 0; i < 9; ++i)
+			cornerCoords[9 * tri + i] = d[3 + i];
+
+		for(size_t i = 0; i < 3; ++i)
+			trisOut[3 * tri + i] = static_cast<index_t>(3 * tri + i);
 	}
 
 	solidRangesOut.push_back(0);
 	solidRangesOut.push_back(trisOut.size() / 3);
 
-	RemoveDoubles (coordsOut, trisOut, coordsWithIndex);
+	RemoveDoubles (coordsOut, trisOut, solidRangesOut, cornerCoords);
 
 	return true;
 }
@@ -681,14 +778,30 @@ bool ReadStlFile_BINARY(const char* filename,
 inline bool StlFileHasASCIIFormat(const char* filename)
 {
 	using namespace std;
-	ifstream in(filename);
+	ifstream in(filename, ios::binary);
 	STL_READER_COND_THROW(!in, "Couldnt open file " << filename);
 
 	string firstWord;
 	in >> firstWord;
 	transform(firstWord.begin(), firstWord.end(), firstWord.begin(), ::tolower);
-
-	return firstWord.compare("solid") == 0;
+	if(firstWord.compare("solid") != 0)
+		return false;
+
+//	binary files which start with solid are recognized by their size
+	char header[84];
+	in.clear();
+	in.seekg(0, ios::beg);
+	in.read(header, 84);
+	if(in.gcount() == 84){
+		uint32_t numTris = 0;
+		memcpy(&numTris, header + 80, 4);
+		in.clear();
+		in.seekg(0, ios::end);
+		const uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+		if(fileSize == 84 + 50 * static_cast<uint64_t>(numTris))
+			return false;
+	}
+	return true;
 }
 
 } // end of namespace stl_reader
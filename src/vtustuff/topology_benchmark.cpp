@@ -0,0 +1,97 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include "topology_builder.hpp"
+
+//	standalone benchmark of TopologyBuilder on structured meshes.
+//	Each mesh is an n x n x n block of cubes, either as hexahedrons or with
+//	every cube split into 6 tetrahedrons around its main diagonal. The
+//	extracted element counts are checked against the closed formulas.
+//
+//	build: target topology_benchmark, or
+//	g++ -O2 -std=c++11 topology_benchmark.cpp -o topology_benchmark
+
+static unsigned vind(unsigned n, unsigned x, unsigned y, unsigned z){
+	return x + (n+1) * (y + (n+1) * z);
+}
+
+static void create_mesh(std::vector<unsigned> &conn, std::vector<unsigned> &offsets,
+						std::vector<unsigned> &types, unsigned n, bool tets){
+	conn.clear(); offsets.clear(); types.clear();
+
+	for(unsigned z = 0; z < n; ++z){
+		for(unsigned y = 0; y < n; ++y){
+			for(unsigned x = 0; x < n; ++x){
+				unsigned c[8] = {vind(n, x, y, z), vind(n, x+1, y, z),
+								 vind(n, x+1, y+1, z), vind(n, x, y+1, z),
+								 vind(n, x, y, z+1), vind(n, x+1, y, z+1),
+								 vind(n, x+1, y+1, z+1), vind(n, x, y+1, z+1)};
+				if(!tets){
+					conn.insert(conn.end(), c, c + 8);
+					offsets.push_back(conn.size());
+					types.push_back(VTK_CELL_HEXAHEDRON);
+					continue;
+				}
+
+			//	Kuhn subdivision: all tets share the diagonal c[0]-c[6]
+				const unsigned paths[6][2] = {{1, 2}, {1, 5}, {3, 2}, {3, 7}, {4, 5}, {4, 7}};
+				for(unsigned i = 0; i < 6; ++i){
+					conn.push_back(c[0]);
+					conn.push_back(c[paths[i][0]]);
+					conn.push_back(c[paths[i][1]]);
+					conn.push_back(c[6]);
+					offsets.push_back(conn.size());
+					types.push_back(VTK_CELL_TETRA);
+				}
+			}
+		}
+	}
+}
+
+static bool run(unsigned n, bool tets){
+	std::vector<unsigned> conn, offsets, types;
+	create_mesh(conn, offsets, types, n, tets);
+
+	TopologyBuilder topology;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	topology.build(conn, offsets, types);
+	std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+	const double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+
+	const size_t N = n;
+	const size_t gridEdges = 3 * N * (N+1) * (N+1);
+	const size_t gridFaces = 3 * N * N * (N+1);
+	size_t expEdges, expTris, expQuads;
+	if(tets){
+		expEdges = gridEdges + gridFaces + N * N * N;
+		expTris = 2 * gridFaces + 6 * N * N * N;
+		expQuads = 0;
+	}
+	else{
+		expEdges = gridEdges;
+		expTris = 0;
+		expQuads = gridFaces;
+	}
+
+	const bool ok = topology.num_edges() == expEdges
+				 && topology.num_triangles() == expTris
+				 && topology.num_quadrilaterals() == expQuads
+				 && topology.num_volumes() == types.size();
+
+	std::cout << (tets ? "tetrahedrons " : "hexahedrons  ") << types.size() << " cells: "
+			  << ms << " ms (" << (types.size() / ms / 1000.) << " Mcells/s), "
+			  << topology.num_edges() << " edges, " << topology.num_faces() << " faces"
+			  << (ok ? "" : "  COUNT MISMATCH") << std::endl;
+	return ok;
+}
+
+int main(int argc, char **argv){
+	unsigned n = 100;
+	if(argc > 1){
+		n = (unsigned)atoi(argv[1]);
+	}
+
+	bool ok = run(n, false);
+	ok = run(n / 2, true) && ok;
+	return ok ? 0 : 1;
+}
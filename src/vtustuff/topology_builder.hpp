@@ -0,0 +1,357 @@
+#ifndef __HPP__EMVIS_topology_builder
+#define __HPP__EMVIS_topology_builder
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include <assert.h>
+
+//	VTK cell types which are understood by the TopologyBuilder
+enum VTKCellType{
+	VTK_CELL_LINE = 3,
+	VTK_CELL_TRIANGLE = 5,
+	VTK_CELL_QUAD = 9,
+	VTK_CELL_TETRA = 10,
+	VTK_CELL_HEXAHEDRON = 12,
+	VTK_CELL_WEDGE = 13,
+	VTK_CELL_PYRAMID = 14
+};
+
+///	set of elements with N corners, deduplicated by their sorted corner indices.
+/**	Elements are stored in a flat array in the corner order in which they were
+ * first inserted. Lookup uses open addressing with linear probing on a
+ * power-of-two table whose slots hold the sorted key inline, so that a probe
+ * touches a single cache line and no allocation per element takes place.*/
+template <unsigned N>
+class UniqueElementSet{
+public:
+	UniqueElementSet() : _capacity(0), _num(0){}
+
+	void clear(){
+		_corners.clear();
+		_slots.clear();
+		_capacity = 0;
+		_num = 0;
+	}
+
+	void reserve(size_t num){
+		_corners.reserve(num * N);
+		size_t cap = 16;
+		while(cap < 2 * num){
+			cap *= 2;
+		}
+		if(cap > _capacity){
+			rehash(cap);
+		}
+	}
+
+	///	returns the index of the element, which may have been inserted before
+	size_t insert(const unsigned* corners){
+		unsigned key[N];
+		for(unsigned i = 0; i < N; ++i){
+			key[i] = corners[i];
+		}
+		std::sort(key, key + N);
+
+		if(2 * (_num + 1) > _capacity){
+			rehash(_capacity == 0 ? 16 : 2 * _capacity);
+		}
+
+		const size_t mask = _capacity - 1;
+		size_t slot = hash(key) & mask;
+		while(true){
+			unsigned* s = &_slots[slot * SLOT_SIZE];
+			if(s[0] == 0){
+				s[0] = (unsigned)(++_num);
+				for(unsigned i = 0; i < N; ++i){
+					s[i+1] = key[i];
+				}
+				break;
+			}
+			if(equals(s + 1, key)){
+				return s[0] - 1;
+			}
+			slot = (slot + 1) & mask;
+		}
+
+		_corners.insert(_corners.end(), corners, corners + N);
+		return _num - 1;
+	}
+
+	size_t size() const						{return _num;}
+	const unsigned* element(size_t i) const	{return &_corners[i * N];}
+	const std::vector<unsigned>& corners() const	{return _corners;}
+
+private:
+	enum{SLOT_SIZE = N + 1};///< element index + 1 (0 marks an empty slot), sorted key
+
+	static size_t hash(const unsigned* key){
+	//	consecutive vertex indices of structured meshes cluster badly with
+	//	weak hashes, hence the full 64 bit finalizer.
+		uint64_t h = 0;
+		for(unsigned i = 0; i < N; ++i){
+			h = (h ^ key[i]) * 0x9E3779B97F4A7C15ULL;
+		}
+		h ^= h >> 31;
+		h *= 0xBF58476D1CE4E5B9ULL;
+		h ^= h >> 29;
+		return (size_t)h;
+	}
+
+	static bool equals(const unsigned* k, const unsigned* key){
+		for(unsigned i = 0; i < N; ++i){
+			if(k[i] != key[i]){
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void rehash(size_t cap){
+		std::vector<unsigned> old(cap * SLOT_SIZE, 0);
+		old.swap(_slots);
+		const size_t oldCapacity = _capacity;
+		_capacity = cap;
+
+		const size_t mask = cap - 1;
+		for(size_t i = 0; i < oldCapacity; ++i){
+			const unsigned* o = &old[i * SLOT_SIZE];
+			if(o[0] == 0){
+				continue;
+			}
+			size_t slot = hash(o + 1) & mask;
+			while(_slots[slot * SLOT_SIZE] != 0){
+				slot = (slot + 1) & mask;
+			}
+			std::copy(o, o + SLOT_SIZE, &_slots[slot * SLOT_SIZE]);
+		}
+	}
+
+	std::vector<unsigned> _corners;
+	std::vector<unsigned> _slots;
+	size_t _capacity;
+	size_t _num;
+};
+
+
+///	extracts the unique edges and faces of an unstructured VTK cell list.
+/**	All elements are stored as flat index arrays (2 indices per edge, 3 per
+ * triangle, ...). Edges and faces are deduplicated through canonical keys, so
+ * faces shared by two cells are only stored once, regardless of the corner
+ * order in which each cell references them.*/
+class TopologyBuilder{
+public:
+	TopologyBuilder() : _num_skipped(0){}
+
+	void clear(){
+		_edges.clear();
+		_triangles.clear();
+		_quadrilaterals.clear();
+		_tets.clear();
+		_hexahedrons.clear();
+		_prisms.clear();
+		_pyramids.clear();
+		_cell_elements.clear();
+		_num_skipped = 0;
+	}
+
+	///	conn, offsets and types as given in the <Cells> section of a vtu file
+	/**	offsets[i] is the end of cell i in conn. Cells of unknown type are
+	 * skipped and counted in num_skipped_cells().*/
+	void build(const std::vector<unsigned> &conn, const std::vector<unsigned> &offsets,
+			   const std::vector<unsigned> &types){
+		assert(offsets.size() == types.size());
+		clear();
+
+	//	estimate the number of unique elements from the number of elements per
+	//	cell in typical meshes, so that the hash tables rarely have to grow.
+		size_t num_edges = 0, num_tris = 0, num_quads = 0;
+		for(size_t i = 0; i < types.size(); ++i){
+			switch(types[i]){
+				case VTK_CELL_LINE:			num_edges += 2; break;
+				case VTK_CELL_TRIANGLE:		num_edges += 3; num_tris += 2; break;
+				case VTK_CELL_QUAD:			num_edges += 4; num_quads += 2; break;
+				case VTK_CELL_TETRA:		num_edges += 3; num_tris += 4; break;
+				case VTK_CELL_HEXAHEDRON:	num_edges += 6; num_quads += 6; break;
+				case VTK_CELL_WEDGE:		num_edges += 4; num_tris += 2; num_quads += 3; break;
+				case VTK_CELL_PYRAMID:		num_edges += 4; num_tris += 4; num_quads += 1; break;
+				default: break;
+			}
+		}
+		_edges.reserve(num_edges / 2);
+		_triangles.reserve(num_tris / 2);
+		_quadrilaterals.reserve(num_quads / 2);
+		_cell_elements.reserve(types.size());
+
+		unsigned begin = 0;
+		for(size_t i = 0; i < types.size(); ++i){
+			const unsigned* c = conn.empty() ? NULL : &conn[0] + begin;
+			const unsigned num_corners = offsets[i] - begin;
+			begin = offsets[i];
+
+			int elem = -1;
+			switch(types[i]){
+				case VTK_CELL_LINE:
+					if(num_corners == 2) elem = (int)_edges.insert(c);
+					break;
+
+				case VTK_CELL_TRIANGLE:
+					if(num_corners == 3) elem = add_triangle(c);
+					break;
+
+				case VTK_CELL_QUAD:
+					if(num_corners == 4) elem = add_quadrilateral(c);
+					break;
+
+				case VTK_CELL_TETRA:
+					if(num_corners == 4) elem = add_tetrahedron(c);
+					break;
+
+				case VTK_CELL_HEXAHEDRON:
+					if(num_corners == 8) elem = add_hexahedron(c);
+					break;
+
+				case VTK_CELL_WEDGE:
+					if(num_corners == 6) elem = add_prism(c);
+					break;
+
+				case VTK_CELL_PYRAMID:
+					if(num_corners == 5) elem = add_pyramid(c);
+					break;
+
+				default:
+					break;
+			}
+
+			if(elem < 0){
+				++_num_skipped;
+			}
+			_cell_elements.push_back(elem);
+		}
+	}
+
+	size_t num_edges() const			{return _edges.size();}
+	size_t num_triangles() const		{return _triangles.size();}
+	size_t num_quadrilaterals() const	{return _quadrilaterals.size();}
+	size_t num_tetrahedrons() const		{return _tets.size() / 4;}
+	size_t num_hexahedrons() const		{return _hexahedrons.size() / 8;}
+	size_t num_prisms() const			{return _prisms.size() / 6;}
+	size_t num_pyramids() const			{return _pyramids.size() / 5;}
+	size_t num_faces() const			{return num_triangles() + num_quadrilaterals();}
+	size_t num_volumes() const			{return num_tetrahedrons() + num_hexahedrons()
+												+ num_prisms() + num_pyramids();}
+	size_t num_skipped_cells() const	{return _num_skipped;}
+
+	///	index of the element created for the i-th cell in the array of its type, -1 if skipped
+	/**	Cells of a surface type index the deduplicated edges(), triangles() or
+	 * quadrilaterals(), so that cell data can be mapped onto the created elements.*/
+	int cell_element(size_t i) const	{return _cell_elements[i];}
+
+	///	flat corner arrays
+	const std::vector<unsigned>& edges() const			{return _edges.corners();}
+	const std::vector<unsigned>& triangles() const		{return _triangles.corners();}
+	const std::vector<unsigned>& quadrilaterals() const	{return _quadrilaterals.corners();}
+	const std::vector<unsigned>& tetrahedrons() const	{return _tets;}
+	const std::vector<unsigned>& hexahedrons() const	{return _hexahedrons;}
+	const std::vector<unsigned>& prisms() const			{return _prisms;}
+	const std::vector<unsigned>& pyramids() const		{return _pyramids;}
+
+private:
+	void add_edge(const unsigned* c, unsigned i0, unsigned i1){
+		unsigned e[2] = {c[i0], c[i1]};
+		_edges.insert(e);
+	}
+
+	void add_triangle(const unsigned* c, unsigned i0, unsigned i1, unsigned i2){
+		unsigned t[3] = {c[i0], c[i1], c[i2]};
+		_triangles.insert(t);
+	}
+
+	void add_quadrilateral(const unsigned* c, unsigned i0, unsigned i1,
+						   unsigned i2, unsigned i3){
+		unsigned q[4] = {c[i0], c[i1], c[i2], c[i3]};
+		_quadrilaterals.insert(q);
+	}
+
+	int add_triangle(const unsigned* c){
+		add_edge(c, 0, 1); add_edge(c, 1, 2); add_edge(c, 2, 0);
+		return (int)_triangles.insert(c);
+	}
+
+	int add_quadrilateral(const unsigned* c){
+		add_edge(c, 0, 1); add_edge(c, 1, 2); add_edge(c, 2, 3); add_edge(c, 3, 0);
+		return (int)_quadrilaterals.insert(c);
+	}
+
+	int add_tetrahedron(const unsigned* c){
+		add_edge(c, 0, 1); add_edge(c, 0, 2); add_edge(c, 1, 2);
+		add_edge(c, 0, 3); add_edge(c, 1, 3); add_edge(c, 2, 3);
+
+		add_triangle(c, 0, 2, 1);
+		add_triangle(c, 0, 1, 3);
+		add_triangle(c, 1, 2, 3);
+		add_triangle(c, 0, 3, 2);
+
+		_tets.insert(_tets.end(), c, c + 4);
+		return (int)(_tets.size() / 4 - 1);
+	}
+
+	int add_hexahedron(const unsigned* c){
+		add_edge(c, 0, 1); add_edge(c, 1, 2); add_edge(c, 2, 3); add_edge(c, 3, 0);
+		add_edge(c, 4, 5); add_edge(c, 5, 6); add_edge(c, 6, 7); add_edge(c, 7, 4);
+		add_edge(c, 0, 4); add_edge(c, 1, 5); add_edge(c, 2, 6); add_edge(c, 3, 7);
+
+		add_quadrilateral(c, 0, 3, 2, 1);
+		add_quadrilateral(c, 4, 5, 6, 7);
+		add_quadrilateral(c, 0, 1, 5, 4);
+		add_quadrilateral(c, 1, 2, 6, 5);
+		add_quadrilateral(c, 2, 3, 7, 6);
+		add_quadrilateral(c, 3, 0, 4, 7);
+
+		_hexahedrons.insert(_hexahedrons.end(), c, c + 8);
+		return (int)(_hexahedrons.size() / 8 - 1);
+	}
+
+	int add_prism(const unsigned* c){
+		add_edge(c, 0, 1); add_edge(c, 0, 2); add_edge(c, 1, 2);
+		add_edge(c, 0, 3); add_edge(c, 1, 4); add_edge(c, 2, 5);
+		add_edge(c, 3, 4); add_edge(c, 3, 5); add_edge(c, 4, 5);
+
+		add_triangle(c, 0, 2, 1);
+		add_triangle(c, 3, 4, 5);
+
+		add_quadrilateral(c, 0, 1, 4, 3);
+		add_quadrilateral(c, 1, 2, 5, 4);
+		add_quadrilateral(c, 2, 0, 3, 5);
+
+		_prisms.insert(_prisms.end(), c, c + 6);
+		return (int)(_prisms.size() / 6 - 1);
+	}
+
+	int add_pyramid(const unsigned* c){
+		add_edge(c, 0, 1); add_edge(c, 1, 2); add_edge(c, 2, 3); add_edge(c, 3, 0);
+		add_edge(c, 0, 4); add_edge(c, 1, 4); add_edge(c, 2, 4); add_edge(c, 3, 4);
+
+		add_triangle(c, 0, 1, 4);
+		add_triangle(c, 1, 2, 4);
+		add_triangle(c, 2, 3, 4);
+		add_triangle(c, 3, 0, 4);
+
+		add_quadrilateral(c, 0, 3, 2, 1);
+
+		_pyramids.insert(_pyramids.end(), c, c + 5);
+		return (int)(_pyramids.size() / 5 - 1);
+	}
+
+	UniqueElementSet<2> _edges;
+	UniqueElementSet<3> _triangles;
+	UniqueElementSet<4> _quadrilaterals;
+	std::vector<unsigned> _tets;
+	std::vector<unsigned> _hexahedrons;
+	std::vector<unsigned> _prisms;
+	std::vector<unsigned> _pyramids;
+	std::vector<int> _cell_elements;
+	size_t _num_skipped;
+};
+
+#endif //guard
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+
+#ifndef __CPP__EMVIS_ug_bridge_stl
+#define __CPP__EMVIS_ug_bridge_stl
+
+#include <sstream>
+#include <vector>
+#include "stl_reader.h"
+#include "../scene/bulk_grid_builder.h"
+#include "../util/frame_profiler.h"
+
+////////////////////////////////////////////////////////////////////////
+///	loads an ascii or binary stl file into the grid and subset handler of an LGObject.
+/**	Equal triangle corners are welded by stl_reader, each solid of the file
+ * is assigned to a subset of its own.*/
+bool LoadSTLObjectFromFile(LGObject* pObjOut, const char* filename)
+{
+	using namespace ug;
+	PROFILE_FUNC();
+	FRAME_PROFILE_STAGE(PS_LOAD);
+	TRACE_SCOPE("LoadSTLObjectFromFile");
+
+	std::vector<float> coords, normals;
+	std::vector<unsigned int> tris, solids;
+
+	try{
+		stl_reader::ReadStlFile(filename, coords, normals, tris, solids);
+	}
+	catch(std::exception& err){
+		UG_LOG("ERROR in LoadSTLObjectFromFile: " << err.what() << std::endl);
+		return false;
+	}
+
+	Grid& grid = pObjOut->grid();
+	SubsetHandler& sh = pObjOut->subset_handler();
+
+	BulkGridBuilder builder(grid);
+	builder.reserve(coords.size() / 3, 0, tris.size() / 3, 0);
+	if(!coords.empty())
+		builder.add_vertices(&coords.front(), coords.size() / 3);
+	if(!tris.empty())
+		builder.add_elements<Triangle>(&tris.front(), tris.size() / 3);
+	builder.finish();
+
+	std::vector<Face*>& faces = builder.faces();
+	for(size_t si = 0; si + 1 < solids.size(); ++si){
+		std::stringstream name;
+		name << "solid " << si;
+		sh.subset_info(si).name = name.str();
+		if(solids[si] < solids[si + 1])
+			sh.assign_subset(faces.begin() + solids[si], faces.begin() + solids[si + 1], si);
+	}
+
+	return true;
+}
+
+#endif //guard
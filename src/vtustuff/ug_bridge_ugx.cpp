@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+
+#ifndef __CPP__EMVIS_ug_bridge_ugx
+#define __CPP__EMVIS_ug_bridge_ugx
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "ugx_object_reader.hpp"
+#include "ugx_stream_writer.hpp"
+
+///	appends the vertex indices of elem to indsOut and assigns the next element index
+template <class TElem>
+static void append_ugx_element(std::vector<int>& indsOut, TElem* elem, int& elemIndex,
+							   ug::Grid::AttachmentAccessor<ug::Vertex, ug::AInt>& aaVrtIndex,
+							   ug::Grid::AttachmentAccessor<TElem, ug::AInt>& aaElemIndex)
+{
+	for(size_t i = 0; i < elem->num_vertices(); ++i)
+		indsOut.push_back(aaVrtIndex[elem->vertex(i)]);
+	aaElemIndex[elem] = elemIndex++;
+}
+
+template <class TElem>
+static void collect_subset_elements(std::vector<int>& indsOut, ug::SubsetHandler& sh, int si,
+									ug::Grid::AttachmentAccessor<TElem, ug::AInt>& aaIndex)
+{
+	typedef typename ug::geometry_traits<TElem>::iterator iter_t;
+	indsOut.clear();
+	for(iter_t iter = sh.begin<TElem>(si); iter != sh.end<TElem>(si); ++iter){
+		if(aaIndex[*iter] >= 0)
+			indsOut.push_back(aaIndex[*iter]);
+	}
+}
+
+bool SaveLGObjectToUGX(LGObject* obj, const char* filename, bool binary)
+{
+	using namespace ug;
+	PROFILE_FUNC();
+
+	UGXStreamWriter out(filename, binary);
+	if(!out.good()){
+		UG_LOG("ERROR in SaveLGObjectToUGX: could not open " << filename << std::endl);
+		return false;
+	}
+
+	Grid& grid = obj->grid();
+	Grid::VertexAttachmentAccessor<APosition> aaPos(grid, aPosition);
+
+//	file indices of all elements, -1 for elements which are not written
+	AInt aIndex;
+	grid.attach_to_vertices_dv(aIndex, -1);
+	grid.attach_to_edges_dv(aIndex, -1);
+	grid.attach_to_faces_dv(aIndex, -1);
+	grid.attach_to_volumes_dv(aIndex, -1);
+	Grid::AttachmentAccessor<Vertex, AInt> aaVrtIndex(grid, aIndex);
+	Grid::AttachmentAccessor<Edge, AInt> aaEdgeIndex(grid, aIndex);
+	Grid::AttachmentAccessor<Face, AInt> aaFaceIndex(grid, aIndex);
+	Grid::AttachmentAccessor<Volume, AInt> aaVolIndex(grid, aIndex);
+
+	std::vector<double> coords;
+	coords.reserve(3 * grid.num_vertices());
+	int numVrts = 0;
+	for(VertexIterator iter = grid.begin<Vertex>(); iter != grid.end<Vertex>(); ++iter){
+		const vector3& p = aaPos[*iter];
+		coords.push_back(p.x());
+		coords.push_back(p.y());
+		coords.push_back(p.z());
+		aaVrtIndex[*iter] = numVrts++;
+	}
+
+	SubsetHandler& sh = obj->subset_handler();
+	UGXMetadata meta;
+	meta.num_vertices = numVrts;
+	meta.num_edges = grid.num_edges();
+	meta.num_faces = grid.num_faces();
+	meta.num_volumes = grid.num<Tetrahedron>() + grid.num<Hexahedron>()
+					 + grid.num<Prism>() + grid.num<Pyramid>();
+	meta.has_bbox = (numVrts > 0);
+	for(size_t i = 0; i < coords.size(); ++i){
+		double& bmin = meta.bbox_min[i % 3];
+		double& bmax = meta.bbox_max[i % 3];
+		if(i < 3 || coords[i] < bmin) bmin = coords[i];
+		if(i < 3 || coords[i] > bmax) bmax = coords[i];
+	}
+	for(int si = 0; si < sh.num_subsets(); ++si)
+		meta.subset_names.push_back(sh.subset_info(si).name);
+
+	out.begin_grid();
+	out.write_metadata(meta);
+	out.write_vertices(coords.empty() ? NULL : &coords.front(), numVrts);
+	std::vector<double>().swap(coords);
+
+//	elements are written block by block, their file indices follow the order of the blocks
+	std::vector<int> inds;
+	int numEdges = 0;
+	inds.reserve(2 * grid.num_edges());
+	for(EdgeIterator iter = grid.begin<Edge>(); iter != grid.end<Edge>(); ++iter)
+		append_ugx_element(inds, *iter, numEdges, aaVrtIndex, aaEdgeIndex);
+	out.write_indices("edges", inds);
+
+	int numFaces = 0;
+	const size_t faceCorners[] = {3, 4};
+	const char* faceTags[] = {"triangles", "quadrilaterals"};
+	for(int i = 0; i < 2; ++i){
+		inds.clear();
+		for(FaceIterator iter = grid.begin<Face>(); iter != grid.end<Face>(); ++iter){
+			if((*iter)->num_vertices() == faceCorners[i])
+				append_ugx_element(inds, *iter, numFaces, aaVrtIndex, aaFaceIndex);
+		}
+		out.write_indices(faceTags[i], inds);
+	}
+
+	int numVols = 0;
+	const int volTypes[] = {ROID_TETRAHEDRON, ROID_HEXAHEDRON, ROID_PRISM, ROID_PYRAMID};
+	const char* volTags[] = {"tetrahedrons", "hexahedrons", "prisms", "pyramids"};
+	for(int i = 0; i < 4; ++i){
+		inds.clear();
+		for(VolumeIterator iter = grid.begin<Volume>(); iter != grid.end<Volume>(); ++iter){
+			if((*iter)->reference_object_id() == volTypes[i])
+				append_ugx_element(inds, *iter, numVols, aaVrtIndex, aaVolIndex);
+		}
+		out.write_indices(volTags[i], inds);
+	}
+	if(numVols < (int)grid.num_volumes()){
+		UG_LOG("WARNING in SaveLGObjectToUGX: skipped " << grid.num_volumes() - numVols
+			   << " volumes of unsupported type.\n");
+	}
+
+	out.begin_subset_handler("defSH");
+	for(int si = 0; si < sh.num_subsets(); ++si){
+		const SubsetInfo& info = sh.subset_info(si);
+		const float color[] = {info.color.x(), info.color.y(), info.color.z(), info.color.w()};
+		out.begin_subset(info.name, color, info.subsetState);
+
+		collect_subset_elements<Vertex>(inds, sh, si, aaVrtIndex);
+		out.write_subset_elements("vertices", inds);
+		collect_subset_elements<Edge>(inds, sh, si, aaEdgeIndex);
+		out.write_subset_elements("edges", inds);
+		collect_subset_elements<Face>(inds, sh, si, aaFaceIndex);
+		out.write_subset_elements("faces", inds);
+		collect_subset_elements<Volume>(inds, sh, si, aaVolIndex);
+		out.write_subset_elements("volumes", inds);
+
+		out.end_subset();
+	}
+	out.end_subset_handler();
+	out.end_grid();
+	const bool written = out.close();
+
+	grid.detach_from_vertices(aIndex);
+	grid.detach_from_edges(aIndex);
+	grid.detach_from_faces(aIndex);
+	grid.detach_from_volumes(aIndex);
+
+	if(!written){
+		UG_LOG("ERROR in SaveLGObjectToUGX: could not write " << filename << std::endl);
+		return false;
+	}
+	return true;
+}
+
+#endif //guard
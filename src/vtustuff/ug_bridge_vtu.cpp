@@ -1,10 +1,13 @@
 #ifndef __CPP__EMVIS_ug_bridge_vtu
 #define __CPP__EMVIS_ug_bridge_vtu
 
+#include <cstdlib>
+#include <stdint.h>
 #include <cstring>
 #include <string>
 //#include "../scene/lg_object.h"
-#include "vtu_ugx_converter.hpp"
+#include "vtu_object_reader.hpp"
+#include "../util/frame_profiler.h"
 #include "lib_grid/file_io/file_io.h"
 //#include "lib_grid/file_io/file_io_art.h"
 //include "lib_grid/file_io/file_io_dump.h"
@@ -15,36 +18,6 @@
 
 #include "lib_grid/file_io/file_io_vtu.h"
 
-void test_ug_vtu(ug::Grid &grid, ug::SubsetHandler &sh){
-	ug::GridReaderVTU reader;
-	bool status = reader.parse_file("test.vtu");
-	if(!status){
-		UG_LOG("error in parse file\n");
-	}
-	else{
-		UG_LOG("ug::GridReaderVTU successful\n");
-	}
-
-	//ug::Grid grid;
-	//ug::SubsetHandler sh;
-
-	reader.grid(grid, 0, ug::aPosition);
-	reader.subset_handler(sh, 0, 0);
-
-
-	ug::GridWriterVTU writer;
-	std::ofstream out("test_output.vtu");
-
-	writer.set_stream(&out);
-
-	writer.new_piece(grid, &sh, ug::aPosition);
-
-	writer.finish();
-
-	SaveGridToUGX(grid, sh, "test_output.ugx", ug::aPosition);	
-}
-
-
 using namespace std;
 using namespace ug;
 
@@ -87,34 +60,147 @@ void subset_handler_elements(ISubsetHandler& shOut,
 	}
 }
 
-bool LoadVTUObjectFromFile(LGObject* pObjOut, const char* filename)
+///	returns the element created for the given cell, NULL if it is not of dimension elemDim
+static GridObject* vtu_cell_element(const TopologyBuilder& topology, unsigned type, int elem,
+									int elemDim, std::vector<Face*>& faces,
+									std::vector<Volume*>& volumes)
 {
-	PROFILE_FUNC();
+	if(elem < 0)
+		return NULL;
+
+	if(elemDim == 2){
+		switch(type){
+			case VTK_CELL_TRIANGLE:	return faces[elem];
+			case VTK_CELL_QUAD:		return faces[topology.num_triangles() + elem];
+			default:				return NULL;
+		}
+	}
 
-	UG_LOG("LoadVTUObjectFromFile.\n");
+//	volumes are created as tetrahedrons, hexahedrons, prisms, pyramids.
+//	The cases fall through to sum up the preceding blocks.
+	size_t offset = 0;
+	switch(type){
+		case VTK_CELL_PYRAMID:		offset += topology.num_prisms();
+		case VTK_CELL_WEDGE:		offset += topology.num_hexahedrons();
+		case VTK_CELL_HEXAHEDRON:	offset += topology.num_tetrahedrons();
+		case VTK_CELL_TETRA:		return volumes[offset + elem];
+		default:					return NULL;
+	}
+}
 
-	//PARSE
+template <class TElem>
+static void fill_cell_field(Grid& grid, const LGObject::DataField& field,
+							const VTUDataArray& arr, const std::vector<GridObject*>& cellElems)
+{
+	if(field.aNumber){
+		Grid::AttachmentAccessor<TElem, ANumber> aaVal(grid, *field.aNumber);
+		for(size_t j = 0; j < cellElems.size(); ++j){
+			if(cellElems[j])
+				aaVal[static_cast<TElem*>(cellElems[j])] = arr.values[j];
+		}
+	}
+	else{
+		Grid::AttachmentAccessor<TElem, AVector3> aaVec(grid, *field.aVector);
+		for(size_t j = 0; j < cellElems.size(); ++j){
+			if(cellElems[j])
+				aaVec[static_cast<TElem*>(cellElems[j])] = vector3(arr.values[3*j], arr.values[3*j+1],
+																   arr.values[3*j+2]);
+		}
+	}
+}
 
-	PARSE P(filename);
-	std::pair<unsigned, unsigned> num_data = P.parse_header();
+///	copies vtu PointData and CellData into data fields of the object
+static void AttachVTUData(LGObject* pObj, const std::vector<VTUDataArray>& pointData,
+						  const std::vector<VTUDataArray>& cellData,
+						  const TopologyBuilder& topology, const std::vector<unsigned>& types,
+						  std::vector<Vertex*>& vertices, std::vector<Face*>& faces,
+						  std::vector<Volume*>& volumes)
+{
+	Grid& grid = pObj->grid();
+
+	for(size_t i = 0; i < pointData.size(); ++i){
+		const VTUDataArray& arr = pointData[i];
+		LGObject::DataField* field = pObj->add_data_field(arr.name.c_str(), arr.num_components, 0);
+		if(!field){
+			UG_LOG("  skipping PointData " << arr.name << " with " << arr.num_components << " components\n");
+			continue;
+		}
 
-	std::vector<std::vector<double> > point_data(num_data.first);
-	P.parse_point_data(point_data, num_data.first);
+		if(field->aNumber){
+			Grid::VertexAttachmentAccessor<ANumber> aaVal(grid, *field->aNumber);
+			for(size_t j = 0; j < vertices.size(); ++j)
+				aaVal[vertices[j]] = arr.values[j];
+		}
+		else{
+			Grid::VertexAttachmentAccessor<AVector3> aaVec(grid, *field->aVector);
+			for(size_t j = 0; j < vertices.size(); ++j)
+				aaVec[vertices[j]] = vector3(arr.values[3*j], arr.values[3*j+1], arr.values[3*j+2]);
+		}
+		UG_LOG("  PointData " << arr.name << " (" << arr.num_components << " components)\n");
+	}
 
-	std::vector<std::vector<double> > points(num_data.first);
-	P.parse_points(points, num_data.first);
+	const int elemDim = topology.num_volumes() > 0 ? 3 : 2;
+	std::vector<GridObject*> cellElems;
+	if(!cellData.empty()){
+		cellElems.resize(types.size());
+		for(size_t j = 0; j < types.size(); ++j){
+			cellElems[j] = vtu_cell_element(topology, types[j], topology.cell_element(j),
+											elemDim, faces, volumes);
+		}
+	}
 
-	std::vector<unsigned> conn; //(num_data.second);
-	P.parse_connectivity(conn);
+	for(size_t i = 0; i < cellData.size(); ++i){
+		const VTUDataArray& arr = cellData[i];
+		LGObject::DataField* field = pObj->add_data_field(arr.name.c_str(), arr.num_components, elemDim);
+		if(!field){
+			UG_LOG("  skipping CellData " << arr.name << " with " << arr.num_components << " components\n");
+			continue;
+		}
 
-	std::vector<unsigned> offsets;
-	P.parse_offsets(offsets, num_data.second);
+		if(elemDim == 3)
+			fill_cell_field<Volume>(grid, *field, arr, cellElems);
+		else
+			fill_cell_field<Face>(grid, *field, arr, cellElems);
+		UG_LOG("  CellData " << arr.name << " (" << arr.num_components << " components)\n");
+	}
+}
 
-	std::vector<unsigned> types;
-	P.parse_types(types);
+bool LoadVTUObjectFromFile(LGObject* pObjOut, const char* filename)
+{
+	PROFILE_FUNC();
+	FRAME_PROFILE_STAGE(PS_LOAD);
+	TRACE_SCOPE("LoadVTUObjectFromFile");
 
-	P.end_file();
+	UG_LOG("LoadVTUObjectFromFile.\n");
 
+	std::vector<double> points;
+	std::vector<unsigned> conn, offsets, types;
+	std::vector<VTUDataArray> point_data, cell_data;
+
+	try{
+		VTUObjectReader reader;
+		if(!reader.parse_file(filename)){
+			UG_LOG("ERROR in LoadVTUObjectFromFile: File not found: " << filename << std::endl);
+			return false;
+		}
+		if(reader.num_grids() < 1){
+			UG_LOG("ERROR in LoadVTUObjectFromFile: File contains no piece.\n");
+			return false;
+		}
+		if(!reader.read_pieces(points, conn, offsets, types, point_data, cell_data))
+			return false;
+	}
+	catch(UGError& err){
+		UG_LOG("ERROR in LoadVTUObjectFromFile: " << err.get_msg() << std::endl);
+		return false;
+	}
+	catch(std::exception& err){
+		UG_LOG("ERROR in LoadVTUObjectFromFile: " << err.what() << std::endl);
+		return false;
+	}
+
+	CombineVTUComponentArrays(point_data);
+	CombineVTUComponentArrays(cell_data);
 
 	//FILL datastructures
 
@@ -122,111 +208,28 @@ bool LoadVTUObjectFromFile(LGObject* pObjOut, const char* filename)
 	SubsetHandler& sh = pObjOut->subset_handler();
 	Selector& sel = pObjOut->selector(); 
 
-
-	//to be removed
-	test_ug_vtu(grid, sh);
-	//end of to be removed
-
-
-
 	pObjOut->m_fileName = filename;
+	pObjOut->clear_data_fields();
 
 	MyGridEntry grid_entry;
 
-	uint gridopts = grid.get_options();
-	grid.set_options(GRIDOPT_NONE);
-
-	if(!grid.has_vertex_attachment(aPosition)){
-		grid.attach_to_vertices(aPosition);
-	}
+	BulkGridBuilder builder(grid);
 
-	Grid::VertexAttachmentAccessor<APosition> aaPos(grid, aPosition);
-	
 	grid_entry.grid = &grid;
 
+	TopologyBuilder topology;
+	BuildVTUGrid(builder, topology, points, conn, offsets, types);
+
 	vector<Vertex*>& vertices = grid_entry.vertices;
 	vector<Edge*>& edges = grid_entry.edges;
 	vector<Face*>& faces = grid_entry.faces;
 	vector<Volume*>& volumes = grid_entry.volumes;
+	vertices.swap(builder.vertices());
+	edges.swap(builder.edges());
+	faces.swap(builder.faces());
+	volumes.swap(builder.volumes());
 
-	WRITE W("");
-	W.assemble_elements(conn, offsets, types);
-
-/*
-	create_vertices(vertices, grid, curNode, aaPos);
-	create_edges(edges, grid, curNode, vertices);
-	create_triangles(faces, grid, curNode, vertices);
-	create_quadrilaterals(faces, grid, curNode, vertices);
-	create_tetrahedrons(volumes, grid, curNode, vertices);
-	//create_hexahedrons(volumes, grid, curNode, vertices); //NOT YET
-	create_prisms(volumes, grid, curNode, vertices);
-	create_pyramids(volumes, grid, curNode, vertices);
-	//create_octahedrons(volumes, grid, curNode, vertices); //NOT YET
-*/
-
-	//create vertices
-
-	for(unsigned i = 0; i < points.size(); ++i){
-		RegularVertex* vrt = *grid.create<RegularVertex>();
-		MathVector<3, double> p;
-		for(unsigned j = 0; j < points[i].size(); ++j){ //TODO: no MathVector(std::vector) constructor?!
-			p[j] = points[i][j];
-		}
-		aaPos[vrt] = p;
-		vertices.push_back(vrt);
-	}
-
-	//create edges
-
-	for(unsigned i = 0; i < W._edges.size(); ++i){
-		edges.push_back(*grid.create<RegularEdge>(EdgeDescriptor(vertices[W._edges[i].first], vertices[W._edges[i].second])));
-	}
-
-/*
-	std::vector<std::vector<unsigned> > _triangles;
-	std::vector<std::vector<unsigned> > _quadrilaterals;
-	std::vector<std::vector<unsigned> > _tets;
-	std::vector<std::vector<unsigned> > _prisms;
-	std::vector<std::vector<unsigned> > _pyramids;
-*/
-
-
-	//create triangles
-
-	for(unsigned i = 0; i < W._triangles.size(); ++i){
-		faces.push_back(*grid.create<Triangle>(TriangleDescriptor(vertices[W._triangles[i][0]], vertices[W._triangles[i][1]], vertices[W._triangles[i][2]])));
-	}
-
-	//create quads
-
-	for(unsigned i = 0; i < W._quadrilaterals.size(); ++i){
-		faces.push_back(*grid.create<Quadrilateral>(QuadrilateralDescriptor(vertices[W._quadrilaterals[i][0]], vertices[W._quadrilaterals[i][1]],
-																			vertices[W._quadrilaterals[i][2]], vertices[W._quadrilaterals[i][3]])));
-	}
-
-	//create tets
-
-	for(unsigned i = 0; i < W._tets.size(); ++i){
-		volumes.push_back(*grid.create<Tetrahedron>(TetrahedronDescriptor(vertices[W._tets[i][0]], vertices[W._tets[i][1]],
-																		  vertices[W._tets[i][2]], vertices[W._tets[i][3]])));
-	}
-
-	//create prisms
-
-	for(unsigned i = 0; i < W._prisms.size(); ++i){
-		volumes.push_back(*grid.create<Prism>(PrismDescriptor(vertices[W._prisms[i][0]], vertices[W._prisms[i][1]],
-															  vertices[W._prisms[i][2]], vertices[W._prisms[i][3]],
-															  vertices[W._prisms[i][4]], vertices[W._prisms[i][5]])));
-	}
-
-	//create pyramids
-
-	for(unsigned i = 0; i < W._pyramids.size(); ++i){
-		volumes.push_back(*grid.create<Pyramid>(PyramidDescriptor(vertices[W._pyramids[i][0]], vertices[W._pyramids[i][1]],
-															  	  vertices[W._pyramids[i][2]], vertices[W._pyramids[i][3]],
-															  	  vertices[W._pyramids[i][4]])));
-	}
-
+	AttachVTUData(pObjOut, point_data, cell_data, topology, types, vertices, faces, volumes);
 
 	unsigned subsetInd = 0;
 
@@ -265,7 +268,7 @@ bool LoadVTUObjectFromFile(LGObject* pObjOut, const char* filename)
 	grid_entry.selectorEntries.push_back(sel_entry);
 	
 
-	grid.set_options(gridopts);
+	builder.finish();
 
 	return true; //TODO
 }
@@ -0,0 +1,387 @@
+#ifndef __HPP__EMVIS_ugx_metadata
+#define __HPP__EMVIS_ugx_metadata
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <locale>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+///	what UGXFileInfo reports about the first grid of a ugx file, without loading it
+struct UGXMetadata{
+	UGXMetadata() : num_vertices(0), num_edges(0), num_faces(0), num_volumes(0), has_bbox(false){
+		for(int i = 0; i < 3; ++i){
+			bbox_min[i] = bbox_max[i] = 0;
+		}
+	}
+
+	std::string grid_name;
+	size_t num_vertices;
+	size_t num_edges;
+	size_t num_faces;
+	size_t num_volumes;
+	bool has_bbox;///< only known if the file carries a metadata header
+	double bbox_min[3];
+	double bbox_max[3];
+	std::vector<std::string> subset_names;///< subsets of the first subset handler
+
+	///	3, 2, 1 or 0, see UGXFileInfo::physical_grid_dimension. Requires has_bbox.
+	int physical_dimension() const{
+		double range[3], max_range = 0;
+		for(int i = 0; i < 3; ++i){
+			range[i] = bbox_max[i] - bbox_min[i];
+			if(range[i] > max_range) max_range = range[i];
+		}
+		const double small = 1e-12 * max_range;
+		for(int i = 2; i >= 0; --i){
+			if(range[i] > small) return i + 1;
+		}
+		return 0;
+	}
+
+	int topological_dimension() const{
+		if(num_volumes) return 3;
+		if(num_faces) return 2;
+		if(num_edges) return 1;
+		return 0;
+	}
+};
+
+///	escapes a string for an xml attribute value in double quotes.
+/**	If inComment is set, '-' is escaped as well, so that the value can't
+ * end or break the comment in which it is placed.*/
+inline std::string XMLEscape(const std::string &str, bool inComment = false){
+	std::string out;
+	out.reserve(str.size());
+	for(size_t i = 0; i < str.size(); ++i){
+		switch(str[i]){
+			case '&': out += "&amp;"; break;
+			case '<': out += "&lt;"; break;
+			case '>': out += "&gt;"; break;
+			case '"': out += "&quot;"; break;
+			case '-': out += inComment ? "&#45;" : "-"; break;
+			default: out += str[i];
+		}
+	}
+	return out;
+}
+
+///	reverts XMLEscape. Also resolves &apos; and decimal character references below 128.
+inline std::string XMLUnescape(const std::string &str){
+	static const char* entities[] = {"&amp;", "&lt;", "&gt;", "&quot;", "&apos;"};
+	static const char chars[] = {'&', '<', '>', '"', '\''};
+	std::string out;
+	out.reserve(str.size());
+	for(size_t i = 0; i < str.size(); ++i){
+		if(str[i] != '&'){
+			out += str[i];
+			continue;
+		}
+		bool resolved = false;
+		for(int j = 0; j < 5 && !resolved; ++j){
+			const size_t len = strlen(entities[j]);
+			if(str.compare(i, len, entities[j]) == 0){
+				out += chars[j];
+				i += len - 1;
+				resolved = true;
+			}
+		}
+		if(!resolved && str.compare(i, 2, "&#") == 0){
+			const size_t semi = str.find(';', i);
+			const long code = (semi == std::string::npos) ? 0 : strtol(str.c_str() + i + 2, NULL, 10);
+			if(code > 0 && code < 128){
+				out += (char)code;
+				i = semi;
+				resolved = true;
+			}
+		}
+		if(!resolved){
+			out += str[i];
+		}
+	}
+	return out;
+}
+
+///	the comment which UGXStreamWriter places right after the grid tag
+static const char* const UGX_METADATA_TAG = "!--emvis-ugx-meta";
+
+///	returns the metadata header for the given metadata, see UGXStreamWriter::write_metadata
+inline std::string UGXMetadataHeader(const UGXMetadata &meta){
+	std::ostringstream out;
+	out.imbue(std::locale::classic());
+	out.precision(17);
+	out << "<" << UGX_METADATA_TAG << " vertices=\"" << meta.num_vertices
+		<< "\" edges=\"" << meta.num_edges << "\" faces=\"" << meta.num_faces
+		<< "\" volumes=\"" << meta.num_volumes << "\"";
+	if(meta.has_bbox){
+		out << " bbox=\"" << meta.bbox_min[0] << " " << meta.bbox_min[1] << " " << meta.bbox_min[2]
+			<< " " << meta.bbox_max[0] << " " << meta.bbox_max[1] << " " << meta.bbox_max[2] << "\"";
+	}
+	out << " subsets=\"" << meta.subset_names.size() << "\"";
+	for(size_t i = 0; i < meta.subset_names.size(); ++i){
+		out << " subset_" << i << "=\"" << XMLEscape(meta.subset_names[i], true) << "\"";
+	}
+	out << " -->";
+	return out.str();
+}
+
+///	scans a ugx file for its metadata without building an xml document.
+/**	Files written by UGXStreamWriter carry a metadata header, then only the
+ * first few bytes are read. Otherwise the file is streamed block by block:
+ * the values of vertex and element nodes are only counted, not converted,
+ * and the scan stops after the subset handlers of the first grid.
+ * Constrained vertices, edges and faces are not counted by the scan.
+ *
+ * If only the number of vertices is required, pass verticesOnly: files
+ * without header are then only read up to the end of their first vertices
+ * node, and the other counts of such files stay 0.*/
+class UGXMetadataScanner{
+public:
+	bool scan(const std::string &filename, UGXMetadata &meta, bool verticesOnly = false){
+		meta = UGXMetadata();
+		_meta = &meta;
+		_vertices_only = verticesOnly;
+		_done = false;
+		_in_tag = false;
+		_counting = false;
+		_seen_grid = false;
+		_in_subset_handler = false;
+		_seen_subset_handler = false;
+		_num_subset_handlers = 0;
+		_tag.clear();
+
+		FILE* file = fopen(filename.c_str(), "rb");
+		if(!file){
+			return false;
+		}
+
+		std::vector<char> buf(1 << 18);
+		size_t num_read;
+		while(!_done && (num_read = fread(&buf[0], 1, buf.size(), file)) > 0){
+			process(&buf[0], &buf[0] + num_read);
+		}
+		fclose(file);
+		return _seen_grid;
+	}
+
+private:
+	void process(const char* c, const char* end){
+		for(; c < end && !_done; ++c){
+			if(_in_tag){
+				if(*c != '>'){
+					_tag.push_back(*c);
+					continue;
+				}
+			//	comments may contain '>'
+				if(_tag.compare(0, 3, "!--") == 0 && (_tag.size() < 5 || _tag.compare(_tag.size() - 2, 2, "--") != 0)){
+					_tag.push_back(*c);
+					continue;
+				}
+				_in_tag = false;
+				process_tag();
+				_tag.clear();
+			}
+			else if(*c == '<'){
+				_in_tag = true;
+				_prev_space = true;
+			}
+			else if(_counting){
+				const bool space = (*c == ' ' || *c == '\n' || *c == '\t' || *c == '\r');
+				if(_base64){
+					if(!space && *c != '=') ++_count;
+				}
+				else if(_prev_space && !space){
+					++_count;
+				}
+				_prev_space = space;
+			}
+		}
+	}
+
+	static std::string tag_name(const std::string &tag){
+		size_t end = tag.find_first_of(" \t\r\n/");
+		return tag.substr(0, end);
+	}
+
+	static std::map<std::string, std::string> attributes(const std::string &tag){
+		std::map<std::string, std::string> attribs;
+		size_t pos = tag.find_first_of(" \t\r\n");
+		while(pos != std::string::npos){
+			size_t eq = tag.find('=', pos);
+			if(eq == std::string::npos) break;
+			size_t q0 = tag.find('"', eq);
+			if(q0 == std::string::npos) break;
+			size_t q1 = tag.find('"', q0 + 1);
+			if(q1 == std::string::npos) break;
+
+			size_t name_begin = tag.find_first_not_of(" \t\r\n", pos);
+			attribs[tag.substr(name_begin, eq - name_begin)] = XMLUnescape(tag.substr(q0 + 1, q1 - q0 - 1));
+			pos = q1 + 1;
+		}
+		return attribs;
+	}
+
+	///	number of values per element of a node, 0 if the node does not hold elements
+	static int values_per_element(const std::string &name, size_t UGXMetadata::* &counter){
+		static const char* names[] = {"edges", "constraining_edges", "triangles", "constraining_triangles",
+									  "quadrilaterals", "constraining_quadrilaterals", "tetrahedrons",
+									  "hexahedrons", "prisms", "pyramids", "octahedrons"};
+	//	see GridReaderUGX::create_octahedrons for the 6 corners of octahedrons
+		static const int corners[] = {2, 2, 3, 3, 4, 4, 4, 8, 6, 5, 6};
+		for(int i = 0; i < 11; ++i){
+			if(name == names[i]){
+				counter = (i < 2) ? &UGXMetadata::num_edges : (i < 6 ? &UGXMetadata::num_faces : &UGXMetadata::num_volumes);
+				return corners[i];
+			}
+		}
+		return 0;
+	}
+
+	void process_tag(){
+		if(_tag.empty() || _tag[0] == '?'){
+			return;
+		}
+
+		if(_tag.compare(0, strlen(UGX_METADATA_TAG), UGX_METADATA_TAG) == 0){
+			read_header();
+			return;
+		}
+		if(_tag[0] == '!'){
+			return;
+		}
+
+		if(_tag[0] == '/'){
+			const std::string name = tag_name(_tag.substr(1));
+			if(_counting){
+				finish_count();
+			}
+			if(name == "subset_handler"){
+				_in_subset_handler = false;
+			}
+			else if(name == "grid"){
+				_done = true;
+			}
+			return;
+		}
+
+		const std::string name = tag_name(_tag);
+		const bool self_closing = (_tag[_tag.size() - 1] == '/');
+
+		if(name == "grid"){
+			if(_seen_grid){
+				_done = true;
+				return;
+			}
+			_seen_grid = true;
+			_meta->grid_name = attributes(_tag)["name"];
+			return;
+		}
+
+	//	subset handlers follow the elements, everything after them is skipped
+		if(_seen_subset_handler && !_in_subset_handler && name != "subset_handler"){
+			_done = true;
+			return;
+		}
+
+		if(name == "subset_handler"){
+			_in_subset_handler = !self_closing;
+			_seen_subset_handler = true;
+			++_num_subset_handlers;
+			return;
+		}
+
+		if(_in_subset_handler){
+			if(name == "subset" && _num_subset_handlers == 1){
+				_meta->subset_names.push_back(attributes(_tag)["name"]);
+			}
+			return;
+		}
+
+		size_t UGXMetadata::* counter = NULL;
+		int num_values = 0;
+		std::map<std::string, std::string> attribs = attributes(_tag);
+		if(name == "vertices"){
+			counter = &UGXMetadata::num_vertices;
+			num_values = atoi(attribs["coords"].c_str());
+		}
+		else{
+			num_values = values_per_element(name, counter);
+		}
+
+		if(num_values > 0 && !self_closing){
+			_counting = true;
+			_count = 0;
+			_counter = counter;
+			_values_per_element = num_values;
+			_base64 = (attribs["format"] == "base64");
+			_value_size = (attribs["type"] == "Float64") ? 8 : 4;
+		}
+	}
+
+	void finish_count(){
+		size_t num_values = _count;
+		if(_base64){
+		//	4 characters encode 3 bytes
+			num_values = (_count * 3 / 4) / _value_size;
+		}
+		_meta->*_counter += num_values / _values_per_element;
+		_counting = false;
+		if(_vertices_only && _counter == &UGXMetadata::num_vertices){
+			_done = true;
+		}
+	}
+
+	void read_header(){
+		std::map<std::string, std::string> attribs = attributes(_tag);
+		_meta->num_vertices = strtoul(attribs["vertices"].c_str(), NULL, 10);
+		_meta->num_edges = strtoul(attribs["edges"].c_str(), NULL, 10);
+		_meta->num_faces = strtoul(attribs["faces"].c_str(), NULL, 10);
+		_meta->num_volumes = strtoul(attribs["volumes"].c_str(), NULL, 10);
+
+		if(attribs.count("bbox")){
+			std::istringstream in(attribs["bbox"]);
+			in.imbue(std::locale::classic());
+			in >> _meta->bbox_min[0] >> _meta->bbox_min[1] >> _meta->bbox_min[2]
+			   >> _meta->bbox_max[0] >> _meta->bbox_max[1] >> _meta->bbox_max[2];
+			_meta->has_bbox = !in.fail();
+		}
+
+		const size_t num_subsets = strtoul(attribs["subsets"].c_str(), NULL, 10);
+		for(size_t i = 0; i < num_subsets; ++i){
+			std::ostringstream key;
+			key << "subset_" << i;
+			_meta->subset_names.push_back(attribs[key.str()]);
+		}
+		_done = true;
+	}
+
+	UGXMetadata* _meta;
+	std::string _tag;
+	bool _vertices_only;
+	bool _done;
+	bool _in_tag;
+	bool _seen_grid;
+	bool _in_subset_handler;
+	bool _seen_subset_handler;
+	int _num_subset_handlers;
+
+	bool _counting;
+	bool _prev_space;
+	bool _base64;
+	size_t _count;
+	size_t _value_size;
+	int _values_per_element;
+	size_t UGXMetadata::* _counter;
+};
+
+///	convenience wrapper around UGXMetadataScanner
+inline bool ScanUGXMetadata(const std::string &filename, UGXMetadata &meta,
+							bool verticesOnly = false){
+	UGXMetadataScanner scanner;
+	return scanner.scan(filename, meta, verticesOnly);
+}
+
+#endif //guard
@@ -0,0 +1,218 @@
+#ifndef __HPP__EMVIS_ugx_object_reader
+#define __HPP__EMVIS_ugx_object_reader
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "parallel_tokenizer.hpp"
+#include "../scene/bulk_grid_builder.h"
+#include "../util/frame_profiler.h"
+#include "lib_grid/file_io/file_io_ugx.h"
+
+////////////////////////////////////////////////////////////////////////
+///	GridReaderUGX which tokenizes the element blocks of a grid on worker threads.
+/**	After rapidxml located the nodes, the values of all vertex- and element-nodes
+ * are split into chunks which are converted to flat number arrays in parallel.
+ * Only the creation of the grid elements is serial, in the order of the file,
+ * so that indices, subset handlers and selectors behave exactly as for
+ * GridReaderUGX::grid.
+ *
+ * Vertex and element nodes may also hold base64 encoded binary arrays, as
+ * written by UGXStreamWriter.*/
+class UGXObjectReader : public ug::GridReaderUGX
+{
+	public:
+	///	fills the grid like GridReaderUGX::grid
+	/**	Grids with constrained or constraining elements are read by
+	 * GridReaderUGX::grid, since their relations are resolved there.
+	 * numThreads == 0 uses all hardware threads.*/
+		bool grid_parallel(ug::Grid& gridOut, size_t index, ug::APosition& aPos,
+						   unsigned numThreads = 0);
+
+	protected:
+	///	an element node and the range of its chunks
+		struct ElementBlock{
+			rapidxml::xml_node<>*	node;
+			int						numCorners;///< 0 for vertices
+			size_t					firstChunk;
+			size_t					endChunk;
+		};
+
+		static int num_corners(const char* nodeName);
+
+		bool create_block(BulkGridBuilder& builder, size_t index, const ElementBlock& block,
+						  const std::vector<TokenChunk>& chunks);
+};
+
+///	returns the number of corners of the elements stored in a node with the given name,
+///	0 for vertices and -1 for nodes which are not read by grid_parallel.
+inline int UGXObjectReader::
+num_corners(const char* nodeName)
+{
+	if(strcmp(nodeName, "vertices") == 0)		return 0;
+	if(strcmp(nodeName, "edges") == 0)			return 2;
+	if(strcmp(nodeName, "triangles") == 0)		return 3;
+	if(strcmp(nodeName, "quadrilaterals") == 0)	return 4;
+	if(strcmp(nodeName, "tetrahedrons") == 0)	return 4;
+	if(strcmp(nodeName, "hexahedrons") == 0)	return 8;
+	if(strcmp(nodeName, "prisms") == 0)			return 6;
+	if(strcmp(nodeName, "pyramids") == 0)		return 5;
+	return -1;
+}
+
+inline bool UGXObjectReader::
+grid_parallel(ug::Grid& grid, size_t index, ug::APosition& aPos, unsigned numThreads)
+{
+	using namespace ug;
+	using namespace rapidxml;
+	PROFILE_FUNC();
+	FRAME_PROFILE_STAGE(PS_LOAD);
+	TRACE_SCOPE("UGXObjectReader::grid_parallel");
+
+	if(num_grids() <= index){
+		UG_LOG("  UGXObjectReader::grid_parallel: bad grid index!\n");
+		return false;
+	}
+
+	xml_node<>* gridNode = m_entries[index].node;
+
+//	collect the blocks and split their values into chunks
+	std::vector<ElementBlock> blocks;
+	std::vector<TokenChunk> chunks;
+	for(xml_node<>* curNode = gridNode->first_node(); curNode; curNode = curNode->next_sibling()){
+		const char* name = curNode->name();
+		if(strncmp(name, "constrain", 9) == 0)
+			return GridReaderUGX::grid(grid, index, aPos);
+
+		ElementBlock block;
+		block.node = curNode;
+		block.numCorners = num_corners(name);
+		block.firstChunk = chunks.size();
+		if(block.numCorners >= 0){
+			const char* begin = curNode->value();
+			const char* end = begin + curNode->value_size();
+			xml_attribute<>* format = curNode->first_attribute("format");
+			if(format && strcmp(format->value(), "base64") == 0)
+				SplitBase64Chunks(chunks, begin, end, block.numCorners == 0);
+			else
+				SplitTokenChunks(chunks, begin, end, block.numCorners == 0);
+		}
+		block.endChunk = chunks.size();
+		blocks.push_back(block);
+	}
+
+	TokenizeChunksParallel(chunks, numThreads);
+
+//	grid options are disabled while the builder creates the elements
+	BulkGridBuilder builder(grid, aPos);
+
+	m_entries[index].grid = &grid;
+
+	for(size_t i = 0; i < blocks.size(); ++i){
+		const ElementBlock& block = blocks[i];
+		const char* name = block.node->name();
+		bool bSuccess = true;
+		if(block.numCorners >= 0)
+			bSuccess = create_block(builder, index, block, chunks);
+		else if(strcmp(name, "octahedrons") == 0)
+			bSuccess = create_octahedrons(m_entries[index].volumes, grid, block.node,
+										  m_entries[index].vertices);
+		else if(strcmp(name, "vertex_attachment") == 0)
+			bSuccess = read_attachment<Vertex>(grid, block.node);
+		else if(strcmp(name, "edge_attachment") == 0)
+			bSuccess = read_attachment<Edge>(grid, block.node);
+		else if(strcmp(name, "face_attachment") == 0)
+			bSuccess = read_attachment<Face>(grid, block.node);
+		else if(strcmp(name, "volume_attachment") == 0)
+			bSuccess = read_attachment<Volume>(grid, block.node);
+
+		if(!bSuccess)
+			return false;
+	}
+
+	builder.finish();
+	return true;
+}
+
+///	creates the elements and appends them to elemsOut, too
+template <class TElem, class TBaseElem>
+inline void add_ugx_elements(BulkGridBuilder& builder, const std::vector<int>& inds,
+							 size_t numCorners, std::vector<TBaseElem*>& elemsOut,
+							 std::vector<TBaseElem*>& builderElems)
+{
+	const size_t numElems = inds.size() / numCorners;
+	if(numElems == 0)
+		return;
+	builder.add_elements<TElem>(&inds.front(), numElems);
+	elemsOut.insert(elemsOut.end(), builderElems.end() - numElems, builderElems.end());
+}
+
+inline bool UGXObjectReader::
+create_block(BulkGridBuilder& builder, size_t index, const ElementBlock& block,
+			 const std::vector<TokenChunk>& chunks)
+{
+	using namespace ug;
+
+//	concatenate the chunks, since elements may cross chunk boundaries
+	std::vector<double> reals;
+	std::vector<int> inds;
+	for(size_t i = block.firstChunk; i < block.endChunk; ++i){
+		if(!chunks[i].ok){
+			UG_LOG("  ERROR in UGXObjectReader: invalid number in " << block.node->name() << ".\n");
+			return false;
+		}
+		reals.insert(reals.end(), chunks[i].reals.begin(), chunks[i].reals.end());
+		inds.insert(inds.end(), chunks[i].ints.begin(), chunks[i].ints.end());
+	}
+
+	GridEntry& entry = m_entries[index];
+
+	if(block.numCorners == 0){
+		int numSrcCoords = -1;
+		rapidxml::xml_attribute<>* attrib = block.node->first_attribute("coords");
+		if(attrib)
+			numSrcCoords = atoi(attrib->value());
+		if(numSrcCoords < 1)
+			return false;
+
+		const size_t numVrts = reals.size() / numSrcCoords;
+		if(numVrts == 0)
+			return true;
+		builder.add_vertices(&reals.front(), numVrts, numSrcCoords);
+		entry.vertices.insert(entry.vertices.end(), builder.vertices().end() - numVrts,
+							  builder.vertices().end());
+		return true;
+	}
+
+//	make sure that the indices are valid
+	const int numCorners = block.numCorners;
+	inds.resize(inds.size() - inds.size() % numCorners);
+	const int maxInd = (int)entry.vertices.size() - 1;
+	for(size_t i = 0; i < inds.size(); ++i){
+		if(inds[i] < 0 || inds[i] > maxInd){
+			UG_LOG("  ERROR in UGXObjectReader: invalid vertex index in "
+				   << block.node->name() << ": " << inds[i] << "\n");
+			return false;
+		}
+	}
+
+	const char* name = block.node->name();
+	if(strcmp(name, "edges") == 0)
+		add_ugx_elements<RegularEdge>(builder, inds, 2, entry.edges, builder.edges());
+	else if(strcmp(name, "triangles") == 0)
+		add_ugx_elements<Triangle>(builder, inds, 3, entry.faces, builder.faces());
+	else if(strcmp(name, "quadrilaterals") == 0)
+		add_ugx_elements<Quadrilateral>(builder, inds, 4, entry.faces, builder.faces());
+	else if(strcmp(name, "tetrahedrons") == 0)
+		add_ugx_elements<Tetrahedron>(builder, inds, 4, entry.volumes, builder.volumes());
+	else if(strcmp(name, "hexahedrons") == 0)
+		add_ugx_elements<Hexahedron>(builder, inds, 8, entry.volumes, builder.volumes());
+	else if(strcmp(name, "prisms") == 0)
+		add_ugx_elements<Prism>(builder, inds, 6, entry.volumes, builder.volumes());
+	else if(strcmp(name, "pyramids") == 0)
+		add_ugx_elements<Pyramid>(builder, inds, 5, entry.volumes, builder.volumes());
+	return true;
+}
+
+#endif //guard
@@ -0,0 +1,334 @@
+#ifndef __HPP__EMVIS_ugx_stream_writer
+#define __HPP__EMVIS_ugx_stream_writer
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "ugx_metadata.hpp"
+
+///	writes ugx files block by block, without building an xml document.
+/**	Vertex coordinates and element indices are either written as text or, in
+ * binary mode, as base64 encoded little endian Float64/Int32 arrays. Binary
+ * nodes carry the attributes format="base64" and type="Float64" or "Int32" and
+ * can be read by UGXObjectReader. Text output round-trips exactly: doubles are
+ * written with 17 significant digits, integral values as integers.
+ *
+ * Subset handler entries are always written as text, so that the subset
+ * handlers of binary files can still be read by GridReaderUGX. Grid and subset
+ * names are escaped, see XMLEscape.
+ * A metadata header (see write_metadata) lets UGXMetadataScanner answer
+ * queries about the file without reading more than its first bytes.
+ *
+ * Nodes can also be written piecewise through begin_vertices/append_vertices/
+ * end_vertices and begin_indices/append_indices/end_indices, so that meshes
+ * which do not fit into memory can be streamed chunk by chunk.*/
+class UGXStreamWriter{
+public:
+	UGXStreamWriter(const std::string &filename, bool binary = false)
+		: _binary(binary), _failed(false), _pos(0), _b64_num(0){
+		_file = fopen(filename.c_str(), "wb");
+		_buf.resize(1 << 16);
+	}
+
+	~UGXStreamWriter(){
+		close();
+	}
+
+	///	false if the file could not be opened or a write failed
+	bool good() const{
+		return _file != NULL && !_failed;
+	}
+
+	///	returns false if any write failed, e.g. since the disk is full
+	bool close(){
+		if(_file){
+			flush();
+			if(fclose(_file) != 0){
+				_failed = true;
+			}
+			_file = NULL;
+		}
+		return !_failed;
+	}
+
+	void begin_grid(const std::string &name = "defGrid"){
+		put("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<grid name=\"");
+		put(XMLEscape(name).c_str());
+		put("\">\n");
+	}
+
+	///	writes the metadata header which UGXMetadataScanner reads. Call right after begin_grid.
+	void write_metadata(const UGXMetadata &meta){
+		put('\t');
+		put(UGXMetadataHeader(meta).c_str());
+		put('\n');
+	}
+
+	void end_grid(){
+		put("</grid>\n");
+	}
+
+	///	coords holds dim values per vertex
+	void write_vertices(const double* coords, size_t num_vertices, unsigned dim = 3){
+		begin_vertices(dim);
+		append_vertices(coords, num_vertices * dim);
+		end_vertices();
+	}
+
+	void begin_vertices(unsigned dim = 3){
+		put("\t<vertices coords=\"");
+		put_uint(dim);
+		put("\"");
+		put(_binary ? " format=\"base64\" type=\"Float64\">" : ">");
+	}
+
+	///	appends num coordinates, the vertices of one node may be split arbitrarily
+	void append_vertices(const double* coords, size_t num){
+		if(_binary){
+			for(size_t i = 0; i < num; ++i){
+				uint64_t bits;
+				memcpy(&bits, &coords[i], 8);
+				put_base64_le(bits, 8);
+			}
+		}
+		else{
+			for(size_t i = 0; i < num; ++i){
+				put_double(coords[i]);
+				put(' ');
+			}
+		}
+	}
+
+	void end_vertices(){
+		if(_binary){
+			end_base64();
+		}
+		put("</vertices>\n");
+	}
+
+	///	writes an element node like edges, triangles or tetrahedrons
+	template <class T>
+	void write_indices(const char* tag, const T* indices, size_t num){
+		if(num == 0){
+			return;
+		}
+		begin_indices(tag);
+		append_indices(indices, num);
+		end_indices(tag);
+	}
+
+	///	begins an element node, which is filled by append_indices and closed by end_indices
+	void begin_indices(const char* tag){
+		put("\t<");
+		put(tag);
+		put(_binary ? " format=\"base64\" type=\"Int32\">" : ">");
+	}
+
+	template <class T>
+	void append_indices(const T* indices, size_t num){
+		if(_binary){
+			for(size_t i = 0; i < num; ++i){
+				put_base64_le((uint32_t)indices[i], 4);
+			}
+		}
+		else{
+			for(size_t i = 0; i < num; ++i){
+				put_uint(indices[i]);
+				put(' ');
+			}
+		}
+	}
+
+	void end_indices(const char* tag){
+		if(_binary){
+			end_base64();
+		}
+		put("</");
+		put(tag);
+		put(">\n");
+	}
+
+	template <class T>
+	void write_indices(const char* tag, const std::vector<T> &indices){
+		if(!indices.empty()){
+			write_indices(tag, &indices.front(), indices.size());
+		}
+	}
+
+	void begin_subset_handler(const std::string &name){
+		put("\t<subset_handler name=\"");
+		put(XMLEscape(name).c_str());
+		put("\">\n");
+	}
+
+	void end_subset_handler(){
+		put("\t</subset_handler>\n");
+	}
+
+	///	color holds 4 values in [0, 1]
+	void begin_subset(const std::string &name, const float* color, unsigned state){
+		put("\t\t<subset name=\"");
+		put(XMLEscape(name).c_str());
+		put("\" color=\"");
+		for(int i = 0; i < 4; ++i){
+			if(i > 0) put(' ');
+			put_double(color[i]);
+		}
+		put("\" state=\"");
+		put_uint(state);
+		put("\">\n");
+	}
+
+	void end_subset(){
+		put("\t\t</subset>\n");
+	}
+
+	///	writes the indices of the elements of a subset, tag is one of vertices, edges, faces, volumes
+	template <class T>
+	void write_subset_elements(const char* tag, const std::vector<T> &indices){
+		if(indices.empty()){
+			return;
+		}
+		put("\t\t\t<");
+		put(tag);
+		put(">");
+		for(size_t i = 0; i < indices.size(); ++i){
+			put_uint(indices[i]);
+			put(' ');
+		}
+		put("</");
+		put(tag);
+		put(">\n");
+	}
+
+	///	writes the indices begin, ..., end-1 as elements of a subset
+	void write_subset_range(const char* tag, size_t begin, size_t end){
+		if(begin >= end){
+			return;
+		}
+		put("\t\t\t<");
+		put(tag);
+		put(">");
+		for(size_t i = begin; i < end; ++i){
+			put_uint(i);
+			put(' ');
+		}
+		put("</");
+		put(tag);
+		put(">\n");
+	}
+
+private:
+	void flush(){
+		if(_file && _pos > 0){
+			write(&_buf[0], _pos);
+		}
+		_pos = 0;
+	}
+
+	void write(const char* s, size_t n){
+		if(fwrite(s, 1, n, _file) != n){
+			_failed = true;
+		}
+	}
+
+	void put(char c){
+		if(_pos == _buf.size()){
+			flush();
+		}
+		_buf[_pos++] = c;
+	}
+
+	void put(const char* s, size_t n){
+		if(_pos + n > _buf.size()){
+			flush();
+			if(n > _buf.size()){
+				if(_file) write(s, n);
+				return;
+			}
+		}
+		memcpy(&_buf[_pos], s, n);
+		_pos += n;
+	}
+
+	void put(const char* s){
+		put(s, strlen(s));
+	}
+
+	void put_uint(uint64_t v){
+		char tmp[24];
+		int n = 0;
+		do{
+			tmp[n++] = char('0' + v % 10);
+			v /= 10;
+		}while(v > 0);
+		if(_pos + n > _buf.size()){
+			flush();
+		}
+		while(n > 0){
+			_buf[_pos++] = tmp[--n];
+		}
+	}
+
+	void put_double(double v){
+		if(v == std::floor(v) && std::fabs(v) < 1e15){
+		//	the sign bit keeps -0.0 apart from 0.0
+			if(std::signbit(v)){
+				put('-');
+			}
+			put_uint((uint64_t)std::fabs(v));
+			return;
+		}
+
+		char tmp[32];
+		int n = snprintf(tmp, sizeof(tmp), "%.17g", v);
+	//	snprintf uses the decimal point of the current locale
+		for(int i = 0; i < n; ++i){
+			if(tmp[i] == ',') tmp[i] = '.';
+		}
+		put(tmp, n);
+	}
+
+	///	appends num_bytes bytes of v, least significant first, to the base64 stream
+	void put_base64_le(uint64_t v, int num_bytes){
+		for(int i = 0; i < num_bytes; ++i){
+			_b64[_b64_num++] = (unsigned char)(v >> (8 * i));
+			if(_b64_num == 3){
+				put_base64_group(3);
+			}
+		}
+	}
+
+	void end_base64(){
+		if(_b64_num > 0){
+			put_base64_group(_b64_num);
+		}
+	}
+
+	void put_base64_group(int n){
+		static const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		const uint32_t w = ((uint32_t)_b64[0] << 16)
+						 | ((uint32_t)(n > 1 ? _b64[1] : 0) << 8)
+						 | (uint32_t)(n > 2 ? _b64[2] : 0);
+		char out[4];
+		out[0] = table[(w >> 18) & 63];
+		out[1] = table[(w >> 12) & 63];
+		out[2] = n > 1 ? table[(w >> 6) & 63] : '=';
+		out[3] = n > 2 ? table[w & 63] : '=';
+		put(out, 4);
+		_b64_num = 0;
+	}
+
+	std::FILE* _file;
+	bool _binary;
+	bool _failed;
+	std::vector<char> _buf;
+	size_t _pos;
+	unsigned char _b64[3];
+	int _b64_num;
+};
+
+#endif //guard
@@ -0,0 +1,74 @@
+#ifndef __HPP__EMVIS_vtu_data
+#define __HPP__EMVIS_vtu_data
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+///	a named DataArray of the PointData or CellData section of a vtu file
+struct VTUDataArray{
+	std::string name;
+	unsigned num_components;
+	std::vector<double> values;///< num_components values per point or cell
+};
+
+///	merges scalar arrays named <prefix>x, <prefix>y, <prefix>z into one vector array <prefix>
+inline void CombineVTUComponentArrays(std::vector<VTUDataArray> &arrays){
+	for(size_t i = 0; i < arrays.size(); ++i){
+		const std::string &name = arrays[i].name;
+		if(arrays[i].num_components != 1 || name.empty() || name[name.size()-1] != 'x'){
+			continue;
+		}
+
+		const std::string prefix = name.substr(0, name.size()-1);
+		size_t iy = arrays.size(), iz = arrays.size();
+		for(size_t j = 0; j < arrays.size(); ++j){
+			if(arrays[j].num_components != 1 || arrays[j].values.size() != arrays[i].values.size()){
+				continue;
+			}
+			if(arrays[j].name == prefix + "y") iy = j;
+			if(arrays[j].name == prefix + "z") iz = j;
+		}
+		if(iy == arrays.size() || iz == arrays.size()){
+			continue;
+		}
+
+		VTUDataArray combined;
+		combined.name = prefix.empty() ? "xyz" : prefix;
+		combined.num_components = 3;
+		combined.values.resize(3 * arrays[i].values.size());
+		for(size_t k = 0; k < arrays[i].values.size(); ++k){
+			combined.values[3*k] = arrays[i].values[k];
+			combined.values[3*k+1] = arrays[iy].values[k];
+			combined.values[3*k+2] = arrays[iz].values[k];
+		}
+
+		size_t rem[3] = {i, iy, iz};
+		std::sort(rem, rem + 3);
+		for(int k = 2; k >= 0; --k){
+			arrays.erase(arrays.begin() + rem[k]);
+		}
+		arrays.push_back(combined);
+		i = (size_t)-1;
+	}
+}
+
+///	returns the array holding the displacements of the points or NULL.
+/**	Prefers an array named "displacement", then "u", then the first array with 3 components.*/
+inline const VTUDataArray* FindVTUDisplacements(const std::vector<VTUDataArray> &point_data){
+	const VTUDataArray* found = NULL;
+	for(size_t i = 0; i < point_data.size(); ++i){
+		if(point_data[i].num_components != 3){
+			continue;
+		}
+		if(point_data[i].name == "displacement"){
+			return &point_data[i];
+		}
+		if(point_data[i].name == "u" || !found){
+			found = &point_data[i];
+		}
+	}
+	return found;
+}
+
+#endif //guard
@@ -0,0 +1,387 @@
+#ifndef __HPP__EMVIS_vtu_object_reader
+#define __HPP__EMVIS_vtu_object_reader
+
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "topology_builder.hpp"
+#include "vtu_data.hpp"
+#include "parallel_tokenizer.hpp"
+#include "../scene/bulk_grid_builder.h"
+#include "lib_grid/file_io/file_io_vtu.h"
+
+////////////////////////////////////////////////////////////////////////
+///	reads the raw arrays of all pieces of a vtu file.
+/**	Builds on the xml document of ug::GridReaderVTU, but leaves the creation of
+ * elements to the TopologyBuilder, so that edges and faces are created, too.
+ * The pieces are concatenated, i.e. point indices of later pieces are shifted
+ * by the number of points of the preceding pieces. Data arrays which are not
+ * present in all pieces are dropped. Ascii and uncompressed inline binary
+ * data arrays are supported.*/
+class VTUObjectReader : public ug::GridReaderVTU
+{
+	public:
+	///	pointsOut receives 3 coordinates per point
+		bool read_pieces(std::vector<double>& pointsOut,
+						 std::vector<unsigned>& connOut,
+						 std::vector<unsigned>& offsetsOut,
+						 std::vector<unsigned>& typesOut,
+						 std::vector<VTUDataArray>& pointDataOut,
+						 std::vector<VTUDataArray>& cellDataOut);
+
+	protected:
+	///	reads ascii or inline binary (base64, uncompressed) data
+		template <class T>
+		bool read_values(std::vector<T>& valsOut, rapidxml::xml_node<>* dataNode);
+
+		template <class T>
+		bool read_binary_values(std::vector<T>& valsOut, rapidxml::xml_node<>* dataNode);
+
+		bool read_data_arrays(std::vector<VTUDataArray>& arraysOut,
+							  rapidxml::xml_node<>* sectionNode, size_t numTuples);
+
+		static void append_data_arrays(std::vector<VTUDataArray>& arrays,
+									   const std::vector<VTUDataArray>& pieceArrays);
+};
+
+template <class T>
+bool VTUObjectReader::
+read_values(std::vector<T>& valsOut, rapidxml::xml_node<>* dataNode)
+{
+	rapidxml::xml_attribute<>* format = dataNode->first_attribute("format");
+	if(format && strcmp(format->value(), "binary") == 0)
+		return read_binary_values(valsOut, dataNode);
+
+	if(format && strcmp(format->value(), "ascii") != 0){
+		UG_LOG("ERROR in " << m_filename << ": DataArrays of format "
+			   << format->value() << " are not supported\n");
+		return false;
+	}
+
+	const char* c = dataNode->value();
+	const char* end = c + dataNode->value_size();
+	while(c < end){
+		while(c < end && is_token_space(*c))
+			++c;
+		double d;
+		const char* next = ParseDouble(c, end, d);
+		if(next == c)
+			break;
+		valsOut.push_back(static_cast<T>(d));
+		c = next;
+	}
+	return true;
+}
+
+template <class TSrc, class T>
+inline void append_raw_values(std::vector<T>& valsOut, const unsigned char* data, size_t numBytes)
+{
+	const size_t num = numBytes / sizeof(TSrc);
+	valsOut.reserve(valsOut.size() + num);
+	for(size_t i = 0; i < num; ++i){
+		TSrc v;
+		memcpy(&v, data + i * sizeof(TSrc), sizeof(TSrc));
+		valsOut.push_back(static_cast<T>(v));
+	}
+}
+
+template <class T>
+bool VTUObjectReader::
+read_binary_values(std::vector<T>& valsOut, rapidxml::xml_node<>* dataNode)
+{
+	using namespace rapidxml;
+
+	xml_node<>* vtkNode = m_doc.first_node("VTKFile");
+	xml_attribute<>* attrib = vtkNode->first_attribute("compressor");
+	if(attrib && attrib->value_size() > 0){
+		UG_LOG("ERROR in " << m_filename << ": compressed DataArrays are not supported\n");
+		return false;
+	}
+	attrib = vtkNode->first_attribute("byte_order");
+	if(attrib && strcmp(attrib->value(), "LittleEndian") != 0){
+		UG_LOG("ERROR in " << m_filename << ": only little endian data is supported\n");
+		return false;
+	}
+	attrib = vtkNode->first_attribute("header_type");
+	const size_t headerSize = (attrib && strcmp(attrib->value(), "UInt64") == 0) ? 8 : 4;
+
+//	inline binary data is base64 encoded and starts with its size in bytes.
+//	Header and data may be encoded separately, so padding may occur in between.
+	std::vector<unsigned char> bytes;
+	bytes.reserve(dataNode->value_size() * 3 / 4);
+	unsigned int acc = 0;
+	int numBits = 0;
+	const char* c = dataNode->value();
+	const char* end = c + dataNode->value_size();
+	for(; c < end; ++c){
+		int v;
+		if(*c >= 'A' && *c <= 'Z')		v = *c - 'A';
+		else if(*c >= 'a' && *c <= 'z')	v = *c - 'a' + 26;
+		else if(*c >= '0' && *c <= '9')	v = *c - '0' + 52;
+		else if(*c == '+')				v = 62;
+		else if(*c == '/')				v = 63;
+		else{
+			if(*c == '='){
+				acc = 0;
+				numBits = 0;
+			}
+			continue;
+		}
+
+		acc = (acc << 6) | (unsigned int)v;
+		numBits += 6;
+		if(numBits >= 8){
+			numBits -= 8;
+			bytes.push_back((unsigned char)((acc >> numBits) & 0xFF));
+		}
+	}
+
+	if(bytes.size() < headerSize){
+		UG_LOG("ERROR in " << m_filename << ": bad binary DataArray\n");
+		return false;
+	}
+
+	uint64_t numBytes = 0;
+	for(size_t i = 0; i < headerSize; ++i)
+		numBytes |= (uint64_t)bytes[i] << (8 * i);
+	if(numBytes > bytes.size() - headerSize){
+		UG_LOG("ERROR in " << m_filename << ": truncated binary DataArray\n");
+		return false;
+	}
+
+	attrib = dataNode->first_attribute("type");
+	const char* type = attrib ? attrib->value() : "";
+	const unsigned char* data = &bytes[0] + headerSize;
+	if(strcmp(type, "Float32") == 0)		append_raw_values<float>(valsOut, data, numBytes);
+	else if(strcmp(type, "Float64") == 0)	append_raw_values<double>(valsOut, data, numBytes);
+	else if(strcmp(type, "Int8") == 0)		append_raw_values<int8_t>(valsOut, data, numBytes);
+	else if(strcmp(type, "UInt8") == 0)		append_raw_values<uint8_t>(valsOut, data, numBytes);
+	else if(strcmp(type, "Int16") == 0)		append_raw_values<int16_t>(valsOut, data, numBytes);
+	else if(strcmp(type, "UInt16") == 0)	append_raw_values<uint16_t>(valsOut, data, numBytes);
+	else if(strcmp(type, "Int32") == 0)		append_raw_values<int32_t>(valsOut, data, numBytes);
+	else if(strcmp(type, "UInt32") == 0)	append_raw_values<uint32_t>(valsOut, data, numBytes);
+	else if(strcmp(type, "Int64") == 0)		append_raw_values<int64_t>(valsOut, data, numBytes);
+	else if(strcmp(type, "UInt64") == 0)	append_raw_values<uint64_t>(valsOut, data, numBytes);
+	else{
+		UG_LOG("ERROR in " << m_filename << ": unsupported DataArray type " << type << "\n");
+		return false;
+	}
+	return true;
+}
+
+inline bool VTUObjectReader::
+read_data_arrays(std::vector<VTUDataArray>& arraysOut,
+				 rapidxml::xml_node<>* sectionNode, size_t numTuples)
+{
+	if(!sectionNode)
+		return true;
+
+	for(rapidxml::xml_node<>* dataNode = sectionNode->first_node("DataArray");
+		dataNode; dataNode = dataNode->next_sibling("DataArray"))
+	{
+		rapidxml::xml_attribute<>* attrib = dataNode->first_attribute("Name");
+		if(!attrib)
+			attrib = dataNode->first_attribute("name");
+
+		VTUDataArray arr;
+		arr.name = attrib ? attrib->value() : "";
+		arr.num_components = 1;
+		attrib = dataNode->first_attribute("NumberOfComponents");
+		if(attrib)
+			arr.num_components = (unsigned)atoi(attrib->value());
+
+		arr.values.reserve(numTuples * arr.num_components);
+		if(!read_values(arr.values, dataNode))
+			return false;
+
+		if(arr.num_components == 0 || arr.values.size() != numTuples * arr.num_components){
+			UG_LOG("ERROR in " << m_filename << ": DataArray " << arr.name << " has "
+				   << arr.values.size() << " values, expected "
+				   << numTuples * arr.num_components << "\n");
+			return false;
+		}
+		arraysOut.push_back(arr);
+	}
+	return true;
+}
+
+inline void VTUObjectReader::
+append_data_arrays(std::vector<VTUDataArray>& arrays,
+				   const std::vector<VTUDataArray>& pieceArrays)
+{
+	for(size_t i = 0; i < arrays.size();){
+		size_t j = 0;
+		while(j < pieceArrays.size()
+			  && (pieceArrays[j].name != arrays[i].name
+				  || pieceArrays[j].num_components != arrays[i].num_components))
+		{
+			++j;
+		}
+
+		if(j == pieceArrays.size()){
+			UG_LOG("  dropping " << arrays[i].name << ", which is not present in all pieces\n");
+			arrays.erase(arrays.begin() + i);
+			continue;
+		}
+
+		arrays[i].values.insert(arrays[i].values.end(), pieceArrays[j].values.begin(),
+								pieceArrays[j].values.end());
+		++i;
+	}
+}
+
+inline bool VTUObjectReader::
+read_pieces(std::vector<double>& pointsOut,
+			std::vector<unsigned>& connOut,
+			std::vector<unsigned>& offsetsOut,
+			std::vector<unsigned>& typesOut,
+			std::vector<VTUDataArray>& pointDataOut,
+			std::vector<VTUDataArray>& cellDataOut)
+{
+	using namespace rapidxml;
+
+	for(size_t ipiece = 0; ipiece < m_entries.size(); ++ipiece){
+		xml_node<>* pieceNode = m_entries[ipiece].node;
+
+	//	points
+		xml_node<>* pointsNode = pieceNode->first_node("Points");
+		xml_node<>* dataNode = pointsNode ? pointsNode->first_node("DataArray") : NULL;
+		if(!dataNode){
+			UG_LOG("ERROR in " << m_filename << ": missing Points in piece " << ipiece << "\n");
+			return false;
+		}
+
+		unsigned numCoords = 3;
+		xml_attribute<>* attrib = dataNode->first_attribute("NumberOfComponents");
+		if(attrib)
+			numCoords = (unsigned)atoi(attrib->value());
+		if(numCoords < 1 || numCoords > 3){
+			UG_LOG("ERROR in " << m_filename << ": unsupported number of coordinates " << numCoords << "\n");
+			return false;
+		}
+
+		std::vector<double> coords;
+		if(!read_values(coords, dataNode))
+			return false;
+
+		const size_t vrtOffset = pointsOut.size() / 3;
+		const size_t numPoints = coords.size() / numCoords;
+		pointsOut.resize(3 * (vrtOffset + numPoints), 0);
+		for(size_t i = 0; i < numPoints; ++i){
+			for(unsigned j = 0; j < numCoords; ++j)
+				pointsOut[3 * (vrtOffset + i) + j] = coords[i * numCoords + j];
+		}
+
+	//	cells
+		xml_node<>* cellsNode = pieceNode->first_node("Cells");
+		if(!cellsNode){
+			UG_LOG("ERROR in " << m_filename << ": missing Cells in piece " << ipiece << "\n");
+			return false;
+		}
+
+		std::vector<unsigned> conn, offsets, types;
+		for(dataNode = cellsNode->first_node("DataArray"); dataNode;
+			dataNode = dataNode->next_sibling("DataArray"))
+		{
+			attrib = dataNode->first_attribute("Name");
+			if(!attrib)
+				attrib = dataNode->first_attribute("name");
+			if(!attrib)
+				continue;
+
+			bool ok = true;
+			if(strcmp(attrib->value(), "connectivity") == 0)
+				ok = read_values(conn, dataNode);
+			else if(strcmp(attrib->value(), "offsets") == 0)
+				ok = read_values(offsets, dataNode);
+			else if(strcmp(attrib->value(), "types") == 0)
+				ok = read_values(types, dataNode);
+			if(!ok)
+				return false;
+		}
+
+		if(offsets.size() != types.size() || (!offsets.empty() && offsets.back() != conn.size())){
+			UG_LOG("ERROR in " << m_filename << ": inconsistent Cells in piece " << ipiece << "\n");
+			return false;
+		}
+		for(size_t i = 0; i < conn.size(); ++i){
+			if(conn[i] >= numPoints){
+				UG_LOG("ERROR in " << m_filename << ": bad point index in piece " << ipiece << "\n");
+				return false;
+			}
+		}
+
+		const unsigned connOffset = (unsigned)connOut.size();
+		for(size_t i = 0; i < conn.size(); ++i)
+			connOut.push_back(conn[i] + (unsigned)vrtOffset);
+		for(size_t i = 0; i < offsets.size(); ++i)
+			offsetsOut.push_back(offsets[i] + connOffset);
+		typesOut.insert(typesOut.end(), types.begin(), types.end());
+
+	//	data
+		std::vector<VTUDataArray> pointData, cellData;
+		if(!read_data_arrays(pointData, pieceNode->first_node("PointData"), numPoints)
+		   || !read_data_arrays(cellData, pieceNode->first_node("CellData"), types.size()))
+		{
+			return false;
+		}
+
+		if(ipiece == 0){
+			pointDataOut.swap(pointData);
+			cellDataOut.swap(cellData);
+		}
+		else{
+			append_data_arrays(pointDataOut, pointData);
+			append_data_arrays(cellDataOut, cellData);
+		}
+	}
+
+	return true;
+}
+
+
+template <class TElem>
+inline void add_vtu_elements(BulkGridBuilder& builder, const std::vector<unsigned>& inds,
+							 size_t numCorners)
+{
+	if(!inds.empty())
+		builder.add_elements<TElem>(&inds.front(), inds.size() / numCorners);
+}
+
+///	creates the vertices and the elements which the topology found in the cells
+/**	points holds 3 coordinates per point, see VTUObjectReader::read_pieces.*/
+inline void BuildVTUGrid(BulkGridBuilder& builder, TopologyBuilder& topology,
+						 const std::vector<double>& points, const std::vector<unsigned>& conn,
+						 const std::vector<unsigned>& offsets, const std::vector<unsigned>& types)
+{
+	using namespace ug;
+
+	topology.build(conn, offsets, types);
+	if(topology.num_skipped_cells()){
+		UG_LOG("skipped " << topology.num_skipped_cells() << " cells of unsupported type\n");
+	}
+
+	builder.reserve(points.size() / 3, topology.num_edges(), topology.num_faces(),
+					topology.num_volumes());
+
+	if(!points.empty())
+		builder.add_vertices(&points.front(), points.size() / 3);
+	add_vtu_elements<RegularEdge>(builder, topology.edges(), 2);
+	add_vtu_elements<Triangle>(builder, topology.triangles(), 3);
+	add_vtu_elements<Quadrilateral>(builder, topology.quadrilaterals(), 4);
+	add_vtu_elements<Tetrahedron>(builder, topology.tetrahedrons(), 4);
+	add_vtu_elements<Hexahedron>(builder, topology.hexahedrons(), 8);
+
+//	vtk wedges are oriented the other way round, see GridReaderVTU
+	std::vector<unsigned> pri = topology.prisms();
+	for(size_t i = 0; i < pri.size(); i += 6){
+		std::swap(pri[i], pri[i+1]);
+		std::swap(pri[i+3], pri[i+4]);
+	}
+	add_vtu_elements<Prism>(builder, pri, 6);
+	add_vtu_elements<Pyramid>(builder, topology.pyramids(), 5);
+}
+
+#endif //guard
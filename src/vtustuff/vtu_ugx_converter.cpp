@@ -1,12 +1,13 @@
 #include "vtu_ugx_converter.hpp"
 
 
-void do_it(std::string fin, std::string fout, bool combine=false){
+void do_it(std::string fin, std::string fout, bool combine=false, bool binary=false){
 	PARSE P(fin);
 	std::pair<unsigned, unsigned> num_data = P.parse_header();
 
-	std::vector<std::vector<double> > point_data(num_data.first);
-	P.parse_point_data(point_data, num_data.first);
+	std::vector<VTUDataArray> point_data, cell_data;
+	P.parse_point_data(point_data, cell_data, num_data.first, num_data.second);
+	CombineVTUComponentArrays(point_data);
 
 	std::vector<std::vector<double> > points(num_data.first);
 	P.parse_points(points, num_data.first);
@@ -22,38 +23,50 @@ void do_it(std::string fin, std::string fout, bool combine=false){
 
 	P.end_file();
 
-	WRITE W(fout);
+	WRITE W(fout, binary);
+	std::vector<unsigned> sizes = W.assemble_elements(conn, offsets, types);
 	W.write_header();
+	W.write_metadata(points, sizes);
 	W.write_points(points);
-	std::vector<unsigned> sizes = W.assemble_elements(conn, offsets, types);
 	W.write_elements();
 	W.write_subset_handler(num_data.first, sizes);
-	W.write_eof();
+	if(!W.write_eof()){
+		std::cerr << "could not write " << fout << std::endl;
+	}
 
-	if(combine){
-		std::cout << "combine point data with points position" << std::endl;
+	const VTUDataArray* displacements = FindVTUDisplacements(point_data);
+	if(combine && !displacements){
+		std::cerr << "no displacement data found, skipping -c" << std::endl;
+	}
+	else if(combine){
+		std::cout << "combine point data " << displacements->name << " with points position" << std::endl;
 
 		for(unsigned i = 0; i < points.size(); ++i){
-			for(unsigned j = 0; j < points[i].size(); ++j){
-				points[i][j] += point_data[i][j];
+			for(unsigned j = 0; j < points[i].size() && j < 3; ++j){
+				points[i][j] += displacements->values[3*i+j];
 			}
 		}
 
 		fout = fout+"c";
 
-		WRITE Wc(fout);
+		WRITE Wc(fout, binary);
+		sizes = Wc.assemble_elements(conn, offsets, types);
 		Wc.write_header();
+		Wc.write_metadata(points, sizes);
 		Wc.write_points(points);
-		sizes = Wc.assemble_elements(conn, offsets, types);
 		Wc.write_elements();
 		Wc.write_subset_handler(num_data.first, sizes);
-		Wc.write_eof();
+		if(!Wc.write_eof()){
+			std::cerr << "could not write " << fout << std::endl;
+		}
 	}
 }
 
 
 void help(){
-	std::cout << "usage: ./converter <fin> <fout>" << std::endl;
+	std::cout << "usage: ./converter [-c] [-b] <fin> ..." << std::endl;
+	std::cout << "  -c  also write <fout>c with the displacements added to the points" << std::endl;
+	std::cout << "  -b  write vertices and elements as base64 encoded binary blocks" << std::endl;
 }
 
 int main(int argc, char **argv){
@@ -63,17 +76,22 @@ int main(int argc, char **argv){
 	}
 
 	bool combine = false;
+	bool binary = false;
 
 	for(unsigned i = 1; i < argc; ++i){
 		if(strcmp(argv[i], "-c") == 0){
 			combine = true;
 			continue;
 		}
+		if(strcmp(argv[i], "-b") == 0){
+			binary = true;
+			continue;
+		}
 		std::string fin = argv[i];
 		unsigned pos = fin.find(".vtu");
 		std::string fout = fin;
 		fout.replace(pos, pos+4, ".ugx");
 		std::cout << "converting " << fin << "..." << std::endl; 
-		do_it(fin, fout, combine);	
+		do_it(fin, fout, combine, binary);	
 	}
 }
@@ -7,8 +7,15 @@
 #include <vector>
 #include <algorithm>
 #include <string.h>
+#include <stdlib.h>
 #include <assert.h>
+#include "topology_builder.hpp"
+#include "ugx_stream_writer.hpp"
+#include "vtu_data.hpp"
 
+//	also defined by UG_LogParser.h
+#ifndef __EMVIS_myatoi
+#define __EMVIS_myatoi
 inline unsigned myatoi(std::string line, unsigned& v, char end=0){
 	unsigned idx = 0;
 	v = line[idx]-'0';
@@ -20,6 +27,7 @@ inline unsigned myatoi(std::string line, unsigned& v, char end=0){
 	}
 	return idx;
 }
+#endif
 
 class PARSE{
 public:
@@ -123,41 +131,65 @@ public:
 		return std::make_pair(num_points, num_cells);
 	}
 
-	void parse_point_data(std::vector<std::vector<double> > &point_data, unsigned num_points){
-		get_line();
-
-		if(_line != "<PointData>"){
-			return;
+	//returns false if the next section is not a <section> (e.g. PointData)
+	bool parse_data_section(std::vector<VTUDataArray> &arrays, std::string section, unsigned num_tuples){
+		if(!_line.size()){
+			get_line();
+		}
+		if(_line.find("<" + section) != 0){
+			return false;
 		}
 
-		expect_exact("<PointData>");
-		expect_contained("<DataArray type", false);
-
-		std::string s_name = get_value(_line, "Name");
-		std::string s_dim = get_value(_line, "NumberOfComponents");
-		unsigned dim;
-		myatoi(s_dim, dim);
+		bool empty = _line.find("/>") != std::string::npos;
+		_line.clear();
 
-		std::cout << "found PointData entry: " << "Name: " << s_name << " NumberOfComponents: " << s_dim << std::endl; 
+		while(!empty){
+			get_line();
+			if(_line.find("</" + section) == 0){
+				_line.clear();
+				break;
+			}
+			if(_is->eof() || _line.find("<DataArray") != 0){
+				std::cerr << "expected \"<DataArray\" in " << section << std::endl;
+				std::cerr << "got \"" << _line << "\"" << std::endl;
+				throw "runtime error";
+			}
 
-		token_iterator tIt(*this, " ", false);
+			VTUDataArray arr;
+			arr.name = get_value(_line, "Name");
+			arr.num_components = 1;
+			if(_line.find("NumberOfComponents") != std::string::npos){
+				myatoi(get_value(_line, "NumberOfComponents"), arr.num_components);
+			}
+			arr.values.reserve(num_tuples * arr.num_components);
+
+			std::cout << "found " << section << " entry: " << "Name: " << arr.name << " NumberOfComponents: " << arr.num_components << std::endl;
+
+		//	values may start behind the opening tag and end in front of the closing one
+			std::string rest = _line.substr(_line.find(">") + 1);
+			while(!read_values(arr.values, rest)){
+				get_line();
+				if(_is->eof()){
+					throw "runtime error";
+				}
+				rest = _line;
+			}
+			_line.clear();
 
-		for(unsigned i = 0; i < num_points; ++i){
-			point_data[i].resize(dim);
-			for(unsigned j = 0; j < dim; ++j){
-				++tIt;
-				std::cout.precision((*tIt).size());
-				point_data[i][j] = std::stod(*tIt);
+			if(arr.values.size() != (size_t)num_tuples * arr.num_components){
+				std::cerr << "DataArray " << arr.name << " has " << arr.values.size() << " values, expected "
+						  << num_tuples * arr.num_components << std::endl;
+				throw "runtime error";
 			}
+			arrays.push_back(arr);
 		}
+		return true;
+	}
 
-		get_line();
-		expect_exact("</DataArray>");
-		expect_exact("</PointData>");
-
-		expect_exact("<CellData>");
-		skip_until("</CellData>");
-		expect_exact("</CellData>");
+	void parse_point_data(std::vector<VTUDataArray> &point_data, std::vector<VTUDataArray> &cell_data,
+						  unsigned num_points, unsigned num_cells){
+		parse_data_section(point_data, "PointData", num_points);
+		parse_data_section(cell_data, "CellData", num_cells);
 	}
 
 	void parse_points(std::vector<std::vector<double> > &points, unsigned num_points){
@@ -257,6 +289,29 @@ public:
 	}
 
 private:
+	//returns true if the closing tag was reached
+	static bool read_values(std::vector<double> &values, const std::string &str){
+		const char* c = str.c_str();
+		while(*c){
+			while(*c == ' ' || *c == '\t' || *c == '\r'){
+				++c;
+			}
+			if(*c == '<'){
+				return true;
+			}
+			if(!*c){
+				break;
+			}
+			char* end;
+			values.push_back(strtod(c, &end));
+			if(end == c){
+				throw "runtime error";
+			}
+			c = end;
+		}
+		return false;
+	}
+
 	std::ifstream* _is;
 	std::string _line;
 	unsigned _uintval;
@@ -315,242 +370,92 @@ public:
 
 class WRITE{
 public:
-	WRITE(const std::string filename)	: _fout(filename){}
+	WRITE(const std::string filename, bool binary = false)	: _out(filename, binary){}
 
 	void write_header(std::string gridname = "defGrid"){
-		_fout << "<?xml version=\"1.0\" encoding=\"utf-8\"?>" << std::endl;
-		_fout << "<grid name=\"" << gridname << "\">" << std::endl;
+		_out.begin_grid(gridname);
+	}
+
+	///	call after assemble_elements
+	void write_metadata(std::vector<std::vector<double> > &points, std::vector<unsigned> &sizes){
+		UGXMetadata meta;
+		meta.num_vertices = points.size();
+		meta.num_edges = sizes[0];
+		meta.num_faces = sizes[1] + sizes[2];
+		meta.num_volumes = sizes[3] + sizes[4] + sizes[5] + sizes[6];
+		meta.has_bbox = !points.empty();
+		for(unsigned i = 0; i < points.size(); ++i){
+			for(unsigned j = 0; j < 3 && j < points[i].size(); ++j){
+				if(i == 0 || points[i][j] < meta.bbox_min[j]) meta.bbox_min[j] = points[i][j];
+				if(i == 0 || points[i][j] > meta.bbox_max[j]) meta.bbox_max[j] = points[i][j];
+			}
+		}
+		meta.subset_names.push_back("Inner");
+		_out.write_metadata(meta);
 	}
 
 	void write_points(std::vector<std::vector<double> > &points, unsigned dim=3){
-		_fout << "	<vertices coords=\"" << dim << "\">";
+		std::vector<double> coords;
+		coords.reserve(dim * points.size());
 		for(unsigned i = 0; i < points.size(); ++i){
 			for(unsigned j = 0; j < dim; ++j){
-				_fout << points[i][j] << " ";
+				coords.push_back(j < points[i].size() ? points[i][j] : 0);
 			}
 		}
-		_fout << "</vertices>" << std::endl;
+		_out.write_vertices(coords.empty() ? NULL : &coords.front(), points.size(), dim);
 	}
 
-	//rtn = vector <edges.size(), triangles.size(), quadrilaterals.size()>
+	//rtn = vector <edges, triangles, quadrilaterals, tetrahedrons, prisms, pyramids, hexahedrons>
 	std::vector<unsigned> assemble_elements(std::vector<unsigned> &conn, std::vector<unsigned> &offsets, std::vector<unsigned> &types){
-		assert(offsets.size() == types.size());
-
-		unsigned j = 0;
-
-		std::pair<unsigned, unsigned> edge;
-		std::vector<unsigned> triangle(3);
-		std::vector<unsigned> quadrilateral(4);
-		std::vector<unsigned> prism(6);
-		std::vector<unsigned> tet(4);
-		std::vector<unsigned> pyramid(5);
-
-		unsigned cnt = 0;
-
-		for(unsigned i = 0; i < types.size(); ++i){
-			switch(types[i]){
-				case 10: //VTK_TETRA
-					edge.first = conn[j]; edge.second = conn[j+1]; _edges.push_back(edge);
-					edge.first = conn[j]; edge.second = conn[j+2]; _edges.push_back(edge);
-					edge.first = conn[j+1]; edge.second = conn[j+2]; _edges.push_back(edge);
-					edge.first = conn[j]; edge.second = conn[j+3]; _edges.push_back(edge);
-					edge.first = conn[j+1]; edge.second = conn[j+3]; _edges.push_back(edge);
-					edge.first = conn[j+2]; edge.second = conn[j+3]; _edges.push_back(edge);
-
-					triangle[0] = conn[j]; triangle[1] = conn[j+1]; triangle[2] = conn[j+3]; _triangles.push_back(triangle);
-					triangle[0] = conn[j]; triangle[1] = conn[j+2]; triangle[2] = conn[j+3]; _triangles.push_back(triangle);
-					triangle[0] = conn[j+1]; triangle[1] = conn[j+2]; triangle[2] = conn[j+3]; _triangles.push_back(triangle);
-
-					for(unsigned k = 0; k < 4; ++k){
-						tet[k] = conn[j+k];
-					}
-					_tets.push_back(tet);
-
-					cnt++;
-
-					j+= 4;
-
-					break;
+		_topology.build(conn, offsets, types);
 
-				case 13: //VTK_WEDGE
-					edge.first = conn[j]; edge.second = conn[j+1]; _edges.push_back(edge);
-					edge.first = conn[j]; edge.second = conn[j+2]; _edges.push_back(edge);
-					edge.first = conn[j+1]; edge.second = conn[j+2]; _edges.push_back(edge);
-					edge.first = conn[j]; edge.second = conn[j+3]; _edges.push_back(edge);
-					edge.first = conn[j+1]; edge.second = conn[j+4]; _edges.push_back(edge);
-					edge.first = conn[j+2]; edge.second = conn[j+5]; _edges.push_back(edge);
-					edge.first = conn[j+3]; edge.second = conn[j+4]; _edges.push_back(edge);
-					edge.first = conn[j+3]; edge.second = conn[j+5]; _edges.push_back(edge);
-					edge.first = conn[j+4]; edge.second = conn[j+5]; _edges.push_back(edge);
-
-					triangle[0] = conn[j]; triangle[1] = conn[j+1]; triangle[2] = conn[j+2]; _triangles.push_back(triangle);
-					triangle[0] = conn[j+3]; triangle[1] = conn[j+4]; triangle[2] = conn[j+5]; _triangles.push_back(triangle);
-
-					quadrilateral[0] = conn[j]; quadrilateral[1] = conn[j+1]; quadrilateral[2] = conn[j+4]; quadrilateral[3] = conn[j+3]; _quadrilaterals.push_back(quadrilateral);
-					quadrilateral[0] = conn[j]; quadrilateral[1] = conn[j+2]; quadrilateral[2] = conn[j+5]; quadrilateral[3] = conn[j+3]; _quadrilaterals.push_back(quadrilateral);
-					quadrilateral[0] = conn[j+1]; quadrilateral[1] = conn[j+2]; quadrilateral[2] = conn[j+5]; quadrilateral[3] = conn[j+4]; _quadrilaterals.push_back(quadrilateral);
-
-					for(unsigned k = 0; k < 6; ++k){
-						prism[k] = conn[j+k];
-					}
-					_prisms.push_back(prism);
-
-					j+=6;
-
-					cnt++;
-
-					break;
-
-				case 14: //VTK_PYRAMID
-					edge.first = conn[j]; edge.second = conn[j+1]; _edges.push_back(edge);
-					edge.first = conn[j+1]; edge.second = conn[j+2]; _edges.push_back(edge);
-					edge.first = conn[j+2]; edge.second = conn[j+3]; _edges.push_back(edge);
-					edge.first = conn[j]; edge.second = conn[j+3]; _edges.push_back(edge);
-					edge.first = conn[j]; edge.second = conn[j+4]; _edges.push_back(edge);
-					edge.first = conn[j+1]; edge.second = conn[j+4]; _edges.push_back(edge);
-					edge.first = conn[j+2]; edge.second = conn[j+4]; _edges.push_back(edge);
-					edge.first = conn[j+3]; edge.second = conn[j+4]; _edges.push_back(edge);
-
-					triangle[0] = conn[j]; triangle[1] = conn[j+1]; triangle[2] = conn[j+4]; _triangles.push_back(triangle);
-					triangle[0] = conn[j+1]; triangle[1] = conn[j+2]; triangle[2] = conn[j+4]; _triangles.push_back(triangle);
-					triangle[0] = conn[j+2]; triangle[1] = conn[j+3]; triangle[2] = conn[j+4]; _triangles.push_back(triangle);
-					triangle[0] = conn[j]; triangle[1] = conn[j+3]; triangle[2] = conn[j+4]; _triangles.push_back(triangle);
-
-					quadrilateral[0] = conn[j]; quadrilateral[1] = conn[j+1]; quadrilateral[2] = conn[j+2]; quadrilateral[3] = conn[j+3]; _quadrilaterals.push_back(quadrilateral);
-
-					for(unsigned k = 0; k < 5; ++k){
-						pyramid[k] = conn[j+k];
-					}
-					_pyramids.push_back(pyramid);
-
-					j+=5;
-
-					cnt++;
-
-					break;
-
-				default:
-					break;
-			}
+		if(_topology.num_skipped_cells()){
+			std::cerr << "skipped " << _topology.num_skipped_cells() << " cells of unsupported type" << std::endl;
 		}
 
-		//rem doubles
-		std::sort(_edges.begin(), _edges.end());
-		_edges.erase(std::unique(_edges.begin(), _edges.end()), _edges.end());
-
-		std::sort(_triangles.begin(), _triangles.end());
-		_triangles.erase(std::unique(_triangles.begin(), _triangles.end()), _triangles.end());
-
-		std::sort(_quadrilaterals.begin(), _quadrilaterals.end());
-		_quadrilaterals.erase(std::unique(_quadrilaterals.begin(), _quadrilaterals.end()), _quadrilaterals.end());
-
-
-		std::vector<unsigned> sizes(6);
-		sizes[0] = _edges.size();
-		sizes[1] = _triangles.size();
-		sizes[2] = _quadrilaterals.size();
-		sizes[3] = _tets.size();
-		sizes[4] = _prisms.size();
-		sizes[5] = _pyramids.size();
+		std::vector<unsigned> sizes(7);
+		sizes[0] = _topology.num_edges();
+		sizes[1] = _topology.num_triangles();
+		sizes[2] = _topology.num_quadrilaterals();
+		sizes[3] = _topology.num_tetrahedrons();
+		sizes[4] = _topology.num_prisms();
+		sizes[5] = _topology.num_pyramids();
+		sizes[6] = _topology.num_hexahedrons();
 
 		return sizes;
-
 	}
 
 	void write_elements(){
-		_fout << "	<edges>";
-		for(unsigned i = 0; i < _edges.size(); ++i){
-			_fout << _edges[i].first << " " << _edges[i].second << " ";
-		}
-		_fout << "	</edges>" << std::endl;
-
-		_fout << "	<triangles>";
-		for(unsigned i = 0; i < _triangles.size(); ++i){
-			for(unsigned j = 0; j < 3; ++j){
-				_fout << _triangles[i][j] << " ";
-			}
-		}
-		_fout << "	</triangles>" << std::endl;
-
-		_fout << "	<quadrilaterals>";
-		for(unsigned i = 0; i < _quadrilaterals.size(); ++i){
-			for(unsigned j = 0; j < 4; ++j){
-				_fout << _quadrilaterals[i][j] << " ";
-			}
-		}
-		_fout << "	</quadrilaterals>" << std::endl;
-
-
-		_fout << "	<tetrahedrons>";
-		for(unsigned i = 0; i < _tets.size(); ++i){
-			for(unsigned j = 0; j < 4; ++j){
-				_fout << _tets[i][j] << " ";
-			}
-		}
-		_fout << "	</tetrahedrons>" << std::endl;
-
-		_fout << "	<prisms>";
-		for(unsigned i = 0; i < _prisms.size(); ++i){
-			for(unsigned j = 0; j < 6; ++j){
-				_fout << _prisms[i][j] << " ";
-			}
-		}
-		_fout << "	</prisms>" << std::endl;
-
-		_fout << "	<pyramids>";
-		for(unsigned i = 0; i < _pyramids.size(); ++i){
-			for(unsigned j = 0; j < 5; ++j){
-				_fout << _pyramids[i][j] << " ";
-			}
-		}
-		_fout << "	</pyramids>" << std::endl;
+		_out.write_indices("edges", _topology.edges());
+		_out.write_indices("triangles", _topology.triangles());
+		_out.write_indices("quadrilaterals", _topology.quadrilaterals());
+		_out.write_indices("tetrahedrons", _topology.tetrahedrons());
+		_out.write_indices("hexahedrons", _topology.hexahedrons());
+		_out.write_indices("prisms", _topology.prisms());
+		_out.write_indices("pyramids", _topology.pyramids());
 	}
 
 	void write_subset_handler(unsigned num_points, std::vector<unsigned> &sizes){
-		_fout << "	<subset_handler name=\"defSH\">" << std::endl;
-		_fout << "		<subset name=\"Inner\" color=\"0 0 0\" state=\"393216\">" << std::endl;
-
-		_fout << "			<vertices>";
-		for(unsigned i = 0; i < num_points; ++i){
-			_fout << i << " ";
-		}
-		_fout << "</vertices>" << std::endl;
-
-		_fout << "			<edges>";
-		for(unsigned i = 0; i < sizes[0]; ++i){
-			_fout << i << " ";
-		}
-		_fout << "</edges>" << std::endl;
-
-		_fout << "			<faces>";
-		for(unsigned i = 0; i < sizes[1]+sizes[2]; ++i){
-			_fout << i << " ";
-		}
-		_fout << "</faces>" << std::endl;
-
-		_fout << "			<volumes>";
-		for(unsigned i = 0; i < sizes[3]+sizes[4]+sizes[5]; ++i){
-			_fout << i << " ";
-		}
-		_fout << "</volumes>" << std::endl;
-
-
-		_fout << "		</subset>" << std::endl;
-		_fout << "	</subset_handler>" << std::endl;
+		const float color[] = {0, 0, 0, 1};
+		_out.begin_subset_handler("defSH");
+		_out.begin_subset("Inner", color, 393216);
+		_out.write_subset_range("vertices", 0, num_points);
+		_out.write_subset_range("edges", 0, sizes[0]);
+		_out.write_subset_range("faces", 0, sizes[1]+sizes[2]);
+		_out.write_subset_range("volumes", 0, sizes[3]+sizes[4]+sizes[5]+sizes[6]);
+		_out.end_subset();
+		_out.end_subset_handler();
 	}
 
-	void write_eof(){
-		_fout << "</grid>" << std::endl;
+	///	returns false if the file could not be written completely
+	bool write_eof(){
+		_out.end_grid();
+		return _out.close();
 	}
 
 public: //TODO
-	std::ofstream _fout;
-	std::vector<std::pair<unsigned, unsigned> > _edges;
-	std::vector<std::vector<unsigned> > _triangles;
-	std::vector<std::vector<unsigned> > _quadrilaterals;
-	std::vector<std::vector<unsigned> > _tets;
-	std::vector<std::vector<unsigned> > _prisms;
-	std::vector<std::vector<unsigned> > _pyramids;
+	UGXStreamWriter _out;
+	TopologyBuilder _topology;
 };
 
 
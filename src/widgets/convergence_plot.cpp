@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <QPainter>
+#include <QMouseEvent>
+#include "convergence_plot.h"
+
+static const double MIN_PLOT_VALUE = 1e-300;
+
+ConvergencePlot::
+ConvergencePlot(QWidget* parent) :
+	QWidget(parent),
+	m_minVal(std::numeric_limits<double>::max()),
+	m_maxVal(0),
+	m_currentIteration(-1),
+	m_cacheDirty(true)
+{
+	setMinimumHeight(80);
+	setBackgroundRole(QPalette::Base);
+	setAutoFillBackground(true);
+}
+
+ConvergencePlot::
+~ConvergencePlot()	{}
+
+QSize ConvergencePlot::
+sizeHint() const
+{
+	return QSize(400, 150);
+}
+
+void ConvergencePlot::
+clear()
+{
+	m_series.clear();
+	m_minVal = std::numeric_limits<double>::max();
+	m_maxVal = 0;
+	m_currentIteration = -1;
+	m_cacheDirty = true;
+	update();
+}
+
+void ConvergencePlot::
+setNumSeries(int num)
+{
+	m_series.resize(std::max(num, 0));
+	m_cacheDirty = true;
+	update();
+}
+
+void ConvergencePlot::
+append(int series, double value)
+{
+	if(series < 0)
+		return;
+	if(series >= numSeries())
+		m_series.resize(series + 1);
+
+	value = std::max(std::fabs(value), MIN_PLOT_VALUE);
+	m_series[series].append(value);
+	m_minVal = std::min(m_minVal, value);
+	m_maxVal = std::max(m_maxVal, value);
+
+//	repaints are coalesced by Qt, so many appends only cause one rebuild
+	m_cacheDirty = true;
+	update();
+}
+
+void ConvergencePlot::
+appendIteration(const std::vector<double>& values)
+{
+	for(size_t i = 0; i < values.size(); ++i)
+		append((int)i, values[i]);
+}
+
+int ConvergencePlot::
+numIterations() const
+{
+	size_t num = 0;
+	for(size_t i = 0; i < m_series.size(); ++i)
+		num = std::max(num, m_series[i].size());
+	return (int)num;
+}
+
+void ConvergencePlot::
+setCurrentIteration(int iteration)
+{
+	if(iteration != m_currentIteration){
+		m_currentIteration = iteration;
+		update();
+	}
+}
+
+QRect ConvergencePlot::
+plotRect() const
+{
+	const int left = fontMetrics().width("1e-000") + 8;
+	const int bottom = fontMetrics().height() + 6;
+	return QRect(left, 6, std::max(width() - left - 10, 1),
+				 std::max(height() - bottom - 6, 1));
+}
+
+double ConvergencePlot::
+xPos(size_t iteration, const QRect& r) const
+{
+	const int numIters = numIterations();
+	if(numIters < 2)
+		return r.left();
+	return r.left() + (double)r.width() * (double)iteration / (double)(numIters - 1);
+}
+
+double ConvergencePlot::
+yPos(double value, const QRect& r) const
+{
+	const double lmin = std::floor(std::log10(m_minVal));
+	const double lmax = std::max(std::ceil(std::log10(m_maxVal)), lmin + 1);
+	const double t = (std::log10(value) - lmin) / (lmax - lmin);
+	return r.bottom() - t * r.height();
+}
+
+void ConvergencePlot::
+rebuildCache()
+{
+	m_cache = QPixmap(size());
+	m_cache.fill(palette().color(QPalette::Base));
+	m_cacheDirty = false;
+
+	QPainter p(&m_cache);
+	const QRect r = plotRect();
+
+	p.setPen(palette().color(QPalette::Mid));
+	p.drawRect(r);
+
+	const int numIters = numIterations();
+	if(numIters == 0 || m_maxVal <= 0)
+		return;
+
+//	decade grid lines and labels
+	const int lmin = (int)std::floor(std::log10(m_minVal));
+	const int lmax = std::max((int)std::ceil(std::log10(m_maxVal)), lmin + 1);
+	const int decadeStep = std::max(1, (lmax - lmin) / std::max(1, r.height() / 20));
+	for(int l = lmin; l <= lmax; l += decadeStep){
+		const int y = (int)yPos(std::pow(10., l), r);
+		p.setPen(palette().color(QPalette::Midlight));
+		p.drawLine(r.left(), y, r.right(), y);
+		p.setPen(palette().color(QPalette::Text));
+		p.drawText(QRect(0, y - 10, r.left() - 4, 20), Qt::AlignRight | Qt::AlignVCenter,
+				   QString("1e%1").arg(l));
+	}
+
+//	iteration labels
+	const int iterStep = std::max(1, (numIters - 1) / std::max(1, r.width() / 60));
+	for(int i = 0; i < numIters; i += iterStep){
+		const int x = (int)xPos(i, r);
+		p.drawText(QRect(x - 30, r.bottom() + 2, 60, fontMetrics().height()),
+				   Qt::AlignHCenter | Qt::AlignTop, QString::number(i));
+	}
+
+//	one polyline per series. Each bucket contributes its first, min, max
+//	and last value, which preserves spikes in decimated series.
+	p.setRenderHint(QPainter::Antialiasing, true);
+	QPolygonF poly;
+	for(size_t is = 0; is < m_series.size(); ++is){
+		const DecimatedSeries& s = m_series[is];
+		poly.clear();
+		for(size_t ib = 0; ib < s.num_buckets(); ++ib){
+			const DecimatedSeries::Bucket& b = s.bucket(ib);
+			const double x0 = xPos(b.first, r);
+			const double x1 = xPos(b.last, r);
+			poly << QPointF(x0, yPos(b.firstVal, r));
+			if(b.last != b.first){
+				const double xm = 0.5 * (x0 + x1);
+				poly << QPointF(xm, yPos(b.maxVal, r))
+					 << QPointF(xm, yPos(b.minVal, r))
+					 << QPointF(x1, yPos(b.lastVal, r));
+			}
+		}
+
+		QColor c = QColor::fromHsv((int)(is * 360 / m_series.size()), 200, 200);
+		p.setPen(QPen(c, 1.5));
+		if(poly.size() == 1)
+			p.drawEllipse(poly.front(), 2, 2);
+		else
+			p.drawPolyline(poly);
+	}
+}
+
+void ConvergencePlot::
+paintEvent(QPaintEvent*)
+{
+	if(m_cacheDirty || m_cache.size() != size())
+		rebuildCache();
+
+	QPainter p(this);
+	p.drawPixmap(0, 0, m_cache);
+
+	if(m_currentIteration >= 0 && m_currentIteration < numIterations()){
+		const QRect r = plotRect();
+		const int x = (int)xPos(m_currentIteration, r);
+		p.setPen(QPen(palette().color(QPalette::Highlight), 1, Qt::DashLine));
+		p.drawLine(x, r.top(), x, r.bottom());
+	}
+}
+
+void ConvergencePlot::
+resizeEvent(QResizeEvent* event)
+{
+	m_cacheDirty = true;
+	QWidget::resizeEvent(event);
+}
+
+void ConvergencePlot::
+mousePressEvent(QMouseEvent* event)
+{
+	const int numIters = numIterations();
+	if(event->button() != Qt::LeftButton || numIters == 0){
+		QWidget::mousePressEvent(event);
+		return;
+	}
+
+	const QRect r = plotRect();
+	int iter = 0;
+	if(numIters > 1){
+		const double t = (double)(event->x() - r.left()) / (double)r.width();
+		iter = (int)std::floor(t * (numIters - 1) + 0.5);
+		iter = std::min(std::max(iter, 0), numIters - 1);
+	}
+
+	setCurrentIteration(iter);
+	emit iterationClicked(iter);
+}
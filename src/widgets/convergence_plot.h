@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef __H__EMVIS_convergence_plot__
+#define __H__EMVIS_convergence_plot__
+
+#include <vector>
+#include <QWidget>
+#include <QPixmap>
+#include "util/decimated_series.h"
+
+///	Plots the defect of each eigenvalue over the solver iterations.
+/**	The y-axis is logarithmic. Values are appended incrementally and are
+ * decimated through DecimatedSeries, so that repainting costs at most
+ * O(numSeries * bucketCapacity), regardless of the number of iterations.
+ * The plot itself is cached in a pixmap and only rebuilt if data was added
+ * or the widget was resized.
+ *
+ * Clicking into the plot emits iterationClicked with the iteration
+ * closest to the mouse position.*/
+class ConvergencePlot : public QWidget
+{
+	Q_OBJECT
+
+	public:
+		ConvergencePlot(QWidget* parent = 0);
+		virtual ~ConvergencePlot();
+
+		void clear();
+
+	///	resizes the number of plotted series. Existing series are kept.
+		void setNumSeries(int num);
+		int numSeries() const			{return (int)m_series.size();}
+
+	///	appends a value to the given series. Non-positive values are clamped.
+		void append(int series, double value);
+
+	///	appends one value to each series, e.g. the defects of one iteration.
+		void appendIteration(const std::vector<double>& values);
+
+		int numIterations() const;
+
+		virtual QSize sizeHint() const;
+
+	signals:
+		void iterationClicked(int iteration);
+
+	public slots:
+	///	highlights the given iteration by a vertical marker
+		void setCurrentIteration(int iteration);
+
+	protected:
+		virtual void paintEvent(QPaintEvent* event);
+		virtual void resizeEvent(QResizeEvent* event);
+		virtual void mousePressEvent(QMouseEvent* event);
+
+	private:
+		QRect plotRect() const;
+		double xPos(size_t iteration, const QRect& r) const;
+		double yPos(double value, const QRect& r) const;
+		void rebuildCache();
+
+		std::vector<DecimatedSeries>	m_series;
+		double	m_minVal;
+		double	m_maxVal;
+		int		m_currentIteration;
+		bool	m_cacheDirty;
+		QPixmap	m_cache;
+};
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#include <algorithm>
+#include <QCheckBox>
+#include <QDoubleSpinBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QSlider>
+#include <QStyle>
+#include <QToolButton>
+#include "timeline_widget.h"
+
+///	number of slider positions between two time steps
+static const int SLIDER_RESOLUTION = 10;
+
+TimelineWidget::
+TimelineWidget(QWidget* parent) :
+	QWidget(parent),
+	m_numSteps(0),
+	m_playing(false)
+{
+	m_play = new QToolButton(this);
+	m_play->setIcon(style()->standardIcon(QStyle::SP_MediaPlay));
+	m_play->setToolTip(tr("Play / Pause"));
+
+	m_slider = new QSlider(Qt::Horizontal, this);
+	m_slider->setRange(0, 0);
+
+	m_label = new QLabel(this);
+	m_label->setMinimumWidth(fontMetrics().width("00000.0 / 00000"));
+
+	m_loop = new QCheckBox(tr("loop"), this);
+
+	m_rate = new QDoubleSpinBox(this);
+	m_rate->setRange(0.01, 100.0);
+	m_rate->setSingleStep(0.25);
+	m_rate->setValue(1.0);
+	m_rate->setSuffix("x");
+	m_rate->setToolTip(tr("Playback rate"));
+
+	QHBoxLayout* l = new QHBoxLayout(this);
+	l->setContentsMargins(2, 2, 2, 2);
+	l->addWidget(m_play);
+	l->addWidget(m_slider, 1);
+	l->addWidget(m_label);
+	l->addWidget(m_loop);
+	l->addWidget(m_rate);
+
+	connect(m_play, SIGNAL(clicked()), this, SLOT(playClicked()));
+	connect(m_slider, SIGNAL(sliderMoved(int)), this, SLOT(sliderMoved(int)));
+	connect(m_loop, SIGNAL(toggled(bool)), this, SIGNAL(loopToggled(bool)));
+	connect(m_rate, SIGNAL(valueChanged(double)), this, SIGNAL(rateChanged(double)));
+
+	updateLabel(0);
+}
+
+TimelineWidget::
+~TimelineWidget()	{}
+
+void TimelineWidget::
+setNumSteps(int numSteps)
+{
+	m_numSteps = numSteps;
+	m_slider->setRange(0, std::max(numSteps - 1, 0) * SLIDER_RESOLUTION);
+	updateLabel(0);
+}
+
+void TimelineWidget::
+setPosition(double position)
+{
+	if(!m_slider->isSliderDown()){
+		m_slider->blockSignals(true);
+		m_slider->setValue((int)(position * SLIDER_RESOLUTION + 0.5));
+		m_slider->blockSignals(false);
+	}
+	updateLabel(position);
+}
+
+void TimelineWidget::
+setPlaying(bool playing)
+{
+	m_playing = playing;
+	m_play->setIcon(style()->standardIcon(playing ? QStyle::SP_MediaPause
+												  : QStyle::SP_MediaPlay));
+}
+
+void TimelineWidget::
+sliderMoved(int value)
+{
+	emit seekRequested((double)value / SLIDER_RESOLUTION);
+}
+
+void TimelineWidget::
+playClicked()
+{
+	emit playToggled(!m_playing);
+}
+
+void TimelineWidget::
+updateLabel(double position)
+{
+	m_label->setText(QString("%1 / %2").arg(position, 0, 'f', 1)
+									   .arg(std::max(m_numSteps - 1, 0)));
+}
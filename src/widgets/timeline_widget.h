@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2019:  Lukas Larisch
+ * Author: Lukas Larisch
+ *
+ * This file is part of EmVis.
+ * 
+ * EmVis is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 3 (as published by the
+ * Free Software Foundation) with the following additional attribution
+ * requirements (according to LGPL/GPL v3 §7):
+ * 
+ * (1) The following notice must be displayed in the Appropriate Legal Notices
+ * of covered and combined works: "Based on ProMesh (www.promesh3d.com)".
+ * 
+ * (2) The following bibliography is recommended for citation and must be
+ * preserved in all covered files:
+ * "Reiter, S. and Wittum, G. ProMesh -- a flexible interactive meshing software
+ *   for unstructured hybrid grids in 1, 2, and 3 dimensions. In preparation."
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ */
+
+#ifndef __H__EMVIS_timeline_widget__
+#define __H__EMVIS_timeline_widget__
+
+#include <QWidget>
+
+class QCheckBox;
+class QDoubleSpinBox;
+class QLabel;
+class QSlider;
+class QToolButton;
+
+///	Controls for a time series playback: play/pause, timeline, loop and rate.
+/**	The widget only emits requests. Connect it to a PlaybackEngine, which
+ * reports the current state back through setPosition and setPlaying.*/
+class TimelineWidget : public QWidget
+{
+	Q_OBJECT
+
+	public:
+		TimelineWidget(QWidget* parent = 0);
+		virtual ~TimelineWidget();
+
+	signals:
+		void playToggled(bool play);
+		void seekRequested(double position);
+		void loopToggled(bool loop);
+		void rateChanged(double rate);
+
+	public slots:
+		void setNumSteps(int numSteps);
+		void setPosition(double position);
+		void setPlaying(bool playing);
+
+	protected slots:
+		void sliderMoved(int value);
+		void playClicked();
+
+	private:
+		void updateLabel(double position);
+
+		QToolButton*	m_play;
+		QSlider*		m_slider;
+		QLabel*			m_label;
+		QCheckBox*		m_loop;
+		QDoubleSpinBox*	m_rate;
+		int				m_numSteps;
+		bool			m_playing;
+};
+
+#endif